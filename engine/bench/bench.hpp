@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <vp/vp.hpp>
+#include <vp/trace/event_dumper.hpp>
+
+// Number of times each measure is repeated, the best one being reported
+#define BENCH_NB_RUNS 5
+
+/*
+ * Minimal platform for the engine benchmarks, with the engines and a root component, and with
+ * everything which is not benchmarked disabled.
+ */
+class BenchPlatform
+{
+public:
+    BenchPlatform(const char *extra_config="")
+    {
+        std::string config = std::string("{\"memcheck\": false, \"power\": false, ") +
+            "\"traces\": {\"include_regex\": [], \"exclude_regex\": [], \"level\": \"debug\", " +
+            "\"format\": \"long\"}, " +
+            "\"events\": {\"include_regex\": [], \"exclude_regex\": [], \"include_raw\": [], " +
+            "\"traces\": {}, \"files\": [], \"format\": \"vcd\", \"enabled\": false}" +
+            extra_config + "}";
+
+        this->gv_config = js::import_config_from_string(config);
+        this->time_engine = new vp::TimeEngine(this->gv_config);
+        this->trace_engine = new vp::TraceEngine(this->gv_config);
+        this->power_engine = new vp::PowerEngine(this->gv_config);
+        // The power engine always opens its report, which is useless here
+        remove("power_report.csv");
+
+        vp::ComponentConf conf("", NULL, js::import_config_from_string("{}"), this->gv_config,
+            this->time_engine, this->trace_engine, this->power_engine, NULL);
+        this->root = new vp::Component(conf);
+        this->time_engine->init(this->root);
+    }
+
+    // Create a component, using the same engines as the root component
+    vp::ComponentConf conf(std::string name, const char *config="{}")
+    {
+        return vp::ComponentConf(name, this->root, js::import_config_from_string(config),
+            this->gv_config, this->time_engine, this->trace_engine, this->power_engine, NULL);
+    }
+
+    // The benchmarks drive the engines directly, which is not part of their public API, so
+    // this class is a friend of the engines and gives access to what they need
+
+    // Execute the time engine until it is stopped or has nothing to execute
+    static void exec(vp::TimeEngine *engine) { engine->exec(); }
+
+    // Attach a block to a clock engine, as the bindings of a real platform would do
+    static void set_clock(vp::Block *block, vp::ClockEngine *clock) { block->clock.set_engine(clock); }
+
+    // Force the writer threads of an event dumper, whatever the number of host threads
+    static void set_parallel(vp::Event_dumper *dumper, bool parallel) { dumper->parallel = parallel; }
+
+    js::Config *gv_config;
+    vp::TimeEngine *time_engine;
+    vp::TraceEngine *trace_engine;
+    vp::PowerEngine *power_engine;
+    vp::Component *root;
+};
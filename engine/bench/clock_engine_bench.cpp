@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Clock engine micro-benchmark.
+ *
+ * All events belong to the same clock domain and re-enqueue themselves from their handler,
+ * mostly with short delays, and sometimes with a delay beyond the event wheel. This measures
+ * the cost of the clock engine delayed event queue, for different numbers of pending events.
+ * Each measure is repeated and the best one is reported, to filter out host noise.
+ *
+ * Usage: clock_engine_bench [nb_events] [nb_pending_events...]
+ */
+
+#include "bench.hpp"
+
+class Client : public vp::Block
+{
+public:
+    Client(vp::Block *parent, vp::ClockEngine *clock, int id, int64_t *count)
+        : vp::Block(parent, "client" + std::to_string(id)), event(this, &Client::handler),
+        seed(id + 1), count(count)
+    {
+        BenchPlatform::set_clock(this, clock);
+        this->event.enqueue(this->next_delay());
+    }
+
+    // Mostly short delays, with one far delay out of 64 events
+    int64_t next_delay()
+    {
+        this->seed = this->seed * 1103515245 + 12345;
+        int value = (this->seed >> 16) & 0x3f;
+        return value == 0 ? 1000 : 1 + (value & 0xf);
+    }
+
+    static void handler(vp::Block *__this, vp::ClockEvent *event)
+    {
+        Client *_this = (Client *)__this;
+        if (--*_this->count == 0)
+        {
+            _this->time.get_engine()->pause();
+        }
+        event->enqueue(_this->next_delay());
+    }
+
+    vp::ClockEvent event;
+    uint32_t seed;
+    int64_t *count;
+};
+
+static double run(BenchPlatform &platform, int nb_clients, int64_t nb_events)
+{
+    vp::TimeEngine *engine = platform.time_engine;
+    std::string name = "clock" + std::to_string(nb_clients);
+    vp::ComponentConf conf = platform.conf(name, "{\"frequency\": 1000000000}");
+    vp::ClockEngine *clock = new vp::ClockEngine(conf);
+    std::vector<Client *> clients;
+    int64_t count = nb_events;
+
+    for (int i = 0; i < nb_clients; i++)
+    {
+        clients.push_back(new Client(clock, clock, i, &count));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (count > 0)
+    {
+        BenchPlatform::exec(engine);
+    }
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (Client *client: clients)
+    {
+        client->event.cancel();
+        delete client;
+    }
+    delete clock;
+
+    return nb_events / duration / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    int64_t nb_events = argc > 1 ? atoll(argv[1]) : 5000000;
+    std::vector<int> sizes = { 1, 2, 4, 8, 16, 64, 256, 1024 };
+
+    if (argc > 2)
+    {
+        sizes.clear();
+        for (int i = 2; i < argc; i++)
+        {
+            sizes.push_back(atoi(argv[i]));
+        }
+    }
+
+    BenchPlatform platform;
+
+    for (int nb_clients: sizes)
+    {
+        double best = 0;
+        for (int i = 0; i < BENCH_NB_RUNS; i++)
+        {
+            best = std::max(best, run(platform, nb_clients, nb_events));
+        }
+        printf("%5d events: %7.2f Mevents/s\n", nb_clients, best);
+    }
+
+    return 0;
+}
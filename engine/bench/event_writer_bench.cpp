@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Event file writer micro-benchmark.
+ *
+ * Signals of 1 and 32 bits toggling at every timestamp are spread over several event files.
+ * The benchmark plays the role of the event thread, and hands the pending value changes to the
+ * files every 16 timestamps, as if a buffer of events had been parsed. Each measure is done with
+ * all files written by the event thread, and then with one writer thread per file, which is
+ * forced even on single-core hosts, where it is disabled by default. Each measure is repeated
+ * and the best one is reported, to filter out host noise.
+ *
+ * Usage: event_writer_bench [format] [nb_signals] [nb_steps] [nb_files...]
+ */
+
+#include "bench.hpp"
+
+static double run(std::string format, bool parallel, int nb_files, int nb_signals, int nb_steps)
+{
+    std::string config = "{\"events\": {\"format\": \"" + format + "\", \"parallel\": false}}";
+    vp::Event_dumper *dumper = new vp::Event_dumper(js::import_config_from_string(config));
+    BenchPlatform::set_parallel(dumper, parallel);
+
+    std::vector<vp::Event_trace *> traces;
+    for (int i = 0; i < nb_signals; i++)
+    {
+        std::string name = "/top/cluster" + std::to_string(i % nb_files) + "/sig" + std::to_string(i);
+        std::string file = "event_writer_bench" + std::to_string(i % nb_files) + "." + format;
+        traces.push_back(dumper->get_trace(name, file, (i & 1) ? 32 : 1));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < nb_steps; step++)
+    {
+        for (int i = 0; i < nb_signals; i++)
+        {
+            uint32_t value = (step + i) & 1 ? 0xffffffff : 0x12345678 * step;
+            traces[i]->reg(step * 1000, (uint8_t *)&value, traces[i]->width, 0, NULL);
+            traces[i]->dump(step * 1000);
+        }
+
+        if ((step & 15) == 15)
+        {
+            dumper->flush();
+        }
+    }
+    dumper->close();
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    delete dumper;
+    for (int i = 0; i < nb_files; i++)
+    {
+        std::string file = "event_writer_bench" + std::to_string(i) + "." + format;
+        remove(file.c_str());
+        // FST files come with their hierarchy
+        remove((file + ".hier").c_str());
+    }
+
+    return (double)nb_signals * nb_steps / duration / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    std::string format = argc > 1 ? argv[1] : "vcd";
+    int nb_signals = argc > 2 ? atoi(argv[2]) : 4000;
+    int nb_steps = argc > 3 ? atoi(argv[3]) : 500;
+    std::vector<int> sizes = { 1, 2, 4, 8 };
+
+    if (argc > 4)
+    {
+        sizes.clear();
+        for (int i = 4; i < argc; i++)
+        {
+            sizes.push_back(atoi(argv[i]));
+        }
+    }
+
+    printf("Host threads: %d\n", std::thread::hardware_concurrency());
+
+    for (int nb_files: sizes)
+    {
+        double best_serial = 0, best_parallel = 0;
+        for (int i = 0; i < BENCH_NB_RUNS; i++)
+        {
+            best_serial = std::max(best_serial, run(format, false, nb_files, nb_signals, nb_steps));
+            best_parallel = std::max(best_parallel, run(format, true, nb_files, nb_signals, nb_steps));
+        }
+        printf("%3d %s files: %7.2f Mevents/s serial, %7.2f Mevents/s with writer threads\n",
+            nb_files, format.c_str(), best_serial, best_parallel);
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Mapping tree micro-benchmark.
+ *
+ * The mapping tree is filled with mappings separated by holes, which go to the default
+ * mapping, like for a router. Lookups are done either at random addresses, or sequentially
+ * within one mapping at a time, which is what a master streaming to a target does. Each lookup
+ * result is checked first. Each measure is repeated and the best one is reported, to filter out
+ * host noise.
+ *
+ * Usage: mapping_tree_bench [nb_lookups] [nb_mappings...]
+ */
+
+#include <random>
+
+#include "bench.hpp"
+#include <vp/mapping_tree.hpp>
+
+// Each mapping covers the first half of its slot, the second half goes to the default mapping
+#define MAPPING_SLOT 0x10000
+#define MAPPING_SIZE 0x8000
+
+static int expected_id(uint64_t addr, int nb_mappings)
+{
+    return addr % MAPPING_SLOT < MAPPING_SIZE ? addr / MAPPING_SLOT : nb_mappings;
+}
+
+static double run(vp::MappingTree &tree, std::vector<uint64_t> &addrs, int64_t nb_lookups)
+{
+    int64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < nb_lookups; )
+    {
+        for (uint64_t addr: addrs)
+        {
+            sum += tree.get(addr, 4, false)->id;
+        }
+        i += addrs.size();
+    }
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Make sure the lookups are not optimized away
+    if (sum == -1)
+    {
+        printf("%ld\n", sum);
+    }
+
+    return duration * 1e9 / nb_lookups;
+}
+
+int main(int argc, char **argv)
+{
+    int64_t nb_lookups = argc > 1 ? atoll(argv[1]) : 10000000;
+    std::vector<int> sizes = { 8, 64, 512 };
+
+    if (argc > 2)
+    {
+        sizes.clear();
+        for (int i = 2; i < argc; i++)
+        {
+            sizes.push_back(atoi(argv[i]));
+        }
+    }
+
+    for (int nb_mappings: sizes)
+    {
+        vp::Trace trace;
+        vp::MappingTree tree(&trace);
+
+        for (int i = 0; i < nb_mappings; i++)
+        {
+            std::string config = "{\"base\": " + std::to_string(i * MAPPING_SLOT) +
+                ", \"size\": " + std::to_string(MAPPING_SIZE) + "}";
+            tree.insert(i, "mapping" + std::to_string(i), js::import_config_from_string(config));
+        }
+        tree.insert(nb_mappings, "default",
+            js::import_config_from_string("{\"base\": 0, \"size\": 0}"));
+        tree.build();
+
+        std::mt19937 rng(1);
+        std::vector<uint64_t> random_addrs(1 << 16);
+        for (uint64_t &addr: random_addrs)
+        {
+            addr = rng() % ((uint64_t)nb_mappings * MAPPING_SLOT);
+        }
+
+        // 64 consecutive words in each mapping, visited in a random order
+        std::vector<uint64_t> stream_addrs;
+        for (int i = 0; i < 1024; i++)
+        {
+            uint64_t base = (rng() % nb_mappings) * MAPPING_SLOT;
+            for (int j = 0; j < 64; j++)
+            {
+                stream_addrs.push_back(base + j * 4);
+            }
+        }
+
+        for (std::vector<uint64_t> *addrs: { &random_addrs, &stream_addrs })
+        {
+            for (uint64_t addr: *addrs)
+            {
+                if (tree.get(addr, 4, false)->id != expected_id(addr, nb_mappings))
+                {
+                    fprintf(stderr, "Wrong mapping returned (addr: 0x%lx)\n", addr);
+                    return 1;
+                }
+            }
+        }
+
+        double best_random = 0, best_stream = 0;
+        for (int i = 0; i < BENCH_NB_RUNS; i++)
+        {
+            double random_time = run(tree, random_addrs, nb_lookups);
+            double stream_time = run(tree, stream_addrs, nb_lookups);
+            best_random = i == 0 ? random_time : std::min(best_random, random_time);
+            best_stream = i == 0 ? stream_time : std::min(best_stream, stream_time);
+        }
+        printf("%5d mappings: random %6.2f ns/lookup, streaming %6.2f ns/lookup\n",
+            nb_mappings, best_random, best_stream);
+    }
+
+    return 0;
+}
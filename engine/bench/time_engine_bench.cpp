@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Time engine micro-benchmark.
+ *
+ * Each client is a block with one time event re-enqueued by its own handler with a period
+ * specific to the client, so that the engine has to elect a different client at almost every
+ * event. This measures the cost of the client queue, for different numbers of clients.
+ * Each measure is repeated and the best one is reported, to filter out host noise.
+ *
+ * Usage: time_engine_bench [nb_events] [nb_clients...]
+ */
+
+#include "bench.hpp"
+
+class Client : public vp::Block
+{
+public:
+    Client(vp::Block *parent, int id, int64_t *count)
+        : vp::Block(parent, "client" + std::to_string(id)), event(this, &Client::handler),
+        period(100 + id * 7), count(count)
+    {
+        this->event.enqueue(this->period);
+    }
+
+    static void handler(vp::Block *__this, vp::TimeEvent *event)
+    {
+        Client *_this = (Client *)__this;
+        if (--*_this->count == 0)
+        {
+            _this->time.get_engine()->pause();
+        }
+        event->enqueue(_this->period);
+    }
+
+    vp::TimeEvent event;
+    int64_t period;
+    int64_t *count;
+};
+
+static double run(BenchPlatform &platform, int nb_clients, int64_t nb_events)
+{
+    vp::TimeEngine *engine = platform.time_engine;
+    vp::Block *parent = new vp::Block(platform.root, "clients" + std::to_string(nb_clients));
+    std::vector<Client *> clients;
+    int64_t count = nb_events;
+
+    for (int i = 0; i < nb_clients; i++)
+    {
+        clients.push_back(new Client(parent, i, &count));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (count > 0)
+    {
+        BenchPlatform::exec(engine);
+    }
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (Client *client: clients)
+    {
+        client->event.cancel();
+        delete client;
+    }
+    delete parent;
+
+    return nb_events / duration / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    int64_t nb_events = argc > 1 ? atoll(argv[1]) : 5000000;
+    std::vector<int> sizes = { 1, 2, 4, 8, 16, 64, 256, 1024 };
+
+    if (argc > 2)
+    {
+        sizes.clear();
+        for (int i = 2; i < argc; i++)
+        {
+            sizes.push_back(atoi(argv[i]));
+        }
+    }
+
+    BenchPlatform platform;
+
+    for (int nb_clients: sizes)
+    {
+        double best = 0;
+        for (int i = 0; i < BENCH_NB_RUNS; i++)
+        {
+            best = std::max(best, run(platform, nb_clients, nb_events));
+        }
+        printf("%5d clients: %7.2f Mevents/s\n", nb_clients, best);
+    }
+
+    return 0;
+}
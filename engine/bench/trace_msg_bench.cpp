@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Trace message micro-benchmark.
+ *
+ * Each step emulates a hot path like the router request handler, with three messages on an
+ * inactive trace, issued either with Trace::msg or with the vp_trace_msg macro, and compares it
+ * with the same step without messages. Messages more verbose than the level given to cmake with
+ * GVSOC_TRACE_LEVEL are compiled out by the macro, so the benchmark must be built once per level
+ * to compare them. It is linked against the debug engine, since traces are compiled out of the
+ * optimized one. Each measure is repeated and the best one is reported, to filter out host noise.
+ *
+ * Usage: trace_msg_bench [nb_steps]
+ */
+
+#include "bench.hpp"
+
+typedef uint64_t (*step_t)(vp::Trace *trace, uint64_t addr, int size, bool is_write);
+
+__attribute__((noinline)) static uint64_t step_none(vp::Trace *trace, uint64_t addr, int size,
+    bool is_write)
+{
+    return addr * 3 + size;
+}
+
+__attribute__((noinline)) static uint64_t step_msg(vp::Trace *trace, uint64_t addr, int size,
+    bool is_write)
+{
+    trace->msg(vp::Trace::LEVEL_TRACE, "Received IO req (offset: 0x%lx, size: 0x%x, is_write: %d)\n",
+        addr, size, is_write);
+    uint64_t result = addr * 3 + size;
+    trace->msg(vp::Trace::LEVEL_TRACE, "Routing to entry (OutputPort: %s)\n", "out");
+    trace->msg(vp::Trace::LEVEL_DEBUG, "Data request (addr: 0x%lx, size: 0x%x, is_write: %d)\n",
+        addr, size, is_write);
+    return result;
+}
+
+__attribute__((noinline)) static uint64_t step_macro(vp::Trace *trace, uint64_t addr, int size,
+    bool is_write)
+{
+    vp_trace_msg(trace, vp::Trace::LEVEL_TRACE, "Received IO req (offset: 0x%lx, size: 0x%x, is_write: %d)\n",
+        addr, size, is_write);
+    uint64_t result = addr * 3 + size;
+    vp_trace_msg(trace, vp::Trace::LEVEL_TRACE, "Routing to entry (OutputPort: %s)\n", "out");
+    vp_trace_msg(trace, vp::Trace::LEVEL_DEBUG, "Data request (addr: 0x%lx, size: 0x%x, is_write: %d)\n",
+        addr, size, is_write);
+    return result;
+}
+
+static double run(step_t step, vp::Trace *trace, int64_t nb_steps)
+{
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < nb_steps; i++)
+    {
+        sum += step(trace, i, 4, i & 1);
+    }
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Make sure the steps are not optimized away
+    if (sum == 1)
+    {
+        printf("%ld\n", sum);
+    }
+
+    return duration * 1e9 / nb_steps;
+}
+
+int main(int argc, char **argv)
+{
+    int64_t nb_steps = argc > 1 ? atoll(argv[1]) : 100000000;
+    vp::Trace *trace = new vp::Trace();
+    std::vector<std::pair<const char *, step_t>> steps = {
+        { "no message", step_none },
+        { "Trace::msg, inactive", step_msg },
+        { "vp_trace_msg, inactive", step_macro },
+    };
+
+    printf("Compiled trace level: %d\n", VP_TRACE_LEVEL_COMPILED);
+
+    for (auto &step: steps)
+    {
+        double best = 0;
+        for (int i = 0; i < BENCH_NB_RUNS; i++)
+        {
+            double time = run(step.second, trace, nb_steps);
+            best = i == 0 ? time : std::min(best, time);
+        }
+        printf("%-24s %6.2f ns/step\n", step.first, best);
+    }
+
+    return 0;
+}
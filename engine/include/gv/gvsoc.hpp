@@ -602,6 +602,79 @@ namespace gv {
         virtual void handle_syscall_stop() {}
     };
 
+    /**
+     * Statistics of a clock engine.
+     *
+     * Each clock domain has its own clock engine executing the clock events of the blocks of
+     * this domain.
+     */
+    class ClockEngineStats
+    {
+    public:
+        /** The path of the clock engine in the hardware hierarchy. */
+        std::string path;
+        /** The current frequency of the clock domain. */
+        int64_t frequency = 0;
+        /** The number of times the clock engine was scheduled by the time engine. */
+        int64_t nb_execs = 0;
+        /** The number of event callbacks executed. */
+        int64_t nb_events = 0;
+        /** The number of events enqueued for a future cycle. */
+        int64_t nb_enqueues = 0;
+        /** The number of events canceled. */
+        int64_t nb_cancels = 0;
+        /** The number of events currently waiting for a future cycle. */
+        int64_t delayed_queue_size = 0;
+        /** The maximum number of events waiting for a future cycle. */
+        int64_t delayed_queue_max = 0;
+    };
+
+    /**
+     * Statistics of a time engine.
+     *
+     * There is one time engine per partition simulated in parallel, or one for the whole system
+     * otherwise. It schedules the clock engines and the blocks having time events.
+     */
+    class TimeEngineStats
+    {
+    public:
+        /** The number of times a client, like a clock engine, was executed. */
+        int64_t nb_execs = 0;
+        /** The number of times the same client could continue, since it still had the first event. */
+        int64_t nb_same_client = 0;
+        /** The number of times a client had to be inserted again into the queue after execution. */
+        int64_t nb_reinserts = 0;
+        /** The number of times a client was enqueued from outside the engine loop. */
+        int64_t nb_enqueues = 0;
+        /** The number of clients currently enqueued. */
+        int64_t queue_size = 0;
+        /** The maximum number of clients enqueued. */
+        int64_t queue_max = 0;
+    };
+
+    /**
+     * Statistics of the simulation engine.
+     *
+     * The counters are accumulated since the beginning of the simulation or since the last
+     * reset. They can be used to tune the clocking of the platform or spot event storms.
+     */
+    class EngineStats
+    {
+    public:
+        /** The statistics of each time engine. */
+        std::vector<TimeEngineStats> time_engines;
+        /** The statistics of each clock engine. */
+        std::vector<ClockEngineStats> clock_engines;
+        /** The number of IO requests allocated from the request pools. */
+        int64_t io_req_allocs = 0;
+        /** The number of IO requests released to the request pools. */
+        int64_t io_req_frees = 0;
+        /** The number of host allocations done to refill the request pools. */
+        int64_t io_req_mallocs = 0;
+    };
+
+
+
     /**
      * GVSOC interface
      *
@@ -828,6 +901,52 @@ namespace gv {
          * @returns The timestamp of the next event to be executed or -1 if there is no event.
          */
         virtual int64_t get_next_event_time() { return -1; }
+
+        /**
+         * Get the engine statistics
+         *
+         * This reports the counters of the time engines, of the clock engines and of the IO
+         * request pools. The counters are always maintained, and are cheap enough to not slow
+         * down the simulation.
+         *
+         * @param stats The statistics are reported here.
+         */
+        virtual void get_engine_stats(EngineStats &stats) {}
+
+        /**
+         * Reset the engine statistics
+         *
+         * This clears the counters of the time and clock engines, so that the statistics can be
+         * taken on a specific part of the simulation. The maximum depths restart from the current
+         * ones.
+         */
+        virtual void reset_engine_stats() {}
+
+        /**
+         * Save a checkpoint
+         *
+         * This saves the state of the whole platform into a file, so that another simulation of
+         * the same platform can restart from it, for example to skip the boot of an operating
+         * system. The simulation must be stopped.
+         *
+         * @param path Path of the checkpoint file.
+         * @returns True if the checkpoint was saved.
+         */
+        virtual bool checkpoint_save(std::string path) { return false; }
+
+        /**
+         * Restore a checkpoint
+         *
+         * This restores the state of the whole platform, including the time, from a file saved
+         * with checkpoint_save by a simulation of the same platform. This is usually done after
+         * the simulation is started and before it is run. The simulation must be stopped.
+         *
+         * @param path Path of the checkpoint file.
+         * @returns True if the checkpoint was restored. If the file could be opened but did not
+         *     match the platform, the platform state is inconsistent and the simulation should
+         *     not be continued.
+         */
+        virtual bool checkpoint_restore(std::string path) { return false; }
     };
 
 
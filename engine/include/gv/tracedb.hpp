@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+
+/*
+ * Trace database format.
+ *
+ * The file starts with a TraceDbHeader, followed by chunks, each one containing consecutive
+ * value changes of a single trace, and ends with the index and a TraceDbTrailer.
+ *
+ * A chunk is a TraceDbChunk header followed by its data, possibly compressed. Once
+ * decompressed, the data is made of columns:
+ * - the timestamps, as nb_events 64bits values
+ * - the flags, as nb_events bytes, padded to 8 bytes. A flag of 1 means high impedance.
+ * - the values. For logical and real traces, this is nb_events values of the trace size. For
+ *   string traces, this is nb_events+1 32bits offsets into the string bytes which follow.
+ *
+ * The index is made of one TraceDbTrace descriptor per trace, followed by its path padded to 8
+ * bytes. Each descriptor points to an array of TraceDbIndexEntry, one per chunk of the trace,
+ * sorted by time so that any timestamp can be found with a binary search.
+ */
+
+#define TRACEDB_MAGIC   "GVTDB\0\0"
+#define TRACEDB_VERSION 1
+
+#define TRACEDB_COMPRESSION_NONE 0
+#define TRACEDB_COMPRESSION_LZ4  1
+
+#define TRACEDB_TYPE_LOGICAL 0
+#define TRACEDB_TYPE_REAL    1
+#define TRACEDB_TYPE_STRING  2
+
+namespace gv {
+
+    typedef struct
+    {
+        char magic[8];
+        uint32_t version;
+        // Time unit as a power of 10 of seconds, -12 for picoseconds
+        int32_t timescale;
+    } TraceDbHeader;
+
+    typedef struct
+    {
+        uint32_t trace_id;
+        uint32_t nb_events;
+        uint32_t compression;
+        uint32_t raw_size;
+        uint32_t stored_size;
+        uint32_t reserved;
+        int64_t first_timestamp;
+        int64_t last_timestamp;
+    } TraceDbChunk;
+
+    typedef struct
+    {
+        int64_t first_timestamp;
+        int64_t last_timestamp;
+        // Offset in the file of the TraceDbChunk header
+        uint64_t offset;
+        uint64_t nb_events;
+    } TraceDbIndexEntry;
+
+    typedef struct
+    {
+        uint32_t id;
+        uint32_t type;
+        // Width in bits for logical traces
+        uint32_t width;
+        uint32_t path_len;
+        uint64_t nb_events;
+        uint64_t nb_chunks;
+        // Offset in the file of the array of TraceDbIndexEntry
+        uint64_t index_offset;
+    } TraceDbTrace;
+
+    typedef struct
+    {
+        uint64_t traces_offset;
+        uint64_t nb_traces;
+        char magic[8];
+    } TraceDbTrailer;
+
+    /**
+     * Reader of trace databases.
+     *
+     * The file is memory-mapped and only the chunks covering the requested time window are
+     * decompressed, so that any part of a huge trace can be read without going through the rest.
+     */
+    class TraceDb
+    {
+    public:
+        /**
+         * Open a trace database.
+         *
+         * Throws a std::runtime_error if the file can not be opened or is not a trace database.
+         */
+        TraceDb(std::string path);
+        ~TraceDb();
+
+        /**
+         * Get the paths of all traces.
+         */
+        std::vector<std::string> get_paths();
+
+        /**
+         * Get the descriptor of a trace, or NULL if it is not in the database.
+         */
+        const TraceDbTrace *get_trace(std::string path);
+
+        /**
+         * Get the value changes of a trace in a time window.
+         *
+         * The callback is first called with the value which is valid at the start of the window,
+         * if any, and then with all value changes until the end of the window, included.
+         * String values are passed with their terminating character.
+         */
+        void get_events(const TraceDbTrace *trace, int64_t start, int64_t end,
+            std::function<void(int64_t timestamp, uint8_t flags, const uint8_t *value, int size)> callback);
+
+        int get_timescale() { return this->header->timescale; }
+
+    private:
+        const TraceDbIndexEntry *get_index(const TraceDbTrace *trace);
+        const uint8_t *get_chunk(const TraceDbIndexEntry *entry, const TraceDbChunk **chunk);
+
+        uint8_t *data;
+        size_t size;
+        const TraceDbHeader *header;
+        std::map<std::string, const TraceDbTrace *> traces;
+        // Last decompressed chunk, since consecutive windows often fall in the same chunk
+        uint64_t chunk_offset;
+        std::vector<uint8_t> chunk_data;
+    };
+
+};
@@ -41,6 +41,12 @@ namespace vp {
     class TraceEngine;
     class reg;
     class MemCheck;
+    class ParallelEngine;
+    class HostProfiler;
+    class HostProfilerEntry;
+    class Top;
+    class CheckpointWriter;
+    class CheckpointReader;
 
     class BlockObject
     {
@@ -74,6 +80,9 @@ namespace vp {
         friend class vp::Component;
         friend class vp::TimeEngine;
         friend class vp::BlockObject;
+        friend class vp::ParallelEngine;
+        friend class vp::HostProfiler;
+        friend class vp::Top;
 
     public:
         /**
@@ -213,6 +222,31 @@ namespace vp {
          */
         virtual void power_supply_set(vp::PowerSupplyState state) {}
 
+        /**
+         * @brief Save the state of the block into a checkpoint
+         *
+         * This virtual method is called for each block of the hierarchy when a checkpoint is
+         * saved. The default implementation saves the registers and signals of the block.
+         * Blocks keeping state in other members must overload it to save them, and should call
+         * this one to also save their registers and signals.
+         * Pending clock and time events are saved by the framework.
+         *
+         * @param writer Stream where the state must be written
+         */
+        virtual void checkpoint_save(vp::CheckpointWriter &writer);
+
+        /**
+         * @brief Restore the state of the block from a checkpoint
+         *
+         * This must read exactly what checkpoint_save wrote, in the same order. It is called
+         * for all blocks before pending events are restored, so it should only restore state
+         * and not enqueue events. The reader can be put in error if the checkpoint does not
+         * match the block.
+         *
+         * @param reader Stream where the state must be read
+         */
+        virtual void checkpoint_restore(vp::CheckpointReader &reader);
+
         /**
          * @brief Declare a new service
          *
@@ -381,6 +415,22 @@ namespace vp {
 
         void register_object(vp::BlockObject *object);
 
+        // Save the state of the clock and time events of this block. Used by the top component
+        // when a checkpoint is saved.
+        void checkpoint_save_events(vp::CheckpointWriter &writer);
+
+        // Forget all pending clock and time events of this block, before a checkpoint is
+        // restored.
+        void checkpoint_drop_events();
+
+        // Restore the state of the clock and time events of this block. Delayed and permanent
+        // clock events are restored by their clock engine.
+        void checkpoint_restore_events(vp::CheckpointReader &reader);
+
+        // Shift the pending time events of this block. Used for blocks outside the hierarchy,
+        // which are not part of the checkpoint, when the time is restored.
+        void checkpoint_shift_events(int64_t delta);
+
 
         /*
          * Real private members
@@ -414,6 +464,8 @@ namespace vp {
         std::map<std::string, void *> services;
         // Block trace
         Trace block_trace;
+        // Host time accounted to this block, allocated the first time the host profiler sees it
+        HostProfilerEntry *host_profiler_entry = NULL;
         // Tells if the reset is connected to an interface or is coming from parent
         bool reset_is_bound = false;
         // Memory checker where this block can declare memories and chunk allocation/free
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace vp {
+
+    /**
+     * @brief Stream where the state of the platform is saved
+     *
+     * The checkpoint file is a gzip-compressed stream of the states of all blocks, in the order
+     * of the hierarchy. Blocks write their state with the methods of this class from their
+     * checkpoint_save method, and must read it back in the same order from their
+     * checkpoint_restore method.
+     */
+    class CheckpointWriter
+    {
+    public:
+        /**
+         * @brief Open a checkpoint file for writing
+         *
+         * @param path Path of the checkpoint file
+         */
+        CheckpointWriter(std::string path);
+        ~CheckpointWriter();
+
+        /**
+         * @brief Write raw data
+         *
+         * @param data Data to be written
+         * @param size Size in bytes of the data
+         */
+        void write(const void *data, uint64_t size);
+
+        /**
+         * @brief Write an integer
+         *
+         * @param value Value to be written
+         */
+        inline void write_u64(uint64_t value) { this->write(&value, sizeof(value)); }
+        inline void write_i64(int64_t value) { this->write(&value, sizeof(value)); }
+
+        /**
+         * @brief Write a string, with its size
+         *
+         * @param value String to be written
+         */
+        void write_str(std::string value);
+
+        /**
+         * @brief Put the writer in error
+         *
+         * This can be used by blocks which are in a state which cannot be saved.
+         *
+         * @param error Reason of the error
+         */
+        void set_error(std::string error);
+
+        /**
+         * @brief Tell if all writes succeeded so far
+         */
+        bool is_ok() { return this->error == ""; }
+
+        /**
+         * @brief Get the reason of the first failure
+         */
+        std::string get_error() { return this->error; }
+
+        /**
+         * @brief Flush and close the file
+         *
+         * @return True if the whole checkpoint was written
+         */
+        bool close();
+
+    private:
+        void *file = NULL;
+        std::string path;
+        std::string error;
+    };
+
+    /**
+     * @brief Stream where the state of the platform is restored from
+     *
+     * Reads are checked, a short read or a block detecting that the checkpoint does not match
+     * its configuration puts the reader in error, after which all reads return zeros.
+     */
+    class CheckpointReader
+    {
+    public:
+        /**
+         * @brief Open a checkpoint file for reading
+         *
+         * @param path Path of the checkpoint file
+         */
+        CheckpointReader(std::string path);
+        ~CheckpointReader();
+
+        /**
+         * @brief Read raw data
+         *
+         * @param data Where the data is written
+         * @param size Size in bytes of the data
+         */
+        void read(void *data, uint64_t size);
+
+        /**
+         * @brief Read an integer
+         *
+         * @return The value
+         */
+        inline uint64_t read_u64() { uint64_t value = 0; this->read(&value, sizeof(value)); return value; }
+        inline int64_t read_i64() { int64_t value = 0; this->read(&value, sizeof(value)); return value; }
+
+        /**
+         * @brief Read a string written with write_str
+         *
+         * @return The string
+         */
+        std::string read_str();
+
+        /**
+         * @brief Read an integer and check it has the expected value
+         *
+         * This is used to check that the checkpoint matches the state being restored, like the
+         * size of a memory or a number of registers.
+         *
+         * @param expected Expected value
+         * @param what Description used in the error if the value is not the expected one
+         * @return True if the value is the expected one
+         */
+        bool check_u64(uint64_t expected, std::string what);
+
+        /**
+         * @brief Put the reader in error
+         *
+         * @param error Reason of the error
+         */
+        void set_error(std::string error);
+
+        /**
+         * @brief Tell if all reads succeeded so far
+         */
+        bool is_ok() { return this->error == ""; }
+
+        /**
+         * @brief Get the reason of the first failure
+         */
+        std::string get_error() { return this->error; }
+
+    private:
+        void *file = NULL;
+        std::string path;
+        std::string error;
+    };
+};
@@ -23,6 +23,8 @@
 
 using namespace std;
 
+class BenchPlatform;
+
 namespace vp
 {
     class TimeEngine;
@@ -43,6 +45,7 @@ namespace vp
         friend class vp::Block;
         friend class vp::ClockEvent;
         friend class vp::ClockEngine;
+        friend class ::BenchPlatform;
 
     public:
         /**
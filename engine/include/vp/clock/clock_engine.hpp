@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <unordered_map>
 #include "vp/component.hpp"
 #include "vp/time/time_engine.hpp"
 #include <vp/itf/clk.hpp>
@@ -32,6 +33,27 @@ namespace vp
     class ClockEvent;
     class Component;
 
+    // Number of bits of the delayed event wheel, which gives the number of cycles in the future
+    // where events can be enqueued in constant time.
+    #define VP_CLOCK_ENGINE_WHEEL_BITS 8
+    #define VP_CLOCK_ENGINE_WHEEL_SIZE (1 << VP_CLOCK_ENGINE_WHEEL_BITS)
+    #define VP_CLOCK_ENGINE_WHEEL_MASK (VP_CLOCK_ENGINE_WHEEL_SIZE - 1)
+    // Number of delayed events above which the wheel is used. Below, a sorted list is cheaper.
+    #define VP_CLOCK_ENGINE_WHEEL_MIN_EVENTS 16
+
+    /**
+     * @brief FIFO of delayed clock events
+     *
+     * Used by the clock engine for the buckets of its event wheel and for far events.
+     * Events are doubly-linked so that they can be removed in constant time.
+     */
+    class ClockEventQueue
+    {
+    public:
+        ClockEvent *first = NULL;
+        ClockEvent *last = NULL;
+    };
+
     /**
      * @brief Clock engine
      *
@@ -46,6 +68,7 @@ namespace vp
         friend class vp::ClockEvent;
         friend class vp::BlockTrace;
         friend class vp::TraceEngine;
+        friend class vp::Top;
 
     public:
         /**
@@ -141,6 +164,36 @@ namespace vp
 
         vp::ClockEvent *get_next_event();
 
+        // Insert a delayed event, its cycle must already be set
+        inline void delayed_push(ClockEvent *event);
+
+        // Remove and return the first delayed event
+        inline ClockEvent *delayed_pop();
+
+        // Remove a delayed event from the queue where it is enqueued
+        void delayed_remove(ClockEvent *event);
+
+        // Insert a delayed event while the wheel is used
+        void wheel_push(ClockEvent *event);
+
+        // Remove and return the first delayed event while the wheel is used
+        ClockEvent *wheel_pop();
+
+        // Get the cycle of the first delayed event, or INT64_MAX if there is none, knowing that
+        // there is no delayed event before the specified cycle
+        int64_t delayed_first_cycle(int64_t cycle);
+
+        // Move the event wheel window so that it starts at the specified cycle, and move far
+        // events which are now inside the window to the wheel.
+        void wheel_advance(int64_t cycle);
+
+        // Start using the wheel, when there are too many delayed events for the sorted list
+        void wheel_enable();
+
+        // Stop using the wheel and move its events back to the sorted list, once there are few
+        // delayed events
+        void wheel_disable();
+
         void event_del(Block *comp, ClockEvent *event)
         {
             delete event;
@@ -160,7 +213,28 @@ namespace vp
 
         int64_t exec();
 
-        bool has_events() { return this->nb_enqueued_to_cycle || this->delayed_queue || this->permanent_first; }
+        // Execute an event callback while accounting its host time to the event block
+        void exec_profiled(ClockEvent *event);
+
+        // Report the statistics of this engine
+        void get_stats(gv::ClockEngineStats &stats);
+
+        // Clear the statistics of this engine
+        void reset_stats();
+
+        // Save the state of this engine and its pending events into a checkpoint. Events are
+        // referenced by the index of their block in the checkpoint and their index in the block.
+        void checkpoint_save_engine(vp::CheckpointWriter &writer,
+            std::unordered_map<vp::Block *, int64_t> &block_ids);
+
+        // Forget all pending events, before a checkpoint is restored
+        void checkpoint_drop_engine();
+
+        // Restore the state of this engine and its pending events. The time engine must already
+        // be at the time of the checkpoint.
+        void checkpoint_restore_engine(vp::CheckpointReader &reader, std::vector<vp::Block *> &blocks);
+
+        bool has_events() { return this->next_delayed_cycle != INT64_MAX || this->permanent_first; }
 
         void pre_start();
 
@@ -177,7 +251,23 @@ namespace vp
         vp::Trace clock_trace;
 
         int factor;
-        ClockEvent *delayed_queue = NULL;
+
+        // Delayed events are stored in a wheel of buckets, one per cycle, covering the cycles
+        // from wheel_cycle to wheel_cycle + VP_CLOCK_ENGINE_WHEEL_SIZE - 1. Each bucket is a FIFO
+        // so that events enqueued at the same cycle are executed in order.
+        ClockEventQueue wheel[VP_CLOCK_ENGINE_WHEEL_SIZE];
+        // Bitmap of the non-empty buckets of the wheel, used to quickly find the next event
+        uint64_t wheel_bitmap[VP_CLOCK_ENGINE_WHEEL_SIZE / 64] = { 0 };
+        // First cycle covered by the wheel. It is only moved forward, when an event is enqueued
+        // outside the window or when the first event is outside the window.
+        int64_t wheel_cycle = 0;
+        // Events enqueued after the window of the wheel, sorted by cycle
+        ClockEventQueue far_queue;
+        // True if the wheel is used. Otherwise, all delayed events are in the far queue, which is
+        // then just a sorted singly linked list, as only the next pointers and the first event
+        // are maintained.
+        bool wheel_active = false;
+
         ClockEvent *permanent_first = NULL;
         ClockEvent *permanent_last = NULL;
         int current_cycle = 0;
@@ -190,12 +280,8 @@ namespace vp
         // engine is updated by an external interaction.
         int64_t cycles = 0;
 
-        // Tells how many events are enqueued to the circular buffer.
-        // If it is zero, there could still be some events in the delayed queue.
-        int nb_enqueued_to_cycle = 0;
-
-        // This time is relevant only when no event is enqueued into the circular
-        // buffer of event so that the number of cycles can be resynchronized when
+        // This time is relevant only when no permanent event is enabled
+        // so that the number of cycles can be resynchronized when
         // something happen (an event is pushed or the frequency is changed).
         // This is set when control is given back to the time engine and used
         // to recompute the numer of cycles when the engine is updated by an
@@ -206,10 +292,19 @@ namespace vp
 
         vp::TimeEngine *time_engine = NULL;
 
+        // Cycle of the first delayed event, or INT64_MAX if there is none
         int64_t next_delayed_cycle = INT64_MAX;
 
+        // Number of pending delayed events, which decides when the wheel is used. It is kept out
+        // of the statistics so that clearing them can not change the scheduling.
+        int64_t nb_delayed_events = 0;
+
         vp::ClockEvent apply_frequency_event;
         int64_t frequency_to_be_applied;
+
+        // Statistics, always counted. Path, frequency and queue size are only filled when the
+        // statistics are reported.
+        gv::ClockEngineStats stats;
     };
 
 };
@@ -29,6 +29,7 @@ namespace vp
     class Component;
     class BlockClock;
     class ClockEngine;
+    class ClockEventQueue;
 
 #define VP_CLOCK_EVENT_NB_ARGS 8
 
@@ -263,6 +264,9 @@ namespace vp
         ClockEvent *next;
         // Pointer for event chaining
         ClockEvent *prev;
+        // Delayed queue where the event is currently enqueued, or NULL if it is not in a delayed
+        // queue. Used to remove it in constant time when it is canceled
+        ClockEventQueue *queue = NULL;
         // True if the event is enqueued into the clock engine
         bool enqueued;
         // Absolute number of cycles where the event should be executed
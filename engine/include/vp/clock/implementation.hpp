@@ -96,6 +96,51 @@ inline void vp::ClockEngine::sync()
   }
 }
 
+inline void vp::ClockEngine::delayed_push(vp::ClockEvent *event)
+{
+    if (likely(!this->wheel_active))
+    {
+        // Few events, the sorted list is browsed from the beginning since short delays are the
+        // most common ones. Events of the same cycle are executed in their enqueue order.
+        int64_t cycle = event->cycle;
+        vp::ClockEvent *current = this->far_queue.first, *prev = NULL;
+
+        while (current && current->cycle <= cycle)
+        {
+            prev = current;
+            current = current->next;
+        }
+
+        if (prev)
+            prev->next = event;
+        else
+            this->far_queue.first = event;
+        event->next = current;
+        event->queue = &this->far_queue;
+    }
+    else
+    {
+        this->wheel_push(event);
+    }
+}
+
+inline vp::ClockEvent *vp::ClockEngine::delayed_pop()
+{
+    if (likely(!this->wheel_active))
+    {
+        vp::ClockEvent *event = this->far_queue.first;
+
+        this->far_queue.first = event->next;
+        this->next_delayed_cycle = event->next ? event->next->cycle : INT64_MAX;
+        event->queue = NULL;
+        this->nb_delayed_events--;
+
+        return event;
+    }
+
+    return this->wheel_pop();
+}
+
 inline int64_t vp::ClockEvent::get_cycle()
 {
   return this->cycle == -1 ? this->clock->get_cycles() + 1: cycle;
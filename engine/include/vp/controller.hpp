@@ -238,6 +238,10 @@ namespace gv {
         void quit(int status) override;
         int64_t get_time() override;
         int64_t get_next_event_time() override;
+        void get_engine_stats(gv::EngineStats &stats) override;
+        void reset_engine_stats() override;
+        bool checkpoint_save(std::string path) override;
+        bool checkpoint_restore(std::string path) override;
 
         // Called by launcher when simulation is over to notify each client
         void sim_finished(int status);
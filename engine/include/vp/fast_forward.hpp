@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace js {
+    class Config;
+};
+
+namespace vp {
+
+    /**
+     * @brief Fast-forward mode
+     *
+     * When enabled, the platform starts in a functional mode where the timing of the models is
+     * not accounted: cores execute instructions back-to-back without fetch and pipeline
+     * timing, and interconnects, caches and memories do not add any latency. This is used to
+     * quickly reach the interesting part of a workload, like after an OS boot.
+     * Once a trigger fires, the whole platform switches to timed mode and stays in it.
+     */
+    class FastForward
+    {
+    public:
+        /**
+         * @brief Enable the mode if the configuration requests it
+         *
+         * @param config gvsoc configuration
+         */
+        static void init(js::Config *config);
+
+        /**
+         * @brief Tell if the platform is in fast-forward mode
+         *
+         * Models check this on each request to skip their timing. Cores check it regularly and
+         * switch to timed mode once it becomes false.
+         */
+        static inline bool is_active() { return FastForward::active; }
+
+        /**
+         * @brief Switch the platform to timed mode
+         *
+         * This is called by the triggers: cores reaching the specified PC or number of
+         * instructions, the software through a semihosting call, or the proxy.
+         *
+         * @param reason Description of the trigger, for the message reporting the switch
+         */
+        static void stop(std::string reason);
+
+        /**
+         * @brief Number of instructions that a core can execute in advance of the clock engine
+         */
+        static int64_t get_quantum() { return FastForward::quantum; }
+
+        /**
+         * @brief PC which switches the platform to timed mode when a core reaches it
+         *
+         * @return The PC, or -1 if there is no PC trigger
+         */
+        static int64_t get_until_pc() { return FastForward::until_pc; }
+
+        /**
+         * @brief Number of instructions which switches the platform to timed mode when a core
+         * has executed them
+         *
+         * @return The number of instructions, or -1 if there is no instruction trigger
+         */
+        static int64_t get_until_insns() { return FastForward::until_insns; }
+
+    private:
+        static bool active;
+        static int64_t quantum;
+        static int64_t until_pc;
+        static int64_t until_insns;
+    };
+};
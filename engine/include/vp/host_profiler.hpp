@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <time.h>
+#include <vp/block.hpp>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace js {
+    class Config;
+};
+
+namespace vp {
+
+    typedef enum
+    {
+        HOST_PROFILER_CLOCK_EVENT,
+        HOST_PROFILER_TIME_EVENT,
+        HOST_PROFILER_IO_REQ,
+        HOST_PROFILER_NB_KINDS
+    } HostProfilerKind;
+
+    /**
+     * @brief Host time accounted to one block
+     */
+    class HostProfilerEntry
+    {
+    public:
+        // Path of the block, kept here so that the profile can be dumped once blocks are destroyed
+        std::string path;
+        // Host ticks spent in the block callbacks, excluding the callbacks of other blocks they called
+        int64_t self_ticks = 0;
+        // Host ticks spent in the block callbacks, including the callbacks of other blocks
+        int64_t total_ticks = 0;
+        // Number of callbacks executed, per kind
+        int64_t nb_calls[HOST_PROFILER_NB_KINDS] = {};
+        // Number of callbacks of this block currently executing, to not account twice the time of
+        // a block calling itself through other blocks
+        int depth = 0;
+    };
+
+    /**
+     * @brief Callback being profiled
+     *
+     * Frames are allocated on the host stack by the code calling the callbacks and chained
+     * together, so that the time of a callback can be removed from the one calling it.
+     */
+    class HostProfilerFrame
+    {
+    public:
+        HostProfilerEntry *entry;
+        HostProfilerFrame *parent;
+        int64_t start;
+        int64_t child_ticks;
+    };
+
+    /**
+     * @brief Host time profiler
+     *
+     * When enabled, the engine measures the host time spent in every clock event, time event
+     * and IO request callback, and accounts it to the block owning the callback. This tells
+     * which models are consuming the simulation time.
+     * It is enabled from the gvsoc configuration before the components are instantiated, and
+     * costs a single test per event when disabled.
+     */
+    class HostProfiler
+    {
+    public:
+        // Tells if callbacks must be profiled. Only set once at startup.
+        static bool enabled;
+
+        /**
+         * @brief Enable the profiler if the configuration requests it
+         *
+         * @param config gvsoc configuration
+         */
+        static void init(js::Config *config);
+
+        /**
+         * @brief Start accounting time to a block
+         *
+         * Must be followed by a call to leave with the same frame, once the block callback
+         * returns.
+         *
+         * @param frame Frame describing the callback, allocated by the caller
+         * @param block Block owning the callback
+         * @param kind Kind of callback
+         */
+        static inline void enter(HostProfilerFrame *frame, vp::Block *block, HostProfilerKind kind);
+
+        /**
+         * @brief Stop accounting time to the block of the frame
+         *
+         * @param frame Frame given to enter
+         */
+        static inline void leave(HostProfilerFrame *frame);
+
+        /**
+         * @brief Dump the profile
+         *
+         * A table of the blocks sorted by self time is written to <file>.txt and the same
+         * information to <file>.json. The profile keeps accumulating after the dump.
+         */
+        static void dump();
+
+    private:
+        static inline int64_t get_ticks();
+        static HostProfilerEntry *entry_new(vp::Block *block);
+        static inline HostProfilerEntry *get_entry(vp::Block *block);
+
+        // Callback currently being executed by this thread
+        static thread_local HostProfilerFrame *current;
+    };
+};
+
+
+
+inline int64_t vp::HostProfiler::get_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+inline vp::HostProfilerEntry *vp::HostProfiler::get_entry(vp::Block *block)
+{
+    HostProfilerEntry *entry = block->host_profiler_entry;
+    if (__builtin_expect(entry == NULL, 0))
+    {
+        entry = HostProfiler::entry_new(block);
+    }
+    return entry;
+}
+
+inline void vp::HostProfiler::enter(HostProfilerFrame *frame, vp::Block *block,
+    HostProfilerKind kind)
+{
+    HostProfilerEntry *entry = HostProfiler::get_entry(block);
+    entry->nb_calls[kind]++;
+    entry->depth++;
+    frame->entry = entry;
+    frame->parent = HostProfiler::current;
+    frame->child_ticks = 0;
+    HostProfiler::current = frame;
+    frame->start = HostProfiler::get_ticks();
+}
+
+inline void vp::HostProfiler::leave(HostProfilerFrame *frame)
+{
+    int64_t ticks = HostProfiler::get_ticks() - frame->start;
+    HostProfilerEntry *entry = frame->entry;
+
+    entry->self_ticks += ticks - frame->child_ticks;
+    if (--entry->depth == 0)
+    {
+        entry->total_ticks += ticks;
+    }
+
+    HostProfiler::current = frame->parent;
+    if (frame->parent)
+    {
+        frame->parent->child_ticks += ticks;
+    }
+}
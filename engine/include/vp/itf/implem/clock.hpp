@@ -106,15 +106,84 @@ namespace vp {
     return _this->set_frequency_meth_mux(_this->comp_mux, frequency, _this->sync_mux);
   }
 
+  inline void ClockMaster::sync_partition_cross_stub(ClockMaster *_this, bool value)
+  {
+    // Before the partitions are simulated by their threads, the slave can be directly
+    // called, otherwise the value is posted to the slave partition.
+    if (!_this->partition->get_parallel()->is_concurrent())
+    {
+      if (_this->remote_port->get_owner()->clock.get_engine())
+        _this->remote_port->get_owner()->clock.get_engine()->sync();
+      _this->sync_meth_partition_cross((Component *)_this->slave_context_for_partition_cross, value);
+    }
+    else
+    {
+      _this->partition->send(_this->remote_partition, &ClockMaster::sync_partition_cross_handler,
+        (void *)_this, NULL, &value, sizeof(value));
+    }
+  }
+
+  inline void ClockMaster::sync_partition_cross_handler(vp::PartitionMessage *msg)
+  {
+    ClockMaster *_this = (ClockMaster *)msg->context;
+    if (_this->remote_port->get_owner()->clock.get_engine())
+      _this->remote_port->get_owner()->clock.get_engine()->sync();
+    _this->sync_meth_partition_cross((Component *)_this->slave_context_for_partition_cross,
+      *(bool *)msg->data);
+  }
+
+  inline void ClockMaster::set_frequency_partition_cross_stub(ClockMaster *_this, int64_t value)
+  {
+    if (!_this->partition->get_parallel()->is_concurrent())
+    {
+      if (_this->remote_port->get_owner()->clock.get_engine())
+        _this->remote_port->get_owner()->clock.get_engine()->sync();
+      _this->set_frequency_meth_partition_cross((Component *)_this->slave_context_for_partition_cross, value);
+    }
+    else
+    {
+      _this->partition->send(_this->remote_partition, &ClockMaster::set_frequency_partition_cross_handler,
+        (void *)_this, NULL, &value, sizeof(value));
+    }
+  }
+
+  inline void ClockMaster::set_frequency_partition_cross_handler(vp::PartitionMessage *msg)
+  {
+    ClockMaster *_this = (ClockMaster *)msg->context;
+    if (_this->remote_port->get_owner()->clock.get_engine())
+      _this->remote_port->get_owner()->clock.get_engine()->sync();
+    _this->set_frequency_meth_partition_cross((Component *)_this->slave_context_for_partition_cross,
+      *(int64_t *)msg->data);
+  }
+
   inline void ClockMaster::finalize()
   {
     ClockMaster *port = this;
 
     while(port)
     {
+      vp::TimePartition *partition = port->get_owner()->time.get_engine()->get_partition();
+      vp::TimePartition *remote_partition = port->remote_port->get_owner()->time.get_engine()->get_partition();
+
+      // In parallel mode, a clock generator can drive a clock domain of another partition,
+      // in which case frequency changes are posted to it.
+      if (partition != remote_partition)
+      {
+        port->partition = partition;
+        port->remote_partition = remote_partition;
+
+        port->sync_meth_partition_cross = port->sync_meth;
+        port->sync_meth = (void (*)(vp::Block *, bool))&ClockMaster::sync_partition_cross_stub;
+
+        port->set_frequency_meth_partition_cross = port->set_frequency_meth;
+        port->set_frequency_meth = (void (*)(vp::Block *, int64_t))&ClockMaster::set_frequency_partition_cross_stub;
+
+        port->slave_context_for_partition_cross = (vp::Block *)port->get_remote_context();
+        port->set_remote_context(port);
+      }
       // We have to instantiate a stub in case the binding is crossing different
       // frequency domains in order to resynchronize the target engine.
-      if (port->get_owner()->clock.get_engine() != port->remote_port->get_owner()->clock.get_engine())
+      else if (port->get_owner()->clock.get_engine() != port->remote_port->get_owner()->clock.get_engine())
       {
         // Just save the normal handler and tweak it to enter the stub when the
         // master is pushing the request.
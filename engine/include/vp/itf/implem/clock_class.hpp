@@ -23,6 +23,7 @@
 #define __VP_ITF_CLOCK_HPP__
 
 #include "vp/vp.hpp"
+#include "vp/time/time_partition.hpp"
 
 namespace vp {
 
@@ -63,6 +64,10 @@ namespace vp {
     static inline void sync_default(vp::Block *, bool value);
     static inline void set_frequency_default(vp::Block *, int64_t value);
     static inline void set_frequency_freq_cross_stub(ClockMaster *_this, int64_t value);
+    static inline void sync_partition_cross_stub(ClockMaster *_this, bool value);
+    static inline void sync_partition_cross_handler(vp::PartitionMessage *msg);
+    static inline void set_frequency_partition_cross_stub(ClockMaster *_this, int64_t value);
+    static inline void set_frequency_partition_cross_handler(vp::PartitionMessage *msg);
 
     void (*sync_meth)(vp::Block *, bool value);
     void (*sync_meth_mux)(vp::Block *, bool value, int id);
@@ -78,6 +83,12 @@ namespace vp {
     ClockMaster *next = NULL;
 
     vp::Block *slave_context_for_freq_cross;
+
+    void (*sync_meth_partition_cross)(vp::Block *, bool value);
+    void (*set_frequency_meth_partition_cross)(vp::Block *, int64_t value);
+    vp::Block *slave_context_for_partition_cross;
+    vp::TimePartition *partition = NULL;
+    vp::TimePartition *remote_partition = NULL;
   };
 
 
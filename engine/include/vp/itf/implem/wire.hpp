@@ -22,6 +22,9 @@
 #ifndef __VP_ITF_IMPLEMEN_WIRE_HPP__
 #define __VP_ITF_IMPLEMEN_WIRE_HPP__
 
+#include <string.h>
+#include <type_traits>
+
 namespace vp {
 
   template<class T>
@@ -103,12 +106,138 @@ namespace vp {
     return _this->sync_back_meth_freq_cross((Component *)_this->slave_context_for_freq_cross, value);
   }
 
+  template<class T>
+  inline void WireMaster<T>::sync_partition_cross_stub(WireMaster<T> *_this, T value)
+  {
+    if constexpr (sizeof(T) <= VP_PARTITION_MESSAGE_DATA_SIZE && std::is_trivially_copyable<T>::value)
+    {
+      // Before the partitions are simulated by their threads, the slave can be directly
+      // called, otherwise the value is posted to the slave partition.
+      if (!_this->partition->get_parallel()->is_concurrent())
+      {
+        if (_this->remote_port->get_owner()->clock.get_engine())
+          _this->remote_port->get_owner()->clock.get_engine()->sync();
+        _this->sync_meth_partition_cross((Component *)_this->slave_context_for_partition_cross, value);
+      }
+      else
+      {
+        _this->partition->send(_this->remote_partition, &WireMaster<T>::sync_partition_cross_handler,
+          (void *)_this, NULL, &value, sizeof(T));
+      }
+    }
+  }
+
+  template<class T>
+  inline void WireMaster<T>::sync_partition_cross_handler(vp::PartitionMessage *msg)
+  {
+    if constexpr (sizeof(T) <= VP_PARTITION_MESSAGE_DATA_SIZE && std::is_trivially_copyable<T>::value)
+    {
+      WireMaster<T> *_this = (WireMaster<T> *)msg->context;
+      T value;
+      memcpy((void *)&value, msg->data, sizeof(T));
+      if (_this->remote_port->get_owner()->clock.get_engine())
+        _this->remote_port->get_owner()->clock.get_engine()->sync();
+      _this->sync_meth_partition_cross((Component *)_this->slave_context_for_partition_cross, value);
+    }
+  }
+
+  template<class T>
+  inline void WireMaster<T>::sync_back_partition_cross_stub(WireMaster<T> *_this, T *value)
+  {
+    // Getting a value from the slave would require the master partition to wait for the
+    // slave one, which the parallel engine never does
+    _this->get_owner()->get_trace()->fatal("Wire sync back is not supported across partitions\n");
+  }
+
+  template<class T>
+  inline void WireSlave<T>::sync_partition_cross_stub(WireSlave<T> *_this, T value)
+  {
+    if constexpr (sizeof(T) <= VP_PARTITION_MESSAGE_DATA_SIZE && std::is_trivially_copyable<T>::value)
+    {
+      if (!_this->partition->get_parallel()->is_concurrent())
+      {
+        _this->master_sync_meth_partition_cross(_this->master_context_for_partition_cross, value);
+      }
+      else
+      {
+        _this->partition->send(_this->remote_partition, &WireSlave<T>::sync_partition_cross_handler,
+          (void *)_this, NULL, &value, sizeof(T));
+      }
+    }
+  }
+
+  template<class T>
+  inline void WireSlave<T>::sync_partition_cross_handler(vp::PartitionMessage *msg)
+  {
+    if constexpr (sizeof(T) <= VP_PARTITION_MESSAGE_DATA_SIZE && std::is_trivially_copyable<T>::value)
+    {
+      WireSlave<T> *_this = (WireSlave<T> *)msg->context;
+      T value;
+      memcpy((void *)&value, msg->data, sizeof(T));
+      _this->master_sync_meth_partition_cross(_this->master_context_for_partition_cross, value);
+    }
+  }
+
+  template<class T>
+  inline void WireMaster<T>::finalize_partition_cross(vp::TimePartition *partition,
+    vp::TimePartition *remote_partition)
+  {
+    if constexpr (!(sizeof(T) <= VP_PARTITION_MESSAGE_DATA_SIZE && std::is_trivially_copyable<T>::value))
+    {
+      this->get_owner()->get_trace()->fatal("Wire type can not be sent across partitions\n");
+    }
+
+    this->partition = partition;
+    this->remote_partition = remote_partition;
+
+    // Values are posted to the other partition in both directions
+    this->sync_meth_partition_cross = this->sync_meth;
+    this->sync_meth = (void (*)(vp::Block *, T))&WireMaster<T>::sync_partition_cross_stub;
+    this->sync_back_meth = (void (*)(vp::Block *, T *))&WireMaster<T>::sync_back_partition_cross_stub;
+    this->slave_context_for_partition_cross = (vp::Block *)this->get_remote_context();
+    this->set_remote_context(this);
+
+    WireSlave<T> *slave = (WireSlave<T> *)this->remote_port;
+    if (slave->partition == NULL)
+    {
+      slave->partition = remote_partition;
+      slave->remote_partition = partition;
+      slave->master_sync_meth_partition_cross = slave->master_sync_meth;
+      slave->master_sync_meth = (void (*)(vp::Block *, T))&WireSlave<T>::sync_partition_cross_stub;
+      slave->master_context_for_partition_cross = (vp::Block *)slave->get_remote_context();
+      slave->set_remote_context(slave);
+    }
+
+    partition->get_parallel()->add_crossing(this->get_owner()->clock.get_engine(),
+      this->remote_port->get_owner()->clock.get_engine());
+  }
+
   template<class T>
   inline void WireMaster<T>::finalize()
   {
+    // In parallel mode, bindings crossing partitions can not directly call the other side as
+    // it is simulated by another thread, stubs are posting the values instead.
+    // Since each slave bound to this port is in its own binding, they are all checked.
+    bool partition_cross = false;
+    for (WireMaster<T> *port = this; port; port = port->next)
+    {
+      if (port->get_owner() == NULL)
+      {
+        port->set_owner(this->get_owner());
+      }
+
+      vp::TimePartition *partition = this->get_owner()->time.get_engine()->get_partition();
+      vp::TimePartition *remote_partition = port->remote_port->get_owner()->time.get_engine()->get_partition();
+      if (partition != remote_partition)
+      {
+        port->finalize_partition_cross(partition, remote_partition);
+        partition_cross |= port == this;
+      }
+    }
+
     // We have to instantiate a stub in case the binding is crossing different
     // frequency domains in order to resynchronize the target engine.
-    if (this->get_owner()->clock.get_engine() != this->remote_port->get_owner()->clock.get_engine())
+    if (!partition_cross && this->get_owner()->clock.get_engine() != this->remote_port->get_owner()->clock.get_engine())
     {
       // Just save the normal handler and tweak it to enter the stub when the
       // master is pushing the request.
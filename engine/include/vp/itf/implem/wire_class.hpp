@@ -23,6 +23,7 @@
 #define __VP_ITF_IMPLEM_WIRE_CLASS_HPP__
 
 #include "vp/vp.hpp"
+#include "vp/time/time_partition.hpp"
 
 namespace vp {
 
@@ -66,6 +67,10 @@ namespace vp {
     static inline void sync_freq_cross_stub(WireMaster *_this, T value);
     static inline void sync_back_freq_cross_stub(WireMaster *_this, T *value);
     static inline void sync_back_muxed(WireMaster *_this, T *value);
+    static inline void sync_partition_cross_stub(WireMaster *_this, T value);
+    static inline void sync_partition_cross_handler(vp::PartitionMessage *msg);
+    static inline void sync_back_partition_cross_stub(WireMaster *_this, T *value);
+    void finalize_partition_cross(vp::TimePartition *partition, vp::TimePartition *remote_partition);
     void (*sync_meth)(vp::Block *, T value);
     void (*sync_meth_mux)(vp::Block *, T value, int id);
     void (*sync_back_meth)(vp::Block *, T *value);
@@ -74,6 +79,8 @@ namespace vp {
     void (*sync_meth_freq_cross)(vp::Block *, T value);
     void (*sync_back_meth_freq_cross)(vp::Block *, T *value);
 
+    void (*sync_meth_partition_cross)(vp::Block *, T value);
+
     void (*master_sync_meth)(vp::Block *comp, T value);
     void (*master_sync_meth_mux)(vp::Block *comp, T value, int id);
 
@@ -88,6 +95,10 @@ namespace vp {
 
     vp::Block *slave_context_for_freq_cross;
 
+    vp::Block *slave_context_for_partition_cross;
+    vp::TimePartition *partition = NULL;
+    vp::TimePartition *remote_partition = NULL;
+
     int master_sync_mux_id;
   };
 
@@ -125,6 +136,9 @@ namespace vp {
     
     static inline void sync_muxed_stub(WireSlave *_this, T value);
 
+    static inline void sync_partition_cross_stub(WireSlave *_this, T value);
+    static inline void sync_partition_cross_handler(vp::PartitionMessage *msg);
+
     void (*sync_meth)(vp::Block *comp, T value);
     void (*sync_meth_mux)(vp::Block *comp, T value, int id);
 
@@ -142,6 +156,11 @@ namespace vp {
     int master_sync_mux;
 
     WireMaster<T> *master_port = NULL;
+
+    void (*master_sync_meth_partition_cross)(vp::Block *comp, T value);
+    vp::Block *master_context_for_partition_cross;
+    vp::TimePartition *partition = NULL;
+    vp::TimePartition *remote_partition = NULL;
   };
 
 };
@@ -23,7 +23,11 @@
 #define __VP_ITF_IO_HPP__
 
 #include "vp/vp.hpp"
+#include "vp/time/time_partition.hpp"
 #include "vp/queue.hpp"
+#include "vp/host_profiler.hpp"
+#include <atomic>
+#include <new>
 
 namespace vp {
 
@@ -64,6 +68,49 @@ namespace vp {
   typedef void (IoRespMeth)(vp::Block *, vp::IoReq *);
   typedef void (IoGrantMeth)(vp::Block *, vp::IoReq *);
 
+  class IoDmi;
+
+  typedef bool (IoDmiMeth)(vp::Block *, uint64_t addr, bool is_write, IoDmi *dmi);
+  typedef bool (IoDmiMethMuxed)(vp::Block *, uint64_t addr, bool is_write, IoDmi *dmi, int id);
+
+
+  /*
+   * Direct memory interface
+   */
+
+  // A slave can give direct access to the host storage behind a range of addresses, so that
+  // masters can access it without sending requests, similar to TLM-2 get_direct_mem_ptr.
+  // This is only possible where accessing the range has no side effect and a latency which does
+  // not depend on the traffic.
+  // Grants are revoked all at once by invalidating them, which increases a global generation.
+  // A master caching grants must drop them as soon as the generation is not the one it saw
+  // when it got them.
+  class IoDmi
+  {
+  public:
+    // Master calls must initialize the grant with this before getting it
+    inline void init() { this->latency = 0; }
+
+    static void invalidate_all();
+    static inline uint64_t get_generation() { return IoDmi::generation.load(std::memory_order_relaxed); }
+
+    // First address of the granted range, in the address space of the port which got the grant
+    uint64_t base;
+    // Size in bytes of the granted range
+    uint64_t size;
+    // Host pointer corresponding to the first address
+    uint8_t *data;
+    // Latency of each access. Like for requests, each component on the path adds its own
+    // latency to it.
+    int64_t latency;
+    // Tell which kinds of accesses are allowed on the range
+    bool read_allowed;
+    bool write_allowed;
+
+  private:
+    static std::atomic<uint64_t> generation;
+  };
+
   class IoReq : public vp::QueueElem
   {
     friend class IoMaster;
@@ -190,6 +237,63 @@ namespace vp {
   };
 
 
+  /*
+   * Pool of IO requests
+   */
+
+  // Counters of the IO request pool, summed over all threads
+  typedef struct
+  {
+    // Number of requests allocated through req_new
+    int64_t nb_allocs;
+    // Number of requests released through req_del
+    int64_t nb_frees;
+    // Number of host allocations done to refill the pools
+    int64_t nb_mallocs;
+    // Number of requests currently held by the pools
+    int64_t nb_free_reqs;
+  } IoReqPoolStats;
+
+  // Each thread has its own free list so that no lock is needed. A request released by a
+  // thread other than the one which allocated it just moves to the pool of the releasing
+  // thread. Pools are refilled with slabs of requests, which are never given back to the host.
+  class IoReqPool
+  {
+  public:
+    static inline IoReq *alloc(uint64_t addr, uint8_t *data, uint64_t size, bool is_write);
+    static inline void free(IoReq *req);
+
+    // Set the number of requests allocated at once when a pool is empty, 1 means one host
+    // allocation per request. This must be called before any request is allocated.
+    static void set_slab_size(int size);
+
+    static void get_stats(IoReqPoolStats *stats);
+
+  private:
+    // Free requests are linked through their own storage
+    struct FreeReq
+    {
+      FreeReq *next;
+    };
+
+    static IoReqPool *create();
+    FreeReq *refill();
+
+    // Counters are only written by the thread owning the pool and may be read from any other
+    // one, relaxed atomics make this safe without adding any locked operation
+    inline void counter_inc(std::atomic<int64_t> &counter);
+
+    FreeReq *first_free = NULL;
+    std::atomic<int64_t> nb_allocs{0};
+    std::atomic<int64_t> nb_frees{0};
+    std::atomic<int64_t> nb_mallocs{0};
+    std::atomic<int64_t> nb_free_reqs{0};
+
+    static thread_local IoReqPool *pool;
+    static int slab_size;
+  };
+
+
   /*
    * Class for IO master ports
    */
@@ -226,6 +330,10 @@ namespace vp {
     // on which port the response will be sent back by the slave.
     inline IoReqStatus req(IoReq *req, IoSlave *SlavePort);
 
+    // Can be called by master component to get direct access to the storage behind the
+    // specified address. Returns true and fills the grant if the slave accepted it.
+    inline bool get_dmi(uint64_t addr, bool is_write, IoDmi *dmi);
+
 
 
     /*
@@ -295,6 +403,12 @@ namespace vp {
     // setup instead
     IoReqStatus (*req_meth_freq_cross)(vp::Block *, vp::IoReq *);
 
+    // req_meth when the binding is crossing partitions as a stub is setup instead
+    IoReqStatus (*req_meth_partition_cross)(vp::Block *, vp::IoReq *);
+
+    // req_meth when the host profiler is enabled as a stub is setup instead
+    IoReqStatus (*req_meth_host_profiler)(vp::Block *, vp::IoReq *);
+
 
     /*
      * Stubs
@@ -310,6 +424,27 @@ namespace vp {
     // domain before we call it.
     static inline IoReqStatus req_freq_cross_stub(IoMaster *_this, IoReq *req);
 
+    // This is a stub setup when the binding is crossing 2 different partitions so that
+    // the request is posted to the slave partition instead of being executed by the
+    // master thread.
+    static inline IoReqStatus req_partition_cross_stub(IoMaster *_this, IoReq *req);
+
+    // This is a stub setup when the host profiler is enabled so that the host time spent in
+    // the slave is accounted to it.
+    static inline IoReqStatus req_host_profiler_stub(IoMaster *_this, IoReq *req);
+
+    // Called in the slave partition when the request posted by the stub is delivered.
+    static inline void req_partition_cross_handler(vp::PartitionMessage *msg);
+
+    // Stubs called in the slave partition when the slave is granting or replying to a
+    // request which was posted by the master partition.
+    static inline void grant_partition_cross_stub(IoMaster *_this, IoReq *req);
+    static inline void resp_partition_cross_stub(IoMaster *_this, IoReq *req);
+
+    // Called in the master partition when the grant or the response is delivered.
+    static inline void grant_partition_cross_handler(vp::PartitionMessage *msg);
+    static inline void resp_partition_cross_handler(vp::PartitionMessage *msg);
+
 
     /*
      * Internal data
@@ -328,6 +463,20 @@ namespace vp {
     // so that the stub is working well.
     vp::Block *slave_context_for_freq_cross = NULL;
 
+    // Slave context when the binding is crossing partitions, for the same reason as above.
+    vp::Block *slave_context_for_partition_cross = NULL;
+
+    // Slave context when the host profiler is enabled, for the same reason as above.
+    vp::Block *slave_context_for_host_profiler = NULL;
+
+    // Partitions of the master and of the slave when the binding is crossing partitions.
+    vp::TimePartition *partition = NULL;
+    vp::TimePartition *remote_partition = NULL;
+
+    // Port given as response port to the slave when the binding is crossing partitions, so
+    // that responses are captured and sent back to the master partition.
+    IoSlave *partition_resp_port = NULL;
+
     // This data is the multiplex ID that we need to send to the slave when the slave port
     // is multiplexed.
     int slave_req_mux_id = -1;
@@ -338,6 +487,13 @@ namespace vp {
     // For that, a slave port is associated to each master port and can
     // be used by the real slave port to reply to a specific master port.
     IoSlave *SlavePort = NULL;
+
+    // Direct memory interface callbacks of the slave, retrieved during binding. They are
+    // kept apart from the request ones since the stubs are hiding the slave context.
+    IoDmiMeth *dmi_meth = NULL;
+    IoDmiMethMuxed *dmi_meth_mux = NULL;
+    vp::Block *dmi_context = NULL;
+    int dmi_mux_id = -1;
   };
 
 
@@ -384,6 +540,14 @@ namespace vp {
     // when calling the callback, and can be used to multiplex a slave port
     inline void set_req_meth_muxed(IoReqMethMuxed *meth, int id);
 
+    // Set the callback on slave side called when the master is asking for a direct memory
+    // interface grant. Slaves not setting it never grant anything.
+    inline void set_dmi_meth(IoDmiMeth *meth);
+
+    // Same as set_dmi_meth but for a multiplexed port, the ID given to set_req_meth_muxed
+    // is provided as the last argument.
+    inline void set_dmi_meth_muxed(IoDmiMethMuxed *meth);
+
 
 
     /*
@@ -419,6 +583,10 @@ namespace vp {
     // This one gets called instead of the normal once in case it is not NULL
     IoReqStatus (*req_meth_mux)(vp::Block *context, IoReq *, int mux);
 
+    // Direct memory interface callbacks set by the user, NULL if not supported
+    IoDmiMeth *dmi_meth = NULL;
+    IoDmiMethMuxed *dmi_meth_mux = NULL;
+
 
 
     /*
@@ -514,19 +682,83 @@ namespace vp {
 
 
 
-  inline IoReq *IoMaster::req_new(uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
+  inline void IoReqPool::counter_inc(std::atomic<int64_t> &counter)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+
+
+  inline IoReq *IoReqPool::alloc(uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
+  {
+    IoReqPool *pool = IoReqPool::pool;
+    if (unlikely(pool == NULL))
+    {
+      pool = IoReqPool::create();
+    }
+
+    FreeReq *free_req = pool->first_free;
+    if (unlikely(free_req == NULL))
+    {
+      free_req = pool->refill();
+    }
+
+    pool->first_free = free_req->next;
+    pool->counter_inc(pool->nb_allocs);
+    pool->nb_free_reqs.store(pool->nb_free_reqs.load(std::memory_order_relaxed) - 1,
+      std::memory_order_relaxed);
+
+    // Construct it in place so that a recycled request looks exactly like a new one
+    return new (free_req) IoReq(addr, data, size, is_write);
+  }
+
+
+
+  inline void IoReqPool::free(IoReq *req)
   {
-    // For now we allocate new requests but this would be better to manage a pool of requests
-    IoReq *req = new IoReq(addr, data, size, is_write);
+    IoReqPool *pool = IoReqPool::pool;
+    if (unlikely(pool == NULL))
+    {
+      pool = IoReqPool::create();
+    }
+
+    req->~IoReq();
 
-    return req;
+    FreeReq *free_req = (FreeReq *)req;
+    free_req->next = pool->first_free;
+    pool->first_free = free_req;
+    pool->counter_inc(pool->nb_frees);
+    pool->counter_inc(pool->nb_free_reqs);
+  }
+
+
+
+  inline IoReq *IoMaster::req_new(uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
+  {
+    return IoReqPool::alloc(addr, data, size, is_write);
   }
 
 
 
   inline void IoMaster::req_del(IoReq *req)
   {
-    delete req;
+    IoReqPool::free(req);
+  }
+
+
+
+  inline bool IoMaster::get_dmi(uint64_t addr, bool is_write, IoDmi *dmi)
+  {
+    if (this->dmi_meth_mux)
+    {
+      return this->dmi_meth_mux(this->dmi_context, addr, is_write, dmi, this->dmi_mux_id);
+    }
+    else if (this->dmi_meth)
+    {
+      return this->dmi_meth(this->dmi_context, addr, is_write, dmi);
+    }
+
+    return false;
   }
 
 
@@ -565,6 +797,11 @@ namespace vp {
     vp_assert(port != NULL, this->get_owner()->get_trace(),
       "Binding to NULL slave port\n");
 
+    this->dmi_meth = port->dmi_meth;
+    this->dmi_meth_mux = port->dmi_meth_mux;
+    this->dmi_context = (vp::Block *)port->get_context();
+    this->dmi_mux_id = port->req_mux_id;
+
     if (port->req_meth_mux == NULL)
     {
       // Normal binding, just register the method and context into the master
@@ -613,6 +850,106 @@ namespace vp {
 
 
 
+  inline IoReqStatus IoMaster::req_partition_cross_stub(IoMaster *_this, IoReq *req)
+  {
+    // Before the partitions are simulated by their threads, or for debug requests which are
+    // only issued while the simulation is stopped, the slave can be directly called.
+    if (!_this->partition->get_parallel()->is_concurrent() || req->is_debug())
+    {
+      _this->remote_port->get_owner()->clock.get_engine()->sync();
+      return _this->req_meth_partition_cross((Component *)_this->slave_context_for_partition_cross, req);
+    }
+
+    // The slave is called later by its own partition, so the request is always handled
+    // asynchronously. The response port is replaced by our own port so that the response
+    // can be sent back to this partition, and is restored when the response arrives.
+    req->arg_push((void *)req->resp_port);
+    req->resp_port = _this->partition_resp_port;
+    _this->partition->send(_this->remote_partition, &IoMaster::req_partition_cross_handler,
+      (void *)_this, (void *)req);
+
+    return IO_REQ_PENDING;
+  }
+
+
+
+  inline IoReqStatus IoMaster::req_host_profiler_stub(IoMaster *_this, IoReq *req)
+  {
+    vp::HostProfilerFrame frame;
+    vp::HostProfiler::enter(&frame, _this->remote_port->get_owner(), vp::HOST_PROFILER_IO_REQ);
+    IoReqStatus status = _this->req_meth_host_profiler(_this->slave_context_for_host_profiler, req);
+    vp::HostProfiler::leave(&frame);
+    return status;
+  }
+
+
+
+  inline void IoMaster::req_partition_cross_handler(vp::PartitionMessage *msg)
+  {
+    IoMaster *_this = (IoMaster *)msg->context;
+    IoReq *req = (IoReq *)msg->arg;
+
+    // We are not called from the slave clock domain, resynchronize it first
+    _this->remote_port->get_owner()->clock.get_engine()->sync();
+
+    IoReqStatus status = _this->req_meth_partition_cross(
+      (Component *)_this->slave_context_for_partition_cross, req);
+
+    req->status = status;
+
+    if (status == IO_REQ_OK || status == IO_REQ_INVALID)
+    {
+      _this->partition_resp_port->resp(req);
+    }
+  }
+
+
+
+  inline void IoMaster::grant_partition_cross_stub(IoMaster *_this, IoReq *req)
+  {
+    if (req->status == IO_REQ_DENIED)
+    {
+      // The slave is now ready to accept the request it denied, post it again
+      req->status = IO_REQ_PENDING;
+      _this->remote_partition->send(_this->remote_partition,
+        &IoMaster::req_partition_cross_handler, (void *)_this, (void *)req);
+    }
+    else
+    {
+      _this->remote_partition->send(_this->partition,
+        &IoMaster::grant_partition_cross_handler, (void *)_this, (void *)req);
+    }
+  }
+
+
+
+  inline void IoMaster::resp_partition_cross_stub(IoMaster *_this, IoReq *req)
+  {
+    _this->remote_partition->send(_this->partition,
+      &IoMaster::resp_partition_cross_handler, (void *)_this, (void *)req);
+  }
+
+
+
+  inline void IoMaster::grant_partition_cross_handler(vp::PartitionMessage *msg)
+  {
+    IoMaster *_this = (IoMaster *)msg->context;
+    // The initial response port may be hidden by arguments pushed by the slave, so the
+    // grant is sent through our own binding.
+    _this->SlavePort->grant((IoReq *)msg->arg);
+  }
+
+
+
+  inline void IoMaster::resp_partition_cross_handler(vp::PartitionMessage *msg)
+  {
+    IoReq *req = (IoReq *)msg->arg;
+    req->resp_port = (IoSlave *)req->arg_pop();
+    req->resp_port->resp(req);
+  }
+
+
+
   inline void IoMaster::finalize()
   {
     vp_assert(this->get_owner() != NULL, NULL,
@@ -628,9 +965,41 @@ namespace vp {
     vp_assert(this->remote_port->get_owner()->clock.get_engine() != NULL, this->get_comp()->get_trace(),
       "No remote port owner clock found when finalizing master binding\n");
 
+    vp::TimePartition *partition = this->get_owner()->time.get_engine()->get_partition();
+    vp::TimePartition *remote_partition = this->remote_port->get_owner()->time.get_engine()->get_partition();
+
+    // Direct accesses would bypass the synchronization of the slave, and its latency would be
+    // expressed in another clock domain, so no grant is given across domains
+    if (this->get_owner()->clock.get_engine() != this->remote_port->get_owner()->clock.get_engine())
+    {
+      this->dmi_meth = NULL;
+      this->dmi_meth_mux = NULL;
+    }
+
+    // In parallel mode, a binding crossing partitions can not directly call the slave as it
+    // is simulated by another thread, a stub is posting requests to the slave partition
+    // instead. This also takes care of resynchronizing the target clock engine.
+    if (partition != remote_partition)
+    {
+      this->partition = partition;
+      this->remote_partition = remote_partition;
+      this->req_meth_partition_cross = this->req_meth;
+      this->req_meth = (IoReqMeth *)&IoMaster::req_partition_cross_stub;
+      this->slave_context_for_partition_cross = (vp::Block *)this->get_remote_context();
+      this->set_remote_context(this);
+
+      this->partition_resp_port = new IoSlave();
+      this->partition_resp_port->set_owner(this->get_owner());
+      this->partition_resp_port->master_resp_meth = (IoRespMeth *)&IoMaster::resp_partition_cross_stub;
+      this->partition_resp_port->master_grant_meth = (IoGrantMeth *)&IoMaster::grant_partition_cross_stub;
+      this->partition_resp_port->set_remote_context(this);
+
+      partition->get_parallel()->add_crossing(this->get_owner()->clock.get_engine(),
+        this->remote_port->get_owner()->clock.get_engine());
+    }
     // We have to instantiate a stub in case the binding is crossing different
     // frequency domains in order to resynchronize the target engine.
-    if (this->get_owner()->clock.get_engine() != this->remote_port->get_owner()->clock.get_engine())
+    else if (this->get_owner()->clock.get_engine() != this->remote_port->get_owner()->clock.get_engine())
     {
       // Just save the normal handler and tweak it to enter the stub when the
       // master is pushing the request.
@@ -639,6 +1008,16 @@ namespace vp {
       this->slave_context_for_freq_cross = (vp::Block *)this->get_remote_context();
       this->set_remote_context(this);
     }
+
+    // The profiler stub is the outermost one, so that the time of the other stubs is also
+    // accounted to the slave
+    if (vp::HostProfiler::enabled)
+    {
+      this->req_meth_host_profiler = this->req_meth;
+      this->req_meth = (IoReqMeth *)&IoMaster::req_host_profiler_stub;
+      this->slave_context_for_host_profiler = (vp::Block *)this->get_remote_context();
+      this->set_remote_context(this);
+    }
   }
 
 
@@ -680,6 +1059,22 @@ namespace vp {
 
 
 
+  inline void IoSlave::set_dmi_meth(IoDmiMeth *meth)
+  {
+    this->dmi_meth = meth;
+    this->dmi_meth_mux = NULL;
+  }
+
+
+
+  inline void IoSlave::set_dmi_meth_muxed(IoDmiMethMuxed *meth)
+  {
+    this->dmi_meth_mux = meth;
+    this->dmi_meth = NULL;
+  }
+
+
+
   inline IoReqStatus IoSlave::req_default(IoSlave *, IoReq *)
   {
     return IO_REQ_OK;
@@ -732,7 +1127,12 @@ namespace vp {
     // frequency domains in order to resynchronize the target engine.
     if (this->remote_port && this->get_owner()->clock.get_engine() != this->remote_port->get_owner()->clock.get_engine())
     {
-      this->set_freq_stub();
+      // When crossing partitions, the slave is replying through the stubs of the master
+      // port, which then uses its own response port from the master partition.
+      if (this->get_owner()->time.get_engine() == this->remote_port->get_owner()->time.get_engine())
+      {
+        this->set_freq_stub();
+      }
 
       if (((IoMaster *)this->remote_port)->SlavePort != NULL)
       {
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <string.h>
+#include <vector>
 
 namespace vp {
 
@@ -32,7 +33,6 @@ namespace vp {
 
     public:
         MappingTreeEntry(int id, std::string name, js::Config *config);
-        MappingTreeEntry(uint64_t base, MappingTreeEntry *left, MappingTreeEntry *right);
 
         std::string name;
         int id;
@@ -41,9 +41,6 @@ namespace vp {
 
     private:
         MappingTreeEntry *next = NULL;
-        uint64_t lowest_base = 0;
-        MappingTreeEntry *left = NULL;
-        MappingTreeEntry *right = NULL;
     };
 
     class MappingTree
@@ -53,12 +50,64 @@ namespace vp {
         void insert(int id, std::string name, js::Config *config);
         void build();
         MappingTreeEntry *get(uint64_t base, uint64_t size, bool is_write);
+        // Same as get but first checks the entry which was last returned for the same caller, so
+        // that masters streaming to the same target skip the search. The caller should keep one
+        // last_hit per source, initialized to NULL.
+        inline MappingTreeEntry *get(uint64_t base, uint64_t size, bool is_write,
+            MappingTreeEntry *&last_hit);
+        // Get the range of addresses around the specified one which is routed to the same
+        // entry. For the default entry, this is the hole between the surrounding mappings.
+        // The end is exclusive.
+        void get_range(uint64_t addr, MappingTreeEntry *entry, uint64_t &base, uint64_t &end);
 
     private:
+        // Return the index of the last mapping whose base is lower or equal to the address, or
+        // -1 if there is none
+        inline int64_t lookup(uint64_t addr);
+
         vp::Trace *trace;
         MappingTreeEntry *first_map_entry = NULL;
-        MappingTreeEntry *top_map_entry = NULL;
+        // Sorted mapping bases and corresponding entries, built from the list of mappings. Bases
+        // are kept contiguous so that the search only touches a few cache lines.
+        std::vector<uint64_t> bases;
+        std::vector<MappingTreeEntry *> entries;
         MappingTreeEntry *default_entry = NULL;
         MappingTreeEntry *error_entry = NULL;
     };
+
+    inline int64_t MappingTree::lookup(uint64_t addr)
+    {
+        const uint64_t *bases = this->bases.data();
+        size_t len = this->bases.size();
+
+        if (len == 0 || addr < bases[0])
+        {
+            return -1;
+        }
+
+        // Branchless binary search, the compiler turns the selection into a conditional move
+        const uint64_t *first = bases;
+        while (len > 1)
+        {
+            size_t half = len / 2;
+            first = first[half] <= addr ? first + half : first;
+            len -= half;
+        }
+
+        return first - bases;
+    }
+
+    inline MappingTreeEntry *MappingTree::get(uint64_t base, uint64_t size, bool is_write,
+        MappingTreeEntry *&last_hit)
+    {
+        MappingTreeEntry *entry = last_hit;
+        if (entry && base >= entry->base && base - entry->base < entry->size)
+        {
+            return entry;
+        }
+
+        entry = this->get(base, size, is_write);
+        last_hit = entry;
+        return entry;
+    }
 };
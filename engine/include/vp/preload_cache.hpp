@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace js {
+    class Config;
+};
+
+namespace vp {
+
+    class Trace;
+
+    /**
+     * @brief Cache of memory preload images shared between simulations
+     *
+     * Memories normally read their preload file into a private array, so that each simulation
+     * running the same binaries owns a copy of them.
+     * When the cache is enabled, the memory content is instead built once into a cache file,
+     * named after the hash of the preload file, and mapped copy-on-write. All simulations
+     * preloading the same file share the same host pages, until they modify them.
+     * Preload files are found in the cache from their path and attributes, so that they are only
+     * read the first time.
+     */
+    class PreloadCache
+    {
+    public:
+        /**
+         * @brief Enable the cache if the configuration requests it
+         *
+         * @param config gvsoc configuration
+         */
+        static void init(js::Config *config);
+
+        /**
+         * @brief Tell if memories should preload through the cache
+         */
+        static bool is_enabled() { return PreloadCache::enabled; }
+
+        /**
+         * @brief Map a memory preloaded with a file
+         *
+         * The returned area has the size of the memory, starts with the content of the file,
+         * truncated to the memory size, and is then filled with the specified value.
+         * It is private to the caller, writes only affect the caller.
+         *
+         * @param trace Trace used to report why the cache could not be used
+         * @param path Path of the preload file
+         * @param size Size of the memory
+         * @param fill Value of the bytes which are not preloaded
+         * @return The memory content, or NULL if the cache is disabled or failed, in which case
+         *   the caller should preload the file by itself
+         */
+        static uint8_t *map(vp::Trace *trace, std::string path, uint64_t size, uint8_t fill);
+
+        /**
+         * @brief Unmap a memory returned by map
+         *
+         * @param data Memory content
+         * @param size Size of the memory
+         */
+        static void unmap(uint8_t *data, uint64_t size);
+
+    private:
+        static bool enabled;
+        static std::string dir;
+    };
+};
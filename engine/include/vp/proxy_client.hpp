@@ -60,6 +60,10 @@ public:
     void event_add(std::string path, bool is_regex) override;
     void event_exclude(std::string path, bool is_regex) override;
     void *get_component(std::string path) override;
+    void get_engine_stats(gv::EngineStats &stats) override;
+    void reset_engine_stats() override;
+    bool checkpoint_save(std::string path) override;
+    bool checkpoint_restore(std::string path) override;
     std::string send_command(std::string command, bool keep_lock=false);
     int post_command(std::string command, bool keep_lock=false);
     void unlock_command();
@@ -33,6 +33,7 @@ namespace vp
 {
     class TimeEvent;
     class TimeEngine;
+    class TimeQueue;
 
     /**
      * @brief Time features for blocks
@@ -44,6 +45,7 @@ namespace vp
     {
         friend class vp::Block;
         friend class vp::TimeEngine;
+        friend class vp::TimeQueue;
         friend class vp::ClockEngine;
         friend class vp::TimeEvent;
         friend class gv::Controller;
@@ -116,8 +118,9 @@ namespace vp
         // Access to parent class owning this BlockTime
         vp::Block &top;
 
-        // Next block in the queue. Used by time scheduler to queue this block
-        vp::Block *next;
+        // Position of this block in the time engine queue when it is a heap, or -1 if it is not
+        // in the heap
+        int queue_index = -1;
 
         // True if this block is currently being executed by the time engine
         bool running = false;
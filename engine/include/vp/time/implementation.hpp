@@ -42,9 +42,81 @@ inline void vp::TimeEngine::update(int64_t time)
         this->time = time;
 }
 
+inline vp::Block *vp::TimeQueue::first()
+{
+    if (this->heap.size() == 0)
+    {
+        return NULL;
+    }
+    return this->sorted ? this->heap.back().client : this->heap[0].client;
+}
+
+inline void vp::TimeQueue::sorted_insert(int index, Entry &entry)
+{
+    // The clients which must be elected before the new one are at the end, shift them
+    while (index > 0 && this->heap[index - 1].time < entry.time)
+    {
+        this->heap[index] = this->heap[index - 1];
+        index--;
+    }
+    this->heap[index] = entry;
+}
+
+inline void vp::TimeQueue::push(vp::Block *client, bool behind_first)
+{
+    if (likely(this->sorted && this->heap.size() < TIME_QUEUE_SORTED_MAX))
+    {
+        Entry entry = { client->time.next_event_time, 0, client };
+        int index = this->heap.size();
+        this->heap.push_back(entry);
+
+        if (behind_first)
+        {
+            // Same timestamp as the first one, the new client just goes below it
+            this->heap[index] = this->heap[index - 1];
+            this->heap[index - 1] = entry;
+        }
+        else
+        {
+            this->sorted_insert(index, entry);
+        }
+    }
+    else
+    {
+        this->heap_push(client, behind_first);
+    }
+}
+
+inline void vp::TimeQueue::replace_first(vp::Block *client, bool behind_first)
+{
+    if (likely(this->sorted))
+    {
+        // Whatever behind_first, the new client is elected first among the ones with the same
+        // timestamp, like the removed one was, so it just takes its slot
+        Entry entry = { client->time.next_event_time, 0, client };
+        this->sorted_insert(this->heap.size() - 1, entry);
+    }
+    else
+    {
+        this->heap_replace_first(client, behind_first);
+    }
+}
+
+inline vp::Block *vp::TimeQueue::pop()
+{
+    if (likely(this->sorted))
+    {
+        vp::Block *client = this->heap.back().client;
+        this->heap.pop_back();
+        return client;
+    }
+    return this->heap_pop();
+}
+
 inline int64_t vp::TimeEngine::get_next_event_time()
 {
-    return this->first_client ? this->first_client->time.next_event_time : -1;
+    vp::Block *first = this->clients.first();
+    return first ? first->time.next_event_time : -1;
 }
 
 inline bool vp::BlockTime::enqueue_to_engine(int64_t time)
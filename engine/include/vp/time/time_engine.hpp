@@ -22,12 +22,18 @@
 #pragma once
 
 #include "vp/json.hpp"
+#include "vp/time/time_queue.hpp"
+#include "vp/time/time_partition.hpp"
+#include "gv/gvsoc.hpp"
 
 namespace gv
 {
     class ControllerClient;
 };
 
+// Engine micro-benchmarks, which drive the engines without a full platform
+class BenchPlatform;
+
 namespace vp
 {
     class BlockTime;
@@ -43,6 +49,9 @@ namespace vp
         friend class vp::Top;
         friend class gv::GvProxy;
         friend class gv::GvProxySession;
+        friend class vp::TimePartition;
+        friend class vp::ParallelEngine;
+        friend class ::BenchPlatform;
 
     public:
         TimeEngine(js::Config *config);
@@ -87,6 +96,13 @@ namespace vp
         */
         bool dequeue(vp::Block *client);
 
+        /**
+         * @brief Get the partition simulated by this engine
+         *
+         * @return The partition, or NULL if the simulation is not parallel.
+         */
+        vp::TimePartition *get_partition() { return this->partition; }
+
     private:
         int64_t run();
 
@@ -110,10 +126,13 @@ namespace vp
         int64_t exec();
         void flush_all();
 
-        // List of clients having time events to execute.
+        void get_stats(gv::TimeEngineStats &stats);
+        void reset_stats();
+
+        // Queue of clients having time events to execute.
         // They are sorted out according to the timestamp of their first event,
         // from lowest to highest
-        vp::Block *first_client = NULL;
+        vp::TimeQueue clients;
 
         // Current time of the engine. This gives the absolute time of the platform
         int64_t time = 0;
@@ -133,5 +152,11 @@ namespace vp
 
         // Pointer to the top launcher
         gv::Gvsoc_user *launcher = NULL;
+
+        // Partition simulated by this engine, in parallel mode
+        vp::TimePartition *partition = NULL;
+
+        // Statistics, always counted. The queue size is only filled when they are reported.
+        gv::TimeEngineStats stats;
     };
 };
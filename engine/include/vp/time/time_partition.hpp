@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <set>
+#include <string>
+
+namespace js
+{
+    class Config;
+};
+
+namespace vp
+{
+    class Block;
+    class Component;
+    class TimeEngine;
+    class TimeEvent;
+    class ClockEngine;
+    class TraceEngine;
+    class PowerEngine;
+    class PartitionMessage;
+    class ParallelEngine;
+
+    // Default synchronization quantum in picoseconds, used when it is not specified and no
+    // crossing binding gives a clock period
+    #define VP_PARALLEL_DEFAULT_QUANTUM 1000000
+
+    // Default number of messages that a mailbox can hold before spilling to its overflow list
+    #define VP_PARALLEL_MAILBOX_SIZE 1024
+
+    // Number of iterations a thread is polling a synchronization variable before sleeping
+    #define VP_PARALLEL_SPIN_COUNT 10000
+
+    // Size of the value that a message can carry
+    #define VP_PARTITION_MESSAGE_DATA_SIZE 16
+
+    typedef void (PartitionMessageMeth)(vp::PartitionMessage *msg);
+
+    /**
+     * @brief Message sent from one partition to another
+     *
+     * This is used by port stubs to transform a call crossing partitions into a call executed
+     * later on by the receiving partition.
+     */
+    class PartitionMessage
+    {
+    public:
+        // Time of the sender when the message was posted
+        int64_t time;
+        // Method called by the receiving partition
+        PartitionMessageMeth *meth;
+        // Arguments for the method, usually the port and the transported object
+        void *context;
+        void *arg;
+        // Copy of the transported value, for interfaces passing values instead of pointers
+        uint8_t data[VP_PARTITION_MESSAGE_DATA_SIZE];
+    };
+
+    /**
+     * @brief Single-producer single-consumer queue
+     *
+     * This is a lock-free circular buffer which can be used by 2 threads, one pushing and one
+     * popping, without any lock.
+     */
+    template<class T>
+    class SpscQueue
+    {
+    public:
+        SpscQueue(int size);
+        ~SpscQueue();
+
+        // Push an element, return false if the queue is full. Only called by the producer.
+        inline bool push(const T &elem);
+
+        // Pop an element, return false if the queue is empty. Only called by the consumer.
+        inline bool pop(T &elem);
+
+    private:
+        T *elems;
+        uint64_t mask;
+        // Index of the next element to pop, only written by the consumer
+        alignas(64) std::atomic<uint64_t> head;
+        // Index of the next element to push, only written by the producer
+        alignas(64) std::atomic<uint64_t> tail;
+    };
+
+    /**
+     * @brief Mailbox receiving the messages sent from one partition to another one
+     *
+     * The ring is never dropping messages, they are stored in an overflow list owned by the
+     * producer when the ring is full, which is only read once the producer is stopped.
+     */
+    class PartitionMailbox
+    {
+    public:
+        PartitionMailbox(int size) : ring(size) {}
+
+        // Called by the sending partition
+        inline void post(PartitionMessage &msg);
+
+        // Called when both partitions are stopped, in the order they were posted
+        void drain(std::vector<PartitionMessage> &messages);
+
+    private:
+        SpscQueue<PartitionMessage> ring;
+        std::vector<PartitionMessage> overflow;
+    };
+
+    /**
+     * @brief Part of the system simulated by its own time engine
+     *
+     * Partition 0 is the main one, simulated by the engine thread. The other ones are executed
+     * by worker threads, one quantum at a time.
+     */
+    class TimePartition
+    {
+        friend class ParallelEngine;
+
+    public:
+        TimePartition(ParallelEngine *parallel, int id, vp::TimeEngine *engine,
+            std::vector<std::string> paths);
+        ~TimePartition();
+
+        /**
+         * @brief Send a message to another partition
+         *
+         * This must be called from the thread simulating this partition. The message is
+         * delivered at the next synchronization point, in a deterministic order.
+         *
+         * @param to Receiving partition.
+         * @param meth Method called in the receiving partition.
+         * @param context First argument given to the method.
+         * @param arg Second argument given to the method.
+         * @param data Optional value copied into the message.
+         * @param size Size of the value.
+         */
+        void send(TimePartition *to, PartitionMessageMeth *meth, void *context, void *arg,
+            const void *data=NULL, int size=0);
+
+        /**
+         * @brief Get the parallel engine owning this partition
+         */
+        ParallelEngine *get_parallel() { return this->parallel; }
+
+        /**
+         * @brief Get the time engine simulating this partition
+         */
+        vp::TimeEngine *get_engine() { return this->engine; }
+
+        /**
+         * @brief Tell if this is the main partition, simulated by the engine thread
+         */
+        bool is_main() { return this->id == 0; }
+
+        /**
+         * @brief Called by the time engine when it gets a new first client
+         */
+        void wakeup();
+
+    private:
+        void start();
+        void stop();
+        void worker_routine();
+        void run_window(int64_t end);
+        static void window_end_handler(vp::Block *__this, vp::TimeEvent *event);
+        static void delivery_handler(vp::Block *__this, vp::TimeEvent *event);
+
+        ParallelEngine *parallel;
+        int id;
+        vp::TimeEngine *engine;
+        // Path of the components which are the root of this partition
+        std::vector<std::string> paths;
+        // One mailbox per sending partition
+        std::vector<PartitionMailbox *> mailboxes;
+        // Messages received at the last synchronization point and not yet executed
+        std::vector<PartitionMessage> pending;
+        vp::Block *block;
+        // Event pausing the engine at the end of the window
+        vp::TimeEvent *window_event;
+        // Event executing the received messages
+        vp::TimeEvent *delivery_event;
+        std::thread *thread = NULL;
+        // Last window executed by the worker thread
+        int64_t window_id = 0;
+        // True once the quit request of this partition has been forwarded to the main engine
+        bool quit_forwarded = false;
+    };
+
+    /**
+     * @brief Parallel simulation engine
+     *
+     * This splits the system into partitions, each one with its own time engine. Partitions
+     * are executed in parallel by windows of time, and exchange messages only at the end of
+     * each window, so that the simulation is deterministic whatever the number of threads
+     * and the size of the windows.
+     * The size of the window, called quantum, is the maximum latency added to an interaction
+     * crossing partitions. If it is not specified, the smallest clock period of the domains
+     * connected by a crossing binding is used.
+     */
+    class ParallelEngine
+    {
+        friend class TimePartition;
+
+    public:
+        ParallelEngine(js::Config *config, vp::TimeEngine *main_engine,
+            vp::TraceEngine *trace_engine, vp::PowerEngine *power_engine);
+        ~ParallelEngine();
+
+        /**
+         * @brief Get the time engine of a new component
+         *
+         * @param path Path of the component.
+         * @param parent_engine Time engine of the parent component.
+         * @return The engine of the partition whose root is this component, or the parent
+         *   engine if the component is not a partition root.
+         */
+        vp::TimeEngine *get_engine(std::string path, vp::TimeEngine *parent_engine);
+
+        /**
+         * @brief Register a binding crossing 2 partitions
+         *
+         * The clock engines are used to compute the synchronization quantum when it is not
+         * specified.
+         */
+        void add_crossing(vp::ClockEngine *master, vp::ClockEngine *slave);
+
+        /**
+         * @brief Start the worker threads
+         *
+         * This must be called once the system is built.
+         */
+        void start(vp::Component *top);
+
+        /**
+         * @brief Stop the worker threads
+         */
+        void stop();
+
+        /**
+         * @brief Wait until all worker threads are done with the current window
+         *
+         * This must be called before the models are accessed from the main thread outside
+         * of the simulation loop.
+         */
+        void sync();
+
+        /**
+         * @brief Tell if worker threads are simulating partitions
+         *
+         * Before the first window, the whole system is still accessed by the main thread only,
+         * for example during reset, so calls crossing partitions can be done directly.
+         */
+        bool is_concurrent() { return this->concurrent; }
+
+    private:
+        static void quantum_handler(vp::Block *__this, vp::TimeEvent *event);
+        void check_partitions(vp::Block *block);
+        void exchange();
+        int64_t get_quantum();
+        void wakeup();
+        void spin_wait(std::function<bool()> cond);
+        void notify();
+
+        std::vector<TimePartition *> partitions;
+        vp::TraceEngine *trace_engine;
+        vp::PowerEngine *power_engine;
+        // Quantum specified by the user, 0 to compute it from the crossing bindings
+        int64_t quantum;
+        int mailbox_size;
+        std::set<vp::ClockEngine *> crossing_engines;
+        vp::Block *block;
+        // Event executed at the end of each window by the main engine
+        vp::TimeEvent *quantum_event;
+        bool started = false;
+        // True once the first window has been started
+        bool concurrent = false;
+        // True when no partition has anything to execute and the quantum event is stopped
+        bool idle = false;
+
+        // Synchronization with worker threads
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::atomic<int64_t> window_id;
+        std::atomic<int> nb_running;
+        int64_t window_end = 0;
+        std::atomic<bool> exit;
+    };
+};
+
+template<class T>
+vp::SpscQueue<T>::SpscQueue(int size) : head(0), tail(0)
+{
+    int real_size = 1;
+    while (real_size < size)
+    {
+        real_size <<= 1;
+    }
+    this->elems = new T[real_size];
+    this->mask = real_size - 1;
+}
+
+template<class T>
+vp::SpscQueue<T>::~SpscQueue()
+{
+    delete[] this->elems;
+}
+
+template<class T>
+inline bool vp::SpscQueue<T>::push(const T &elem)
+{
+    uint64_t tail = this->tail.load(std::memory_order_relaxed);
+    if (tail - this->head.load(std::memory_order_acquire) > this->mask)
+    {
+        return false;
+    }
+    this->elems[tail & this->mask] = elem;
+    this->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template<class T>
+inline bool vp::SpscQueue<T>::pop(T &elem)
+{
+    uint64_t head = this->head.load(std::memory_order_relaxed);
+    if (head == this->tail.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    elem = this->elems[head & this->mask];
+    this->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+inline void vp::PartitionMailbox::post(vp::PartitionMessage &msg)
+{
+    // Once the ring is full, keep on using the overflow list until the mailbox is drained
+    // to preserve the ordering
+    if (!this->overflow.empty() || !this->ring.push(msg))
+    {
+        this->overflow.push_back(msg);
+    }
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Maximum number of clients for which the queue is kept sorted
+#define TIME_QUEUE_SORTED_MAX 16
+
+namespace vp
+{
+    class Block;
+
+    /**
+     * @brief Queue of time engine clients
+     *
+     * Clients are sorted according to the timestamp of their next event. Blocks with the same
+     * timestamp are elected in the reverse order of their insertion, which is the order which
+     * was given by the previous sorted list, so that simulation results do not depend on the
+     * queue implementation.
+     * As long as the queue is small, which is the case on most platforms, it is kept fully
+     * sorted in the reverse order of election, so that the first client is taken from the end
+     * without moving the others. The operations on this sorted array are inlined, since
+     * browsing a few entries is cheaper than calling them.
+     * Bigger queues are turned into a binary min-heap, so that the time engine can insert,
+     * remove and elect clients in O(log n). Each block then stores its position in the heap
+     * so that it can be removed without browsing the queue.
+     */
+    class TimeQueue
+    {
+    public:
+        TimeQueue() { this->heap.reserve(TIME_QUEUE_SORTED_MAX); }
+
+        /**
+         * @brief Tell if the queue is empty
+         */
+        inline bool empty() { return this->heap.size() == 0; }
+
+        /**
+         * @brief Get the number of clients in the queue
+         */
+        inline int size() { return this->heap.size(); }
+
+        /**
+         * @brief Get the client with the lowest timestamp, or NULL if the queue is empty
+         */
+        inline vp::Block *first();
+
+        /**
+         * @brief Insert a client
+         *
+         * @param client The client to insert, its next event time must already be set.
+         * @param behind_first True if the client must be elected just after the first one in
+         *   case they have the same timestamp.
+         */
+        inline void push(vp::Block *client, bool behind_first=false);
+
+        /**
+         * @brief Remove the first client and insert a new one in the same operation
+         *
+         * @param client The client to insert, its next event time must already be set.
+         * @param behind_first True if the client must be elected just after the removed one in
+         *   case they have the same timestamp.
+         */
+        inline void replace_first(vp::Block *client, bool behind_first);
+
+        /**
+         * @brief Remove and return the client with the lowest timestamp
+         */
+        inline vp::Block *pop();
+
+        /**
+         * @brief Remove a client from any position in the queue
+         */
+        void remove(vp::Block *client);
+
+    private:
+        // Heap entries keep a copy of the ordering key so that comparisons do not need to
+        // access the blocks. The sequence number is only used in heap mode, the sorted array
+        // gives the order of clients with the same timestamp from their position.
+        class Entry
+        {
+        public:
+            int64_t time;
+            int64_t seq;
+            vp::Block *client;
+        };
+
+        // Insert the new entry in the sorted array, where its slot is at the specified index
+        // and the entries before it are elected after it
+        inline void sorted_insert(int index, Entry &entry);
+
+        // Heap mode versions of the operations, used once the queue gets too big
+        void heap_push(vp::Block *client, bool behind_first);
+        void heap_replace_first(vp::Block *client, bool behind_first);
+        vp::Block *heap_pop();
+
+        // Return true if entry a must be elected before entry b
+        inline bool before(Entry &a, Entry &b);
+
+        // Store an entry at the specified position of the heap and update the client index
+        inline void set(int index, Entry &entry);
+
+        void sift_up(int index);
+
+        void sift_down(int index);
+
+        // Turn the sorted array into a heap
+        void heapify();
+
+        // Sort the heap, to switch back to the sorted mode
+        void sort();
+
+        // Clients, either sorted in the reverse order of election, or stored as an implicit
+        // binary tree where the first one has the lowest timestamp
+        std::vector<Entry> heap;
+
+        // True if the queue is a sorted array. This is the case as long as it does not
+        // contain more than TIME_QUEUE_SORTED_MAX clients.
+        bool sorted = true;
+
+        // Insertion sequence number, decremented at each insertion so that the last inserted
+        // client is elected first when several clients have the same timestamp
+        int64_t seq = 0;
+    };
+};
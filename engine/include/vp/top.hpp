@@ -43,12 +43,28 @@ namespace vp {
 
     void flush();
     void start();
+    void stop();
+
+    // Report the statistics of the time engines, clock engines and IO request pools
+    void get_engine_stats(gv::EngineStats &stats);
+    // Clear the statistics of the time and clock engines
+    void reset_engine_stats();
+
+    // Save the state of the whole platform into a checkpoint file
+    bool checkpoint_save(std::string path);
+    // Restore the state of the whole platform from a checkpoint file saved by the same platform
+    bool checkpoint_restore(std::string path);
 
   private:
+      void get_blocks(vp::Block *block, std::vector<vp::Block *> &blocks);
+      void get_clock_engines(vp::Block *block, std::vector<vp::ClockEngine *> &engines);
+      void get_time_engines(std::vector<vp::TimeEngine *> &engines);
+
       vp::TimeEngine *time_engine;
       vp::TraceEngine *trace_engine;
       vp::PowerEngine *power_engine;
       vp::MemCheck *memcheck;
+      vp::ParallelEngine *parallel_engine;
   };
 
 };
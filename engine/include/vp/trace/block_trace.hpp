@@ -58,6 +58,8 @@ namespace vp
 
         void new_trace_event_real(std::string name, Trace *trace);
 
+        void new_trace_binary(std::string name, Trace *trace);
+
         inline TraceEngine *get_trace_engine();
 
         std::map<std::string, Trace *> traces;
@@ -23,10 +23,18 @@
 #define __VP_TRACE_EVENT_DUMPER_HPP__
 
 #include <stdio.h>
+#include <pthread.h>
+#include <thread>
+#include <queue>
+#include <vector>
 #include <unordered_map>
 #include <gv/gvsoc.hpp>
+#include <gv/tracedb.hpp>
 #include "vp/json.hpp"
 #include <string>
+#include <string.h>
+
+class BenchPlatform;
 
 namespace vp {
 
@@ -35,15 +43,60 @@ namespace vp {
   class Event_file 
   {
   public:
+    virtual ~Event_file();
     virtual void dump(int64_t timestamp, int id, uint8_t *event, int width, bool is_real, bool is_string, uint8_t flags, uint8_t *flag_mask) {}
     virtual void close() {}
     virtual void add_trace(std::string name, int id, int width, bool is_real, bool is_string) {}
 
+    // Start a thread dedicated to this file. Value changes are then batched by the event thread
+    // and encoded by this writer thread.
+    void start_writer(Event_dumper *dumper);
+    // Declare a trace, taking care of the writer thread if any
+    void reg_trace(std::string name, int id, int width, bool is_real, bool is_string);
+    // Dump a value change, either directly or through the writer thread
+    inline void push(int64_t timestamp, int id, uint8_t *event, int width, bool is_real, bool is_string, uint8_t flags, uint8_t *flag_mask);
+    // Hand the current batch of value changes to the writer thread
+    void flush_batch();
+    // Wait until the writer thread has dumped everything, stop it and close the file
+    void stop();
+
   protected:
 
     int64_t last_timestamp = -1;
     FILE *file;
     bool header_dumped = false;
+
+  private:
+    // Header of each value change in a batch, followed by the value and the flags mask
+    typedef struct
+    {
+      int64_t timestamp;
+      int32_t id;
+      int32_t width;
+      int32_t size;
+      uint8_t is_real;
+      uint8_t is_string;
+      uint8_t flags;
+    } Event_file_record;
+
+    void writer_routine();
+    void dump_batch(std::vector<uint8_t> *batch);
+    // Wait until the writer thread has dumped everything, join it and free the batches
+    void writer_stop();
+
+    Event_dumper *dumper;
+    std::thread *writer = NULL;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    // Protects the file itself, since traces can be declared while the writer thread is dumping
+    pthread_mutex_t dump_mutex;
+    // Batch being filled by the event thread
+    std::vector<uint8_t> *batch = NULL;
+    // Batches waiting for the writer thread, and batches which can be reused
+    std::queue<std::vector<uint8_t> *> ready_batches;
+    std::vector<std::vector<uint8_t> *> free_batches;
+    int nb_batches = 0;
+    bool writer_end = false;
   };
 
   class Event_trace
@@ -51,7 +104,7 @@ namespace vp {
   public:
     Event_trace(std::string trace_name, Event_file *file, int width, bool is_real, bool is_string);
     void reg(int64_t timestamp, uint8_t *event, int width, uint8_t flags, uint8_t *flag_mask);
-    inline void dump(int64_t timestamp) { if (this->buffer) file->dump(timestamp, id, this->buffer, this->width, this->is_real, this->is_string, this->flags, this->flags_mask); }
+    inline void dump(int64_t timestamp) { if (this->buffer) file->push(timestamp, id, this->buffer, this->width, this->is_real, this->is_string, this->flags, this->flags_mask); }
     std::string trace_name;
     bool is_real = false;
     bool is_string;
@@ -73,13 +126,28 @@ namespace vp {
 
   class Event_dumper
   {
+    friend class ::BenchPlatform;
+
   public:
-    Event_dumper(js::Config *config) : config(config) { this->user_vcd = NULL; }
+    Event_dumper(js::Config *config) : config(config)
+    {
+      this->user_vcd = NULL;
+      // Writer threads only pay off if they can run in parallel with the event thread
+      this->parallel = config->get_child_bool("**/events/parallel") &&
+        std::thread::hardware_concurrency() > 1;
+    }
+    ~Event_dumper();
     Event_trace *get_trace(std::string trace_name, std::string file_name, int width, bool is_real=false, bool is_string=false);
     Event_trace *get_trace_real(std::string trace_name, std::string file_name);
     Event_trace *get_trace_string(std::string trace_name, std::string file_name);
     void close();
+    // Hand the pending value changes of all files to their writer threads
+    void flush();
+    // Called by the event thread when a file gets its first value change in its current batch
+    void set_file_pending(Event_file *file) { this->pending_files.push_back(file); }
     void set_vcd_user(gv::Vcd_user *user, bool is_external_dumper);
+    // Tell if each file is written by its own thread
+    bool is_parallel() { return this->parallel; }
 
   private:
     std::map<std::string, Event_trace *> event_traces;
@@ -87,6 +155,10 @@ namespace vp {
     gv::Vcd_user *user_vcd;
     js::Config *config;
     bool is_external_dumper = false;
+    bool parallel = false;
+    // Files with value changes not yet handed to their writer thread. This is only accessed by
+    // the event thread, while files can be created by the simulation thread.
+    std::vector<Event_file *> pending_files;
   };
 
   class Vcd_file : public Event_file
@@ -144,6 +216,97 @@ namespace vp {
     std::unordered_map<int, void *> traces;
   };
 
+
+  // Columnar trace database, see gv/tracedb.hpp for the format
+  class Tdb_file : public Event_file
+  {
+  public:
+    Tdb_file(Event_dumper *dumper, std::string path, js::Config *config);
+    void close();
+    void add_trace(std::string name, int id, int width, bool is_real, bool is_string);
+    void dump(int64_t timestamp, int id, uint8_t *event, int width, bool is_real, bool is_string, uint8_t flags, uint8_t *flag_mask);
+
+  private:
+    class Tdb_trace
+    {
+    public:
+      std::string path;
+      int id;
+      int type;
+      int width;
+      // Size of each value for logical and real traces
+      int value_size;
+      int64_t nb_events = 0;
+      // Columns of the chunk being filled
+      std::vector<int64_t> timestamps;
+      std::vector<uint8_t> flags;
+      std::vector<uint8_t> values;
+      std::vector<uint32_t> string_offsets;
+      std::vector<gv::TraceDbIndexEntry> index;
+    };
+
+    void write(const void *data, size_t size);
+    void flush_chunk(Tdb_trace *trace);
+
+    std::unordered_map<int, Tdb_trace *> traces;
+    int chunk_events;
+    bool compress;
+    uint64_t offset = 0;
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> compressed;
+  };
+
 };
 
+// Above this size, a batch of value changes is handed to the writer thread without waiting for
+// the end of the current buffer of events
+#define EVENT_FILE_BATCH_SIZE (64*1024)
+// Maximum number of batches in flight for a file, after which the event thread waits for the
+// writer thread
+#define EVENT_FILE_NB_BATCH 16
+
+inline void vp::Event_file::push(int64_t timestamp, int id, uint8_t *event, int width, bool is_real, bool is_string, uint8_t flags, uint8_t *flag_mask)
+{
+  if (this->writer == NULL)
+  {
+    this->dump(timestamp, id, event, width, is_real, is_string, flags, flag_mask);
+    return;
+  }
+
+  // Strings contain the terminating character and reals are stored as doubles. Other values
+  // are copied with at least 8 bytes since some formats read them as integers.
+  int bytes = is_real ? sizeof(double) : is_string ? width / 8 : (width + 7) / 8;
+  int size = (bytes + 7) & ~7;
+  if (size == 0) size = 8;
+
+  std::vector<uint8_t> *batch = this->batch;
+  size_t offset = batch->size();
+  if (offset == 0)
+  {
+    this->dumper->set_file_pending(this);
+  }
+  batch->resize(offset + sizeof(Event_file_record) + size * (flags == 1 ? 2 : 1));
+
+  uint8_t *data = batch->data() + offset;
+  Event_file_record *record = (Event_file_record *)data;
+  record->timestamp = timestamp;
+  record->id = id;
+  record->width = width;
+  record->size = size;
+  record->is_real = is_real;
+  record->is_string = is_string;
+  record->flags = flags;
+  data += sizeof(Event_file_record);
+  memcpy(data, event, bytes);
+  if (flags == 1)
+  {
+    memcpy(data + size, flag_mask, bytes);
+  }
+
+  if (batch->size() >= EVENT_FILE_BATCH_SIZE)
+  {
+    this->flush_batch();
+  }
+}
+
 #endif
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __VP_TRACE_FLIGHT_RECORDER_HPP__
+#define __VP_TRACE_FLIGHT_RECORDER_HPP__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string>
+#include <atomic>
+
+namespace vp {
+
+    class Trace;
+    class TraceEngine;
+
+    // The memory of the flight recorder is split into blocks, which are reused in a circular way,
+    // so that only whole blocks of the oldest records are overwritten
+    #define FLIGHT_RECORDER_BLOCK_SIZE (64*1024)
+    // Records are truncated to this size, so that a record always fits in the rest of a block
+    #define FLIGHT_RECORDER_MAX_RECORD 4096
+
+    #define FLIGHT_RECORDER_RECORD_MSG          0
+    #define FLIGHT_RECORDER_RECORD_EVENT        1
+    #define FLIGHT_RECORDER_RECORD_EVENT_STRING 2
+
+    typedef struct
+    {
+        // Size of the record including this header, aligned on 8 bytes
+        uint16_t size;
+        uint8_t kind;
+        // Message level, or 1 if an event is high impedance
+        uint8_t info;
+        uint32_t reserved;
+        vp::Trace *trace;
+        int64_t timestamp;
+        int64_t cycles;
+    } FlightRecorderRecord;
+
+    /**
+     * In-memory circular buffer of trace messages and events.
+     *
+     * Messages are stored in binary form, as their format string followed by their arguments,
+     * and are only formatted when the recorder is dumped, so that recording them costs much less
+     * than printing them.
+     * All methods must be called from the engine thread or with the engine locked, except
+     * request_dump.
+     */
+    class FlightRecorder
+    {
+    public:
+        FlightRecorder(vp::TraceEngine *engine, size_t size, std::string path);
+        ~FlightRecorder();
+
+        void record_msg(vp::Trace *trace, int level, const char *fmt, va_list ap);
+        void record_event(vp::Trace *trace, int64_t timestamp, int64_t cycles, uint8_t *value,
+            bool highz);
+        void record_event_string(vp::Trace *trace, int64_t timestamp, int64_t cycles,
+            const char *value);
+
+        // Format all records to the output file, from the oldest one, and clear them
+        void dump(std::string reason);
+
+        // Ask for a dump when the engine is destroyed. This can be called from any thread.
+        void request_dump() { this->dump_requested = true; }
+        bool is_dump_requested() { return this->dump_requested; }
+
+    private:
+        // Return where the next record can be written, with at least FLIGHT_RECORDER_MAX_RECORD
+        // bytes available
+        inline uint8_t *alloc();
+        inline void commit(uint8_t *end);
+        inline FlightRecorderRecord *record_header(uint8_t *buffer, int kind, int info,
+            vp::Trace *trace, int64_t timestamp, int64_t cycles);
+        void next_block();
+        void dump_record(FlightRecorderRecord *record);
+        void dump_msg(FlightRecorderRecord *record, uint8_t *data, uint8_t *end);
+
+        vp::TraceEngine *engine;
+        std::string path;
+        FILE *file = NULL;
+        uint8_t *blocks;
+        int nb_blocks;
+        // Number of bytes used in each block
+        uint32_t *block_used;
+        int current_block = 0;
+        uint8_t *current;
+        uint8_t *current_end;
+        // Number of times a block with older records was reused
+        int64_t nb_overwritten = 0;
+        std::atomic<bool> dump_requested{false};
+    };
+
+};
+
+#endif
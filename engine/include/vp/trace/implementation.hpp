@@ -97,6 +97,13 @@ namespace vp {
   }
 
 
+  inline uint8_t *vp::Trace::binary_alloc(int size)
+  {
+    return this->comp->traces.get_trace_engine()->get_binary_buffer(this, comp->time.get_time(),
+      comp->clock.get_engine() ? comp->clock.get_cycles() : -1, size);
+  }
+
+
   inline void vp::Trace::user_msg(const char *fmt, ...) {
     #if 0
     fprintf(trace_file, "%ld: %ld: [\033[34m%-*.*s\033[0m] ", comp->clock.get_engine()->time.get_time(), comp->clock.get_engine()->get_cycles(), max_trace_len, max_trace_len, comp->get_path());
@@ -109,6 +116,7 @@ namespace vp {
 
   inline void vp::Trace::fatal(const char *fmt, ...)
   {
+    comp->traces.get_trace_engine()->flight_recorder_dump("fatal");
     dump_fatal_header();
     va_list ap;
     va_start(ap, fmt);
@@ -157,14 +165,31 @@ namespace vp {
   #endif
   }
 
+  inline bool vp::Trace::get_msg_active(int level)
+  {
+  #ifdef VP_TRACE_ACTIVE
+    return level <= VP_TRACE_LEVEL_COMPILED && __builtin_expect(this->is_active, 0) &&
+      comp->traces.get_trace_engine()->get_trace_level() >= level;
+  #else
+    return false;
+  #endif
+  }
+
   inline void vp::Trace::msg(const char *fmt, ...) 
   {
   #ifdef VP_TRACE_ACTIVE
-  	if (is_active && comp->traces.get_trace_engine()->get_trace_level() >= this->level)
+  	if (this->level <= VP_TRACE_LEVEL_COMPILED && __builtin_expect(is_active, 0) &&
+      comp->traces.get_trace_engine()->get_trace_level() >= this->level)
     {
-      dump_header();
       va_list ap;
       va_start(ap, fmt);
+      if (this->recorder)
+      {
+        this->recorder->record_msg(this, this->level, fmt, ap);
+        va_end(ap);
+        return;
+      }
+      dump_header();
       if (vfprintf(this->trace_file, fmt, ap) < 0) {}
       va_end(ap);  
     }
@@ -174,8 +199,16 @@ namespace vp {
   inline void vp::Trace::msg(int level, const char *fmt, ...) 
   {
   #ifdef VP_TRACE_ACTIVE
-    if (is_active && comp->traces.get_trace_engine()->get_trace_level() >= level)
+    if (this->get_msg_active(level))
     {
+      if (this->recorder)
+      {
+        va_list ap;
+        va_start(ap, fmt);
+        this->recorder->record_msg(this, level, fmt, ap);
+        va_end(ap);
+        return;
+      }
       dump_header();
       if (level == vp::Trace::LEVEL_ERROR)
       {
@@ -27,18 +27,27 @@
 #include <functional>
 #include <vector>
 
+// Most verbose trace level compiled into the models, from 0 for errors to 4 for everything.
+// Messages of a higher level are removed at compile time. This is set with the CMake variable
+// GVSOC_TRACE_LEVEL.
+#ifndef VP_TRACE_LEVEL_COMPILED
+#define VP_TRACE_LEVEL_COMPILED 4
+#endif
+
 namespace vp {
 
   #define BUFFER_SIZE (1<<16)
 
   class TraceEngine;
   class Component;
+  class FlightRecorder;
 
   class Trace
   {
 
     friend class BlockTrace;
     friend class TraceEngine;
+    friend class FlightRecorder;
 
   public:
 
@@ -70,6 +79,11 @@ namespace vp {
     inline void event_string(const char *value, bool realloc);
     inline void event_real(double value);
 
+    // Allocate a record of the specified size in the binary trace. The record is written to the
+    // trace file by the event thread, with the current timestamp and cycles, so that the caller
+    // only has to fill it.
+    inline uint8_t *binary_alloc(int size);
+
     void register_callback(std::function<void()> callback) { this->callbacks.push_back(callback); }
 
     inline std::string get_name() { return this->name; }
@@ -84,6 +98,9 @@ namespace vp {
     void set_active(bool active);
     void set_event_active(bool active);
 
+    // Tell if a message of the specified level would be dumped
+    inline bool get_msg_active(int level);
+
   #ifndef VP_TRACE_ACTIVE
     inline bool get_active() { return false; }
     inline bool get_active(int level) { return false; }
@@ -100,6 +117,8 @@ namespace vp {
     Event_trace *event_trace = NULL;
     bool is_real = false;
     bool is_string = false;
+    // Binary traces dump records instead of messages, see binary_alloc
+    bool is_binary = false;
     int id;
     FILE *trace_file = stdout;
     int is_event;
@@ -122,6 +141,10 @@ namespace vp {
     std::string full_path;
     std::vector<std::function<void()>> callbacks;
     vp::Trace *clock_trace = NULL;
+    // Set once the trace has been declared in its binary trace file
+    bool binary_declared = false;
+    // When set, messages are stored into this flight recorder instead of being printed
+    FlightRecorder *recorder = NULL;
   };
 
 
@@ -154,6 +177,15 @@ namespace vp {
       exit(1);                                     \
     }
 
+// Same as msg, except that the arguments are only evaluated if the message is dumped, and that
+// the call is removed at compile time if the level is above VP_TRACE_LEVEL_COMPILED.
+// This should be preferred to msg on hot paths.
+#define vp_trace_msg(trace_ptr, level, args...)          \
+  do {                                                  \
+    if ((trace_ptr)->get_msg_active(level))             \
+      (trace_ptr)->msg(level, args);                    \
+  } while (0)
+
 #ifndef VP_TRACE_ACTIVE
 #define vp_assert(cond, trace, msg...)
 #else
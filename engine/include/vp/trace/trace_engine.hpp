@@ -24,11 +24,13 @@
 
 #include "vp/component.hpp"
 #include "vp/trace/trace.hpp"
+#include "vp/trace/flight_recorder.hpp"
+#include "vp/trace/trace_path_matcher.hpp"
 #include "gv/gvsoc.hpp"
 #include <pthread.h>
 #include <thread>
 #include <regex.h>
-#include <queue>
+#include <atomic>
 
 namespace vp {
 
@@ -39,16 +41,46 @@ namespace vp {
     #define TRACE_FORMAT_LONG  0
     #define TRACE_FORMAT_SHORT 1
 
-    class trace_regex
+    // Binary trace files start with this magic and version, followed by the trace format, and
+    // then contain a sequence of records, each one starting with a TraceBinaryRecord header.
+    #define TRACE_BINARY_MAGIC   "GVTRACE"
+    #define TRACE_BINARY_VERSION 1
+
+    // Record declaring a trace, its content is the maximum path length used for aligning
+    // traces, as a 32bits value, followed by the path of the trace
+    #define TRACE_BINARY_RECORD_DECLARE 0
+    // Record containing data dumped by a model through binary_alloc
+    #define TRACE_BINARY_RECORD_DATA    1
+
+    typedef struct
     {
-    public:
-        trace_regex(std::string path, regex_t *regex, std::string file_path, bool is_path=false) : is_path(is_path), path(path), regex(regex), file_path(file_path) {}
+        uint32_t kind;
+        uint32_t trace_id;
+        uint32_t size;
+        int64_t timestamp;
+        int64_t cycles;
+    } __attribute__((packed)) TraceBinaryRecord;
+
+    // Header of binary records in the event buffers, just after the trace
+    typedef struct
+    {
+        int32_t size;
+        int64_t timestamp;
+        int64_t cycles;
+    } __attribute__((packed)) TraceBinaryEvent;
 
-        bool is_path;
-        std::string path;
-        regex_t *regex;
-        std::string file_path;
-    };
+    // Counters of the ring of event buffers shared with the event thread
+    typedef struct
+    {
+        // Buffers filled by the simulation and handed to the event thread
+        int64_t nb_produced;
+        // Buffers processed by the event thread and given back to the simulation
+        int64_t nb_consumed;
+        // Times the simulation had to wait for the event thread because the ring was full
+        int64_t nb_stalled;
+        // Buffers whose events were discarded because the ring was full, in drop mode
+        int64_t nb_dropped;
+    } TraceEngineStats;
 
     class TraceEngine
     {
@@ -72,6 +104,9 @@ namespace vp {
         static void dump_event_64_external(vp::TraceEngine *__this, vp::Trace *trace, int64_t timestamp, int64_t cycles, uint8_t *event, uint8_t *flags);
         static void dump_event_string_external(vp::TraceEngine *__this, vp::Trace *trace, int64_t timestamp, int64_t cycles, uint8_t *event, int flags, bool realloc);
 
+        static void dump_event_recorder(vp::TraceEngine *__this, vp::Trace *trace, int64_t timestamp, int64_t cycles, uint8_t *event, uint8_t *flags);
+        static void dump_event_string_recorder(vp::TraceEngine *__this, vp::Trace *trace, int64_t timestamp, int64_t cycles, uint8_t *event, int flags, bool realloc);
+
         static uint8_t *parse_event(vp::TraceEngine *__this, vp::Trace *trace, uint8_t *buffer, bool &unlock);
         static uint8_t *parse_event_1(vp::TraceEngine *__this, vp::Trace *trace, uint8_t *buffer, bool &unlock);
         static uint8_t *parse_event_8(vp::TraceEngine *__this, vp::Trace *trace, uint8_t *buffer, bool &unlock);
@@ -96,6 +131,7 @@ namespace vp {
         void add_paths(int events, int nb_path, const char **paths);
         void add_path(int events, const char *path, bool is_path=false);
         void add_exclude_path(int events, const char *path);
+        void add_binary_path(std::string path);
         void add_trace_path(int events, std::string path);
         void conf_trace(int event, std::string path, bool enabled);
         void add_exclude_trace_path(int events, std::string path);
@@ -122,6 +158,19 @@ namespace vp {
 
         bool is_memcheck_enabled() { return this->memcheck_enabled; }
 
+        inline uint8_t *get_binary_buffer(vp::Trace *trace, int64_t timestamp, int64_t cycles,
+            int size);
+
+        // Get the counters of the ring of event buffers. The consumed count is only final once
+        // the engine is destroyed.
+        void get_stats(vp::TraceEngineStats *stats);
+
+        // Flight recorder, or NULL if it is disabled
+        vp::FlightRecorder *get_flight_recorder() { return this->flight_recorder; }
+        // Dump the content of the flight recorder, if it is enabled. Must be called from the
+        // engine thread or with the engine locked.
+        void flight_recorder_dump(std::string reason);
+
     protected:
         std::map<std::string, Trace *> traces_map;
         std::vector<Trace *> traces_array;
@@ -131,12 +180,25 @@ namespace vp {
         bool werror;
 
     private:
+        // Activate or deactivate a trace depending on the patterns matching it
         void check_trace_active(vp::Trace *trace, int event = 0);
-
-        std::unordered_map<std::string, trace_regex *> trace_regexs;
-        std::unordered_map<std::string, trace_regex *> trace_exclude_regexs;
-        std::unordered_map<std::string, trace_regex *> events_path_regex;
-        std::unordered_map<std::string, trace_regex *> events_exclude_path_regex;
+        // Get the sets of patterns which can include or exclude a trace
+        void get_trace_matchers(vp::Trace *trace, vp::TracePathMatcher **includes,
+            vp::TracePathMatcher **excludes);
+        // Add or remove a pattern, and update the patterns matching each trace. The activation
+        // of the modified traces is only updated by check_traces.
+        void add_pattern(vp::TracePathMatcher *matcher, vp::trace_regex *regex);
+        void remove_pattern(vp::TracePathMatcher *matcher, std::string path);
+
+        vp::TracePathMatcher trace_regexs;
+        vp::TracePathMatcher trace_exclude_regexs;
+        vp::TracePathMatcher binary_trace_regexs;
+        vp::TracePathMatcher events_path_regex;
+        vp::TracePathMatcher events_exclude_path_regex;
+        // Patterns matching each trace, indexed by trace id
+        std::vector<vp::TracePathMatches> trace_matches;
+        // Traces whose matching patterns changed since the last check_traces
+        std::vector<vp::Trace *> dirty_traces;
         int max_path_len = 0;
         vp::TraceLevel trace_level = vp::TRACE;
         std::vector<vp::Trace *> init_traces;
@@ -161,9 +223,34 @@ namespace vp {
         // This mechanism is used to merged different values of the same trace dumped during
         // the same timestamp.
         void flush_event_traces(int64_t timestamp);
+        // Called by the event thread to write a binary record to the trace file
+        uint8_t *dump_binary_event(vp::Trace *trace, uint8_t *buffer);
+        // Get the event trace where the events of a trace are dumped, or NULL if they go to the
+        // flight recorder
+        vp::Event_trace *get_event_trace(vp::Trace *trace, std::string path, std::string file_path);
+
+        // Single-producer single-consumer ring of event buffers. The simulation thread fills
+        // the buffer at ring_head and publishes it by incrementing ring_head, the event thread
+        // processes the buffer at ring_tail and gives it back by incrementing ring_tail.
+        // A thread only takes the mutex to sleep when it has nothing to do, and the other one
+        // only takes it to wake it up.
+        char *ring_acquire();
+        void ring_publish(char *buffer);
+        char *ring_pop();
+        void ring_release();
+
+        char **ring_buffers;
+        int ring_depth;
+        // When the ring is full, events are written to this buffer and discarded instead of
+        // waiting for the event thread
+        bool ring_drop;
+        char *ring_drop_buffer = NULL;
+        std::atomic<uint64_t> ring_head{0};
+        std::atomic<uint64_t> ring_tail{0};
+        std::atomic<bool> producer_waiting{false};
+        std::atomic<bool> consumer_waiting{false};
+        vp::TraceEngineStats ring_stats = {};
 
-        std::queue<char *> event_buffers;
-        std::queue<char *> ready_event_buffers;
         char *current_buffer;
         char *current_buffer_event;
         int current_buffer_size;
@@ -178,6 +265,7 @@ namespace vp {
         bool global_enable = true;
         gv::Vcd_user *vcd_user;
         bool memcheck_enabled;
+        vp::FlightRecorder *flight_recorder = NULL;
     };
 };
 
@@ -195,4 +283,22 @@ char *vp::TraceEngine::get_event_buffer_external(int size)
 
     return result;
 }
+
+uint8_t *vp::TraceEngine::get_binary_buffer(vp::Trace *trace, int64_t timestamp, int64_t cycles,
+    int size)
+{
+    int bytes = sizeof(vp::Trace *) + sizeof(vp::TraceBinaryEvent) + size;
+    uint8_t *buffer = this->use_external_dumper ? (uint8_t *)this->get_event_buffer_external(bytes) :
+        (uint8_t *)this->get_event_buffer(bytes);
+
+    *(vp::Trace **)buffer = trace;
+    buffer += sizeof(vp::Trace *);
+
+    vp::TraceBinaryEvent *event = (vp::TraceBinaryEvent *)buffer;
+    event->size = size;
+    event->timestamp = timestamp;
+    event->cycles = cycles;
+
+    return buffer + sizeof(vp::TraceBinaryEvent);
+}
 #endif
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __VP_TRACE_TRACE_PATH_MATCHER_HPP__
+#define __VP_TRACE_TRACE_PATH_MATCHER_HPP__
+
+#include <stdint.h>
+#include <regex.h>
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+
+namespace vp {
+
+    // Pattern selecting traces from their path. Patterns are POSIX basic regular expressions
+    // searched anywhere in the path, but most of them are plain strings, like "insn" or
+    // ".*/pe0/.*", which are matched without the regex engine.
+    class trace_regex
+    {
+    public:
+        trace_regex(std::string path, std::string file_path, bool is_path=false);
+        ~trace_regex();
+
+        // Tell if the pattern matches the path, without going through the automaton
+        bool match(const std::string &path);
+
+        bool is_path;
+        std::string path;
+        // Compiled regular expression, or NULL if the pattern is a plain string
+        regex_t *regex = NULL;
+        std::string file_path;
+        // Order in which the patterns were added. When several ones match, the last one gives
+        // the file.
+        int64_t id;
+
+    private:
+        friend class TracePathMatcher;
+
+        // Plain string the pattern is reduced to, when it does not need the regex engine
+        std::string literal;
+        bool anchor_start = false;
+        bool anchor_end = false;
+        bool is_invalid = false;
+        // Last match call which reported this pattern, to report it only once per path
+        int64_t match_stamp = -1;
+    };
+
+    // Set of patterns compiled into a single automaton, so that all plain string patterns are
+    // evaluated in one pass over the path, whatever their number.
+    class TracePathMatcher
+    {
+    public:
+        ~TracePathMatcher();
+
+        // Add a pattern. There must be no other one with the same path.
+        void add(trace_regex *regex);
+        // Remove a pattern, without freeing it
+        void remove(trace_regex *regex);
+        // Get the pattern with the specified path, or NULL if there is none
+        trace_regex *get(std::string path);
+        // Append to result all patterns matching the path
+        void match(const std::string &path, std::vector<trace_regex *> &result);
+
+    private:
+        // Build the automaton, which is done lazily on the next match after patterns changed
+        void build();
+
+        std::unordered_map<std::string, trace_regex *> patterns;
+        bool dirty = true;
+        int64_t match_stamp = 0;
+
+        // Aho-Corasick automaton of the plain string patterns. Each state has a complete
+        // transition table for ASCII characters, and the list of patterns ending at this state.
+        std::vector<std::array<int32_t, 128>> transitions;
+        std::vector<std::vector<trace_regex *>> outputs;
+        // Patterns matching any path
+        std::vector<trace_regex *> universal;
+        // Patterns which must be checked one by one
+        std::vector<trace_regex *> others;
+    };
+
+    // Patterns currently matching a trace, so that adding or removing a pattern only requires
+    // checking this pattern against all traces
+    class TracePathMatches
+    {
+    public:
+        std::vector<trace_regex *> includes;
+        std::vector<trace_regex *> excludes;
+        // Set when the activation of the trace must be checked again
+        bool dirty = false;
+    };
+
+};
+
+#endif
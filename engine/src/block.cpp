@@ -22,6 +22,7 @@
 #include <vp/vp.hpp>
 #include <vp/signal.hpp>
 #include <vp/register.hpp>
+#include <vp/checkpoint.hpp>
 #include <algorithm>
 
 vp::BlockObject::BlockObject(Block &parent)
@@ -137,6 +138,193 @@ void vp::Block::reset_all(bool active, bool from_itf)
 
 
 
+static void checkpoint_save_value(vp::CheckpointWriter &writer, uint8_t *value, int nb_bytes)
+{
+    writer.write_u64(nb_bytes);
+    writer.write(value, nb_bytes);
+}
+
+static void checkpoint_restore_value(vp::CheckpointReader &reader, uint8_t *value, int nb_bytes,
+    std::string path, std::string name)
+{
+    if (reader.check_u64(nb_bytes, "size of " + path + "/" + name))
+    {
+        reader.read(value, nb_bytes);
+    }
+}
+
+void vp::Block::checkpoint_save(vp::CheckpointWriter &writer)
+{
+    writer.write_u64(this->registers.size());
+    for (RegisterCommon *reg: this->registers)
+    {
+        checkpoint_save_value(writer, reg->value_bytes, reg->nb_bytes);
+    }
+
+    writer.write_u64(this->signals.size());
+    for (SignalCommon *signal: this->signals)
+    {
+        checkpoint_save_value(writer, signal->value_bytes, signal->nb_bytes);
+    }
+
+    writer.write_u64(this->regs.size());
+    for (vp::reg *reg: this->regs)
+    {
+        checkpoint_save_value(writer, reg->value_bytes, reg->nb_bytes);
+    }
+}
+
+void vp::Block::checkpoint_restore(vp::CheckpointReader &reader)
+{
+    // Values are copied without calling register callbacks, the models state derived from
+    // them is restored by the models themselves
+    reader.check_u64(this->registers.size(), "number of registers of " + this->get_path());
+    for (RegisterCommon *reg: this->registers)
+    {
+        checkpoint_restore_value(reader, reg->value_bytes, reg->nb_bytes, this->get_path(),
+            reg->get_name());
+    }
+
+    reader.check_u64(this->signals.size(), "number of signals of " + this->get_path());
+    for (SignalCommon *signal: this->signals)
+    {
+        checkpoint_restore_value(reader, signal->value_bytes, signal->nb_bytes, this->get_path(),
+            signal->name);
+    }
+
+    reader.check_u64(this->regs.size(), "number of registers of " + this->get_path());
+    for (vp::reg *reg: this->regs)
+    {
+        checkpoint_restore_value(reader, reg->value_bytes, reg->nb_bytes, this->get_path(),
+            reg->get_name());
+    }
+}
+
+void vp::Block::checkpoint_save_events(vp::CheckpointWriter &writer)
+{
+    // Only the stall cycles of clock events are saved here, their clock engine saves them
+    // if they are enqueued, so that the order of its queues is kept
+    writer.write_u64(this->clock.events.size());
+    for (ClockEvent *event: this->clock.events)
+    {
+        writer.write_i64(event->stall_cycle);
+    }
+
+    std::vector<vp::TimeEvent *> &events = this->time.events;
+    int64_t nb_enqueued = 0;
+    for (vp::TimeEvent *event = this->time.first_event; event; event = event->next)
+    {
+        nb_enqueued++;
+    }
+
+    writer.write_u64(events.size());
+    writer.write_u64(nb_enqueued);
+    for (vp::TimeEvent *event = this->time.first_event; event; event = event->next)
+    {
+        writer.write_u64(std::find(events.begin(), events.end(), event) - events.begin());
+        writer.write_i64(event->time);
+    }
+}
+
+void vp::Block::checkpoint_drop_events()
+{
+    for (ClockEvent *event: this->clock.events)
+    {
+        if (event->meth_saved)
+        {
+            event->meth = event->meth_saved;
+            event->meth_saved = NULL;
+        }
+        event->stall_cycle = 0;
+        event->pending_disable = false;
+        event->enqueued = false;
+        event->queue = NULL;
+        event->next = NULL;
+        event->prev = NULL;
+    }
+
+    for (vp::TimeEvent *event: this->time.events)
+    {
+        event->set_enqueued(false);
+        event->next = NULL;
+    }
+    this->time.first_event = NULL;
+
+    if (this->time.is_enqueued)
+    {
+        this->time.time_engine->dequeue(this);
+    }
+}
+
+void vp::Block::checkpoint_restore_events(vp::CheckpointReader &reader)
+{
+    if (!reader.check_u64(this->clock.events.size(), "number of clock events of " + this->get_path()))
+    {
+        return;
+    }
+
+    for (ClockEvent *event: this->clock.events)
+    {
+        int64_t stall_cycle = reader.read_i64();
+        if (stall_cycle != 0)
+        {
+            event->stall_cycle_set(stall_cycle);
+        }
+    }
+
+    std::vector<vp::TimeEvent *> &events = this->time.events;
+    if (!reader.check_u64(events.size(), "number of time events of " + this->get_path()))
+    {
+        return;
+    }
+
+    int64_t nb_enqueued = reader.read_u64();
+    vp::TimeEvent *last = NULL;
+    for (int64_t i = 0; i < nb_enqueued && reader.is_ok(); i++)
+    {
+        uint64_t index = reader.read_u64();
+        int64_t time = reader.read_i64();
+        if (index >= events.size())
+        {
+            reader.set_error("invalid time event of " + this->get_path());
+            return;
+        }
+
+        vp::TimeEvent *event = events[index];
+        event->time = time;
+        event->set_enqueued(true);
+        event->next = NULL;
+        if (last)
+        {
+            last->next = event;
+        }
+        else
+        {
+            this->time.first_event = event;
+        }
+        last = event;
+    }
+
+    if (this->time.first_event)
+    {
+        this->time.enqueue_to_engine(this->time.first_event->time);
+    }
+}
+
+void vp::Block::checkpoint_shift_events(int64_t delta)
+{
+    int64_t next_event_time = this->time.next_event_time + delta;
+
+    for (vp::TimeEvent *event = this->time.first_event; event; event = event->next)
+    {
+        event->time += delta;
+    }
+
+    this->time.enqueue_to_engine(next_event_time);
+}
+
+
+
 void vp::Block::add_block(Block *block)
 {
     this->childs.push_back(block);
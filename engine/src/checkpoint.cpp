@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <zlib.h>
+#include <vp/checkpoint.hpp>
+
+// gzip functions take sizes as unsigned int, big memories are transferred in chunks
+#define CHECKPOINT_CHUNK_SIZE (1 << 30)
+
+
+
+vp::CheckpointWriter::CheckpointWriter(std::string path) : path(path)
+{
+    // Fastest compression level, most of the checkpoint is memory content which is either
+    // uniform and already skipped, or code and data which do not compress much better with
+    // higher levels
+    gzFile file = gzopen(path.c_str(), "wb1");
+    if (file == NULL)
+    {
+        this->error = "unable to open " + path + ": " + strerror(errno);
+        return;
+    }
+    gzbuffer(file, 1 << 18);
+    this->file = file;
+}
+
+vp::CheckpointWriter::~CheckpointWriter()
+{
+    this->close();
+}
+
+void vp::CheckpointWriter::write(const void *data, uint64_t size)
+{
+    if (this->file == NULL)
+    {
+        return;
+    }
+
+    const uint8_t *buffer = (const uint8_t *)data;
+    while (size > 0)
+    {
+        unsigned int len = std::min(size, (uint64_t)CHECKPOINT_CHUNK_SIZE);
+        if (gzwrite((gzFile)this->file, buffer, len) != (int)len)
+        {
+            this->set_error("failed writing to " + this->path);
+            return;
+        }
+        buffer += len;
+        size -= len;
+    }
+}
+
+void vp::CheckpointWriter::write_str(std::string value)
+{
+    this->write_u64(value.size());
+    this->write(value.c_str(), value.size());
+}
+
+void vp::CheckpointWriter::set_error(std::string error)
+{
+    if (this->error == "")
+    {
+        this->error = error;
+    }
+
+    if (this->file != NULL)
+    {
+        gzclose((gzFile)this->file);
+        this->file = NULL;
+    }
+}
+
+bool vp::CheckpointWriter::close()
+{
+    if (this->file != NULL)
+    {
+        if (gzclose((gzFile)this->file) != Z_OK && this->error == "")
+        {
+            this->error = "failed closing " + this->path;
+        }
+        this->file = NULL;
+    }
+
+    return this->is_ok();
+}
+
+
+
+vp::CheckpointReader::CheckpointReader(std::string path) : path(path)
+{
+    gzFile file = gzopen(path.c_str(), "rb");
+    if (file == NULL)
+    {
+        this->error = "unable to open " + path + ": " + strerror(errno);
+        return;
+    }
+    gzbuffer(file, 1 << 18);
+    this->file = file;
+}
+
+vp::CheckpointReader::~CheckpointReader()
+{
+    if (this->file != NULL)
+    {
+        gzclose((gzFile)this->file);
+    }
+}
+
+void vp::CheckpointReader::read(void *data, uint64_t size)
+{
+    uint8_t *buffer = (uint8_t *)data;
+
+    if (this->file == NULL)
+    {
+        memset(buffer, 0, size);
+        return;
+    }
+
+    while (size > 0)
+    {
+        unsigned int len = std::min(size, (uint64_t)CHECKPOINT_CHUNK_SIZE);
+        if (gzread((gzFile)this->file, buffer, len) != (int)len)
+        {
+            this->set_error("unexpected end of " + this->path);
+            memset(buffer, 0, size);
+            return;
+        }
+        buffer += len;
+        size -= len;
+    }
+}
+
+std::string vp::CheckpointReader::read_str()
+{
+    uint64_t size = this->read_u64();
+
+    // Protect against corrupted files making us allocate huge strings
+    if (size > 4096)
+    {
+        this->set_error("invalid string in " + this->path);
+        return "";
+    }
+
+    std::string value(size, '\0');
+    this->read(&value[0], size);
+    return value;
+}
+
+bool vp::CheckpointReader::check_u64(uint64_t expected, std::string what)
+{
+    uint64_t value = this->read_u64();
+    if (this->is_ok() && value != expected)
+    {
+        this->set_error("mismatch on " + what + " (checkpoint: " + std::to_string(value) +
+            ", platform: " + std::to_string(expected) + ")");
+    }
+    return this->is_ok();
+}
+
+void vp::CheckpointReader::set_error(std::string error)
+{
+    if (this->error == "")
+    {
+        this->error = error;
+    }
+
+    if (this->file != NULL)
+    {
+        gzclose((gzFile)this->file);
+        this->file = NULL;
+    }
+}
@@ -43,6 +43,8 @@
 #include <vp/proxy.hpp>
 #include <vp/queue.hpp>
 #include <vp/signal.hpp>
+#include <vp/host_profiler.hpp>
+#include <vp/checkpoint.hpp>
 #include <sys/stat.h>
 
 vp::ClockEvent *vp::ClockEngine::enable(vp::ClockEvent *event)
@@ -286,76 +288,357 @@ vp::ClockEvent *vp::ClockEngine::enqueue(vp::ClockEvent *event, int64_t cycle)
         }
     }
 
-    vp::ClockEvent *current = delayed_queue, *prev = NULL;
+    event->cycle = full_cycle;
+
+    this->delayed_push(event);
 
-    while (current && current->cycle <= full_cycle)
+    this->stats.nb_enqueues++;
+    if (++this->nb_delayed_events > this->stats.delayed_queue_max)
     {
-        prev = current;
-        current = current->next;
+        this->stats.delayed_queue_max = this->nb_delayed_events;
     }
 
-    if (prev)
-        prev->next = event;
-    else
-        delayed_queue = event;
-    event->next = current;
-    event->cycle = full_cycle;
+    if (unlikely(!this->wheel_active &&
+        this->nb_delayed_events > VP_CLOCK_ENGINE_WHEEL_MIN_EVENTS))
+    {
+        this->wheel_enable();
+    }
 
-    this->next_delayed_cycle = this->delayed_queue->cycle;
+    if (full_cycle < this->next_delayed_cycle)
+    {
+        this->next_delayed_cycle = full_cycle;
+    }
 
     return event;
 }
 
 vp::ClockEvent *vp::ClockEngine::get_next_event()
 {
-    // There is no quick way of getting the next event.
-    // We have to first check if there is an event in the circular buffer
-    // and if not in the delayed queue
-
     if (this->permanent_first)
     {
         return this->permanent_first;
     }
 
-    return this->delayed_queue;
+    if (this->next_delayed_cycle == INT64_MAX)
+    {
+        return NULL;
+    }
+
+    if (this->wheel_active &&
+        this->next_delayed_cycle < this->wheel_cycle + VP_CLOCK_ENGINE_WHEEL_SIZE)
+    {
+        return this->wheel[this->next_delayed_cycle & VP_CLOCK_ENGINE_WHEEL_MASK].first;
+    }
+
+    return this->far_queue.first;
 }
 
-void vp::ClockEngine::cancel(vp::ClockEvent *event)
+void vp::ClockEngine::wheel_advance(int64_t cycle)
 {
-    if (!event->is_enqueued())
-        return;
+    this->wheel_cycle = cycle;
 
-    // There is no way to know if the event is enqueued into the circular buffer
-    // or in the delayed queue so first go through the delayed queue and if it is
-    // not found, look in the circular buffer
+    // Far events are sorted, so they are moved in order and stay behind the events of the same
+    // cycle which are already in the wheel.
+    while (this->far_queue.first &&
+        this->far_queue.first->cycle < this->wheel_cycle + VP_CLOCK_ENGINE_WHEEL_SIZE)
+    {
+        vp::ClockEvent *event = this->far_queue.first;
+        this->far_queue.first = event->next;
+        if (event->next)
+        {
+            event->next->prev = NULL;
+        }
+        else
+        {
+            this->far_queue.last = NULL;
+        }
+        this->wheel_push(event);
+    }
+}
+
+void vp::ClockEngine::wheel_enable()
+{
+    // The sorted list only has forward links, add the backward ones needed by the far queue
+    vp::ClockEvent *prev = NULL;
+    for (vp::ClockEvent *event = this->far_queue.first; event; event = event->next)
+    {
+        event->prev = prev;
+        prev = event;
+    }
+    this->far_queue.last = prev;
+
+    // No event can be before the first delayed event or before the current cycle, so the
+    // window can start there. Since the wheel is empty, events moved from the far queue keep
+    // their order.
+    this->wheel_active = true;
+    this->wheel_advance(std::min(this->cycles, this->next_delayed_cycle));
+}
+
+void vp::ClockEngine::wheel_disable()
+{
+    vp::ClockEventQueue queue;
 
-    // First the delayed queue
-    vp::ClockEvent *current = delayed_queue, *prev = NULL;
-    while (current)
+    // Wheel events are all before far events, so browsing the buckets in cycle order from the
+    // start of the window and putting the far queue behind gives the full sorted list.
+    for (int i = 0; i < VP_CLOCK_ENGINE_WHEEL_SIZE; i++)
     {
-        if (current == event)
+        vp::ClockEventQueue *bucket = &this->wheel[(this->wheel_cycle + i) & VP_CLOCK_ENGINE_WHEEL_MASK];
+        if (bucket->first)
         {
-            if (prev)
-                prev->next = event->next;
+            for (vp::ClockEvent *event = bucket->first; event; event = event->next)
+            {
+                event->queue = &this->far_queue;
+            }
+            bucket->first->prev = queue.last;
+            if (queue.last)
+            {
+                queue.last->next = bucket->first;
+            }
             else
-                delayed_queue = event->next;
+            {
+                queue.first = bucket->first;
+            }
+            queue.last = bucket->last;
+            bucket->first = NULL;
+            bucket->last = NULL;
+        }
+    }
+
+    for (int i = 0; i < VP_CLOCK_ENGINE_WHEEL_SIZE / 64; i++)
+    {
+        this->wheel_bitmap[i] = 0;
+    }
+
+    if (queue.first)
+    {
+        queue.last->next = this->far_queue.first;
+        if (this->far_queue.first)
+        {
+            this->far_queue.first->prev = queue.last;
+        }
+        else
+        {
+            this->far_queue.last = queue.last;
+        }
+        this->far_queue.first = queue.first;
+    }
+
+    this->wheel_active = false;
+}
+
+void vp::ClockEngine::wheel_push(vp::ClockEvent *event)
+{
+    int64_t cycle = event->cycle;
+
+    if (unlikely(cycle >= this->wheel_cycle + VP_CLOCK_ENGINE_WHEEL_SIZE))
+    {
+        // Try to move the window forward. No event can be before the first delayed event or
+        // before the current cycle so this is the furthest we can go.
+        int64_t new_cycle = std::min(this->cycles, this->next_delayed_cycle);
+        if (new_cycle > this->wheel_cycle)
+        {
+            this->wheel_advance(new_cycle);
+        }
+    }
+
+    if (likely(cycle < this->wheel_cycle + VP_CLOCK_ENGINE_WHEEL_SIZE))
+    {
+        int bucket = cycle & VP_CLOCK_ENGINE_WHEEL_MASK;
+        vp::ClockEventQueue *queue = &this->wheel[bucket];
+
+        event->queue = queue;
+        event->next = NULL;
+        event->prev = queue->last;
+        if (queue->last)
+        {
+            queue->last->next = event;
+        }
+        else
+        {
+            queue->first = event;
+            this->wheel_bitmap[bucket >> 6] |= 1ULL << (bucket & 63);
+        }
+        queue->last = event;
+    }
+    else
+    {
+        // Far events are rare and usually enqueued with increasing cycles, just keep them sorted
+        // starting from the end
+        vp::ClockEventQueue *queue = &this->far_queue;
+        vp::ClockEvent *prev = queue->last;
 
-            goto end;
+        while (prev && prev->cycle > cycle)
+        {
+            prev = prev->prev;
         }
 
-        prev = current;
-        current = current->next;
+        event->queue = queue;
+        event->prev = prev;
+        event->next = prev ? prev->next : queue->first;
+        if (event->next)
+        {
+            event->next->prev = event;
+        }
+        else
+        {
+            queue->last = event;
+        }
+        if (prev)
+        {
+            prev->next = event;
+        }
+        else
+        {
+            queue->first = event;
+        }
     }
+}
 
-    event->disable();
+vp::ClockEvent *vp::ClockEngine::wheel_pop()
+{
+    int64_t cycle = this->next_delayed_cycle;
 
-    // TODO some models are pushing events to a different one that that they belong to
-    // vp_assert(0, NULL, "Didn't find event in any queue while canceling event\n");
+    // The first event may still be in the far queue if the window is late
+    if (unlikely(cycle >= this->wheel_cycle + VP_CLOCK_ENGINE_WHEEL_SIZE))
+    {
+        this->wheel_advance(cycle);
+    }
 
-end:
-    event->enqueued = false;
+    vp::ClockEvent *event = this->wheel[cycle & VP_CLOCK_ENGINE_WHEEL_MASK].first;
+    this->delayed_remove(event);
+    return event;
+}
+
+void vp::ClockEngine::delayed_remove(vp::ClockEvent *event)
+{
+    vp::ClockEventQueue *queue = event->queue;
 
-    this->next_delayed_cycle = this->delayed_queue ? this->delayed_queue->cycle : INT64_MAX;
+    if (likely(!this->wheel_active))
+    {
+        // The sorted list has no backward links, the previous event must be searched
+        vp::ClockEvent *current = queue->first, *prev = NULL;
+        while (current != event)
+        {
+            prev = current;
+            current = current->next;
+        }
+
+        if (prev)
+        {
+            prev->next = event->next;
+        }
+        else
+        {
+            queue->first = event->next;
+            this->next_delayed_cycle = queue->first ? queue->first->cycle : INT64_MAX;
+        }
+
+        event->queue = NULL;
+        this->nb_delayed_events--;
+        return;
+    }
+
+    if (event->prev)
+    {
+        event->prev->next = event->next;
+    }
+    else
+    {
+        queue->first = event->next;
+    }
+
+    if (event->next)
+    {
+        event->next->prev = event->prev;
+    }
+    else
+    {
+        queue->last = event->prev;
+    }
+
+    event->queue = NULL;
+    this->nb_delayed_events--;
+
+    if (queue->first == NULL && queue != &this->far_queue)
+    {
+        int bucket = queue - this->wheel;
+        this->wheel_bitmap[bucket >> 6] &= ~(1ULL << (bucket & 63));
+    }
+
+    // The first cycle does not change if other events remain in the wheel bucket, since a bucket
+    // only contains events of the same cycle. Far events are always after the wheel events, so
+    // the wheel is empty if the first one is removed.
+    if (event->cycle == this->next_delayed_cycle &&
+        (queue->first == NULL || queue == &this->far_queue))
+    {
+        if (queue == &this->far_queue)
+        {
+            this->next_delayed_cycle = queue->first ? queue->first->cycle : INT64_MAX;
+        }
+        else
+        {
+            this->next_delayed_cycle = this->delayed_first_cycle(event->cycle);
+        }
+    }
+
+    // Only go back to the sorted list at half the limit, so that events are not moved again
+    // and again when their number is around it.
+    if (unlikely(this->wheel_active &&
+        this->nb_delayed_events <= VP_CLOCK_ENGINE_WHEEL_MIN_EVENTS / 2))
+    {
+        this->wheel_disable();
+    }
+}
+
+int64_t vp::ClockEngine::delayed_first_cycle(int64_t cycle)
+{
+    // All events of the wheel are inside its window and after the specified cycle, so the
+    // first event is in the first non-empty bucket starting from the one of this cycle, and far
+    // events are always after it.
+    int start = cycle & VP_CLOCK_ENGINE_WHEEL_MASK;
+    int nb_words = VP_CLOCK_ENGINE_WHEEL_SIZE / 64;
+
+    for (int i = 0; i <= nb_words; i++)
+    {
+        int word = ((start >> 6) + i) % nb_words;
+        uint64_t bits = this->wheel_bitmap[word];
+
+        if (i == 0)
+        {
+            bits &= ~0ULL << (start & 63);
+        }
+        else if (i == nb_words)
+        {
+            bits &= ~(~0ULL << (start & 63));
+        }
+
+        if (bits)
+        {
+            return this->wheel[word * 64 + __builtin_ctzll(bits)].first->cycle;
+        }
+    }
+
+    return this->far_queue.first ? this->far_queue.first->cycle : INT64_MAX;
+}
+
+void vp::ClockEngine::cancel(vp::ClockEvent *event)
+{
+    if (!event->is_enqueued())
+        return;
+
+    this->stats.nb_cancels++;
+
+    if (event->queue)
+    {
+        this->delayed_remove(event);
+    }
+    else
+    {
+        // Permanent events are not in any delayed queue
+        event->disable();
+    }
+
+    event->enqueued = false;
 
     if (!this->has_events())
         this->dequeue_from_engine();
@@ -371,6 +654,13 @@ int64_t vp::ClockEngine::exec()
     vp_assert(this->get_next_event(), NULL, "Executing clock engine while it has no next event\n");
 
     ClockEvent *current = this->permanent_first;
+    bool profiled = vp::HostProfiler::enabled;
+
+    // Events are counted locally and only added when the engine returns, so that they do not
+    // cost a memory access per event
+    int64_t nb_events = 0;
+
+    this->stats.nb_execs++;
 
     // Also remember the current time in order to resynchronize the clock engine
     // in case we enqueue and event from another engine.
@@ -385,7 +675,15 @@ int64_t vp::ClockEngine::exec()
             do
             {
                 ClockEvent *next = current->next;
-                current->meth(current->_this, current);
+                nb_events++;
+                if (unlikely(profiled))
+                {
+                    this->exec_profiled(current);
+                }
+                else
+                {
+                    current->meth(current->_this, current);
+                }
                 current = next;
             } while (likely(current != NULL));
 
@@ -397,13 +695,14 @@ int64_t vp::ClockEngine::exec()
                 if (likely(this->next_delayed_cycle > this->cycles))
                 {
                     vp::TimeEngine *engine = this->time_engine;
-                    if (likely(time_engine->first_client == NULL && !time_engine->stop_req))
+                    if (likely(time_engine->clients.empty() && !time_engine->stop_req))
                     {
                         engine->time += period;
                         current = this->permanent_first;
                         continue;
                     }
 
+                    this->stats.nb_events += nb_events;
                     return period;
                 }
             }
@@ -413,27 +712,29 @@ int64_t vp::ClockEngine::exec()
     }
     else
     {
-        vp_assert(this->cycles <= delayed_queue->cycle, NULL, "Executing event in the past\n");
+        vp_assert(this->cycles <= this->next_delayed_cycle, NULL, "Executing event in the past\n");
 
-        this->cycles = delayed_queue->cycle;
+        this->cycles = this->next_delayed_cycle;
     }
 
-    while (delayed_queue)
+    while (this->next_delayed_cycle <= this->get_cycles())
     {
-        if (delayed_queue->cycle > this->get_cycles())
-        {
-            break;
-        }
-
-        ClockEvent *current = delayed_queue;
+        ClockEvent *current = this->delayed_pop();
         current->enqueued = false;
-        delayed_queue = delayed_queue->next;
-
-        this->next_delayed_cycle = this->delayed_queue ? this->delayed_queue->cycle : INT64_MAX;
 
-        current->meth(current->_this, current);
+        nb_events++;
+        if (unlikely(profiled))
+        {
+            this->exec_profiled(current);
+        }
+        else
+        {
+            current->meth(current->_this, current);
+        }
     }
 
+    this->stats.nb_events += nb_events;
+
     // Need to check again if we have a permanent event since it could have been enabled during
     // the execution of a delayed event
     if (likely(this->permanent_first != NULL))
@@ -443,9 +744,9 @@ int64_t vp::ClockEngine::exec()
     else
     {
 
-        if (delayed_queue)
+        if (this->next_delayed_cycle != INT64_MAX)
         {
-            int64_t cycle_diff = delayed_queue->cycle - get_cycles();
+            int64_t cycle_diff = this->next_delayed_cycle - get_cycles();
             int64_t time_diff = cycle_diff * period;
             return time_diff;
         }
@@ -456,6 +757,223 @@ int64_t vp::ClockEngine::exec()
     }
 }
 
+void vp::ClockEngine::exec_profiled(vp::ClockEvent *event)
+{
+    // The callback context is not always a block, the host time is accounted to the block
+    // owning the event instead
+    vp::HostProfilerFrame frame;
+    vp::HostProfiler::enter(&frame, event->comp, vp::HOST_PROFILER_CLOCK_EVENT);
+    event->meth(event->_this, event);
+    vp::HostProfiler::leave(&frame);
+}
+
+void vp::ClockEngine::get_stats(gv::ClockEngineStats &stats)
+{
+    stats = this->stats;
+    stats.path = this->get_path();
+    stats.frequency = this->period != 0 ? 1000000000000LL / this->period : 0;
+    stats.delayed_queue_size = this->nb_delayed_events;
+}
+
+void vp::ClockEngine::reset_stats()
+{
+    this->stats = gv::ClockEngineStats();
+    this->stats.delayed_queue_max = this->nb_delayed_events;
+}
+
+static void checkpoint_save_event(vp::CheckpointWriter &writer,
+    std::unordered_map<vp::Block *, int64_t> &block_ids, vp::Block *block,
+    std::vector<vp::ClockEvent *> &events, vp::ClockEvent *event)
+{
+    auto id = block_ids.find(block);
+    if (id == block_ids.end())
+    {
+        writer.set_error("clock event owned by a block outside the hierarchy");
+        return;
+    }
+    writer.write_u64(id->second);
+    writer.write_u64(std::find(events.begin(), events.end(), event) - events.begin());
+}
+
+void vp::ClockEngine::checkpoint_save_engine(vp::CheckpointWriter &writer,
+    std::unordered_map<vp::Block *, int64_t> &block_ids)
+{
+    this->sync();
+
+    int64_t next_event_time = this->time.is_enqueued ? this->time.next_event_time : -1;
+
+    // With permanent events, cycles are counted by the engine loop and the stop time is not
+    // updated, give the one of the current cycle instead
+    int64_t stop_time = this->stop_time;
+    if (this->permanent_first && next_event_time != -1)
+    {
+        stop_time = next_event_time - this->period;
+    }
+
+    writer.write_i64(this->cycles);
+    writer.write_i64(this->period);
+    writer.write_i64(this->freq);
+    writer.write_i64(stop_time);
+    writer.write_i64(this->frequency_to_be_applied);
+    writer.write_i64(next_event_time);
+
+    std::vector<vp::ClockEvent *> permanent;
+    for (vp::ClockEvent *event = this->permanent_first; event; event = event->next)
+    {
+        // Disabled events are only waiting to be removed by the engine loop
+        if (event->enqueued)
+        {
+            permanent.push_back(event);
+        }
+    }
+
+    // Delayed events are saved sorted by cycle, and in execution order for the same cycle
+    std::vector<vp::ClockEvent *> delayed;
+    for (int i = 0; i < VP_CLOCK_ENGINE_WHEEL_SIZE; i++)
+    {
+        vp::ClockEventQueue *queue = &this->wheel[(this->wheel_cycle + i) & VP_CLOCK_ENGINE_WHEEL_MASK];
+        for (vp::ClockEvent *event = queue->first; event; event = event->next)
+        {
+            delayed.push_back(event);
+        }
+    }
+    for (vp::ClockEvent *event = this->far_queue.first; event; event = event->next)
+    {
+        delayed.push_back(event);
+    }
+
+    writer.write_u64(permanent.size());
+    for (vp::ClockEvent *event: permanent)
+    {
+        checkpoint_save_event(writer, block_ids, event->comp, event->comp->clock.events, event);
+    }
+
+    writer.write_u64(delayed.size());
+    for (vp::ClockEvent *event: delayed)
+    {
+        checkpoint_save_event(writer, block_ids, event->comp, event->comp->clock.events, event);
+        writer.write_i64(event->cycle);
+    }
+}
+
+void vp::ClockEngine::checkpoint_drop_engine()
+{
+    // Events themselves are reset by their blocks
+    for (int i = 0; i < VP_CLOCK_ENGINE_WHEEL_SIZE; i++)
+    {
+        this->wheel[i].first = NULL;
+        this->wheel[i].last = NULL;
+    }
+    for (int i = 0; i < VP_CLOCK_ENGINE_WHEEL_SIZE / 64; i++)
+    {
+        this->wheel_bitmap[i] = 0;
+    }
+    this->far_queue.first = NULL;
+    this->far_queue.last = NULL;
+    this->wheel_active = false;
+    this->permanent_first = NULL;
+    this->permanent_last = NULL;
+    this->next_delayed_cycle = INT64_MAX;
+    this->nb_delayed_events = 0;
+}
+
+void vp::ClockEngine::checkpoint_restore_engine(vp::CheckpointReader &reader,
+    std::vector<vp::Block *> &blocks)
+{
+    auto restore_event = [&]() -> vp::ClockEvent * {
+        uint64_t block_id = reader.read_u64();
+        uint64_t index = reader.read_u64();
+
+        if (!reader.is_ok() || block_id >= blocks.size() ||
+            index >= blocks[block_id]->clock.events.size())
+        {
+            reader.set_error("invalid clock event of " + this->get_path());
+            return NULL;
+        }
+
+        return blocks[block_id]->clock.events[index];
+    };
+
+    int64_t period = this->period;
+
+    this->cycles = reader.read_i64();
+    this->period = reader.read_i64();
+    this->freq = reader.read_i64();
+    this->stop_time = reader.read_i64();
+    this->frequency_to_be_applied = reader.read_i64();
+    int64_t next_event_time = reader.read_i64();
+
+    int64_t nb_permanent = reader.read_u64();
+    for (int64_t i = 0; i < nb_permanent; i++)
+    {
+        vp::ClockEvent *event = restore_event();
+        if (event == NULL)
+        {
+            return;
+        }
+
+        event->clock = this;
+        event->enqueued = true;
+        event->cycle = -1;
+        event->next = NULL;
+        event->prev = this->permanent_last;
+        if (this->permanent_last)
+        {
+            this->permanent_last->next = event;
+        }
+        else
+        {
+            this->permanent_first = event;
+        }
+        this->permanent_last = event;
+    }
+
+    int64_t nb_delayed = reader.read_u64();
+    for (int64_t i = 0; i < nb_delayed; i++)
+    {
+        vp::ClockEvent *event = restore_event();
+        int64_t cycle = reader.read_i64();
+        if (event == NULL)
+        {
+            return;
+        }
+
+        // Events are saved sorted, the first one is the next one
+        if (i == 0)
+        {
+            this->next_delayed_cycle = cycle;
+        }
+
+        event->clock = this;
+        event->enqueued = true;
+        event->cycle = cycle;
+        this->delayed_push(event);
+        this->nb_delayed_events++;
+    }
+
+    if (this->nb_delayed_events > VP_CLOCK_ENGINE_WHEEL_MIN_EVENTS)
+    {
+        this->wheel_enable();
+    }
+
+    // The frequency is not propagated to the clock ports, components driven by this engine
+    // restore their own state
+    if (this->period != period)
+    {
+        this->clock_trace.event((uint8_t *)&this->period);
+    }
+
+    // Put back the engine in the time engine queue exactly where it was, whatever its events
+    if (this->time.is_enqueued)
+    {
+        this->time_engine->dequeue(this);
+    }
+    if (next_event_time != -1)
+    {
+        this->time_engine->enqueue(this, next_event_time);
+    }
+}
+
 vp::ClockEvent *vp::ClockEngine::reenqueue(vp::ClockEvent *event, int64_t enqueue_cycles)
 {
     if (event->is_enqueued())
@@ -521,7 +1039,6 @@ vp::ClockEngine::ClockEngine(vp::ComponentConf &config)
     apply_frequency_event(this, &vp::ClockEngine::apply_frequency_handler)
 {
     this->time_engine = config.time_engine;
-    delayed_queue = NULL;
     current_cycle = 0;
 
     this->apply_frequency(get_js_config()->get_child_int("frequency"));
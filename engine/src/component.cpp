@@ -358,8 +358,18 @@ void vp::Component::reset_sync(vp::Block *__this, bool active)
 
 vp::Component *vp::Component::new_component(std::string name, js::Config *config, std::string module_name)
 {
+    vp::TimeEngine *time_engine = this->time.get_engine();
+
+    // In parallel mode, the component is simulated by the engine of its parent, unless it is
+    // the root of another partition
+    if (time_engine->get_partition())
+    {
+        time_engine = time_engine->get_partition()->get_parallel()->get_engine(
+            this->get_path() + "/" + name, time_engine);
+    }
+
     vp::Component *instance = vp::Component::load_component(config, this->gv_config, this, name,
-        this->time.get_engine(), this->traces.get_trace_engine(), this->power.get_engine(), this->memcheck);
+        time_engine, this->traces.get_trace_engine(), this->power.get_engine(), this->memcheck);
 
     this->get_trace()->msg(vp::Trace::LEVEL_DEBUG, "New component (name: %s)\n", name.c_str());
 
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <vp/fast_forward.hpp>
+
+
+bool vp::FastForward::active = false;
+int64_t vp::FastForward::quantum = 0;
+int64_t vp::FastForward::until_pc = -1;
+int64_t vp::FastForward::until_insns = -1;
+
+
+
+void vp::FastForward::init(js::Config *config)
+{
+    if (!config->get_child_bool("fast_forward/enabled"))
+    {
+        return;
+    }
+
+    // Models check the mode without any synchronization, the switch would not be seen at the
+    // same time by all partitions
+    if (config->get_child_bool("parallel/enabled"))
+    {
+        fprintf(stderr, "Fast-forward mode is not supported in parallel mode, disabling it\n");
+        return;
+    }
+
+    FastForward::quantum = config->get_child_int("fast_forward/quantum");
+    if (FastForward::quantum <= 0)
+    {
+        FastForward::quantum = 1000;
+    }
+
+    js::Config *until_pc = config->get("fast_forward/until_pc");
+    FastForward::until_pc = until_pc ? until_pc->get_int() : -1;
+    js::Config *until_insns = config->get("fast_forward/until_insns");
+    FastForward::until_insns = until_insns ? until_insns->get_int() : -1;
+
+    FastForward::active = true;
+}
+
+
+
+void vp::FastForward::stop(std::string reason)
+{
+    if (!FastForward::active)
+    {
+        return;
+    }
+
+    FastForward::active = false;
+
+    // Direct accesses were granted without the latency of the models, masters must ask for
+    // them again so that the timed ones are refused or get the right latency
+    vp::IoDmi::invalidate_all();
+
+    printf("Fast-forward mode stopped, switching to timed mode (trigger: %s)\n",
+        reason.c_str());
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <vp/vp.hpp>
+#include <vp/host_profiler.hpp>
+
+
+bool vp::HostProfiler::enabled = false;
+thread_local vp::HostProfilerFrame *vp::HostProfiler::current = NULL;
+
+// All entries, blocks of different partitions may create them concurrently
+static std::mutex entries_mutex;
+static std::vector<vp::HostProfilerEntry *> entries;
+static std::string profile_file;
+// Reference points taken when the profiler is enabled, to convert ticks to nanoseconds
+static int64_t start_ticks;
+static int64_t start_ns;
+
+static int64_t get_host_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+
+void vp::HostProfiler::init(js::Config *config)
+{
+    if (!config->get_child_bool("host_profiler/enabled"))
+    {
+        return;
+    }
+
+    profile_file = config->get_child_str("host_profiler/file");
+    if (profile_file == "")
+    {
+        profile_file = "host_profile";
+    }
+
+    start_ns = get_host_ns();
+    start_ticks = HostProfiler::get_ticks();
+    HostProfiler::enabled = true;
+}
+
+
+
+vp::HostProfilerEntry *vp::HostProfiler::entry_new(vp::Block *block)
+{
+    std::lock_guard<std::mutex> lock(entries_mutex);
+
+    HostProfilerEntry *entry = new HostProfilerEntry();
+    entry->path = block->get_path() == "" ? "/" : block->get_path();
+    entries.push_back(entry);
+    block->host_profiler_entry = entry;
+
+    return entry;
+}
+
+
+
+void vp::HostProfiler::dump()
+{
+    if (!HostProfiler::enabled)
+    {
+        return;
+    }
+
+    int64_t elapsed_ns = get_host_ns() - start_ns;
+    int64_t elapsed_ticks = HostProfiler::get_ticks() - start_ticks;
+    double ns_per_tick = elapsed_ticks > 0 ? (double)elapsed_ns / elapsed_ticks : 1.0;
+
+    std::vector<HostProfilerEntry> sorted;
+    {
+        std::lock_guard<std::mutex> lock(entries_mutex);
+        for (HostProfilerEntry *entry: entries)
+        {
+            sorted.push_back(*entry);
+        }
+    }
+
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [](const HostProfilerEntry &a, const HostProfilerEntry &b) {
+            return a.self_ticks > b.self_ticks; });
+
+    int64_t profiled_ticks = 0;
+    for (HostProfilerEntry &entry: sorted)
+    {
+        profiled_ticks += entry.self_ticks;
+    }
+    int64_t profiled_ns = profiled_ticks * ns_per_tick;
+    double total = elapsed_ns > 0 ? elapsed_ns : 1;
+
+    std::string txt_path = profile_file + ".txt";
+    FILE *file = fopen(txt_path.c_str(), "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Unable to open host profile file (path: %s, error: %s)\n",
+            txt_path.c_str(), strerror(errno));
+        return;
+    }
+
+    fprintf(file, "# Host time: %.3f ms, in models: %.3f ms (%.2f %%), in engine: %.3f ms\n",
+        elapsed_ns / 1e6, profiled_ns / 1e6, profiled_ns * 100.0 / total,
+        (elapsed_ns - profiled_ns) / 1e6);
+    fprintf(file, "\n%12s %8s %12s %12s %12s %12s %10s  %s\n", "self_ms", "self%", "total_ms",
+        "clock_events", "time_events", "io_reqs", "ns/call", "path");
+
+    for (HostProfilerEntry &entry: sorted)
+    {
+        int64_t nb_calls = entry.nb_calls[HOST_PROFILER_CLOCK_EVENT] +
+            entry.nb_calls[HOST_PROFILER_TIME_EVENT] + entry.nb_calls[HOST_PROFILER_IO_REQ];
+        double self_ns = entry.self_ticks * ns_per_tick;
+
+        fprintf(file, "%12.3f %8.2f %12.3f %12" PRId64 " %12" PRId64 " %12" PRId64 " %10.1f  %s\n",
+            self_ns / 1e6, self_ns * 100.0 / total, entry.total_ticks * ns_per_tick / 1e6,
+            entry.nb_calls[HOST_PROFILER_CLOCK_EVENT], entry.nb_calls[HOST_PROFILER_TIME_EVENT],
+            entry.nb_calls[HOST_PROFILER_IO_REQ], nb_calls > 0 ? self_ns / nb_calls : 0.0,
+            entry.path.c_str());
+    }
+
+    fclose(file);
+
+    std::string json_path = profile_file + ".json";
+    file = fopen(json_path.c_str(), "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Unable to open host profile file (path: %s, error: %s)\n",
+            json_path.c_str(), strerror(errno));
+        return;
+    }
+
+    fprintf(file, "{\n  \"host_ns\": %" PRId64 ",\n  \"models_ns\": %" PRId64 ",\n  \"blocks\": [",
+        elapsed_ns, profiled_ns);
+
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        HostProfilerEntry &entry = sorted[i];
+        fprintf(file, "%s\n    {\"path\": \"%s\", \"self_ns\": %" PRId64 ", \"total_ns\": %" PRId64
+            ", \"clock_events\": %" PRId64 ", \"time_events\": %" PRId64 ", \"io_reqs\": %" PRId64 "}",
+            i == 0 ? "" : ",", entry.path.c_str(), (int64_t)(entry.self_ticks * ns_per_tick),
+            (int64_t)(entry.total_ticks * ns_per_tick), entry.nb_calls[HOST_PROFILER_CLOCK_EVENT],
+            entry.nb_calls[HOST_PROFILER_TIME_EVENT], entry.nb_calls[HOST_PROFILER_IO_REQ]);
+    }
+
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <mutex>
+#include <vector>
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+
+
+thread_local vp::IoReqPool *vp::IoReqPool::pool = NULL;
+int vp::IoReqPool::slab_size = 64;
+
+// All pools ever created, only used to sum the counters. Pools are never freed since requests
+// they gave may still be in flight in other threads.
+static std::mutex pools_mutex;
+static std::vector<vp::IoReqPool *> pools;
+
+
+
+void vp::IoReqPool::set_slab_size(int size)
+{
+    if (size > 0)
+    {
+        IoReqPool::slab_size = size;
+    }
+}
+
+
+
+vp::IoReqPool *vp::IoReqPool::create()
+{
+    IoReqPool *pool = new IoReqPool();
+    IoReqPool::pool = pool;
+
+    std::lock_guard<std::mutex> lock(pools_mutex);
+    pools.push_back(pool);
+
+    return pool;
+}
+
+
+
+vp::IoReqPool::FreeReq *vp::IoReqPool::refill()
+{
+    int nb_reqs = IoReqPool::slab_size;
+    uint8_t *slab = (uint8_t *)::operator new(sizeof(IoReq) * nb_reqs);
+
+    this->counter_inc(this->nb_mallocs);
+
+    for (int i=0; i<nb_reqs; i++)
+    {
+        FreeReq *free_req = (FreeReq *)(slab + sizeof(IoReq) * i);
+        free_req->next = this->first_free;
+        this->first_free = free_req;
+    }
+
+    this->nb_free_reqs.store(this->nb_free_reqs.load(std::memory_order_relaxed) + nb_reqs,
+        std::memory_order_relaxed);
+
+    return this->first_free;
+}
+
+
+
+void vp::IoReqPool::get_stats(IoReqPoolStats *stats)
+{
+    *stats = {};
+
+    std::lock_guard<std::mutex> lock(pools_mutex);
+    for (IoReqPool *pool: pools)
+    {
+        stats->nb_allocs += pool->nb_allocs.load(std::memory_order_relaxed);
+        stats->nb_frees += pool->nb_frees.load(std::memory_order_relaxed);
+        stats->nb_mallocs += pool->nb_mallocs.load(std::memory_order_relaxed);
+        stats->nb_free_reqs += pool->nb_free_reqs.load(std::memory_order_relaxed);
+    }
+}
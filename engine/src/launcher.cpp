@@ -54,6 +54,13 @@ void *gv::Controller::signal_routine(void *__this)
     do
     {
         sigwait(&sigs_to_catch, &caught);
+        // The flight recorder can only be dumped from the engine thread, it will be done when
+        // the engine is closed
+        vp::FlightRecorder *recorder = launcher->handler->get_trace_engine()->get_flight_recorder();
+        if (recorder)
+        {
+            recorder->request_dump();
+        }
         launcher->handler->get_time_engine()->quit(-1);
     } while (1);
     return NULL;
@@ -158,6 +165,13 @@ void gv::Controller::start(ControllerClient *client)
     this->instance->reset_all(true);
     this->instance->reset_all(false);
 
+    // The checkpoint must be restored after the reset, which would overwrite it
+    std::string checkpoint = this->handler->gv_config->get_child_str("checkpoint/restore");
+    if (checkpoint != "" && !this->handler->checkpoint_restore(checkpoint))
+    {
+        throw runtime_error("Failed to restore checkpoint");
+    }
+
     // Now that all initialization are done, wait for at least one proxy connection before
     // running.
     if (this->proxy)
@@ -180,10 +194,13 @@ void gv::Controller::start(ControllerClient *client)
 
 void gv::Controller::close(ControllerClient *client)
 {
-    this->instance->stop_all();
-
     vp::Top *top = (vp::Top *)this->handler;
 
+    // Stop partition threads first so that components are stopped by this thread only
+    top->stop();
+
+    this->instance->stop_all();
+
     delete top;
 }
 
@@ -332,3 +332,23 @@ int64_t gv::ControllerClient::get_next_event_time()
 {
     return gv::Controller::get().handler->get_time_engine()->get_next_event_time();
 }
+
+void gv::ControllerClient::get_engine_stats(gv::EngineStats &stats)
+{
+    gv::Controller::get().handler->get_engine_stats(stats);
+}
+
+void gv::ControllerClient::reset_engine_stats()
+{
+    gv::Controller::get().handler->reset_engine_stats();
+}
+
+bool gv::ControllerClient::checkpoint_save(std::string path)
+{
+    return gv::Controller::get().handler->checkpoint_save(path);
+}
+
+bool gv::ControllerClient::checkpoint_restore(std::string path)
+{
+    return gv::Controller::get().handler->checkpoint_restore(path);
+}
@@ -29,16 +29,6 @@ vp::MappingTreeEntry::MappingTreeEntry(int id, std::string name, js::Config *con
     js::Config *conf;
     this->base = config->get_uint("base");
     this->size = config->get_uint("size");
-    this->lowest_base = base;
-}
-
-vp::MappingTreeEntry::MappingTreeEntry(uint64_t base, vp::MappingTreeEntry *left,
-    vp::MappingTreeEntry *right)
-{
-    this->base = base;
-    this->left = left;
-    this->right = right;
-    this->lowest_base = left->lowest_base;
 }
 
 vp::MappingTree::MappingTree(vp::Trace *trace)
@@ -87,39 +77,34 @@ void vp::MappingTree::insert(int id, std::string name, js::Config *config)
 
 vp::MappingTreeEntry *vp::MappingTree::get(uint64_t base, uint64_t size, bool is_write)
 {
-    vp::MappingTreeEntry *entry = this->top_map_entry;
+    int64_t index = this->lookup(base);
 
-    if (entry)
+    if (index >= 0)
     {
-        while(1) {
-            // The entry does not have any child, this means we are at a final entry
-            if (entry->left == NULL)
-            {
-                break;
-            }
-
-            if (base >= entry->base)
-            {
-                entry = entry->right;
-            }
-            else
-            {
-                entry = entry->left;
-            }
-        }
-
-        if (entry && (base < entry->base || base > entry->base + entry->size - 1))
+        vp::MappingTreeEntry *entry = this->entries[index];
+        if (base <= entry->base + entry->size - 1)
         {
-            entry = NULL;
+            return entry;
         }
     }
 
-    if (entry == NULL)
+    return this->default_entry;
+}
+
+void vp::MappingTree::get_range(uint64_t addr, vp::MappingTreeEntry *entry, uint64_t &base,
+    uint64_t &end)
+{
+    if (entry->size != 0)
     {
-        entry = this->default_entry;
+        base = entry->base;
+        end = entry->base + entry->size;
+        return;
     }
 
-    return entry;
+    // The hole is limited by the last mapping before the address and the first one after
+    int64_t index = this->lookup(addr);
+    base = index >= 0 ? this->entries[index]->base + this->entries[index]->size : 0;
+    end = index + 1 < (int64_t)this->bases.size() ? this->bases[index + 1] : UINT64_MAX;
 }
 
 void vp::MappingTree::build()
@@ -146,60 +131,14 @@ void vp::MappingTree::build()
             this->default_entry->name.c_str());
     }
 
-    vp::MappingTreeEntry *first_in_level = this->first_map_entry;
+    this->bases.clear();
+    this->entries.clear();
 
-    // Loop until we merged everything into a single entry
-    // Start with the routing table entries
     current = this->first_map_entry;
-
-    // The first loop is here to loop until we have merged everything to a single entry
-    while(1) {
-        // Gives the map entry that should be on the left side of the next created entry
-        vp::MappingTreeEntry *left = NULL;
-
-        // Gives the last allocated entry where the entry should be inserted
-        vp::MappingTreeEntry *current_in_level=NULL;
-
-        // The second loop is iterating on a single level to merge entries 2 by 2
-        while(current)
-        {
-            if (left == NULL)
-            {
-                left = current;
-            }
-            else
-            {
-                vp::MappingTreeEntry *entry = new vp::MappingTreeEntry(current->lowest_base, left, current);
-
-                left = NULL;
-                if (current_in_level)
-                {
-                    current_in_level->next = entry;
-                }
-                else
-                {
-                    first_in_level = entry;
-                }
-                current_in_level = entry;
-            }
-
-            current = current->next;
-        }
-
-        current = first_in_level;
-
-        // Stop in case we got a single entry
-        if (current_in_level == NULL)
-        {
-            break;
-        }
-
-        // In case an entry is alone, insert it at the end, it will be merged with an upper entry
-        if (left != NULL)
-        {
-            current_in_level->next = left;
-        }
+    while(current)
+    {
+        this->bases.push_back(current->base);
+        this->entries.push_back(current);
+        current = current->next;
     }
-
-    this->top_map_entry = first_in_level;
 }
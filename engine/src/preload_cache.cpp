@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+#include <vp/vp.hpp>
+#include <vp/preload_cache.hpp>
+
+
+bool vp::PreloadCache::enabled = false;
+std::string vp::PreloadCache::dir;
+
+
+
+void vp::PreloadCache::init(js::Config *config)
+{
+    if (!config->get_child_bool("preload_cache/enabled"))
+    {
+        return;
+    }
+
+    PreloadCache::dir = config->get_child_str("preload_cache/dir");
+    if (PreloadCache::dir == "")
+    {
+        PreloadCache::dir = "/tmp/gvsoc_preload_cache_" + std::to_string(getuid());
+    }
+
+    if (mkdir(PreloadCache::dir.c_str(), 0700) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Unable to create preload cache directory, disabling it (path: %s, error: %s)\n",
+            PreloadCache::dir.c_str(), strerror(errno));
+        return;
+    }
+
+    // The directory may have been created by someone else, typically in /tmp, who could then
+    // plant links to files of their choice. Only trust a real directory that only we can modify.
+    struct stat dir_stat;
+    if (lstat(PreloadCache::dir.c_str(), &dir_stat) != 0)
+    {
+        fprintf(stderr, "Unable to access preload cache directory, disabling it (path: %s, error: %s)\n",
+            PreloadCache::dir.c_str(), strerror(errno));
+        return;
+    }
+
+    if (!S_ISDIR(dir_stat.st_mode) || dir_stat.st_uid != getuid() ||
+        (dir_stat.st_mode & (S_IWGRP | S_IWOTH)))
+    {
+        fprintf(stderr, "Preload cache directory is not a directory owned by the current user and "
+            "not writable by others, disabling it (path: %s)\n", PreloadCache::dir.c_str());
+        return;
+    }
+
+    PreloadCache::enabled = true;
+}
+
+
+
+// FNV-1a, only used to name cache files, their content is checked when they are created
+static uint64_t preload_cache_hash(const uint8_t *data, uint64_t size,
+    uint64_t hash=0xcbf29ce484222325ULL)
+{
+    for (uint64_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+
+// Identify a preload file from its path and attributes, which change whenever the file is
+// modified or replaced, so that a file already in the cache can be found without reading it
+static uint64_t preload_cache_key(std::string path, struct stat &file_stat)
+{
+    uint64_t attrs[] = {
+        (uint64_t)file_stat.st_dev, (uint64_t)file_stat.st_ino, (uint64_t)file_stat.st_size,
+        (uint64_t)file_stat.st_mtim.tv_sec, (uint64_t)file_stat.st_mtim.tv_nsec,
+        (uint64_t)file_stat.st_ctim.tv_sec, (uint64_t)file_stat.st_ctim.tv_nsec,
+    };
+    uint64_t hash = preload_cache_hash((const uint8_t *)path.c_str(), path.size() + 1);
+    return preload_cache_hash((const uint8_t *)attrs, sizeof(attrs), hash);
+}
+
+
+
+static bool preload_cache_write(int fd, uint8_t *data, uint64_t size)
+{
+    while (size > 0)
+    {
+        ssize_t len = write(fd, data, size);
+        if (len < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += len;
+        size -= len;
+    }
+    return true;
+}
+
+
+
+// Write the whole memory content to a temporary file and then move it to its final name, so that
+// simulations creating the same file at the same time never see a partial one
+static bool preload_cache_create(std::string cache_path, std::vector<uint8_t> &content,
+    uint64_t size, uint8_t fill)
+{
+    std::string tmp_path = cache_path + ".tmp." + std::to_string(getpid());
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    bool ok = preload_cache_write(fd, content.data(), content.size());
+
+    if (ok && fill != 0)
+    {
+        std::vector<uint8_t> fill_buffer(1 << 20, fill);
+        uint64_t remaining = size - content.size();
+        while (ok && remaining > 0)
+        {
+            uint64_t len = std::min(remaining, (uint64_t)fill_buffer.size());
+            ok = preload_cache_write(fd, fill_buffer.data(), len);
+            remaining -= len;
+        }
+    }
+    else if (ok)
+    {
+        // Zero fill is done with a hole, so that big memories do not use disk space
+        ok = ftruncate(fd, size) == 0;
+    }
+
+    close(fd);
+
+    if (!ok || rename(tmp_path.c_str(), cache_path.c_str()) != 0)
+    {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+
+
+// Read the preload file and make sure the cache contains a file with the memory content, named
+// after the hash of the content, so that the same content is shared even if it comes from
+// different preload files. Returns the name of the cache file, or an empty string on failure.
+static std::string preload_cache_fill(vp::Trace *trace, std::string dir, std::string path,
+    uint64_t size, uint8_t fill)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+    {
+        trace->force_warning_no_error("Unable to open preload file (path: %s, error: %s)\n",
+            path.c_str(), strerror(errno));
+        return "";
+    }
+
+    // Like preloading without the cache, the file is truncated to the memory size
+    struct stat file_stat;
+    uint64_t content_size = 0;
+    if (fstat(fileno(file), &file_stat) == 0)
+    {
+        content_size = std::min((uint64_t)file_stat.st_size, size);
+    }
+    std::vector<uint8_t> content(content_size);
+    if (content_size == 0 || fread(content.data(), 1, content_size, file) != content_size)
+    {
+        trace->force_warning_no_error("Unable to read preload file (path: %s)\n", path.c_str());
+        fclose(file);
+        return "";
+    }
+    fclose(file);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%016" PRIx64 "-%" PRIx64 "-%02x.img",
+        preload_cache_hash(content.data(), content_size), size, fill);
+    std::string cache_path = dir + "/" + name;
+
+    int fd = open(cache_path.c_str(), O_RDONLY);
+    if (fd < 0 && errno == ENOENT)
+    {
+        trace->msg(vp::Trace::LEVEL_INFO, "Creating preload cache file (path: %s, cache: %s)\n",
+            path.c_str(), cache_path.c_str());
+
+        if (!preload_cache_create(cache_path, content, size, fill))
+        {
+            trace->force_warning_no_error("Unable to create preload cache file (path: %s, error: %s)\n",
+                cache_path.c_str(), strerror(errno));
+            return "";
+        }
+
+        fd = open(cache_path.c_str(), O_RDONLY);
+    }
+
+    if (fd < 0)
+    {
+        trace->force_warning_no_error("Unable to open preload cache file (path: %s, error: %s)\n",
+            cache_path.c_str(), strerror(errno));
+        return "";
+    }
+
+    // Protect against hash collisions and files modified in the cache. This is only done when
+    // the content is read anyway, the next simulations find the cache file from the preload
+    // file attributes.
+    bool valid = fstat(fd, &file_stat) == 0 && (uint64_t)file_stat.st_size == size;
+    if (valid)
+    {
+        void *area = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        valid = area != MAP_FAILED && memcmp(area, content.data(), content_size) == 0;
+        if (area != MAP_FAILED)
+        {
+            munmap(area, size);
+        }
+    }
+    close(fd);
+
+    if (!valid)
+    {
+        trace->force_warning_no_error("Preload cache file does not match preload file "
+            "(path: %s, cache: %s)\n", path.c_str(), cache_path.c_str());
+        return "";
+    }
+
+    return name;
+}
+
+
+
+uint8_t *vp::PreloadCache::map(vp::Trace *trace, std::string path, uint64_t size, uint8_t fill)
+{
+    if (!PreloadCache::enabled)
+    {
+        return NULL;
+    }
+
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) != 0)
+    {
+        trace->force_warning_no_error("Unable to open preload file (path: %s, error: %s)\n",
+            path.c_str(), strerror(errno));
+        return NULL;
+    }
+
+    // The preload file is first looked up from its attributes, through a link to the cache file
+    // with its content. The file is only read and hashed when the link does not exist yet.
+    char name[64];
+    snprintf(name, sizeof(name), "%016" PRIx64 "-%" PRIx64 "-%02x.key",
+        preload_cache_key(path, file_stat), size, fill);
+    std::string key_path = PreloadCache::dir + "/" + name;
+    std::string cache_path = key_path;
+
+    int fd = open(key_path.c_str(), O_RDONLY);
+    if (fd < 0 && errno == ENOENT)
+    {
+        std::string cache_name = preload_cache_fill(trace, PreloadCache::dir, path, size, fill);
+        if (cache_name == "")
+        {
+            return NULL;
+        }
+        cache_path = PreloadCache::dir + "/" + cache_name;
+
+        // Like cache files, the link is created under a temporary name and then moved, and a
+        // failure only means that the next simulation will read the file again
+        std::string tmp_path = key_path + ".tmp." + std::to_string(getpid());
+        if (symlink(cache_name.c_str(), tmp_path.c_str()) != 0 ||
+            rename(tmp_path.c_str(), key_path.c_str()) != 0)
+        {
+            unlink(tmp_path.c_str());
+        }
+
+        fd = open(cache_path.c_str(), O_RDONLY);
+    }
+    else
+    {
+        trace->msg(vp::Trace::LEVEL_DEBUG, "Found preload file in cache (path: %s, key: %s)\n",
+            path.c_str(), key_path.c_str());
+    }
+
+    if (fd < 0)
+    {
+        trace->force_warning_no_error("Unable to open preload cache file (path: %s, error: %s)\n",
+            cache_path.c_str(), strerror(errno));
+        return NULL;
+    }
+
+    if (fstat(fd, &file_stat) != 0 || (uint64_t)file_stat.st_size != size)
+    {
+        trace->force_warning_no_error("Invalid preload cache file size (path: %s)\n",
+            cache_path.c_str());
+        close(fd);
+        return NULL;
+    }
+
+    // Private mapping, pages are shared with the other simulations mapping the same file until
+    // they are written
+    void *area = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (area == MAP_FAILED)
+    {
+        trace->force_warning_no_error("Unable to map preload cache file (path: %s, error: %s)\n",
+            cache_path.c_str(), strerror(errno));
+        return NULL;
+    }
+
+    trace->msg(vp::Trace::LEVEL_INFO, "Mapped preload file from cache (path: %s, cache: %s)\n",
+        path.c_str(), cache_path.c_str());
+
+    return (uint8_t *)area;
+}
+
+
+
+void vp::PreloadCache::unmap(uint8_t *data, uint64_t size)
+{
+    munmap(data, size);
+}
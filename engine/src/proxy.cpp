@@ -38,6 +38,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <vp/proxy.hpp>
+#include <vp/host_profiler.hpp>
+#include <vp/fast_forward.hpp>
 #include <vp/controller.hpp>
 #include "vp/top.hpp"
 
@@ -55,6 +57,48 @@ static std::vector<std::string> split(const std::string& s, char delimiter)
 }
 
 
+// Engine statistics are sent as a single JSON line, so that they can be parsed by both the C++
+// and the Python clients
+static std::string engine_stats_to_json(gv::EngineStats &stats)
+{
+    std::string result = "{\"time_engines\": [";
+
+    for (size_t i = 0; i < stats.time_engines.size(); i++)
+    {
+        gv::TimeEngineStats &engine = stats.time_engines[i];
+        result += (i == 0 ? "" : ", ") + std::string("{") +
+            "\"nb_execs\": " + std::to_string(engine.nb_execs) +
+            ", \"nb_same_client\": " + std::to_string(engine.nb_same_client) +
+            ", \"nb_reinserts\": " + std::to_string(engine.nb_reinserts) +
+            ", \"nb_enqueues\": " + std::to_string(engine.nb_enqueues) +
+            ", \"queue_size\": " + std::to_string(engine.queue_size) +
+            ", \"queue_max\": " + std::to_string(engine.queue_max) + "}";
+    }
+
+    result += "], \"clock_engines\": [";
+
+    for (size_t i = 0; i < stats.clock_engines.size(); i++)
+    {
+        gv::ClockEngineStats &engine = stats.clock_engines[i];
+        result += (i == 0 ? "" : ", ") + std::string("{") +
+            "\"path\": \"" + engine.path + "\"" +
+            ", \"frequency\": " + std::to_string(engine.frequency) +
+            ", \"nb_execs\": " + std::to_string(engine.nb_execs) +
+            ", \"nb_events\": " + std::to_string(engine.nb_events) +
+            ", \"nb_enqueues\": " + std::to_string(engine.nb_enqueues) +
+            ", \"nb_cancels\": " + std::to_string(engine.nb_cancels) +
+            ", \"delayed_queue_size\": " + std::to_string(engine.delayed_queue_size) +
+            ", \"delayed_queue_max\": " + std::to_string(engine.delayed_queue_max) + "}";
+    }
+
+    result += "], \"io_req_allocs\": " + std::to_string(stats.io_req_allocs) +
+        ", \"io_req_frees\": " + std::to_string(stats.io_req_frees) +
+        ", \"io_req_mallocs\": " + std::to_string(stats.io_req_mallocs) + "}";
+
+    return result;
+}
+
+
 gv::GvProxy::GvProxy(vp::TimeEngine *engine, vp::Component *top, int req_pipe, int reply_pipe)
   : top(top), req_pipe(req_pipe), reply_pipe(reply_pipe), logger("PROXY")
 {
@@ -373,7 +417,7 @@ void gv::GvProxySession::proxy_loop()
                 {
                     if (words.size() != 3)
                     {
-                        fprintf(stderr, "This command requires 2 arguments: trace [add|remove] regexp");
+                        fprintf(stderr, "This command requires 2 arguments: trace [add|remove|level] regexp or trace flight_recorder dump");
                     }
                     else
                     {
@@ -387,6 +431,10 @@ void gv::GvProxySession::proxy_loop()
                             this->proxy->top->traces.get_trace_engine()->set_trace_level(words[2].c_str());
                             this->proxy->top->traces.get_trace_engine()->check_traces();
                         }
+                        else if (words[1] == "flight_recorder" && words[2] == "dump")
+                        {
+                            this->proxy->top->traces.get_trace_engine()->flight_recorder_dump("proxy");
+                        }
                         else
                         {
                             this->proxy->top->traces.get_trace_engine()->add_exclude_trace_path(0, words[2]);
@@ -396,6 +444,70 @@ void gv::GvProxySession::proxy_loop()
                         fflush(reply_sock);
                     }
                 }
+                else if (words[0] == "engine_stats")
+                {
+                    if (words.size() == 2 && words[1] == "reset")
+                    {
+                        this->gvsoc->reset_engine_stats();
+                        fprintf(reply_sock, "req=%s\n", req.c_str());
+                    }
+                    else
+                    {
+                        gv::EngineStats stats;
+                        this->gvsoc->get_engine_stats(stats);
+                        std::string msg = engine_stats_to_json(stats);
+                        std::unique_lock<std::mutex> lock(this->proxy->mutex);
+                        fprintf(reply_sock, "req=%s;msg=%s\n", req.c_str(), msg.c_str());
+                        lock.unlock();
+                    }
+                    fflush(reply_sock);
+                }
+                else if (words[0] == "checkpoint")
+                {
+                    bool ok = false;
+                    if (words.size() != 3 || (words[1] != "save" && words[1] != "restore"))
+                    {
+                        fprintf(stderr, "This command requires 2 arguments: checkpoint [save|restore] <path>\n");
+                    }
+                    else if (words[1] == "save")
+                    {
+                        ok = this->gvsoc->checkpoint_save(words[2]);
+                    }
+                    else
+                    {
+                        ok = this->gvsoc->checkpoint_restore(words[2]);
+                    }
+                    std::unique_lock<std::mutex> lock(this->proxy->mutex);
+                    fprintf(reply_sock, "req=%s;msg=%s\n", req.c_str(), ok ? "ok" : "error");
+                    fflush(reply_sock);
+                    lock.unlock();
+                }
+                else if (words[0] == "fast_forward")
+                {
+                    if (words.size() != 2 || words[1] != "stop")
+                    {
+                        fprintf(stderr, "This command requires 1 argument: fast_forward stop\n");
+                    }
+                    else
+                    {
+                        vp::FastForward::stop("proxy");
+                    }
+                    fprintf(reply_sock, "req=%s\n", req.c_str());
+                    fflush(reply_sock);
+                }
+                else if (words[0] == "host_profiler")
+                {
+                    if (words.size() != 2 || words[1] != "dump")
+                    {
+                        fprintf(stderr, "This command requires 1 argument: host_profiler dump");
+                    }
+                    else
+                    {
+                        vp::HostProfiler::dump();
+                    }
+                    fprintf(reply_sock, "req=%s\n", req.c_str());
+                    fflush(reply_sock);
+                }
                 else if (words[0] == "event")
                 {
                     if (words.size() != 3)
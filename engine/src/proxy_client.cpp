@@ -278,6 +278,63 @@ void *Gvsoc_proxy_client::get_component(std::string path)
     return (void *)strtol(result.c_str(), NULL, 0);
 }
 
+void Gvsoc_proxy_client::get_engine_stats(gv::EngineStats &stats)
+{
+    std::string result = this->send_command("engine_stats");
+    js::Config *config = js::import_config_from_string(result);
+
+    stats = gv::EngineStats();
+    if (config == NULL)
+    {
+        return;
+    }
+
+    for (js::Config *engine_config: config->get("time_engines")->get_elems())
+    {
+        gv::TimeEngineStats engine;
+        engine.nb_execs = engine_config->get_int("nb_execs");
+        engine.nb_same_client = engine_config->get_int("nb_same_client");
+        engine.nb_reinserts = engine_config->get_int("nb_reinserts");
+        engine.nb_enqueues = engine_config->get_int("nb_enqueues");
+        engine.queue_size = engine_config->get_int("queue_size");
+        engine.queue_max = engine_config->get_int("queue_max");
+        stats.time_engines.push_back(engine);
+    }
+
+    for (js::Config *engine_config: config->get("clock_engines")->get_elems())
+    {
+        gv::ClockEngineStats engine;
+        engine.path = engine_config->get_child_str("path");
+        engine.frequency = engine_config->get_int("frequency");
+        engine.nb_execs = engine_config->get_int("nb_execs");
+        engine.nb_events = engine_config->get_int("nb_events");
+        engine.nb_enqueues = engine_config->get_int("nb_enqueues");
+        engine.nb_cancels = engine_config->get_int("nb_cancels");
+        engine.delayed_queue_size = engine_config->get_int("delayed_queue_size");
+        engine.delayed_queue_max = engine_config->get_int("delayed_queue_max");
+        stats.clock_engines.push_back(engine);
+    }
+
+    stats.io_req_allocs = config->get_int("io_req_allocs");
+    stats.io_req_frees = config->get_int("io_req_frees");
+    stats.io_req_mallocs = config->get_int("io_req_mallocs");
+}
+
+void Gvsoc_proxy_client::reset_engine_stats()
+{
+    this->send_command("engine_stats reset");
+}
+
+bool Gvsoc_proxy_client::checkpoint_save(std::string path)
+{
+    return this->send_command("checkpoint save " + path) == "ok";
+}
+
+bool Gvsoc_proxy_client::checkpoint_restore(std::string path)
+{
+    return this->send_command("checkpoint restore " + path) == "ok";
+}
+
 void Gvsoc_proxy_client::unlock_command()
 {
     this->mutex.unlock();
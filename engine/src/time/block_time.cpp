@@ -23,6 +23,7 @@
 #include <vp/signal.hpp>
 #include <vp/time/block_time.hpp>
 #include <vp/time/time_event.hpp>
+#include <vp/host_profiler.hpp>
 #include <algorithm>
 
 vp::BlockTime::BlockTime(vp::Block *parent, vp::Block &top, vp::TimeEngine *engine) : top(top), time_engine(engine)
@@ -42,7 +43,17 @@ int64_t vp::Block::exec()
         this->time.first_event = current->next;
         current->set_enqueued(false);
 
-        current->meth(current->top, current);
+        if (unlikely(vp::HostProfiler::enabled))
+        {
+            vp::HostProfilerFrame frame;
+            vp::HostProfiler::enter(&frame, current->top, vp::HOST_PROFILER_TIME_EVENT);
+            current->meth(current->top, current);
+            vp::HostProfiler::leave(&frame);
+        }
+        else
+        {
+            current->meth(current->top, current);
+        }
 
         current = this->time.first_event;
     }
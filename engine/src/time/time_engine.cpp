@@ -26,7 +26,6 @@
 
 
 vp::TimeEngine::TimeEngine(js::Config *config)
-    : first_client(NULL)
 {
 }
 
@@ -37,11 +36,15 @@ void vp::TimeEngine::init(vp::Component *top)
 
 int64_t vp::TimeEngine::exec()
 {
-    vp::Block *current = this->first_client;
+    vp::Block *current = this->clients.first();
 
     if (current)
     {
-        first_client = current->time.next;
+        // Statistics are counted locally and only added when the engine stops, so that they do
+        // not cost memory accesses in the loop
+        int64_t nb_execs = 0, nb_same_client = 0, nb_reinserts = 0;
+
+        this->clients.pop();
         current->time.is_enqueued = false;
 
         // Update the global engine time with the current event time
@@ -51,9 +54,10 @@ int64_t vp::TimeEngine::exec()
         {
             current->time.running = true;
 
+            nb_execs++;
             int64_t time = current->exec();
 
-            vp::Block *next = this->first_client;
+            vp::Block *next = this->clients.first();
 
             // Shortcut to quickly continue with the same client
             if (likely(time > 0))
@@ -63,77 +67,87 @@ int64_t vp::TimeEngine::exec()
                 {
                     if (likely(!this->stop_req))
                     {
+                        nb_same_client++;
                         this->time = time;
                         continue;
                     }
                     else
                     {
                         this->stop_req = false;
-                        current->time.next = first_client;
-                        first_client = current;
+                        nb_reinserts++;
                         current->time.next_event_time = time;
                         current->time.is_enqueued = true;
                         current->time.running = false;
+                        this->clients.push(current);
                         break;
                     }
                 }
             }
 
-            // Otherwise remove it, reenqueue it and continue with the next one.
-            // We can optimize a bit the operation as we already know
-            // who to schedule next.
-
-            if (time > 0)
-            {
-                current->time.next_event_time = time;
-                vp::Block *client = next->time.next, *prev = next;
-                while (client && client->time.next_event_time < time)
-                {
-                    prev = client;
-                    client = client->time.next;
-                }
-                current->time.next = client;
-                prev->time.next = current;
-                current->time.is_enqueued = true;
-            }
-
             current->time.running = false;
 
-            current = first_client;
-
             // Leave the loop either if there is no more client to schedule or if there is a stop request.
             // In case of a stop request, always take it into account when time is increased so that teh engine
             // is stopped at the end of the current timestamp. This will ensure the step operation, which is using a
             // stop event, is stepping until the end of the timestamp.
-            if (!current || (this->stop_req && current->time.next_event_time > this->time))
+            if (!next || (this->stop_req && next->time.next_event_time > this->time))
             {
+                if (time > 0)
+                {
+                    nb_reinserts++;
+                    current->time.next_event_time = time;
+                    current->time.is_enqueued = true;
+                    this->clients.push(current, time == next->time.next_event_time);
+                }
                 this->stop_req = false;
                 break;
             }
 
-            vp_assert(first_client->time.next_event_time >= get_time(), NULL, "event time is before vp time\n");
+            vp_assert(next->time.next_event_time >= get_time(), NULL, "event time is before vp time\n");
+
+            // Otherwise reenqueue it and continue with the next one.
+            // We can optimize a bit the operation as we already know who to schedule next, so
+            // the current client can directly take its place in the queue.
+            // In case both have the same timestamp, the next one is kept first.
+            if (time > 0)
+            {
+                nb_reinserts++;
+                current->time.next_event_time = time;
+                current->time.is_enqueued = true;
+                this->clients.replace_first(current, time == next->time.next_event_time);
+            }
+            else
+            {
+                this->clients.pop();
+            }
 
-            first_client = current->time.next;
+            current = next;
             current->time.is_enqueued = false;
 
             // Update the global engine time with the current event time
             this->time = current->time.next_event_time;
         }
-    }
-
-    int64_t time = -1;
 
-    if (this->first_client)
-    {
-        time = this->first_client->time.next_event_time;
+        this->stats.nb_execs += nb_execs;
+        this->stats.nb_same_client += nb_same_client;
+        this->stats.nb_reinserts += nb_reinserts;
     }
 
-    return time;
+    return this->get_next_event_time();
 }
 
 int64_t vp::TimeEngine::run()
 {
-    return this->exec();
+    int64_t time = this->exec();
+
+    // In parallel mode, the other partitions may still be simulating the current window.
+    // Wait for them so that the models can be safely accessed once the engine is stopped.
+    if (this->partition && this->partition->is_main())
+    {
+        this->partition->get_parallel()->sync();
+    }
+
+    return time;
 }
 
 void vp::TimeEngine::bind_to_launcher(gv::Gvsoc_user *launcher)
@@ -148,24 +162,13 @@ bool vp::TimeEngine::dequeue(vp::Block *client)
 
     client->time.is_enqueued = false;
 
-    vp::Block *current = this->first_client, *prev = NULL;
-    while (current && current != client)
-    {
-        prev = current;
-        current = current->time.next;
-    }
-    if (prev)
-        prev->time.next = client->time.next;
-    else
-        this->first_client = client->time.next;
+    this->clients.remove(client);
 
     return true;
 }
 
 bool vp::TimeEngine::enqueue(vp::Block *client, int64_t full_time)
 {
-    bool update = false;
-
     vp_assert(full_time >= get_time(), NULL, "Time must be higher than current time\n");
 
     if (client->time.is_running())
@@ -179,31 +182,43 @@ bool vp::TimeEngine::enqueue(vp::Block *client, int64_t full_time)
     }
 
     client->time.is_enqueued = true;
-
-    vp::Block *current = first_client, *prev = NULL;
     client->time.next_event_time = full_time;
-    while (current && current->time.next_event_time < client->time.next_event_time)
-    {
-        prev = current;
-        current = current->time.next;
-    }
-    if (prev)
-        prev->time.next = client;
-    else
+
+    this->clients.push(client);
+
+    this->stats.nb_enqueues++;
+    if (this->clients.size() > this->stats.queue_max)
     {
-        update = true;
-        first_client = client;
+        this->stats.queue_max = this->clients.size();
     }
-    client->time.next = current;
 
-    if (update && this->launcher)
+    if (this->clients.first() == client)
     {
-        this->launcher->was_updated();
+        if (this->launcher)
+        {
+            this->launcher->was_updated();
+        }
+        if (this->partition)
+        {
+            this->partition->wakeup();
+        }
     }
 
     return true;
 }
 
+void vp::TimeEngine::get_stats(gv::TimeEngineStats &stats)
+{
+    stats = this->stats;
+    stats.queue_size = this->clients.size();
+}
+
+void vp::TimeEngine::reset_stats()
+{
+    this->stats = gv::TimeEngineStats();
+    this->stats.queue_max = this->clients.size();
+}
+
 void vp::TimeEngine::quit(int status)
 {
     this->pause();
@@ -224,6 +239,7 @@ void vp::TimeEngine::flush()
 
 void vp::TimeEngine::fatal(const char *fmt, ...)
 {
+    this->top->traces.get_trace_engine()->flight_recorder_dump("fatal");
     fprintf(stdout, "[\033[31mFATAL\033[0m] ");
     va_list ap;
     va_start(ap, fmt);
@@ -0,0 +1,481 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vp/vp.hpp>
+#include <vp/time/time_partition.hpp>
+#include <vp/time/time_event.hpp>
+
+
+void vp::PartitionMailbox::drain(std::vector<PartitionMessage> &messages)
+{
+    PartitionMessage msg;
+
+    while (this->ring.pop(msg))
+    {
+        messages.push_back(msg);
+    }
+
+    messages.insert(messages.end(), this->overflow.begin(), this->overflow.end());
+    this->overflow.clear();
+}
+
+
+
+vp::TimePartition::TimePartition(ParallelEngine *parallel, int id, vp::TimeEngine *engine,
+    std::vector<std::string> paths)
+    : parallel(parallel), id(id), engine(engine), paths(paths)
+{
+    engine->partition = this;
+
+    this->block = new vp::Block(NULL, "partition_" + std::to_string(id), engine,
+        parallel->trace_engine, parallel->power_engine);
+
+    this->window_event = new vp::TimeEvent(this->block, &TimePartition::window_end_handler);
+    this->window_event->get_args()[0] = this;
+    this->delivery_event = new vp::TimeEvent(this->block, &TimePartition::delivery_handler);
+    this->delivery_event->get_args()[0] = this;
+}
+
+vp::TimePartition::~TimePartition()
+{
+    for (PartitionMailbox *mailbox : this->mailboxes)
+    {
+        delete mailbox;
+    }
+}
+
+void vp::TimePartition::send(TimePartition *to, PartitionMessageMeth *meth, void *context,
+    void *arg, const void *data, int size)
+{
+    PartitionMessage msg;
+
+    msg.time = this->engine->get_time();
+    msg.meth = meth;
+    msg.context = context;
+    msg.arg = arg;
+    if (size)
+    {
+        memcpy(msg.data, data, size);
+    }
+
+    // Each sending partition has its own mailbox so that the queue has a single producer
+    to->mailboxes[this->id]->post(msg);
+}
+
+void vp::TimePartition::wakeup()
+{
+    // Only the main partition can receive events while the quantum loop is stopped, since
+    // the other ones are only driven by the main one.
+    if (this->id == 0)
+    {
+        this->parallel->wakeup();
+    }
+}
+
+void vp::TimePartition::start()
+{
+    this->thread = new std::thread(&vp::TimePartition::worker_routine, this);
+#ifndef __APPLE__
+    pthread_setname_np(this->thread->native_handle(), ("partition_" + std::to_string(this->id)).c_str());
+#endif
+}
+
+void vp::TimePartition::stop()
+{
+    this->thread->join();
+    delete this->thread;
+    this->thread = NULL;
+}
+
+void vp::TimePartition::worker_routine()
+{
+    ParallelEngine *parallel = this->parallel;
+
+    while (1)
+    {
+        parallel->spin_wait([&]() {
+            return parallel->exit.load(std::memory_order_acquire) ||
+                parallel->window_id.load(std::memory_order_acquire) != this->window_id;
+        });
+
+        if (parallel->exit.load(std::memory_order_acquire))
+        {
+            break;
+        }
+
+        this->window_id = parallel->window_id.load(std::memory_order_acquire);
+
+        this->run_window(parallel->window_end);
+
+        // The last worker to finish wakes up the main thread
+        if (parallel->nb_running.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            parallel->notify();
+        }
+    }
+}
+
+void vp::TimePartition::run_window(int64_t end)
+{
+    // The engine is paused by the window event, after all the events of the last timestamp
+    // of the window have been executed. Models may also pause the engine, in which case we
+    // just continue until the end of the window.
+    this->window_event->enqueue(end - this->engine->get_time());
+
+    while (this->window_event->is_enqueued())
+    {
+        this->engine->run();
+    }
+}
+
+void vp::TimePartition::window_end_handler(vp::Block *__this, vp::TimeEvent *event)
+{
+    TimePartition *_this = (TimePartition *)event->get_args()[0];
+    _this->engine->pause();
+}
+
+void vp::TimePartition::delivery_handler(vp::Block *__this, vp::TimeEvent *event)
+{
+    TimePartition *_this = (TimePartition *)event->get_args()[0];
+
+    // Messages executed here can only post new messages to the mailboxes, so the pending
+    // list is not modified while we go through it.
+    for (size_t i = 0; i < _this->pending.size(); i++)
+    {
+        PartitionMessage *msg = &_this->pending[i];
+        msg->meth(msg);
+    }
+
+    _this->pending.clear();
+}
+
+
+
+vp::ParallelEngine::ParallelEngine(js::Config *config, vp::TimeEngine *main_engine,
+    vp::TraceEngine *trace_engine, vp::PowerEngine *power_engine)
+    : trace_engine(trace_engine), power_engine(power_engine), window_id(0), nb_running(0),
+    exit(false)
+{
+    // Trace events, the flight recorder and memory checks are managed with shared buffers which
+    // are not protected against concurrent accesses
+    if (config->get_child_bool("events/enabled"))
+    {
+        throw std::runtime_error("Parallel simulation can not be used with events");
+    }
+    if (config->get_child_bool("traces/flight_recorder/enabled"))
+    {
+        throw std::runtime_error("Parallel simulation can not be used with the flight recorder");
+    }
+    if (config->get_child_bool("memcheck"))
+    {
+        throw std::runtime_error("Parallel simulation can not be used with memory checks");
+    }
+
+    js::Config *quantum = config->get("parallel/quantum");
+    this->quantum = quantum ? quantum->get_int() : 0;
+
+    this->mailbox_size = config->get_child_int("parallel/mailbox_size");
+    if (this->mailbox_size <= 0)
+    {
+        this->mailbox_size = VP_PARALLEL_MAILBOX_SIZE;
+    }
+
+    // The main partition contains everything which is not explicitly put in another
+    // partition
+    this->partitions.push_back(new TimePartition(this, 0, main_engine, {}));
+
+    js::Config *partitions = config->get("parallel/partitions");
+    if (partitions)
+    {
+        for (js::Config *partition : partitions->get_elems())
+        {
+            // A partition is described either by the path of its root component or by a list
+            // of paths, for example to include the clock domain of a cluster which is usually
+            // instantiated next to it.
+            std::vector<std::string> paths;
+            std::vector<js::Config *> elems = partition->get_elems();
+            if (elems.size() == 0)
+            {
+                paths.push_back(partition->get_str());
+            }
+            for (js::Config *elem : elems)
+            {
+                paths.push_back(elem->get_str());
+            }
+
+            this->partitions.push_back(new TimePartition(this, this->partitions.size(),
+                new vp::TimeEngine(config), paths));
+        }
+    }
+
+    for (TimePartition *partition : this->partitions)
+    {
+        for (size_t i = 0; i < this->partitions.size(); i++)
+        {
+            partition->mailboxes.push_back(new PartitionMailbox(this->mailbox_size));
+        }
+    }
+
+    this->block = new vp::Block(NULL, "parallel", main_engine, trace_engine, power_engine);
+    this->quantum_event = new vp::TimeEvent(this->block, &ParallelEngine::quantum_handler);
+    this->quantum_event->get_args()[0] = this;
+}
+
+vp::ParallelEngine::~ParallelEngine()
+{
+    this->stop();
+
+    for (TimePartition *partition : this->partitions)
+    {
+        if (partition->id != 0)
+        {
+            delete partition->engine;
+        }
+        delete partition;
+    }
+}
+
+vp::TimeEngine *vp::ParallelEngine::get_engine(std::string path, vp::TimeEngine *parent_engine)
+{
+    for (TimePartition *partition : this->partitions)
+    {
+        for (std::string &partition_path : partition->paths)
+        {
+            if (partition_path == path)
+            {
+                return partition->engine;
+            }
+        }
+    }
+
+    return parent_engine;
+}
+
+void vp::ParallelEngine::add_crossing(vp::ClockEngine *master, vp::ClockEngine *slave)
+{
+    if (master)
+    {
+        this->crossing_engines.insert(master);
+    }
+    if (slave)
+    {
+        this->crossing_engines.insert(slave);
+    }
+}
+
+void vp::ParallelEngine::check_partitions(vp::Block *block)
+{
+    // Clock events are executed by the time engine of the clock domain, so a component
+    // can only be in the partition of its clock domain
+    vp::ClockEngine *clock = block->clock.get_engine();
+    if (clock && clock->time.get_engine() != block->time.get_engine())
+    {
+        throw std::runtime_error("Block " + block->get_path() +
+            " is not in the same partition as its clock domain " + clock->get_path());
+    }
+
+    for (vp::Block *child : block->get_childs())
+    {
+        this->check_partitions(child);
+    }
+}
+
+void vp::ParallelEngine::start(vp::Component *top)
+{
+    this->check_partitions(top);
+
+    for (TimePartition *partition : this->partitions)
+    {
+        if (partition->id != 0)
+        {
+            partition->engine->init(top);
+            partition->start();
+        }
+    }
+
+    this->started = true;
+
+    // The first window is started at the first timestamp, once the system has been reset
+    this->quantum_event->enqueue(0);
+}
+
+void vp::ParallelEngine::stop()
+{
+    if (this->started)
+    {
+        this->sync();
+
+        this->exit.store(true, std::memory_order_release);
+        this->notify();
+
+        for (TimePartition *partition : this->partitions)
+        {
+            if (partition->id != 0)
+            {
+                partition->stop();
+            }
+        }
+
+        this->started = false;
+        this->concurrent = false;
+    }
+}
+
+void vp::ParallelEngine::sync()
+{
+    this->spin_wait([this]() {
+        return this->nb_running.load(std::memory_order_acquire) == 0;
+    });
+}
+
+void vp::ParallelEngine::wakeup()
+{
+    if (this->idle)
+    {
+        this->idle = false;
+        this->quantum_event->enqueue(0);
+    }
+}
+
+void vp::ParallelEngine::notify()
+{
+    // Taking the lock makes sure a thread which has just checked the condition is either
+    // not yet waiting or already waiting on the condition variable, so that the notification
+    // is never lost.
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+    }
+    this->cond.notify_all();
+}
+
+void vp::ParallelEngine::spin_wait(std::function<bool()> cond)
+{
+    // Windows are usually short, so first poll the condition before going to sleep
+    for (int i = 0; i < VP_PARALLEL_SPIN_COUNT; i++)
+    {
+        if (cond())
+        {
+            return;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->cond.wait(lock, cond);
+}
+
+int64_t vp::ParallelEngine::get_quantum()
+{
+    if (this->quantum > 0)
+    {
+        return this->quantum;
+    }
+
+    // Without user quantum, partitions are synchronized every cycle of the fastest clock
+    // domain having a crossing binding, which is the minimum latency of these bindings.
+    // The period is checked at each window as frequencies can be changed dynamically.
+    int64_t result = 0;
+    for (vp::ClockEngine *engine : this->crossing_engines)
+    {
+        int64_t period = engine->get_period();
+        if (period > 0 && (result == 0 || period < result))
+        {
+            result = period;
+        }
+    }
+
+    return result > 0 ? result : VP_PARALLEL_DEFAULT_QUANTUM;
+}
+
+void vp::ParallelEngine::exchange()
+{
+    for (TimePartition *partition : this->partitions)
+    {
+        size_t first = partition->pending.size();
+
+        // Mailboxes are drained in the order of the sending partitions and messages are then
+        // sorted by time, so that the delivery order only depends on the simulated time and
+        // not on the way threads were scheduled.
+        for (PartitionMailbox *mailbox : partition->mailboxes)
+        {
+            mailbox->drain(partition->pending);
+        }
+
+        std::stable_sort(partition->pending.begin() + first, partition->pending.end(),
+            [](const PartitionMessage &a, const PartitionMessage &b) { return a.time < b.time; });
+
+        // Messages are executed at the beginning of the next window
+        if (partition->pending.size() && !partition->delivery_event->is_enqueued())
+        {
+            partition->delivery_event->enqueue(0);
+        }
+    }
+}
+
+void vp::ParallelEngine::quantum_handler(vp::Block *__this, vp::TimeEvent *event)
+{
+    ParallelEngine *_this = (ParallelEngine *)event->get_args()[0];
+    vp::TimeEngine *main_engine = _this->partitions[0]->engine;
+    int64_t time = main_engine->get_time();
+
+    // Wait until all partitions reach the end of the window. Since they are all stopped,
+    // the main thread can now access any of them.
+    _this->sync();
+
+    for (TimePartition *partition : _this->partitions)
+    {
+        if (partition->id != 0 && partition->engine->finished && !partition->quit_forwarded)
+        {
+            partition->quit_forwarded = true;
+            main_engine->quit(partition->engine->stop_status);
+        }
+    }
+
+    _this->exchange();
+
+    // Find the first event of the whole system, so that windows where nothing happens are
+    // skipped
+    int64_t next = -1;
+    for (TimePartition *partition : _this->partitions)
+    {
+        int64_t next_time = partition->engine->get_next_event_time();
+        if (next_time != -1 && (next == -1 || next_time < next))
+        {
+            next = next_time;
+        }
+    }
+
+    if (next == -1)
+    {
+        // Nothing to execute anymore, the quantum loop is restarted when the main engine
+        // gets a new event
+        _this->idle = true;
+        return;
+    }
+
+    _this->window_end = std::max(time, next) + _this->get_quantum();
+
+    _this->concurrent = true;
+    _this->nb_running.store(_this->partitions.size() - 1, std::memory_order_release);
+    _this->window_id.fetch_add(1, std::memory_order_acq_rel);
+    _this->notify();
+
+    _this->quantum_event->enqueue(_this->window_end - time);
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <vp/vp.hpp>
+#include <vp/time/time_queue.hpp>
+#include <algorithm>
+
+
+inline bool vp::TimeQueue::before(Entry &a, Entry &b)
+{
+    return a.time < b.time || (a.time == b.time && a.seq < b.seq);
+}
+
+inline void vp::TimeQueue::set(int index, Entry &entry)
+{
+    this->heap[index] = entry;
+    entry.client->time.queue_index = index;
+}
+
+void vp::TimeQueue::sift_up(int index)
+{
+    Entry entry = this->heap[index];
+
+    while (index > 0)
+    {
+        int parent = (index - 1) / 2;
+        if (!this->before(entry, this->heap[parent]))
+        {
+            break;
+        }
+        this->set(index, this->heap[parent]);
+        index = parent;
+    }
+
+    this->set(index, entry);
+}
+
+void vp::TimeQueue::sift_down(int index)
+{
+    int size = this->heap.size();
+    Entry entry = this->heap[index];
+
+    while (1)
+    {
+        int child = index * 2 + 1;
+        if (child >= size)
+        {
+            break;
+        }
+        if (child + 1 < size && this->before(this->heap[child + 1], this->heap[child]))
+        {
+            child++;
+        }
+        if (!this->before(this->heap[child], entry))
+        {
+            break;
+        }
+        this->set(index, this->heap[child]);
+        index = child;
+    }
+
+    this->set(index, entry);
+}
+
+void vp::TimeQueue::sort()
+{
+    // Reverse order of election, the first client is at the end
+    std::sort(this->heap.begin(), this->heap.end(),
+        [this](Entry &a, Entry &b) { return this->before(b, a); });
+
+    this->sorted = true;
+}
+
+void vp::TimeQueue::heapify()
+{
+    // A sorted array in the order of election is a valid heap. Clients with the same timestamp
+    // are ordered by their position in the sorted array, which is turned into sequence numbers
+    // lower than any future one.
+    std::reverse(this->heap.begin(), this->heap.end());
+
+    int size = this->heap.size();
+    for (int i = 0; i < size; i++)
+    {
+        this->heap[i].seq = i - size;
+        this->heap[i].client->time.queue_index = i;
+    }
+    this->seq = -size;
+
+    this->sorted = false;
+}
+
+void vp::TimeQueue::heap_push(vp::Block *client, bool behind_first)
+{
+    if (this->sorted)
+    {
+        this->heapify();
+    }
+
+    Entry entry = { client->time.next_event_time, 0, client };
+
+    if (behind_first)
+    {
+        // Take the sequence number of the first client and give it a new one. Its key only
+        // decreases so it stays at the top, and the new client gets elected right after it.
+        entry.seq = this->heap[0].seq;
+        this->heap[0].seq = --this->seq;
+    }
+    else
+    {
+        entry.seq = --this->seq;
+    }
+
+    this->heap.push_back(entry);
+    this->sift_up(this->heap.size() - 1);
+}
+
+void vp::TimeQueue::heap_replace_first(vp::Block *client, bool behind_first)
+{
+    // Taking the sequence number of the removed client gives the new one the same rank
+    // among the clients having the same timestamp
+    Entry entry = { client->time.next_event_time,
+        behind_first ? this->heap[0].seq : --this->seq, client };
+
+    this->heap[0].client->time.queue_index = -1;
+    this->heap[0] = entry;
+    this->sift_down(0);
+}
+
+vp::Block *vp::TimeQueue::heap_pop()
+{
+    vp::Block *client = this->heap[0].client;
+    this->remove(client);
+    return client;
+}
+
+void vp::TimeQueue::remove(vp::Block *client)
+{
+    if (this->sorted)
+    {
+        // Clients are not indexed in the sorted array, which is small enough to be browsed
+        auto it = std::find_if(this->heap.begin(), this->heap.end(),
+            [client](Entry &entry) { return entry.client == client; });
+        if (it != this->heap.end())
+        {
+            this->heap.erase(it);
+        }
+        return;
+    }
+
+    int index = client->time.queue_index;
+    client->time.queue_index = -1;
+
+    Entry last = this->heap.back();
+
+    this->heap.pop_back();
+
+    if (last.client != client)
+    {
+        // Move the last entry to the hole and restore the heap property in whichever
+        // direction is needed
+        this->heap[index] = last;
+        if (index > 0 && this->before(last, this->heap[(index - 1) / 2]))
+        {
+            this->sift_up(index);
+        }
+        else
+        {
+            this->sift_down(index);
+        }
+    }
+
+    // Go back to the sorted mode once the queue is small enough. This is done only at half the
+    // maximum size, to not sort the queue again and again when its size is around the limit.
+    if (this->heap.size() <= TIME_QUEUE_SORTED_MAX / 2)
+    {
+        this->sort();
+    }
+}
@@ -20,8 +20,23 @@
  */
 
 #include <string>
+#include <algorithm>
+#include <inttypes.h>
+#include <unistd.h>
+#include <unordered_map>
 #include <vp/vp.hpp>
 #include "vp/top.hpp"
+#include "vp/itf/io.hpp"
+#include "vp/host_profiler.hpp"
+#include "vp/preload_cache.hpp"
+#include "vp/checkpoint.hpp"
+#include "vp/fast_forward.hpp"
+
+// "gvsockpt", at the beginning of checkpoint files
+#define CHECKPOINT_MAGIC   0x74706b636f737667ULL
+#define CHECKPOINT_VERSION 1
+// Written after each part of the checkpoint to detect blocks reading more or less than they wrote
+#define CHECKPOINT_MARKER  0x3c3c3c3c3e3e3e3eULL
 
 vp::Top::Top(std::string config_path, bool is_async, gv::Controller *launcher)
 {
@@ -33,11 +48,28 @@ vp::Top::Top(std::string config_path, bool is_async, gv::Controller *launcher)
 
     this->gv_config = js_config->get("target/gvsoc");
 
+    vp::IoReqPool::set_slab_size(this->gv_config->get_child_int("io_req_pool/slab_size"));
+
+    // Must be enabled before the components are loaded, since their bindings are only
+    // instrumented if it is enabled
+    vp::HostProfiler::init(this->gv_config);
+    vp::PreloadCache::init(this->gv_config);
+    vp::FastForward::init(this->gv_config);
+
     this->time_engine = new vp::TimeEngine(this->gv_config);
     this->trace_engine = new vp::TraceEngine(this->gv_config);
     this->power_engine = new vp::PowerEngine(this->gv_config);
     this->memcheck = new vp::MemCheck();
 
+    // In parallel mode, the parallel engine creates one time engine per partition, which
+    // are then assigned to components while they are loaded
+    this->parallel_engine = NULL;
+    if (this->gv_config->get_child_bool("parallel/enabled"))
+    {
+        this->parallel_engine = new vp::ParallelEngine(this->gv_config, this->time_engine,
+            this->trace_engine, this->power_engine);
+    }
+
     this->top_instance = vp::Component::load_component(js_config->get("**/target"), this->gv_config,
         NULL, "", this->time_engine, this->trace_engine, this->power_engine, this->memcheck);
 
@@ -56,10 +88,312 @@ void vp::Top::flush()
 void vp::Top::start()
 {
     this->trace_engine->start();
+
+    if (this->parallel_engine)
+    {
+        this->parallel_engine->start(this->top_instance);
+    }
+}
+
+void vp::Top::stop()
+{
+    if (this->parallel_engine)
+    {
+        this->parallel_engine->stop();
+    }
 }
 
 vp::Top::~Top()
 {
+    if (this->gv_config->get_child_bool("io_req_pool/report"))
+    {
+        vp::IoReqPoolStats stats;
+        vp::IoReqPool::get_stats(&stats);
+        printf("IO request pool: %" PRId64 " allocations, %" PRId64 " releases, %" PRId64 " host allocations, %" PRId64 " free requests\n",
+            stats.nb_allocs, stats.nb_frees, stats.nb_mallocs, stats.nb_free_reqs);
+    }
+
+    vp::HostProfiler::dump();
+
+    delete this->parallel_engine;
     delete this->power_engine;
     delete this->trace_engine;
 }
+
+
+
+void vp::Top::get_clock_engines(vp::Block *block, std::vector<vp::ClockEngine *> &engines)
+{
+    vp::ClockEngine *engine = dynamic_cast<vp::ClockEngine *>(block);
+    if (engine)
+    {
+        engines.push_back(engine);
+    }
+
+    for (vp::Block *child: block->get_childs())
+    {
+        this->get_clock_engines(child, engines);
+    }
+}
+
+void vp::Top::get_time_engines(std::vector<vp::TimeEngine *> &engines)
+{
+    // Partition engines are found through the clock engines they schedule
+    std::vector<vp::ClockEngine *> clock_engines;
+    this->get_clock_engines(this->top_instance, clock_engines);
+
+    engines.push_back(this->time_engine);
+    for (vp::ClockEngine *clock_engine: clock_engines)
+    {
+        vp::TimeEngine *engine = clock_engine->time_engine;
+        if (engine && std::find(engines.begin(), engines.end(), engine) == engines.end())
+        {
+            engines.push_back(engine);
+        }
+    }
+}
+
+void vp::Top::get_engine_stats(gv::EngineStats &stats)
+{
+    std::vector<vp::TimeEngine *> time_engines;
+    std::vector<vp::ClockEngine *> clock_engines;
+    this->get_time_engines(time_engines);
+    this->get_clock_engines(this->top_instance, clock_engines);
+
+    stats = gv::EngineStats();
+
+    for (vp::TimeEngine *engine: time_engines)
+    {
+        stats.time_engines.emplace_back();
+        engine->get_stats(stats.time_engines.back());
+    }
+
+    for (vp::ClockEngine *engine: clock_engines)
+    {
+        stats.clock_engines.emplace_back();
+        engine->get_stats(stats.clock_engines.back());
+    }
+
+    vp::IoReqPoolStats pool_stats;
+    vp::IoReqPool::get_stats(&pool_stats);
+    stats.io_req_allocs = pool_stats.nb_allocs;
+    stats.io_req_frees = pool_stats.nb_frees;
+    stats.io_req_mallocs = pool_stats.nb_mallocs;
+}
+
+void vp::Top::reset_engine_stats()
+{
+    std::vector<vp::TimeEngine *> time_engines;
+    std::vector<vp::ClockEngine *> clock_engines;
+    this->get_time_engines(time_engines);
+    this->get_clock_engines(this->top_instance, clock_engines);
+
+    for (vp::TimeEngine *engine: time_engines)
+    {
+        engine->reset_stats();
+    }
+
+    for (vp::ClockEngine *engine: clock_engines)
+    {
+        engine->reset_stats();
+    }
+}
+
+
+
+void vp::Top::get_blocks(vp::Block *block, std::vector<vp::Block *> &blocks)
+{
+    blocks.push_back(block);
+
+    for (vp::Block *child: block->get_childs())
+    {
+        this->get_blocks(child, blocks);
+    }
+}
+
+bool vp::Top::checkpoint_save(std::string path)
+{
+    if (this->parallel_engine)
+    {
+        fprintf(stderr, "Checkpoints are not supported in parallel mode\n");
+        return false;
+    }
+
+    // Memcheck keeps the state of each byte and the allocated buffers in the memories and in
+    // the memcheck engine, which are not part of the checkpoint
+    if (this->trace_engine->is_memcheck_enabled())
+    {
+        fprintf(stderr, "Checkpoints are not supported with memcheck\n");
+        return false;
+    }
+
+    std::vector<vp::Block *> blocks;
+    std::vector<vp::ClockEngine *> clock_engines;
+    std::unordered_map<vp::Block *, int64_t> block_ids;
+    this->get_blocks(this->top_instance, blocks);
+    this->get_clock_engines(this->top_instance, clock_engines);
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        block_ids[blocks[i]] = i;
+    }
+
+    vp::CheckpointWriter writer(path);
+    writer.write_u64(CHECKPOINT_MAGIC);
+    writer.write_u64(CHECKPOINT_VERSION);
+    writer.write_u64(blocks.size());
+
+    // First the state of the models, so that it is restored before events are enqueued
+    for (vp::Block *block: blocks)
+    {
+        writer.write_str(block->get_path());
+        block->checkpoint_save(writer);
+        writer.write_u64(CHECKPOINT_MARKER);
+    }
+
+    writer.write_i64(this->time_engine->get_time());
+
+    for (vp::Block *block: blocks)
+    {
+        block->checkpoint_save_events(writer);
+    }
+
+    writer.write_u64(clock_engines.size());
+    for (vp::ClockEngine *engine: clock_engines)
+    {
+        engine->checkpoint_save_engine(writer, block_ids);
+    }
+
+    writer.write_u64(CHECKPOINT_MARKER);
+
+    if (!writer.close())
+    {
+        fprintf(stderr, "Failed to save checkpoint (path: %s, error: %s)\n", path.c_str(),
+            writer.get_error().c_str());
+        unlink(path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool vp::Top::checkpoint_restore(std::string path)
+{
+    if (this->parallel_engine)
+    {
+        fprintf(stderr, "Checkpoints are not supported in parallel mode\n");
+        return false;
+    }
+
+    // Memcheck keeps the state of each byte and the allocated buffers in the memories and in
+    // the memcheck engine, which are not part of the checkpoint
+    if (this->trace_engine->is_memcheck_enabled())
+    {
+        fprintf(stderr, "Checkpoints are not supported with memcheck\n");
+        return false;
+    }
+
+    std::vector<vp::Block *> blocks;
+    std::vector<vp::ClockEngine *> clock_engines;
+    this->get_blocks(this->top_instance, blocks);
+    this->get_clock_engines(this->top_instance, clock_engines);
+
+    vp::CheckpointReader reader(path);
+    if (reader.read_u64() != CHECKPOINT_MAGIC && reader.is_ok())
+    {
+        reader.set_error("not a checkpoint file");
+    }
+    reader.check_u64(CHECKPOINT_VERSION, "checkpoint version");
+    reader.check_u64(blocks.size(), "number of blocks");
+
+    if (!reader.is_ok())
+    {
+        fprintf(stderr, "Failed to restore checkpoint (path: %s, error: %s)\n", path.c_str(),
+            reader.get_error().c_str());
+        return false;
+    }
+
+    for (vp::Block *block: blocks)
+    {
+        std::string block_path = reader.read_str();
+        if (reader.is_ok() && block_path != block->get_path())
+        {
+            reader.set_error("block mismatch (checkpoint: " + block_path + ", platform: " +
+                block->get_path() + ")");
+        }
+        if (!reader.is_ok())
+        {
+            break;
+        }
+
+        block->checkpoint_restore(reader);
+
+        if (reader.read_u64() != CHECKPOINT_MARKER && reader.is_ok())
+        {
+            reader.set_error("state of " + block->get_path() + " does not match");
+        }
+    }
+
+    int64_t time = reader.read_i64();
+
+    if (reader.is_ok())
+    {
+        for (vp::Block *block: blocks)
+        {
+            block->checkpoint_drop_events();
+        }
+
+        for (vp::ClockEngine *engine: clock_engines)
+        {
+            engine->checkpoint_drop_engine();
+        }
+
+        // Only blocks outside the hierarchy, like the one used for stepping, are still
+        // enqueued. They are not part of the checkpoint and keep their relative times.
+        std::vector<vp::Block *> clients;
+        while (this->time_engine->clients.first())
+        {
+            clients.push_back(this->time_engine->clients.first());
+            this->time_engine->dequeue(clients.back());
+        }
+
+        int64_t delta = time - this->time_engine->time;
+        this->time_engine->time = time;
+
+        for (vp::Block *client: clients)
+        {
+            client->checkpoint_shift_events(delta);
+        }
+
+        for (vp::Block *block: blocks)
+        {
+            block->checkpoint_restore_events(reader);
+        }
+
+        reader.check_u64(clock_engines.size(), "number of clock engines");
+        for (vp::ClockEngine *engine: clock_engines)
+        {
+            if (!reader.is_ok())
+            {
+                break;
+            }
+            engine->checkpoint_restore_engine(reader, blocks);
+        }
+
+        if (reader.read_u64() != CHECKPOINT_MARKER && reader.is_ok())
+        {
+            reader.set_error("invalid end of checkpoint");
+        }
+    }
+
+    // Masters may have cached direct accesses to memories which have been restored
+    vp::IoDmi::invalidate_all();
+
+    if (!reader.is_ok())
+    {
+        fprintf(stderr, "Failed to restore checkpoint, the platform state is inconsistent "
+            "(path: %s, error: %s)\n", path.c_str(), reader.get_error().c_str());
+        return false;
+    }
+
+    return true;
+}
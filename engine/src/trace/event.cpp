@@ -33,7 +33,7 @@ vp::Event_trace::Event_trace(string trace_name, Event_file *file, int width, boo
   id = vcd_id++;
   if (file)
   {
-    file->add_trace(trace_name, id, width, is_real, is_string);
+    file->reg_trace(trace_name, id, width, is_real, is_string);
   }
   this->width = width;
   this->bytes = (width+7)/8;
@@ -102,11 +102,20 @@ vp::Event_trace *vp::Event_dumper::get_trace(string trace_name, string file_name
         {
           event_file = new Raw_file(this, file_name);
         }
+        else if (format == "tdb")
+        {
+          event_file = new Tdb_file(this, file_name, this->config);
+        }
         else
         {
           throw std::invalid_argument("Unknown trace format (name: " + format + ")\n");
         }
         event_files[file_name] = event_file;
+
+        if (this->parallel)
+        {
+          event_file->start_writer(this);
+        }
       }
     }
 
@@ -140,14 +149,31 @@ void vp::Event_trace::set_vcd_user(gv::Vcd_user *user)
 }
 
 
+vp::Event_dumper::~Event_dumper()
+{
+  for (auto &x: event_files)
+  {
+    delete x.second;
+  }
+}
+
 void vp::Event_dumper::close()
 {
   for (auto &x: event_files)
   {
-    x.second->close();
+    x.second->stop();
   }
 }
 
+void vp::Event_dumper::flush()
+{
+  for (Event_file *file: this->pending_files)
+  {
+    file->flush_batch();
+  }
+  this->pending_files.clear();
+}
+
 void vp::Event_dumper::set_vcd_user(gv::Vcd_user *user, bool is_external_dumper)
 {
     this->user_vcd = user;
@@ -160,4 +186,171 @@ void vp::Event_dumper::set_vcd_user(gv::Vcd_user *user, bool is_external_dumper)
             x.second->set_vcd_user(user);
         }
     }
-}
\ No newline at end of file
+}
+
+
+void vp::Event_file::start_writer(Event_dumper *dumper)
+{
+  this->dumper = dumper;
+  pthread_mutex_init(&this->mutex, NULL);
+  pthread_mutex_init(&this->dump_mutex, NULL);
+  pthread_cond_init(&this->cond, NULL);
+  this->batch = new std::vector<uint8_t>();
+  this->batch->reserve(EVENT_FILE_BATCH_SIZE * 2);
+  this->nb_batches = 1;
+  this->writer = new std::thread(&vp::Event_file::writer_routine, this);
+#ifndef __APPLE__
+  pthread_setname_np(this->writer->native_handle(), "event_writer");
+#endif
+}
+
+void vp::Event_file::reg_trace(std::string name, int id, int width, bool is_real, bool is_string)
+{
+  // Traces can be declared by the simulation while the writer thread is dumping
+  if (this->writer)
+  {
+    pthread_mutex_lock(&this->dump_mutex);
+    this->add_trace(name, id, width, is_real, is_string);
+    pthread_mutex_unlock(&this->dump_mutex);
+  }
+  else
+  {
+    this->add_trace(name, id, width, is_real, is_string);
+  }
+}
+
+void vp::Event_file::flush_batch()
+{
+  if (this->writer == NULL || this->batch->size() == 0)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&this->mutex);
+
+  this->ready_batches.push(this->batch);
+  pthread_cond_broadcast(&this->cond);
+
+  // Take a free batch, or allocate a new one as long as the maximum is not reached, otherwise
+  // wait for the writer thread
+  while (this->free_batches.size() == 0 && this->nb_batches >= EVENT_FILE_NB_BATCH)
+  {
+    pthread_cond_wait(&this->cond, &this->mutex);
+  }
+
+  if (this->free_batches.size() == 0)
+  {
+    this->batch = new std::vector<uint8_t>();
+    this->batch->reserve(EVENT_FILE_BATCH_SIZE * 2);
+    this->nb_batches++;
+  }
+  else
+  {
+    this->batch = this->free_batches.back();
+    this->free_batches.pop_back();
+  }
+
+  pthread_mutex_unlock(&this->mutex);
+}
+
+void vp::Event_file::dump_batch(std::vector<uint8_t> *batch)
+{
+  uint8_t *data = batch->data();
+  uint8_t *end = data + batch->size();
+
+  while (data < end)
+  {
+    Event_file_record *record = (Event_file_record *)data;
+    data += sizeof(Event_file_record);
+    uint8_t *event = data;
+    data += record->size;
+    uint8_t *flags_mask = NULL;
+    if (record->flags == 1)
+    {
+      flags_mask = data;
+      data += record->size;
+    }
+
+    this->dump(record->timestamp, record->id, event, record->width, record->is_real,
+      record->is_string, record->flags, flags_mask);
+  }
+}
+
+void vp::Event_file::writer_routine()
+{
+  pthread_mutex_lock(&this->mutex);
+
+  while (1)
+  {
+    while (this->ready_batches.size() == 0 && !this->writer_end)
+    {
+      pthread_cond_wait(&this->cond, &this->mutex);
+    }
+
+    if (this->ready_batches.size() == 0)
+    {
+      break;
+    }
+
+    std::vector<uint8_t> *batch = this->ready_batches.front();
+    this->ready_batches.pop();
+
+    pthread_mutex_unlock(&this->mutex);
+
+    pthread_mutex_lock(&this->dump_mutex);
+    this->dump_batch(batch);
+    pthread_mutex_unlock(&this->dump_mutex);
+
+    batch->clear();
+
+    pthread_mutex_lock(&this->mutex);
+    this->free_batches.push_back(batch);
+    pthread_cond_broadcast(&this->cond);
+  }
+
+  pthread_mutex_unlock(&this->mutex);
+}
+
+vp::Event_file::~Event_file()
+{
+  this->writer_stop();
+}
+
+void vp::Event_file::writer_stop()
+{
+  if (this->writer == NULL)
+  {
+    return;
+  }
+
+  this->flush_batch();
+
+  pthread_mutex_lock(&this->mutex);
+  this->writer_end = true;
+  pthread_cond_broadcast(&this->cond);
+  pthread_mutex_unlock(&this->mutex);
+
+  this->writer->join();
+  delete this->writer;
+  this->writer = NULL;
+
+  // The writer thread has dumped all ready batches, they are all back in the free list
+  delete this->batch;
+  this->batch = NULL;
+  for (std::vector<uint8_t> *batch: this->free_batches)
+  {
+    delete batch;
+  }
+  this->free_batches.clear();
+  this->nb_batches = 0;
+
+  pthread_cond_destroy(&this->cond);
+  pthread_mutex_destroy(&this->dump_mutex);
+  pthread_mutex_destroy(&this->mutex);
+}
+
+void vp::Event_file::stop()
+{
+  this->writer_stop();
+  this->close();
+}
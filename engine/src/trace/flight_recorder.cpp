@@ -0,0 +1,595 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vp/vp.hpp"
+#include "vp/trace/trace_engine.hpp"
+#include "vp/trace/flight_recorder.hpp"
+#include <string.h>
+#include <inttypes.h>
+#include <stdexcept>
+
+
+#define FLIGHT_RECORDER_ALIGN(x) (((x) + 7) & ~7)
+
+// Classes of arguments of a printf conversion, which tell how they are stored in the records
+typedef enum
+{
+    ARG_NONE,
+    ARG_INT,
+    ARG_LONG,
+    ARG_LONG_LONG,
+    ARG_SIZE,
+    ARG_DOUBLE,
+    ARG_LONG_DOUBLE,
+    ARG_PTR,
+    ARG_STR,
+    // %n, the argument is consumed but nothing is stored
+    ARG_SKIP
+} flight_recorder_arg_e;
+
+// Parse the printf conversion starting just after the '%', and return the character following it.
+// This is used both when recording and dumping messages, so that they always agree on the layout
+// of the arguments.
+static const char *parse_conversion(const char *fmt, int *nb_star, int *arg)
+{
+    int nb_long = 0;
+    bool is_size = false;
+    bool is_long_double = false;
+
+    *nb_star = 0;
+    *arg = ARG_NONE;
+
+    while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' || *fmt == '0' ||
+        *fmt == '\'')
+    {
+        fmt++;
+    }
+
+    if (*fmt == '*')
+    {
+        (*nb_star)++;
+        fmt++;
+    }
+    while (*fmt >= '0' && *fmt <= '9')
+    {
+        fmt++;
+    }
+
+    if (*fmt == '.')
+    {
+        fmt++;
+        if (*fmt == '*')
+        {
+            (*nb_star)++;
+            fmt++;
+        }
+        while (*fmt >= '0' && *fmt <= '9')
+        {
+            fmt++;
+        }
+    }
+
+    while (1)
+    {
+        if (*fmt == 'l')
+        {
+            nb_long++;
+        }
+        else if (*fmt == 'q' || *fmt == 'j')
+        {
+            nb_long = 2;
+        }
+        else if (*fmt == 'z' || *fmt == 't')
+        {
+            is_size = true;
+        }
+        else if (*fmt == 'L')
+        {
+            is_long_double = true;
+        }
+        else if (*fmt != 'h')
+        {
+            break;
+        }
+        fmt++;
+    }
+
+    switch (*fmt)
+    {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            *arg = is_size ? ARG_SIZE : nb_long >= 2 ? ARG_LONG_LONG : nb_long ? ARG_LONG : ARG_INT;
+            break;
+        case 'c':
+            *arg = ARG_INT;
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            *arg = is_long_double ? ARG_LONG_DOUBLE : ARG_DOUBLE;
+            break;
+        case 's':
+            *arg = ARG_STR;
+            break;
+        case 'p':
+            *arg = ARG_PTR;
+            break;
+        case 'n':
+            *arg = ARG_SKIP;
+            break;
+        case 0:
+            // Truncated conversion, do not go past the end of the string
+            return fmt;
+    }
+
+    return fmt + 1;
+}
+
+template<typename T> static void print_arg(FILE *file, const char *spec, int nb_star,
+    int64_t *stars, T value)
+{
+    if (nb_star == 0)
+    {
+        fprintf(file, spec, value);
+    }
+    else if (nb_star == 1)
+    {
+        fprintf(file, spec, (int)stars[0], value);
+    }
+    else
+    {
+        fprintf(file, spec, (int)stars[0], (int)stars[1], value);
+    }
+}
+
+
+vp::FlightRecorder::FlightRecorder(vp::TraceEngine *engine, size_t size, std::string path)
+    : engine(engine), path(path)
+{
+    this->nb_blocks = size / FLIGHT_RECORDER_BLOCK_SIZE;
+    // At least one full block must remain when the current one is reused
+    if (this->nb_blocks < 2)
+    {
+        this->nb_blocks = 2;
+    }
+
+    this->blocks = new uint8_t[(size_t)this->nb_blocks * FLIGHT_RECORDER_BLOCK_SIZE];
+    this->block_used = new uint32_t[this->nb_blocks]();
+    this->current = this->blocks;
+    this->current_end = this->blocks + FLIGHT_RECORDER_BLOCK_SIZE;
+}
+
+vp::FlightRecorder::~FlightRecorder()
+{
+    if (this->file && this->file != stdout)
+    {
+        fclose(this->file);
+    }
+    delete[] this->blocks;
+    delete[] this->block_used;
+}
+
+void vp::FlightRecorder::next_block()
+{
+    uint8_t *block = this->blocks + (size_t)this->current_block * FLIGHT_RECORDER_BLOCK_SIZE;
+    this->block_used[this->current_block] = this->current - block;
+
+    this->current_block++;
+    if (this->current_block == this->nb_blocks)
+    {
+        this->current_block = 0;
+    }
+
+    if (this->block_used[this->current_block] != 0)
+    {
+        this->nb_overwritten++;
+        this->block_used[this->current_block] = 0;
+    }
+
+    this->current = this->blocks + (size_t)this->current_block * FLIGHT_RECORDER_BLOCK_SIZE;
+    this->current_end = this->current + FLIGHT_RECORDER_BLOCK_SIZE;
+}
+
+inline uint8_t *vp::FlightRecorder::alloc()
+{
+    if (this->current_end - this->current < FLIGHT_RECORDER_MAX_RECORD)
+    {
+        this->next_block();
+    }
+    return this->current;
+}
+
+inline void vp::FlightRecorder::commit(uint8_t *end)
+{
+    FlightRecorderRecord *record = (FlightRecorderRecord *)this->current;
+    record->size = FLIGHT_RECORDER_ALIGN(end - this->current);
+    this->current += record->size;
+}
+
+inline vp::FlightRecorderRecord *vp::FlightRecorder::record_header(uint8_t *buffer, int kind,
+    int info, vp::Trace *trace, int64_t timestamp, int64_t cycles)
+{
+    FlightRecorderRecord *record = (FlightRecorderRecord *)buffer;
+    record->kind = kind;
+    record->info = info;
+    record->trace = trace;
+    record->timestamp = timestamp;
+    record->cycles = cycles;
+    return record;
+}
+
+void vp::FlightRecorder::record_msg(vp::Trace *trace, int level, const char *fmt, va_list ap)
+{
+    int64_t timestamp = -1;
+    int64_t cycles = -1;
+    if (trace->comp->clock.get_engine())
+    {
+        cycles = trace->comp->clock.get_engine()->get_cycles();
+    }
+    if (trace->comp->time.get_engine())
+    {
+        timestamp = trace->comp->time.get_engine()->get_time();
+    }
+
+    uint8_t *buffer = this->alloc();
+    uint8_t *limit = buffer + FLIGHT_RECORDER_MAX_RECORD;
+    this->record_header(buffer, FLIGHT_RECORDER_RECORD_MSG, level, trace, timestamp, cycles);
+    uint8_t *data = buffer + sizeof(FlightRecorderRecord);
+
+    // The format string is copied since some models pass a temporary buffer. Half of the record
+    // is kept for the arguments.
+    char *fmt_copy = (char *)data;
+    size_t len = strnlen(fmt, FLIGHT_RECORDER_MAX_RECORD / 2);
+    memcpy(fmt_copy, fmt, len);
+    fmt_copy[len] = 0;
+    data += FLIGHT_RECORDER_ALIGN(len + 1);
+
+    // Arguments are stored as 8 bytes values, except strings which are copied, since they may
+    // not exist anymore when the record is dumped. When the record is full, the remaining
+    // arguments are dropped.
+    const char *current = fmt_copy;
+    while ((current = strchr(current, '%')) != NULL)
+    {
+        int nb_star, arg;
+        current = parse_conversion(current + 1, &nb_star, &arg);
+
+        for (int i = 0; i < nb_star; i++)
+        {
+            if (data + 8 > limit) goto end;
+            *(int64_t *)data = va_arg(ap, int);
+            data += 8;
+        }
+
+        switch (arg)
+        {
+            case ARG_INT:
+                if (data + 8 > limit) goto end;
+                *(int64_t *)data = va_arg(ap, int);
+                data += 8;
+                break;
+            case ARG_LONG:
+                if (data + 8 > limit) goto end;
+                *(int64_t *)data = va_arg(ap, long);
+                data += 8;
+                break;
+            case ARG_LONG_LONG:
+                if (data + 8 > limit) goto end;
+                *(int64_t *)data = va_arg(ap, long long);
+                data += 8;
+                break;
+            case ARG_SIZE:
+                if (data + 8 > limit) goto end;
+                *(int64_t *)data = va_arg(ap, size_t);
+                data += 8;
+                break;
+            case ARG_DOUBLE:
+                if (data + 8 > limit) goto end;
+                *(double *)data = va_arg(ap, double);
+                data += 8;
+                break;
+            case ARG_LONG_DOUBLE:
+            {
+                if (data + 16 > limit) goto end;
+                long double value = va_arg(ap, long double);
+                memcpy(data, &value, sizeof(value));
+                data += 16;
+                break;
+            }
+            case ARG_PTR:
+                if (data + 8 > limit) goto end;
+                *(void **)data = va_arg(ap, void *);
+                data += 8;
+                break;
+            case ARG_STR:
+            {
+                if (data + 8 > limit) goto end;
+                const char *str = va_arg(ap, const char *);
+                if (str == NULL)
+                {
+                    str = "(null)";
+                }
+                size_t str_len = strnlen(str, limit - data - 1);
+                memcpy(data, str, str_len);
+                data[str_len] = 0;
+                data += FLIGHT_RECORDER_ALIGN(str_len + 1);
+                break;
+            }
+            case ARG_SKIP:
+                (void)va_arg(ap, void *);
+                break;
+        }
+    }
+
+end:
+    this->commit(data);
+}
+
+void vp::FlightRecorder::record_event(vp::Trace *trace, int64_t timestamp, int64_t cycles,
+    uint8_t *value, bool highz)
+{
+    uint8_t *buffer = this->alloc();
+    this->record_header(buffer, FLIGHT_RECORDER_RECORD_EVENT, highz, trace, timestamp, cycles);
+    uint8_t *data = buffer + sizeof(FlightRecorderRecord);
+
+    int bytes = trace->bytes;
+    if (bytes > FLIGHT_RECORDER_MAX_RECORD - (int)sizeof(FlightRecorderRecord))
+    {
+        bytes = FLIGHT_RECORDER_MAX_RECORD - sizeof(FlightRecorderRecord);
+    }
+    memcpy(data, value, bytes);
+
+    this->commit(data + bytes);
+}
+
+void vp::FlightRecorder::record_event_string(vp::Trace *trace, int64_t timestamp,
+    int64_t cycles, const char *value)
+{
+    uint8_t *buffer = this->alloc();
+    this->record_header(buffer, FLIGHT_RECORDER_RECORD_EVENT_STRING, value == NULL, trace,
+        timestamp, cycles);
+    uint8_t *data = buffer + sizeof(FlightRecorderRecord);
+
+    size_t len = 0;
+    if (value)
+    {
+        len = strnlen(value, FLIGHT_RECORDER_MAX_RECORD - sizeof(FlightRecorderRecord) - 1);
+        memcpy(data, value, len);
+    }
+    data[len] = 0;
+
+    this->commit(data + len + 1);
+}
+
+void vp::FlightRecorder::dump_msg(FlightRecorderRecord *record, uint8_t *data, uint8_t *end)
+{
+    const char *fmt = (const char *)data;
+    data += FLIGHT_RECORDER_ALIGN(strlen(fmt) + 1);
+
+    if (record->info == vp::Trace::LEVEL_ERROR)
+    {
+        fprintf(this->file, "\033[31m");
+    }
+    else if (record->info == vp::Trace::LEVEL_WARNING)
+    {
+        fprintf(this->file, "\033[33m");
+    }
+
+    const char *current = fmt;
+    while (1)
+    {
+        const char *percent = strchr(current, '%');
+        if (percent == NULL)
+        {
+            fputs(current, this->file);
+            break;
+        }
+
+        fwrite(current, 1, percent - current, this->file);
+
+        int nb_star, arg;
+        const char *next = parse_conversion(percent + 1, &nb_star, &arg);
+
+        char spec[64];
+        size_t spec_len = next - percent;
+        if (spec_len >= sizeof(spec))
+        {
+            spec_len = sizeof(spec) - 1;
+        }
+        memcpy(spec, percent, spec_len);
+        spec[spec_len] = 0;
+
+        int64_t stars[2];
+        for (int i = 0; i < nb_star; i++)
+        {
+            if (data + 8 > end) goto truncated;
+            stars[i] = *(int64_t *)data;
+            data += 8;
+        }
+
+        switch (arg)
+        {
+            case ARG_NONE:
+                if (spec_len == 2 && spec[1] == '%')
+                {
+                    fputc('%', this->file);
+                }
+                else
+                {
+                    fputs(spec, this->file);
+                }
+                break;
+            case ARG_INT:
+                if (data + 8 > end) goto truncated;
+                print_arg(this->file, spec, nb_star, stars, (int)*(int64_t *)data);
+                data += 8;
+                break;
+            case ARG_LONG:
+                if (data + 8 > end) goto truncated;
+                print_arg(this->file, spec, nb_star, stars, (long)*(int64_t *)data);
+                data += 8;
+                break;
+            case ARG_LONG_LONG:
+                if (data + 8 > end) goto truncated;
+                print_arg(this->file, spec, nb_star, stars, (long long)*(int64_t *)data);
+                data += 8;
+                break;
+            case ARG_SIZE:
+                if (data + 8 > end) goto truncated;
+                print_arg(this->file, spec, nb_star, stars, (size_t)*(int64_t *)data);
+                data += 8;
+                break;
+            case ARG_DOUBLE:
+                if (data + 8 > end) goto truncated;
+                print_arg(this->file, spec, nb_star, stars, *(double *)data);
+                data += 8;
+                break;
+            case ARG_LONG_DOUBLE:
+            {
+                if (data + 16 > end) goto truncated;
+                long double value;
+                memcpy(&value, data, sizeof(value));
+                print_arg(this->file, spec, nb_star, stars, value);
+                data += 16;
+                break;
+            }
+            case ARG_PTR:
+                if (data + 8 > end) goto truncated;
+                print_arg(this->file, spec, nb_star, stars, *(void **)data);
+                data += 8;
+                break;
+            case ARG_STR:
+            {
+                if (data + 8 > end) goto truncated;
+                const char *str = (const char *)data;
+                print_arg(this->file, spec, nb_star, stars, str);
+                data += FLIGHT_RECORDER_ALIGN(strlen(str) + 1);
+                break;
+            }
+        }
+
+        current = next;
+    }
+
+    if (record->info == vp::Trace::LEVEL_ERROR || record->info == vp::Trace::LEVEL_WARNING)
+    {
+        fprintf(this->file, "\033[0m");
+    }
+    return;
+
+truncated:
+    fprintf(this->file, "<truncated>\n");
+}
+
+void vp::FlightRecorder::dump_record(FlightRecorderRecord *record)
+{
+    if (this->engine->get_format() == TRACE_FORMAT_SHORT)
+    {
+        fprintf(this->file, "%" PRId64 "ps %" PRId64 " ", record->timestamp, record->cycles);
+    }
+    else
+    {
+        int max_trace_len = this->engine->get_max_path_len();
+        fprintf(this->file, "%" PRId64 ": %" PRId64 ": [\033[34m%-*.*s\033[0m] ",
+            record->timestamp, record->cycles, max_trace_len, max_trace_len,
+            record->trace->get_full_path().c_str());
+    }
+
+    uint8_t *data = (uint8_t *)record + sizeof(FlightRecorderRecord);
+    uint8_t *end = (uint8_t *)record + record->size;
+
+    if (record->kind == FLIGHT_RECORDER_RECORD_MSG)
+    {
+        this->dump_msg(record, data, end);
+    }
+    else if (record->kind == FLIGHT_RECORDER_RECORD_EVENT_STRING)
+    {
+        fprintf(this->file, "%s\n", record->info ? "Z" : (char *)data);
+    }
+    else if (record->info)
+    {
+        fprintf(this->file, "Z\n");
+    }
+    else if (record->trace->is_real)
+    {
+        fprintf(this->file, "%f\n", *(double *)data);
+    }
+    else
+    {
+        fprintf(this->file, "0x");
+        for (int i = record->trace->bytes - 1; i >= 0; i--)
+        {
+            fprintf(this->file, "%2.2x", data[i]);
+        }
+        fprintf(this->file, "\n");
+    }
+}
+
+void vp::FlightRecorder::dump(std::string reason)
+{
+    if (this->file == NULL)
+    {
+        if (this->path == "")
+        {
+            this->file = stdout;
+        }
+        else
+        {
+            this->file = fopen(this->path.c_str(), "w");
+            if (this->file == NULL)
+            {
+                fprintf(stderr, "Unable to open flight recorder file (path: %s, error: %s)\n",
+                    this->path.c_str(), strerror(errno));
+                return;
+            }
+        }
+    }
+
+    uint8_t *block = this->blocks + (size_t)this->current_block * FLIGHT_RECORDER_BLOCK_SIZE;
+    this->block_used[this->current_block] = this->current - block;
+
+    fprintf(this->file, "--- Flight recorder dump (reason: %s, overwritten blocks: %" PRId64 ") ---\n",
+        reason.c_str(), this->nb_overwritten);
+
+    // The block following the current one contains the oldest records
+    for (int i = 1; i <= this->nb_blocks; i++)
+    {
+        int index = (this->current_block + i) % this->nb_blocks;
+        uint8_t *data = this->blocks + (size_t)index * FLIGHT_RECORDER_BLOCK_SIZE;
+        uint8_t *end = data + this->block_used[index];
+
+        while (data < end)
+        {
+            FlightRecorderRecord *record = (FlightRecorderRecord *)data;
+            // A record without size can only come from a corrupted block, stop there instead of
+            // looping forever on it
+            if (record->size == 0)
+            {
+                break;
+            }
+            this->dump_record(record);
+            data += record->size;
+        }
+
+        this->block_used[index] = 0;
+    }
+
+    fprintf(this->file, "--- End of flight recorder dump ---\n");
+    fflush(this->file);
+
+    // Start again from scratch so that the next dump only contains new records
+    this->current_block = 0;
+    this->current = this->blocks;
+    this->current_end = this->blocks + FLIGHT_RECORDER_BLOCK_SIZE;
+    this->nb_overwritten = 0;
+}
@@ -33,6 +33,12 @@ vp::Fst_file::Fst_file(vp::Event_dumper *dumper, string path)
     throw std::invalid_argument("Error while opening FST file (path: " + path + ")\n");
   }
   fstWriterSetTimescale(this->writer, -12);
+
+  if (dumper->is_parallel())
+  {
+    // Let the FST writer compress blocks in its own threads
+    fstWriterSetParallelMode(this->writer, 1);
+  }
 }
 
 
@@ -90,7 +96,9 @@ void vp::Fst_file::dump(int64_t timestamp, int id, uint8_t *event, int width, bo
   }
   else if (is_string)
   {
-    fstWriterEmitVariableLengthValueChange(this->writer, this->vars[id], event, width);
+    // The width of strings is the number of bytes, including the terminating character,
+    // multiplied by 8
+    fstWriterEmitVariableLengthValueChange(this->writer, this->vars[id], event, width / 8 - 1);
   }
   else
   {
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vp/vp.hpp"
+#include "vp/trace/event_dumper.hpp"
+#include "fst/lz4.h"
+#include <string.h>
+#include <stdexcept>
+
+vp::Tdb_file::Tdb_file(vp::Event_dumper *dumper, string path, js::Config *config)
+{
+  this->file = fopen(path.c_str(), "wb");
+  if (this->file == NULL)
+  {
+    throw std::invalid_argument("Error while opening trace database (path: " + path + ", error: " + strerror(errno) + ")\n");
+  }
+
+  this->chunk_events = config->get_child_int("**/events/tdb_chunk_events");
+  if (this->chunk_events <= 0)
+  {
+    this->chunk_events = 4096;
+  }
+  this->compress = config->get_child_str("**/events/tdb_compression") != "none";
+
+  gv::TraceDbHeader header = {};
+  memcpy(header.magic, TRACEDB_MAGIC, sizeof(header.magic));
+  header.version = TRACEDB_VERSION;
+  header.timescale = -12;
+  this->write(&header, sizeof(header));
+}
+
+void vp::Tdb_file::write(const void *data, size_t size)
+{
+  fwrite(data, 1, size, this->file);
+  this->offset += size;
+}
+
+void vp::Tdb_file::add_trace(string path, int id, int width, bool is_real, bool is_string)
+{
+  Tdb_trace *trace = new Tdb_trace();
+  trace->path = path;
+  trace->id = id;
+  trace->type = is_real ? TRACEDB_TYPE_REAL : is_string ? TRACEDB_TYPE_STRING : TRACEDB_TYPE_LOGICAL;
+  trace->width = is_real ? 64 : is_string ? 0 : width;
+  trace->value_size = is_real ? sizeof(double) : (width + 7) / 8;
+  trace->string_offsets.push_back(0);
+
+  this->traces[id] = trace;
+}
+
+void vp::Tdb_file::dump(int64_t timestamp, int id, uint8_t *event, int width, bool is_real, bool is_string, uint8_t flags, uint8_t *flag_mask)
+{
+  Tdb_trace *trace = this->traces[id];
+
+  trace->timestamps.push_back(timestamp);
+  trace->flags.push_back(flags);
+
+  if (trace->type == TRACEDB_TYPE_STRING)
+  {
+    // The width of strings is the number of bytes, including the terminating character,
+    // multiplied by 8
+    trace->values.insert(trace->values.end(), event, event + width / 8);
+    trace->string_offsets.push_back(trace->values.size());
+  }
+  else
+  {
+    trace->values.insert(trace->values.end(), event, event + trace->value_size);
+  }
+
+  if ((int)trace->timestamps.size() == this->chunk_events)
+  {
+    this->flush_chunk(trace);
+  }
+}
+
+void vp::Tdb_file::flush_chunk(Tdb_trace *trace)
+{
+  int nb_events = trace->timestamps.size();
+  if (nb_events == 0)
+  {
+    return;
+  }
+
+  // Gather the columns
+  size_t flags_size = (nb_events + 7) & ~7;
+  this->raw.clear();
+  this->raw.insert(this->raw.end(), (uint8_t *)trace->timestamps.data(),
+    (uint8_t *)(trace->timestamps.data() + nb_events));
+  trace->flags.resize(flags_size);
+  this->raw.insert(this->raw.end(), trace->flags.begin(), trace->flags.end());
+  if (trace->type == TRACEDB_TYPE_STRING)
+  {
+    this->raw.insert(this->raw.end(), (uint8_t *)trace->string_offsets.data(),
+      (uint8_t *)(trace->string_offsets.data() + nb_events + 1));
+  }
+  this->raw.insert(this->raw.end(), trace->values.begin(), trace->values.end());
+
+  gv::TraceDbChunk chunk = {};
+  chunk.trace_id = trace->id;
+  chunk.nb_events = nb_events;
+  chunk.raw_size = this->raw.size();
+  chunk.first_timestamp = trace->timestamps[0];
+  chunk.last_timestamp = trace->timestamps[nb_events - 1];
+
+  const uint8_t *data = this->raw.data();
+  chunk.stored_size = this->raw.size();
+  chunk.compression = TRACEDB_COMPRESSION_NONE;
+
+  if (this->compress)
+  {
+    this->compressed.resize(LZ4_compressBound(this->raw.size()));
+    int size = LZ4_compress_default((const char *)this->raw.data(), (char *)this->compressed.data(),
+      this->raw.size(), this->compressed.size());
+
+    // Keep the chunk uncompressed if it does not get smaller
+    if (size > 0 && (uint32_t)size < chunk.raw_size)
+    {
+      data = this->compressed.data();
+      chunk.stored_size = size;
+      chunk.compression = TRACEDB_COMPRESSION_LZ4;
+    }
+  }
+
+  gv::TraceDbIndexEntry entry;
+  entry.first_timestamp = chunk.first_timestamp;
+  entry.last_timestamp = chunk.last_timestamp;
+  entry.offset = this->offset;
+  entry.nb_events = nb_events;
+  trace->index.push_back(entry);
+  trace->nb_events += nb_events;
+
+  this->write(&chunk, sizeof(chunk));
+  this->write(data, chunk.stored_size);
+
+  // Keep chunks 8 bytes aligned
+  uint64_t padding = 0;
+  this->write(&padding, ((chunk.stored_size + 7) & ~7) - chunk.stored_size);
+
+  trace->timestamps.clear();
+  trace->flags.clear();
+  trace->values.clear();
+  trace->string_offsets.resize(1);
+}
+
+void vp::Tdb_file::close()
+{
+  for (auto &x: this->traces)
+  {
+    this->flush_chunk(x.second);
+  }
+
+  // The chunk indexes of all traces, then the trace descriptors pointing to them
+  std::vector<uint64_t> index_offsets;
+  for (auto &x: this->traces)
+  {
+    index_offsets.push_back(this->offset);
+    this->write(x.second->index.data(), x.second->index.size() * sizeof(gv::TraceDbIndexEntry));
+  }
+
+  gv::TraceDbTrailer trailer = {};
+  trailer.traces_offset = this->offset;
+  trailer.nb_traces = this->traces.size();
+  memcpy(trailer.magic, TRACEDB_MAGIC, sizeof(trailer.magic));
+
+  int index = 0;
+  for (auto &x: this->traces)
+  {
+    Tdb_trace *trace = x.second;
+    gv::TraceDbTrace desc = {};
+    desc.id = trace->id;
+    desc.type = trace->type;
+    desc.width = trace->width;
+    desc.path_len = trace->path.size();
+    desc.nb_events = trace->nb_events;
+    desc.nb_chunks = trace->index.size();
+    desc.index_offset = index_offsets[index++];
+    this->write(&desc, sizeof(desc));
+
+    uint64_t padding = 0;
+    this->write(trace->path.c_str(), desc.path_len);
+    this->write(&padding, ((desc.path_len + 7) & ~7) - desc.path_len);
+  }
+
+  this->write(&trailer, sizeof(trailer));
+
+  fclose(this->file);
+
+  for (auto &x: this->traces)
+  {
+    delete x.second;
+  }
+  this->traces.clear();
+}
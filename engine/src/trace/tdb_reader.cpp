@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gv/tracedb.hpp"
+#include "fst/lz4.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <stdexcept>
+
+gv::TraceDb::TraceDb(std::string path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throw std::runtime_error("Error while opening trace database (path: " + path + ", error: " + strerror(errno) + ")");
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    this->size = st.st_size;
+
+    if (this->size < sizeof(TraceDbHeader) + sizeof(TraceDbTrailer))
+    {
+        ::close(fd);
+        throw std::runtime_error("Invalid trace database (path: " + path + ")");
+    }
+
+    this->data = (uint8_t *)mmap(NULL, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (this->data == MAP_FAILED)
+    {
+        throw std::runtime_error("Error while mapping trace database (path: " + path + ", error: " + strerror(errno) + ")");
+    }
+
+    this->header = (const TraceDbHeader *)this->data;
+    const TraceDbTrailer *trailer = (const TraceDbTrailer *)(this->data + this->size - sizeof(TraceDbTrailer));
+
+    // The trailer is only written when the simulation properly ends
+    if (memcmp(this->header->magic, TRACEDB_MAGIC, sizeof(this->header->magic)) != 0 ||
+        memcmp(trailer->magic, TRACEDB_MAGIC, sizeof(trailer->magic)) != 0 ||
+        this->header->version != TRACEDB_VERSION)
+    {
+        munmap(this->data, this->size);
+        throw std::runtime_error("Invalid or incomplete trace database (path: " + path + ")");
+    }
+
+    const uint8_t *current = this->data + trailer->traces_offset;
+    for (uint64_t i = 0; i < trailer->nb_traces; i++)
+    {
+        const TraceDbTrace *trace = (const TraceDbTrace *)current;
+        current += sizeof(TraceDbTrace);
+        this->traces[std::string((const char *)current, trace->path_len)] = trace;
+        current += (trace->path_len + 7) & ~7;
+    }
+
+    this->chunk_offset = 0;
+}
+
+gv::TraceDb::~TraceDb()
+{
+    munmap(this->data, this->size);
+}
+
+std::vector<std::string> gv::TraceDb::get_paths()
+{
+    std::vector<std::string> result;
+    for (auto &x: this->traces)
+    {
+        result.push_back(x.first);
+    }
+    return result;
+}
+
+const gv::TraceDbTrace *gv::TraceDb::get_trace(std::string path)
+{
+    auto it = this->traces.find(path);
+    return it == this->traces.end() ? NULL : it->second;
+}
+
+const gv::TraceDbIndexEntry *gv::TraceDb::get_index(const TraceDbTrace *trace)
+{
+    return (const TraceDbIndexEntry *)(this->data + trace->index_offset);
+}
+
+const uint8_t *gv::TraceDb::get_chunk(const TraceDbIndexEntry *entry, const TraceDbChunk **chunk)
+{
+    *chunk = (const TraceDbChunk *)(this->data + entry->offset);
+    const uint8_t *stored = this->data + entry->offset + sizeof(TraceDbChunk);
+
+    if ((*chunk)->compression == TRACEDB_COMPRESSION_NONE)
+    {
+        return stored;
+    }
+
+    if (this->chunk_offset != entry->offset)
+    {
+        this->chunk_data.resize((*chunk)->raw_size);
+        if (LZ4_decompress_safe((const char *)stored, (char *)this->chunk_data.data(),
+            (*chunk)->stored_size, (*chunk)->raw_size) != (int)(*chunk)->raw_size)
+        {
+            throw std::runtime_error("Corrupted chunk in trace database");
+        }
+        this->chunk_offset = entry->offset;
+    }
+
+    return this->chunk_data.data();
+}
+
+void gv::TraceDb::get_events(const TraceDbTrace *trace, int64_t start, int64_t end,
+    std::function<void(int64_t timestamp, uint8_t flags, const uint8_t *value, int size)> callback)
+{
+    const TraceDbIndexEntry *index = this->get_index(trace);
+    const TraceDbIndexEntry *index_end = index + trace->nb_chunks;
+
+    // Start from the last chunk beginning at or before the window, since it contains the value
+    // valid at the start of the window
+    const TraceDbIndexEntry *entry = std::upper_bound(index, index_end, start,
+        [](int64_t timestamp, const TraceDbIndexEntry &entry) { return timestamp < entry.first_timestamp; });
+    if (entry != index)
+    {
+        entry--;
+    }
+
+    bool first = true;
+
+    for (; entry < index_end && entry->first_timestamp <= end; entry++)
+    {
+        const TraceDbChunk *chunk;
+        const uint8_t *data = this->get_chunk(entry, &chunk);
+        int nb_events = chunk->nb_events;
+        const int64_t *timestamps = (const int64_t *)data;
+        const uint8_t *flags = data + nb_events * sizeof(int64_t);
+        const uint8_t *values = flags + ((nb_events + 7) & ~7);
+        const uint32_t *string_offsets = NULL;
+        int value_size = trace->type == TRACEDB_TYPE_REAL ? sizeof(double) : (trace->width + 7) / 8;
+
+        if (trace->type == TRACEDB_TYPE_STRING)
+        {
+            string_offsets = (const uint32_t *)values;
+            values += (nb_events + 1) * sizeof(uint32_t);
+        }
+
+        int event = 0;
+        if (first)
+        {
+            // Last event at or before the start of the window
+            event = std::upper_bound(timestamps, timestamps + nb_events, start) - timestamps;
+            if (event > 0)
+            {
+                event--;
+            }
+            first = false;
+        }
+
+        for (; event < nb_events && timestamps[event] <= end; event++)
+        {
+            if (string_offsets)
+            {
+                callback(timestamps[event], flags[event], values + string_offsets[event],
+                    string_offsets[event + 1] - string_offsets[event]);
+            }
+            else
+            {
+                callback(timestamps[event], flags[event], values + event * value_size, value_size);
+            }
+        }
+    }
+}
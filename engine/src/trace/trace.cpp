@@ -102,6 +102,18 @@ void vp::BlockTrace::new_trace_event_string(std::string name, Trace *trace)
     this->reg_trace(trace, 1);
 }
 
+void vp::BlockTrace::new_trace_binary(std::string name, Trace *trace)
+{
+    traces[name] = trace;
+    trace->level = vp::TraceLevel::DEBUG;
+    trace->is_binary = true;
+    trace->comp = static_cast<vp::Component *>(&top);
+    trace->name = name;
+    trace->path = top.get_path() + "/" + name;
+
+    this->reg_trace(trace, 0);
+}
+
 #ifdef VP_TRACE_ACTIVE
 bool vp::Trace::get_active(int level)
 {
@@ -227,7 +239,12 @@ void vp::Trace::set_event_active(bool active)
 
     if (active)
     {
-        if (this->comp->traces.get_trace_engine()->use_external_dumper)
+        if (this->comp->traces.get_trace_engine()->get_flight_recorder())
+        {
+            this->dump_event_callback_variable = &vp::TraceEngine::dump_event_string_recorder;
+            this->dump_event_callback_fixed = &vp::TraceEngine::dump_event_recorder;
+        }
+        else if (this->comp->traces.get_trace_engine()->use_external_dumper)
         {
             if (this->is_string)
             {
@@ -300,31 +317,118 @@ void vp::Trace::set_event_active(bool active)
     }
 }
 
+char *vp::TraceEngine::ring_acquire()
+{
+    uint64_t head = this->ring_head.load(std::memory_order_relaxed);
+
+    if (head - this->ring_tail.load(std::memory_order_acquire) == (uint64_t)this->ring_depth)
+    {
+        if (this->ring_drop)
+        {
+            return this->ring_drop_buffer;
+        }
+
+        this->ring_stats.nb_stalled++;
+
+        // The flag must be visible before the ring is checked again, so that the event thread
+        // either sees it when releasing a buffer, or we see the released buffer
+        pthread_mutex_lock(&this->mutex);
+        this->producer_waiting.store(true);
+        while (head - this->ring_tail.load() == (uint64_t)this->ring_depth)
+        {
+            pthread_cond_wait(&this->cond, &this->mutex);
+        }
+        this->producer_waiting.store(false);
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    return this->ring_buffers[head % this->ring_depth];
+}
+
+void vp::TraceEngine::ring_publish(char *buffer)
+{
+    if (buffer == this->ring_drop_buffer)
+    {
+        this->ring_stats.nb_dropped++;
+        return;
+    }
+
+    this->ring_stats.nb_produced++;
+    this->ring_head.store(this->ring_head.load(std::memory_order_relaxed) + 1);
+
+    if (this->consumer_waiting.load())
+    {
+        pthread_mutex_lock(&this->mutex);
+        pthread_cond_broadcast(&this->cond);
+        pthread_mutex_unlock(&this->mutex);
+    }
+}
+
+char *vp::TraceEngine::ring_pop()
+{
+    uint64_t tail = this->ring_tail.load(std::memory_order_relaxed);
+
+    // Spin a bit before sleeping since the simulation usually produces buffers in bursts
+    for (int i = 0; i < 64; i++)
+    {
+        if (this->ring_head.load(std::memory_order_acquire) != tail)
+        {
+            return this->ring_buffers[tail % this->ring_depth];
+        }
+        std::this_thread::yield();
+    }
+
+    pthread_mutex_lock(&this->mutex);
+    this->consumer_waiting.store(true);
+    while (this->ring_head.load() == tail && !this->end)
+    {
+        pthread_cond_wait(&this->cond, &this->mutex);
+    }
+    this->consumer_waiting.store(false);
+    pthread_mutex_unlock(&this->mutex);
+
+    // All buffers are published before the end is notified, so an empty ring at this point
+    // means the end of simulation
+    if (this->ring_head.load(std::memory_order_acquire) == tail)
+    {
+        return NULL;
+    }
+
+    return this->ring_buffers[tail % this->ring_depth];
+}
+
+void vp::TraceEngine::ring_release()
+{
+    this->ring_stats.nb_consumed++;
+    this->ring_tail.store(this->ring_tail.load(std::memory_order_relaxed) + 1);
+
+    if (this->producer_waiting.load())
+    {
+        pthread_mutex_lock(&this->mutex);
+        pthread_cond_broadcast(&this->cond);
+        pthread_mutex_unlock(&this->mutex);
+    }
+}
+
+void vp::TraceEngine::get_stats(vp::TraceEngineStats *stats)
+{
+    *stats = this->ring_stats;
+}
+
 char *vp::TraceEngine::get_event_buffer(int bytes)
 {
     if (current_buffer == NULL || bytes > TRACE_EVENT_BUFFER_SIZE - current_buffer_size)
     {
-        pthread_mutex_lock(&mutex);
-
         if (current_buffer && bytes > TRACE_EVENT_BUFFER_SIZE - current_buffer_size)
         {
             if ((unsigned int)(TRACE_EVENT_BUFFER_SIZE - current_buffer_size) > sizeof(vp::Trace *))
                 *(vp::Trace **)(current_buffer + current_buffer_size) = NULL;
 
-            ready_event_buffers.push(current_buffer);
-            current_buffer = NULL;
-
-            pthread_cond_broadcast(&cond);
+            this->ring_publish(current_buffer);
         }
 
-        while (event_buffers.empty())
-        {
-            pthread_cond_wait(&cond, &mutex);
-        }
-        current_buffer = event_buffers.front();
-        event_buffers.pop();
+        current_buffer = this->ring_acquire();
         current_buffer_size = 0;
-        pthread_mutex_unlock(&mutex);
     }
 
     char *result = current_buffer + current_buffer_size;
@@ -336,8 +440,6 @@ char *vp::TraceEngine::get_event_buffer(int bytes)
 
 void vp::TraceEngine::get_new_buffer_external()
 {
-    pthread_mutex_lock(&this->mutex);
-
     // Since the depacker does not know the size of the events, but only that first element is
     // always the trace, push a NULL trace if there is enough room so that it knowns when to
     // stop.
@@ -347,19 +449,11 @@ void vp::TraceEngine::get_new_buffer_external()
         *(vp::Trace **)this->current_buffer_event = NULL;
     }
 
-    this->ready_event_buffers.push(this->current_buffer);
-    pthread_cond_broadcast(&this->cond);
+    this->ring_publish(this->current_buffer);
 
-    while (this->event_buffers.empty())
-    {
-        pthread_cond_wait(&this->cond, &this->mutex);
-    }
-
-    this->current_buffer = this->event_buffers.front();
+    this->current_buffer = this->ring_acquire();
     this->current_buffer_event = this->current_buffer;
-    this->event_buffers.pop();
     this->current_buffer_remaining_size = TRACE_EVENT_BUFFER_SIZE;
-    pthread_mutex_unlock(&this->mutex);
 }
 
 vp::TraceEngine::~TraceEngine()
@@ -379,6 +473,32 @@ vp::TraceEngine::~TraceEngine()
     {
         fflush(file.second);
     }
+
+    if (this->config->get_child_bool("events/ring_report"))
+    {
+        printf("Event buffers: %" PRId64 " produced, %" PRId64 " consumed, %" PRId64 " stalled, %" PRId64 " dropped\n",
+            this->ring_stats.nb_produced, this->ring_stats.nb_consumed,
+            this->ring_stats.nb_stalled, this->ring_stats.nb_dropped);
+    }
+
+    if (this->flight_recorder)
+    {
+        // Dumps requested from other threads, like on SIGINT, are done here since the engine
+        // is now stopped
+        if (this->flight_recorder->is_dump_requested())
+        {
+            this->flight_recorder->dump("interrupted");
+        }
+        delete this->flight_recorder;
+    }
+}
+
+void vp::TraceEngine::flight_recorder_dump(std::string reason)
+{
+    if (this->flight_recorder)
+    {
+        this->flight_recorder->dump(reason);
+    }
 }
 
 void vp::TraceEngine::flush()
@@ -391,16 +511,12 @@ void vp::TraceEngine::flush()
 
         if (current_buffer_size)
         {
-            pthread_mutex_lock(&mutex);
-
             if (current_buffer)
             {
                 *(vp::Trace **)(current_buffer + current_buffer_size) = NULL;
-                ready_event_buffers.push(current_buffer);
+                this->ring_publish(current_buffer);
                 current_buffer = NULL;
             }
-            pthread_cond_broadcast(&cond);
-            pthread_mutex_unlock(&mutex);
         }
     }
     else
@@ -805,6 +921,22 @@ void vp::TraceEngine::dump_event_string(vp::TraceEngine *_this, vp::Trace *trace
     }
 }
 
+void vp::TraceEngine::dump_event_recorder(vp::TraceEngine *_this, vp::Trace *trace, int64_t timestamp, int64_t cycles, uint8_t *event, uint8_t *flags)
+{
+    if (_this->global_enable)
+    {
+        _this->flight_recorder->record_event(trace, timestamp, cycles, event, flags[0] != 0);
+    }
+}
+
+void vp::TraceEngine::dump_event_string_recorder(vp::TraceEngine *_this, vp::Trace *trace, int64_t timestamp, int64_t cycles, uint8_t *event, int flags, bool realloc)
+{
+    if (_this->global_enable)
+    {
+        _this->flight_recorder->record_event_string(trace, timestamp, cycles, (char *)event);
+    }
+}
+
 void vp::TraceEngine::check_pending_events(int64_t timestamp)
 {
     vp::Trace *trace = this->first_pending_event;
@@ -916,6 +1048,36 @@ void vp::TraceEngine::flush_event_traces(int64_t timestamp)
     first_trace_to_dump = NULL;
 }
 
+uint8_t *vp::TraceEngine::dump_binary_event(vp::Trace *trace, uint8_t *buffer)
+{
+    vp::TraceBinaryEvent *event = (vp::TraceBinaryEvent *)buffer;
+    buffer += sizeof(vp::TraceBinaryEvent);
+
+    vp::TraceBinaryRecord record;
+    record.trace_id = trace->id;
+    record.timestamp = event->timestamp;
+    record.cycles = event->cycles;
+
+    // Traces are declared the first time they are dumped so that the file is self-contained
+    if (!trace->binary_declared)
+    {
+        trace->binary_declared = true;
+        uint32_t max_path_len = this->max_path_len;
+        record.kind = TRACE_BINARY_RECORD_DECLARE;
+        record.size = sizeof(max_path_len) + trace->path.size();
+        fwrite(&record, sizeof(record), 1, trace->trace_file);
+        fwrite(&max_path_len, sizeof(max_path_len), 1, trace->trace_file);
+        fwrite(trace->path.c_str(), trace->path.size(), 1, trace->trace_file);
+    }
+
+    record.kind = TRACE_BINARY_RECORD_DATA;
+    record.size = event->size;
+    fwrite(&record, sizeof(record), 1, trace->trace_file);
+    fwrite(buffer, event->size, 1, trace->trace_file);
+
+    return buffer + event->size;
+}
+
 void vp::TraceEngine::set_vcd_user(gv::Vcd_user *user)
 {
     this->event_dumper.set_vcd_user(user, this->use_external_dumper);
@@ -937,27 +1099,13 @@ void vp::TraceEngine::vcd_routine()
     {
         char *event_buffer, *event_buffer_start;
 
-        pthread_mutex_lock(&this->mutex);
-
-        // Wait for a buffer of event of the end of simulation
-        while (this->ready_event_buffers.empty() && !end)
-        {
-            pthread_cond_wait(&this->cond, &this->mutex);
-        }
-
-        // In case of the end of simulation, just leave
-        if (this->ready_event_buffers.empty() && end)
+        // Wait for a buffer of event of the end of simulation, in which case just leave
+        event_buffer = this->ring_pop();
+        if (event_buffer == NULL)
         {
-            pthread_mutex_unlock(&this->mutex);
             break;
         }
-
-        // Pop the first buffer
-        event_buffer = ready_event_buffers.front();
         event_buffer_start = event_buffer;
-        ready_event_buffers.pop();
-
-        pthread_mutex_unlock(&this->mutex);
 
         // And go through the events to unpack them
         while (event_buffer - event_buffer_start < (int)(TRACE_EVENT_BUFFER_SIZE - sizeof(vp::Trace *)))
@@ -976,6 +1124,12 @@ void vp::TraceEngine::vcd_routine()
 
             event_buffer += sizeof(trace);
 
+            if (trace->is_binary)
+            {
+                event_buffer = (char *)this->dump_binary_event(trace, (uint8_t *)event_buffer);
+                continue;
+            }
+
             int bytes = trace->bytes;
             uint8_t flags_mask[bytes];
 
@@ -1036,11 +1190,12 @@ void vp::TraceEngine::vcd_routine()
             }
         }
 
-        // Now push back the buffer of events into the list of free buffers
-        pthread_mutex_lock(&this->mutex);
-        event_buffers.push(event_buffer_start);
-        pthread_cond_broadcast(&cond);
-        pthread_mutex_unlock(&this->mutex);
+        // Hand the value changes found in this buffer to the file writer threads, so that
+        // they are not delayed until the batches are full
+        this->event_dumper.flush();
+
+        // Now give back the buffer of events to the simulation
+        this->ring_release();
     }
 
     this->flush_event_traces(last_timestamp);
@@ -1053,27 +1208,13 @@ void vp::TraceEngine::vcd_routine_external()
     {
         uint8_t *event_buffer, *event_buffer_start;
 
-        pthread_mutex_lock(&this->mutex);
-
-        // Wait for a buffer of event of the end of simulation
-        while (this->ready_event_buffers.size() == 0 && !end)
-        {
-            pthread_cond_wait(&this->cond, &this->mutex);
-        }
-
-        // In case of the end of simulation, just leave
-        if (this->ready_event_buffers.size() == 0 && end)
+        // Wait for a buffer of event of the end of simulation, in which case just leave
+        event_buffer = (uint8_t *)this->ring_pop();
+        if (event_buffer == NULL)
         {
-            pthread_mutex_unlock(&this->mutex);
             break;
         }
-
-        // Pop the first buffer
-        event_buffer = (uint8_t *)ready_event_buffers.front();
         event_buffer_start = event_buffer;
-        ready_event_buffers.pop();
-
-        pthread_mutex_unlock(&this->mutex);
 
         this->vcd_user->lock();
 
@@ -1086,6 +1227,12 @@ void vp::TraceEngine::vcd_routine_external()
 
             event_buffer += sizeof(trace);
 
+            if (trace->is_binary)
+            {
+                event_buffer = this->dump_binary_event(trace, event_buffer);
+                continue;
+            }
+
             bool unlock;
             event_buffer = trace->parse_event_callback(this, trace, event_buffer, unlock);
 
@@ -1098,11 +1245,8 @@ void vp::TraceEngine::vcd_routine_external()
 
         this->vcd_user->unlock();
 
-        // Now push back the buffer of events into the list of free buffers
-        pthread_mutex_lock(&this->mutex);
-        event_buffers.push((char *)event_buffer_start);
-        pthread_cond_broadcast(&cond);
-        pthread_mutex_unlock(&this->mutex);
+        // Now give back the buffer of events to the simulation
+        this->ring_release();
     }
 
 }
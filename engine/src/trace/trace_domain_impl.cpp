@@ -26,103 +26,182 @@
 #include <thread>
 #include <set>
 #include <string.h>
+#include <algorithm>
 
 
+// When several patterns include a trace, the last one added gives the file
+static vp::trace_regex *get_last_pattern(std::vector<vp::trace_regex *> &patterns)
+{
+    vp::trace_regex *result = NULL;
+    for (vp::trace_regex *regex: patterns)
+    {
+        if (result == NULL || regex->id > result->id)
+        {
+            result = regex;
+        }
+    }
+    return result;
+}
+
 void vp::TraceEngine::check_trace_active(vp::Trace *trace, int event)
 {
-    std::string full_path = trace->get_full_path();
+    std::string &full_path = trace->full_path;
+    vp::TracePathMatches &matches = this->trace_matches[trace->id];
+
+    matches.dirty = false;
 
     trace->set_event_active(false);
     trace->set_active(false);
 
     if (event)
     {
-        std::string file_path = this->active_events[full_path];
-        if (file_path != "")
+        // Exclude patterns apply last, even to events selected with their raw path
+        if (matches.excludes.size() == 0)
         {
-            vp::Event_trace *event_trace;
-            if (trace->is_real)
-                event_trace = event_dumper.get_trace_real(full_path, file_path);
-            else if (trace->is_string)
-                event_trace = event_dumper.get_trace_string(full_path, file_path);
-            else
-                event_trace = event_dumper.get_trace(full_path, file_path, trace->width);
-            trace->set_event_active(true);
-            trace->event_trace = event_trace;
+            auto raw = this->active_events.find(full_path);
+            if (raw != this->active_events.end() && raw->second != "")
+            {
+                trace->event_trace = this->get_event_trace(trace, full_path, raw->second);
+                trace->set_event_active(true);
+            }
+            else if (matches.includes.size() > 0)
+            {
+                trace->event_trace = this->get_event_trace(trace, full_path,
+                    get_last_pattern(matches.includes)->file_path);
+                trace->set_event_active(true);
+            }
+        }
+    }
+    else if (matches.includes.size() > 0 && matches.excludes.size() == 0)
+    {
+        std::string file_path = get_last_pattern(matches.includes)->file_path;
+        // Binary traces can not go to the terminal
+        if (file_path == "" && trace->is_binary)
+        {
+            file_path = "trace.bin";
+        }
+
+        if (file_path == "")
+        {
+            trace->trace_file = stdout;
         }
         else
         {
-            for (auto &x : events_path_regex)
+            if (this->trace_files.count(file_path) == 0)
             {
-                if ((x.second->is_path && x.second->path == full_path) || regexec(x.second->regex, full_path.c_str(), 0, NULL, 0) == 0)
+                FILE *file = fopen(file_path.c_str(), trace->is_binary ? "wb" : "w");
+                if (file == NULL)
+                    throw std::logic_error("Unable to open file: " + file_path);
+                this->trace_files[file_path] = file;
+
+                if (trace->is_binary)
                 {
-                    std::string file_path = x.second->file_path;
-                    vp::Event_trace *event_trace;
-                    if (trace->is_real)
-                        event_trace = event_dumper.get_trace_real(full_path, file_path);
-                    else if (trace->is_string)
-                        event_trace = event_dumper.get_trace_string(full_path, file_path);
-                    else
-                        event_trace = event_dumper.get_trace(full_path, file_path, trace->width);
-                    trace->set_event_active(true);
-                    trace->event_trace = event_trace;
+                    uint32_t header[2] = { TRACE_BINARY_VERSION, (uint32_t)this->trace_format };
+                    fwrite(TRACE_BINARY_MAGIC, sizeof(TRACE_BINARY_MAGIC), 1, file);
+                    fwrite(header, sizeof(header), 1, file);
                 }
             }
+            trace->trace_file = this->trace_files[file_path];
         }
+        trace->recorder = trace->is_binary ? NULL : this->flight_recorder;
+        trace->set_active(true);
+    }
+}
 
-        for (auto &x : this->events_exclude_path_regex)
-        {
-            if (regexec(x.second->regex, full_path.c_str(), 0, NULL, 0) == 0)
-            {
-                trace->set_event_active(false);
-            }
-        }
+void vp::TraceEngine::get_trace_matchers(vp::Trace *trace, vp::TracePathMatcher **includes,
+    vp::TracePathMatcher **excludes)
+{
+    if (trace->is_event)
+    {
+        *includes = &this->events_path_regex;
+        *excludes = &this->events_exclude_path_regex;
     }
     else
     {
-        for (auto &x : this->trace_regexs)
+        // Binary traces are only enabled by their own paths, since they go to a binary file
+        *includes = trace->is_binary ? &this->binary_trace_regexs : &this->trace_regexs;
+        *excludes = &this->trace_exclude_regexs;
+    }
+}
+
+void vp::TraceEngine::add_pattern(vp::TracePathMatcher *matcher, vp::trace_regex *regex)
+{
+    // A pattern given again replaces the previous one, since it may have a different file
+    this->remove_pattern(matcher, regex->path);
+
+    matcher->add(regex);
+
+    // Only the new pattern needs to be checked, the other ones are still valid
+    for (vp::Trace *trace: this->traces_array)
+    {
+        vp::TracePathMatcher *includes, *excludes;
+        this->get_trace_matchers(trace, &includes, &excludes);
+
+        if ((matcher == includes || matcher == excludes) && regex->match(trace->full_path))
         {
-            if (regexec(x.second->regex, full_path.c_str(), 0, NULL, 0) == 0)
+            vp::TracePathMatches &matches = this->trace_matches[trace->id];
+            (matcher == includes ? matches.includes : matches.excludes).push_back(regex);
+            if (!matches.dirty)
             {
-                std::string file_path = x.second->file_path;
-                if (file_path == "")
-                {
-                    trace->trace_file = stdout;
-                }
-                else
-                {
-                    if (this->trace_files.count(file_path) == 0)
-                    {
-                        FILE *file = fopen(file_path.c_str(), "w");
-                        if (file == NULL)
-                            throw std::logic_error("Unable to open file: " + file_path);
-                        this->trace_files[file_path] = file;
-                    }
-                    trace->trace_file = this->trace_files[file_path];
-                }
-                trace->set_active(true);
+                matches.dirty = true;
+                this->dirty_traces.push_back(trace);
             }
         }
+    }
+}
 
-        for (auto &x : this->trace_exclude_regexs)
+void vp::TraceEngine::remove_pattern(vp::TracePathMatcher *matcher, std::string path)
+{
+    vp::trace_regex *regex = matcher->get(path);
+    if (regex == NULL)
+    {
+        return;
+    }
+
+    matcher->remove(regex);
+
+    for (vp::Trace *trace: this->traces_array)
+    {
+        vp::TracePathMatches &matches = this->trace_matches[trace->id];
+        for (auto *patterns: { &matches.includes, &matches.excludes })
         {
-            if (regexec(x.second->regex, full_path.c_str(), 0, NULL, 0) == 0)
+            auto it = std::find(patterns->begin(), patterns->end(), regex);
+            if (it != patterns->end())
             {
-                if (event)
-                    trace->set_event_active(false);
-                else
-                    trace->set_active(false);
+                patterns->erase(it);
+                if (!matches.dirty)
+                {
+                    matches.dirty = true;
+                    this->dirty_traces.push_back(trace);
+                }
             }
         }
     }
+
+    delete regex;
+}
+
+vp::Event_trace *vp::TraceEngine::get_event_trace(vp::Trace *trace, std::string path,
+    std::string file_path)
+{
+    // Events recorded by the flight recorder must not create any event file
+    if (this->flight_recorder)
+        return NULL;
+    else if (trace->is_real)
+        return event_dumper.get_trace_real(path, file_path);
+    else if (trace->is_string)
+        return event_dumper.get_trace_string(path, file_path);
+    else
+        return event_dumper.get_trace(path, file_path, trace->width);
 }
 
 void vp::TraceEngine::check_traces()
 {
-    for (auto x : this->traces_array)
+    for (auto x : this->dirty_traces)
     {
         this->check_trace_active(x, x->is_event);
     }
+    this->dirty_traces.clear();
 }
 
 void vp::TraceEngine::reg_trace(vp::Trace *trace, int event, string path, string name)
@@ -132,7 +211,8 @@ void vp::TraceEngine::reg_trace(vp::Trace *trace, int event, string path, string
 
     int len = path.size() + name.size() + 1;
 
-    if (len > max_path_len)
+    // Binary traces are not displayed, they must not change the alignment of other traces
+    if (len > max_path_len && !trace->is_binary)
         max_path_len = len;
 
     string full_path;
@@ -148,6 +228,14 @@ void vp::TraceEngine::reg_trace(vp::Trace *trace, int event, string path, string
 
     trace->trace_file = stdout;
 
+    // All the patterns are evaluated in one pass over the path
+    this->trace_matches.emplace_back();
+    vp::TracePathMatches &matches = this->trace_matches.back();
+    vp::TracePathMatcher *includes, *excludes;
+    this->get_trace_matchers(trace, &includes, &excludes);
+    includes->match(full_path, matches.includes);
+    excludes->match(full_path, matches.excludes);
+
     this->check_trace_active(trace, event);
 
     if (trace->get_event_active())
@@ -170,13 +258,24 @@ vp::TraceEngine::TraceEngine(js::Config *config)
     pthread_mutex_init(&mutex, NULL);
     pthread_cond_init(&cond, NULL);
 
-    for (int i = 0; i < TRACE_EVENT_NB_BUFFER; i++)
+    this->ring_depth = config->get_child_int("events/ring_depth");
+    if (this->ring_depth <= 0)
+    {
+        this->ring_depth = TRACE_EVENT_NB_BUFFER;
+    }
+    this->ring_drop = config->get_child_bool("events/ring_drop");
+
+    this->ring_buffers = new char *[this->ring_depth];
+    for (int i = 0; i < this->ring_depth; i++)
+    {
+        this->ring_buffers[i] = new char[TRACE_EVENT_BUFFER_SIZE];
+    }
+    if (this->ring_drop)
     {
-        event_buffers.push(new char[TRACE_EVENT_BUFFER_SIZE]);
+        this->ring_drop_buffer = new char[TRACE_EVENT_BUFFER_SIZE];
     }
-    current_buffer = event_buffers.front();
+    current_buffer = this->ring_acquire();
     current_buffer_event = current_buffer;
-    event_buffers.pop();
     current_buffer_size = 0;
     current_buffer_remaining_size = TRACE_EVENT_BUFFER_SIZE;
     this->first_pending_event = NULL;
@@ -209,6 +308,14 @@ vp::TraceEngine::TraceEngine(js::Config *config)
         std::string trace_path = x->get_str();
         this->add_trace_path(0, trace_path);
     }
+    js::Config *binary_regexs = config->get("traces/binary_include_regex");
+    if (binary_regexs != NULL)
+    {
+        for (auto x : binary_regexs->get_elems())
+        {
+            this->add_binary_path(x->get_str());
+        }
+    }
     for (auto x : config->get("events/include_regex")->get_elems())
     {
         std::string trace_path = x->get_str();
@@ -256,6 +363,17 @@ vp::TraceEngine::TraceEngine(js::Config *config)
     }
 
     this->memcheck_enabled = config->get("memcheck")->get_bool();
+
+    if (config->get_child_bool("traces/flight_recorder/enabled"))
+    {
+        int size = config->get_child_int("traces/flight_recorder/size");
+        if (size <= 0)
+        {
+            size = 64;
+        }
+        this->flight_recorder = new vp::FlightRecorder(this, (size_t)size * 1024 * 1024,
+            config->get_child_str("traces/flight_recorder/file"));
+    }
 }
 
 void vp::TraceEngine::init(vp::Component *top)
@@ -317,95 +435,65 @@ void vp::TraceEngine::start()
 
 
 
-void vp::TraceEngine::add_exclude_path(int events, const char *path)
+void vp::TraceEngine::add_exclude_path(int events, const char *path_str)
 {
-    regex_t *regex = new regex_t();
-
-    if (events)
+    std::string path = path_str;
+    size_t pos = path.find(events ? '@' : ':');
+    if (pos != std::string::npos)
     {
-        char *delim = (char *)::index(path, '@');
-        if (delim)
-        {
-            *delim = 0;
-        }
+        path = path.substr(0, pos);
+    }
 
-        if (this->events_path_regex.count(path) > 0)
-        {
-            delete this->events_path_regex[path];
-            this->events_path_regex.erase(path);
-        }
-        else
-        {
-            this->events_exclude_path_regex[path] = new trace_regex(path, regex, "");
-        }
+    // Excluding a path which was included just removes it
+    vp::TracePathMatcher *includes = events ? &this->events_path_regex : &this->trace_regexs;
+    vp::TracePathMatcher *excludes = events ? &this->events_exclude_path_regex : &this->trace_exclude_regexs;
+
+    if (includes->get(path) != NULL)
+    {
+        this->remove_pattern(includes, path);
     }
     else
     {
-        char *delim = (char *)::index(path, ':');
-        if (delim)
-        {
-            *delim = 0;
-        }
-        if (this->trace_regexs.count(path) > 0)
-        {
-            delete this->trace_regexs[path];
-            this->trace_regexs.erase(path);
-        }
-        else
-        {
-            this->trace_exclude_regexs[path] = new trace_regex(path, regex, "");
-        }
+        this->add_pattern(excludes, new trace_regex(path, ""));
     }
-
-    regcomp(regex, path, 0);
 }
 
 
 
-void vp::TraceEngine::add_path(int events, const char *path, bool is_path)
+void vp::TraceEngine::add_path(int events, const char *path_str, bool is_path)
 {
-    regex_t *regex = new regex_t();
+    std::string path = path_str;
+    std::string file_path = events ? "all.vcd" : "";
+    size_t pos = path.find(events ? '@' : ':');
+    if (pos != std::string::npos)
+    {
+        file_path = path.substr(pos + 1);
+        path = path.substr(0, pos);
+    }
 
     if (events)
     {
-        const char *file_path = "all.vcd";
-        char *delim = (char *)::index(path, '@');
-        if (delim)
-        {
-            *delim = 0;
-            file_path = delim + 1;
-        }
-
-        if (this->events_exclude_path_regex.count(path) > 0)
-        {
-            delete this->events_exclude_path_regex[path];
-            this->events_exclude_path_regex.erase(path);
-        }
-
-        this->events_path_regex[path] = new trace_regex(path, regex, file_path, is_path);
+        this->remove_pattern(&this->events_exclude_path_regex, path);
+        this->add_pattern(&this->events_path_regex, new trace_regex(path, file_path, is_path));
     }
     else
     {
-        std::string file_path = "";
-        char *dup_path = strdup(path);
-        char *sep = strchr(dup_path, ':');
-        if (sep)
-        {
-            *sep = 0;
-            file_path = sep + 1;
-            path = dup_path;
-        }
-
-        if (this->trace_exclude_regexs.count(path) > 0)
-        {
-            delete this->trace_exclude_regexs[path];
-            this->trace_exclude_regexs.erase(path);
-        }
+        this->remove_pattern(&this->trace_exclude_regexs, path);
+        this->add_pattern(&this->trace_regexs, new trace_regex(path, file_path));
+    }
+}
 
-        this->trace_regexs[path] = new trace_regex(path, regex, file_path);
+void vp::TraceEngine::add_binary_path(std::string path)
+{
+    std::string file_path = "";
+    size_t pos = path.find(':');
+    if (pos != std::string::npos)
+    {
+        file_path = path.substr(pos + 1);
+        path = path.substr(0, pos);
     }
 
-    regcomp(regex, path, 0);
+    this->add_pattern(&this->binary_trace_regexs, new trace_regex(path, file_path));
 }
 
 void vp::TraceEngine::conf_trace(int event, std::string path_str, bool enabled)
@@ -440,14 +528,8 @@ void vp::TraceEngine::conf_trace(int event, std::string path_str, bool enabled)
         {
             if (enabled)
             {
-                vp::Event_trace *event_trace;
-                if (trace->is_real)
-                    event_trace = event_dumper.get_trace_real(trace->get_full_path(), file_path);
-                else if (trace->is_string)
-                    event_trace = event_dumper.get_trace_string(trace->get_full_path(), file_path);
-                else
-                    event_trace = event_dumper.get_trace(trace->get_full_path(), file_path, trace->width);
-                trace->event_trace = event_trace;
+                trace->event_trace = this->get_event_trace(trace, trace->get_full_path(),
+                    file_path);
             }
             trace->set_event_active(enabled);
         }
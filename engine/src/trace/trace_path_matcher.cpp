@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vp/trace/trace_path_matcher.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+
+
+static int64_t trace_regex_next_id = 0;
+
+static bool ends_with(const std::string &str, const std::string &suffix)
+{
+    return str.size() >= suffix.size() &&
+        str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+vp::trace_regex::trace_regex(std::string path, std::string file_path, bool is_path)
+    : is_path(is_path), path(path), file_path(file_path)
+{
+    this->id = trace_regex_next_id++;
+
+    // Since the pattern is searched anywhere in the path, leading and trailing ".*" can be
+    // removed, and what remains is a plain string if it does not contain any special character.
+    std::string literal = path;
+
+    if (literal.size() > 0 && literal[0] == '^')
+    {
+        this->anchor_start = true;
+        literal = literal.substr(1);
+    }
+    while (literal.compare(0, 2, ".*") == 0)
+    {
+        this->anchor_start = false;
+        literal = literal.substr(2);
+    }
+
+    if (ends_with(literal, "$") && !ends_with(literal, "\\$"))
+    {
+        this->anchor_end = true;
+        literal = literal.substr(0, literal.size() - 1);
+    }
+    while (ends_with(literal, ".*") && !ends_with(literal, "\\.*"))
+    {
+        this->anchor_end = false;
+        literal = literal.substr(0, literal.size() - 2);
+    }
+
+    bool is_literal = true;
+    for (char c: literal)
+    {
+        if (strchr(".[]*^$\\", c) != NULL || (unsigned char)c >= 128)
+        {
+            is_literal = false;
+            break;
+        }
+    }
+
+    if (is_literal)
+    {
+        this->literal = literal;
+    }
+    else
+    {
+        this->regex = new regex_t();
+        if (regcomp(this->regex, path.c_str(), 0) != 0)
+        {
+            fprintf(stderr, "Invalid trace path regular expression, ignoring it: %s\n",
+                path.c_str());
+            delete this->regex;
+            this->regex = NULL;
+            this->is_invalid = true;
+        }
+    }
+}
+
+vp::trace_regex::~trace_regex()
+{
+    if (this->regex)
+    {
+        regfree(this->regex);
+        delete this->regex;
+    }
+}
+
+bool vp::trace_regex::match(const std::string &path)
+{
+    if (this->is_invalid)
+    {
+        return false;
+    }
+
+    if (this->regex)
+    {
+        return (this->is_path && this->path == path) ||
+            regexec(this->regex, path.c_str(), 0, NULL, 0) == 0;
+    }
+
+    if (this->anchor_start && this->anchor_end)
+    {
+        return path == this->literal;
+    }
+    else if (this->anchor_start)
+    {
+        return path.compare(0, this->literal.size(), this->literal) == 0;
+    }
+    else if (this->anchor_end)
+    {
+        return ends_with(path, this->literal);
+    }
+    else
+    {
+        return path.find(this->literal) != std::string::npos;
+    }
+}
+
+
+vp::TracePathMatcher::~TracePathMatcher()
+{
+    for (auto &x: this->patterns)
+    {
+        delete x.second;
+    }
+}
+
+void vp::TracePathMatcher::add(trace_regex *regex)
+{
+    this->patterns[regex->path] = regex;
+    this->dirty = true;
+}
+
+void vp::TracePathMatcher::remove(trace_regex *regex)
+{
+    this->patterns.erase(regex->path);
+    this->dirty = true;
+}
+
+vp::trace_regex *vp::TracePathMatcher::get(std::string path)
+{
+    auto it = this->patterns.find(path);
+    return it == this->patterns.end() ? NULL : it->second;
+}
+
+void vp::TracePathMatcher::build()
+{
+    std::array<int32_t, 128> empty;
+    empty.fill(-1);
+
+    this->transitions.assign(1, empty);
+    this->outputs.assign(1, {});
+    this->universal.clear();
+    this->others.clear();
+
+    // First build the trie of all plain strings
+    for (auto &x: this->patterns)
+    {
+        trace_regex *regex = x.second;
+
+        if (regex->regex || regex->is_invalid)
+        {
+            this->others.push_back(regex);
+        }
+        else if (regex->literal.size() == 0)
+        {
+            if (regex->anchor_start && regex->anchor_end)
+            {
+                this->others.push_back(regex);
+            }
+            else
+            {
+                this->universal.push_back(regex);
+            }
+        }
+        else
+        {
+            int state = 0;
+            for (char c: regex->literal)
+            {
+                if (this->transitions[state][c] == -1)
+                {
+                    this->transitions[state][c] = this->transitions.size();
+                    this->transitions.push_back(empty);
+                    this->outputs.push_back({});
+                }
+                state = this->transitions[state][c];
+            }
+            this->outputs[state].push_back(regex);
+        }
+    }
+
+    // Then turn it into a complete automaton, by following the failure links in breadth-first
+    // order. Each state also reports the patterns of the states it falls back to, since they are
+    // suffixes of the string it represents.
+    std::vector<int32_t> fail(this->transitions.size(), 0);
+    std::deque<int32_t> queue;
+
+    for (int c = 0; c < 128; c++)
+    {
+        int32_t next = this->transitions[0][c];
+        if (next == -1)
+        {
+            this->transitions[0][c] = 0;
+        }
+        else
+        {
+            queue.push_back(next);
+        }
+    }
+
+    while (!queue.empty())
+    {
+        int32_t state = queue.front();
+        queue.pop_front();
+
+        std::vector<trace_regex *> &fail_outputs = this->outputs[fail[state]];
+        this->outputs[state].insert(this->outputs[state].end(), fail_outputs.begin(),
+            fail_outputs.end());
+
+        for (int c = 0; c < 128; c++)
+        {
+            int32_t next = this->transitions[state][c];
+            if (next == -1)
+            {
+                this->transitions[state][c] = this->transitions[fail[state]][c];
+            }
+            else
+            {
+                fail[next] = this->transitions[fail[state]][c];
+                queue.push_back(next);
+            }
+        }
+    }
+
+    this->dirty = false;
+}
+
+void vp::TracePathMatcher::match(const std::string &path, std::vector<trace_regex *> &result)
+{
+    if (this->dirty)
+    {
+        this->build();
+    }
+
+    int64_t stamp = this->match_stamp++;
+    int size = path.size();
+    int32_t state = 0;
+
+    for (int i = 0; i < size; i++)
+    {
+        unsigned char c = path[i];
+        // Patterns only contain ASCII characters
+        state = c < 128 ? this->transitions[state][c] : 0;
+
+        for (trace_regex *regex: this->outputs[state])
+        {
+            int start = i + 1 - regex->literal.size();
+            if (regex->match_stamp != stamp &&
+                (!regex->anchor_start || start == 0) &&
+                (!regex->anchor_end || i + 1 == size))
+            {
+                regex->match_stamp = stamp;
+                result.push_back(regex);
+            }
+        }
+    }
+
+    result.insert(result.end(), this->universal.begin(), this->universal.end());
+
+    for (trace_regex *regex: this->others)
+    {
+        if (regex->match(path))
+        {
+            result.push_back(regex);
+        }
+    }
+}
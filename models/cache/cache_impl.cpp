@@ -23,6 +23,7 @@
 #include <vp/queue.hpp>
 #include <vp/itf/io.hpp>
 #include <vp/signal.hpp>
+#include <vp/fast_forward.hpp>
 #include <vector>
 #include <sstream>
 
@@ -280,7 +281,9 @@ cache_line_t *Cache::refill(int line_index, unsigned int addr, unsigned int tag,
 
     line->tag = tag;
 
-    if (!req->is_debug())
+    // Refills take no time in fast-forward mode. Line timestamps are then left in the past so
+    // that hits do not get any latency either.
+    if (!req->is_debug() && !vp::FastForward::is_active())
     {
         // This cache supports only one refill at the same time. Since we allow
         // synchronous request responses, make sure we report the delay in the latency
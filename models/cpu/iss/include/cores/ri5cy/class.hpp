@@ -90,6 +90,8 @@ public:
 
     void start();
     void reset(bool active);
+    void checkpoint_save(vp::CheckpointWriter &writer) override;
+    void checkpoint_restore(vp::CheckpointReader &reader) override;
 
     Iss iss;
 
@@ -160,6 +160,15 @@ public:
 
     int stall_reg;
 
+    // Set by the instruction cache when translated blocks are flushed. Loosely-timed mode is not
+    // supported by this core, so this is only there to share the instruction cache.
+    bool quantum_yield;
+
+    // Fast-forward mode is not supported by this core, this is only there to share the
+    // decoder, the timing and the semihosting code
+    bool fast_forward = false;
+    void fast_forward_trigger(std::string reason) {}
+
     inline void offload_insn(IssOffloadInsn<iss_reg_t> *insn);
 
 private:
@@ -119,7 +119,7 @@ inline void Exec::insn_resume()
 
 inline void Exec::insn_terminate()
 {
-    if (this->iss.trace.insn_trace.get_active())
+    if (this->iss.trace.get_insn_trace_active())
     {
         // TODO this is not possible to correctly handle it for now, a better system should be implemented
         // for staling execution.
@@ -152,6 +152,12 @@ inline bool Exec::can_switch_to_fast_mode()
         return false;
     }
 
+    // The instruction profiler countdown is only checked by the slow handler
+    if (this->iss.timing.profiler_insns)
+    {
+        return false;
+    }
+
 #ifdef VP_TRACE_ACTIVE
     return false;
 #else
@@ -187,7 +193,8 @@ inline void Exec::stalled_dec()
 
 inline void Exec::insn_exec_profiling()
 {
-    this->trace.msg("Executing instruction (addr: 0x%x)\n", this->iss.exec.current_insn);
+    vp_trace_msg(&this->trace, vp::Trace::LEVEL_DEBUG, "Executing instruction (addr: 0x%x)\n", this->iss.exec.current_insn);
+
     if (this->iss.timing.pc_trace_event.get_event_active())
     {
         this->iss.timing.pc_trace_event.event((uint8_t *)&this->iss.exec.current_insn);
@@ -231,6 +238,10 @@ inline void Exec::busy_enter()
     uint8_t one = 1;
     this->iss.timing.state_event.event(&one);
     this->iss.exec.busy.set(1);
+    if (this->iss.timing.profiler)
+    {
+        this->iss.timing.profiler->core_active(true);
+    }
     if (this->iss.exec.busy_itf.is_bound())
     {
         this->iss.exec.busy_itf.sync(1);
@@ -241,6 +252,10 @@ inline void Exec::busy_exit()
 {
     this->iss.timing.state_event.event_highz();
     this->iss.exec.busy.release();
+    if (this->iss.timing.profiler)
+    {
+        this->iss.timing.profiler->core_active(false);
+    }
     if (this->iss.exec.busy_itf.is_bound())
     {
         this->iss.exec.busy_itf.sync(0);
@@ -89,6 +89,9 @@ public:
 
 
 private:
+    // The wrapper saves the barrier state in checkpoints
+    friend class IssWrapper;
+
     bool barrier_update(bool is_write, iss_reg_t &value);
     static void barrier_sync(vp::Block *__this, bool value);
 
@@ -107,6 +110,8 @@ public:
 
     void start();
     void reset(bool active);
+    void checkpoint_save(vp::CheckpointWriter &writer) override;
+    void checkpoint_restore(vp::CheckpointReader &reader) override;
 
     Iss iss;
 
@@ -158,6 +158,9 @@ public:
 
     bool access(bool is_write, iss_reg_t address, iss_reg_t &value);
 
+    void checkpoint_save(vp::CheckpointWriter &writer);
+    void checkpoint_restore(vp::CheckpointReader &reader);
+
     Iss &iss;
 
     vp::Trace trace;
@@ -245,6 +248,7 @@ private:
     bool tselect_access(bool is_write, iss_reg_t &value);
     bool time_access(bool is_write, iss_reg_t &value);
     bool mcycle_access(bool is_write, iss_reg_t &value);
+    uint64_t checkpoint_nb_regs();
 
     std::map<iss_reg_t, CsrAbtractReg *> regs;
     vp::WireMaster<uint64_t> time_itf;
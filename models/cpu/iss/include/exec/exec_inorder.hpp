@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <vp/vp.hpp>
 #include <cpu/iss/include/types.hpp>
 #include ISS_CORE_INC(class.hpp)
@@ -98,6 +99,7 @@ public:
 
     static void exec_instr(vp::Block *__this, vp::ClockEvent *event);
     static void exec_instr_check_all(vp::Block *__this, vp::ClockEvent *event);
+    static void exec_instr_quantum(vp::Block *__this, vp::ClockEvent *event);
 
     int64_t get_cycles();
 
@@ -160,6 +162,30 @@ public:
 
     int stall_reg;
 
+    // Number of instructions that the core can execute in advance of the clock engine in
+    // loosely-timed mode. 0 means the core executes one instruction per engine cycle.
+    int64_t quantum;
+    // Set when something needs the clock engine to get back control, to stop the current quantum
+    bool quantum_yield;
+    // True if instructions are executed by translated blocks in loosely-timed mode
+    bool block_cache;
+    // Total number of instructions executed in loosely-timed mode
+    vp::reg_64 quantum_insns;
+    vp::Trace quantum_trace;
+
+    // True while the platform is in fast-forward mode. The core then runs loosely-timed with
+    // the fast-forward quantum, without fetch and pipeline timing.
+    bool fast_forward;
+    // Quantum to be used once the platform switches to timed mode
+    int64_t timed_quantum;
+    // PC and remaining number of instructions which switch the platform to timed mode, or -1
+    iss_reg_t fast_forward_pc;
+    int64_t fast_forward_insns;
+    // Switch the platform to timed mode because of a trigger detected by this core
+    void fast_forward_trigger(std::string reason);
+    // Switch this core to timed mode, once the platform has left fast-forward mode
+    void fast_forward_exit();
+
     inline void offload_insn(IssOffloadInsn<iss_reg_t> *insn);
 
 private:
@@ -169,6 +195,8 @@ private:
     static void fetchen_sync(vp::Block *_this, bool active);
     static void offload_grant(vp::Block *_this, IssOffloadInsnGrant<iss_reg_t> *result);
     void bootaddr_apply(uint32_t value);
+    void quantum_report();
+    int64_t quantum_exec_blocks(int64_t quantum);
 
     Iss &iss;
 
@@ -181,6 +209,10 @@ private:
 
     bool clock_active;
 
+    // Used for reporting the throughput achieved in loosely-timed mode
+    int64_t quantum_report_insns;
+    std::chrono::steady_clock::time_point quantum_report_time;
+
     vp::WireMaster<IssOffloadInsn<iss_reg_t> *> offload_itf;
     vp::WireSlave<IssOffloadInsnGrant<iss_reg_t> *> offload_grant_itf;
 };
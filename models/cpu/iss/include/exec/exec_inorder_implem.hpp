@@ -106,6 +106,7 @@ inline void Exec::insn_stall()
 
 inline void Exec::insn_hold(vp::ClockEventMeth *meth)
 {
+    this->quantum_yield = true;
     this->iss.trace.dump_trace_enabled = false;
     this->stall_insn = this->current_insn;
     // Flag that we cannto execute instructions so that no one tries
@@ -123,7 +124,7 @@ inline void Exec::insn_resume()
 
 inline void Exec::insn_terminate()
 {
-    if (this->iss.trace.insn_trace.get_active())
+    if (this->iss.trace.get_insn_trace_active())
     {
         // TODO this is not possible to correctly handle it for now, a better system should be implemented
         // for staling execution.
@@ -156,6 +157,12 @@ inline bool Exec::can_switch_to_fast_mode()
         return false;
     }
 
+    // The instruction profiler countdown is only checked by the slow handler
+    if (this->iss.timing.profiler_insns)
+    {
+        return false;
+    }
+
 #ifdef VP_TRACE_ACTIVE
     return false;
 #else
@@ -170,6 +177,7 @@ inline bool Exec::is_stalled()
 
 inline void Exec::stalled_inc()
 {
+    this->quantum_yield = true;
     if (this->stalled.get() == 0)
     {
         this->instr_event.disable();
@@ -196,11 +204,12 @@ inline void Exec::stalled_dec()
 
 inline void Exec::insn_exec_profiling()
 {
-    this->trace.msg("Executing instruction (addr: 0x%x)\n", this->iss.exec.current_insn);
+    vp_trace_msg(&this->trace, vp::Trace::LEVEL_DEBUG, "Executing instruction (addr: 0x%x)\n", this->iss.exec.current_insn);
 
     this->irq_enter.set(0);
     this->irq_exit.set(0);
 
+
     if (this->iss.timing.pc_trace_event.get_event_active())
     {
         this->iss.timing.pc_trace_event.event((uint8_t *)&this->iss.exec.current_insn);
@@ -225,6 +234,9 @@ inline void Exec::insn_exec_power(iss_insn_t *insn)
 
 inline void Exec::switch_to_full_mode()
 {
+    // Also stop the current quantum, the full handler needs to be called as soon as possible
+    this->quantum_yield = true;
+
     // Only switch to full mode instruction if we are not currently executing instructions,
     // do not overwrite the event callback used for another activity
     if (!this->insn_on_hold)
@@ -244,6 +256,10 @@ inline void Exec::busy_enter()
     uint8_t one = 1;
     this->iss.timing.state_event.event(&one);
     this->iss.exec.busy.set(1);
+    if (this->iss.timing.profiler)
+    {
+        this->iss.timing.profiler->core_active(true);
+    }
     if (this->iss.exec.busy_itf.is_bound())
     {
         this->iss.exec.busy_itf.sync(1);
@@ -254,6 +270,10 @@ inline void Exec::busy_exit()
 {
     this->iss.timing.state_event.event_highz();
     this->iss.exec.busy.release();
+    if (this->iss.timing.profiler)
+    {
+        this->iss.timing.profiler->core_active(false);
+    }
     if (this->iss.exec.busy_itf.is_bound())
     {
         this->iss.exec.busy_itf.sync(0);
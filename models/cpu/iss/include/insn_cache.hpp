@@ -21,17 +21,91 @@
 
 #pragma once
 
-// The size of a page corresponds to the tlb page size with instructions of at least 2 bytes
-#define INSN_PAGE_BITS 9
+#if defined(CONFIG_GVSOC_ISS_JIT)
+#include <cpu/iss/include/jit.hpp>
+#endif
+
+// The size of a page corresponds to the tlb page size with instructions of at least 2 bytes.
+// It can be overridden per core, bigger pages mean less page switches but more memory for sparse
+// code.
+#ifndef CONFIG_GVSOC_ISS_INSN_PAGE_BITS
+#define CONFIG_GVSOC_ISS_INSN_PAGE_BITS 9
+#endif
+
+#define INSN_PAGE_BITS CONFIG_GVSOC_ISS_INSN_PAGE_BITS
 #define INSN_PAGE_SIZE (1 << (INSN_PAGE_BITS - 1))
 #define INSN_PAGE_MASK (INSN_PAGE_SIZE - 1)
 
+#if defined(CONFIG_GVSOC_ISS_MMU) && INSN_PAGE_BITS > 12
+#error "Instruction cache pages must not be bigger than MMU pages"
+#endif
+
+// Pages are found from their physical address through a 3-level radix table. The 2 lower
+// levels resolve this number of bits each, the top level is sized from the physical address
+// range given by the insn_cache_addr_bits property. Pages out of this range go to a map.
+#define INSN_TABLE_LEVEL_BITS 10
+#define INSN_TABLE_LEVEL_SIZE (1 << INSN_TABLE_LEVEL_BITS)
+#define INSN_TABLE_LEVEL_MASK (INSN_TABLE_LEVEL_SIZE - 1)
+#define INSN_TABLE_TOP_MAX_BITS 20
+
+// Number of entries of the direct-mapped cache of recently used pages, indexed by virtual
+// address, which avoids both the address translation and the table walk on page switches
+#define INSN_RECENT_PAGES 16
+
 struct InsnPage
 {
     iss_insn_t insns[INSN_PAGE_SIZE];
     InsnPage *next;
 };
 
+struct InsnPageTableLeaf
+{
+    InsnPage *pages[INSN_TABLE_LEVEL_SIZE];
+};
+
+struct InsnPageTableNode
+{
+    InsnPageTableLeaf *leaves[INSN_TABLE_LEVEL_SIZE];
+};
+
+struct InsnRecentPage
+{
+    // Virtual page index, all ones when the entry is empty
+    iss_reg_t vpage;
+    InsnPage *page;
+};
+
+// Maximum number of instructions recorded in a translated block
+#define INSN_BLOCK_MAX_INSNS 32
+
+// A translated block is a straight-line sequence of decoded instructions, recorded while they
+// are executed, and ended by the first instruction which does not continue with the next one,
+// like a taken branch or a jump.
+// Not-taken branches do not end the block, they become side exits which are detected by
+// comparing the returned PC with the next recorded one.
+struct InsnBlock
+{
+    // Virtual address of the first instruction
+    iss_reg_t pc;
+    int nb_insns;
+    iss_insn_t *insns[INSN_BLOCK_MAX_INSNS];
+    iss_reg_t (*handlers[INSN_BLOCK_MAX_INSNS])(Iss *, iss_insn_t *, iss_reg_t);
+    // Address of each instruction, plus the address where the last one continued when the block
+    // was recorded
+    iss_reg_t pcs[INSN_BLOCK_MAX_INSNS + 1];
+    // Chained successors, the first one for the address recorded in pcs[nb_insns], the second
+    // one for any other address
+    InsnBlock *next[2];
+#if defined(CONFIG_GVSOC_ISS_JIT)
+    // Number of times the block was executed, used to detect hot blocks
+    int64_t nb_execs;
+    // Native code for the run of instructions starting at each index, if any, and index of the
+    // first instruction after the run
+    iss_jit_code_t jit_code[INSN_BLOCK_MAX_INSNS];
+    uint8_t jit_end[INSN_BLOCK_MAX_INSNS];
+#endif
+};
+
 class InsnCache
 {
 public:
@@ -44,12 +118,36 @@ public:
     void mode_flush();
     inline void insn_init(iss_insn_t *insn, iss_addr_t addr);
     InsnPage *page_get(iss_reg_t paddr);
+    InsnPage **page_entry_get(iss_reg_t index);
+
+    inline InsnBlock *block_get(iss_reg_t pc, InsnBlock *prev);
+    InsnBlock *block_lookup(iss_reg_t pc, InsnBlock *prev);
+    InsnBlock *block_new(iss_reg_t pc);
+    InsnBlock *block_commit(InsnBlock *block);
+    void block_flush();
+
+#if defined(CONFIG_GVSOC_ISS_JIT)
+    Jit jit;
+#endif
 
 
 private:
     InsnPage *current_insn_page;
     iss_reg_t current_insn_page_base;
+    InsnRecentPage recent_pages[INSN_RECENT_PAGES];
+    // Top level of the radix table, lower levels are allocated on demand
+    InsnPageTableNode **page_table;
+    int page_table_size;
+    // First page index which is not covered by the radix table
+    iss_reg_t page_table_limit;
+    // Pages which are not covered by the radix table
     std::unordered_map<iss_reg_t, InsnPage *>pages;
+    std::unordered_map<iss_reg_t, InsnBlock *>blocks;
+    // Flushed blocks are kept here and reused since a flush can happen while a block is being
+    // executed, from an instruction handler
+    std::vector<InsnBlock *>free_blocks;
+    // Set when blocks are flushed while a new one is being recorded
+    bool block_recording_flushed;
 
     Iss &iss;
 };
@@ -67,11 +165,34 @@ inline iss_insn_t *InsnCache::get_insn(iss_reg_t vaddr, iss_reg_t &index)
     return this->get_insn_from_cache(vaddr, index);
 }
 
+inline InsnBlock *InsnCache::block_get(iss_reg_t pc, InsnBlock *prev)
+{
+    // Follow the chain from the previous block first, which is the common case
+    if (likely(prev != NULL))
+    {
+        InsnBlock *block = prev->next[0];
+        if (likely(block != NULL && block->pc == pc))
+        {
+            return block;
+        }
+        block = prev->next[1];
+        if (block != NULL && block->pc == pc)
+        {
+            return block;
+        }
+    }
+
+    return this->block_lookup(pc, prev);
+}
+
 inline void InsnCache::insn_init(iss_insn_t *insn, iss_addr_t addr)
 {
     insn->handler = iss_decode_pc_handler;
     insn->fast_handler = iss_decode_pc_handler;
+    // Only set once the instruction is successfully decoded
+    insn->decoder_item = NULL;
     insn->addr = addr;
+    insn->trace_binary_id = 0;
 #if defined(CONFIG_GVSOC_ISS_RI5KY)
     insn->hwloop_handler = NULL;
 #endif
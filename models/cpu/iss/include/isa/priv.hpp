@@ -227,7 +227,8 @@ static inline iss_reg_t sfence_vma_exec(Iss *iss, iss_insn_t *insn, iss_reg_t pc
     }
     else
     {
-        iss->mmu.flush(REG_GET(0), REG_GET(1));
+        // rs1 and rs2 set to x0 respectively select all addresses and all address spaces
+        iss->mmu.flush(REG_GET(0), REG_GET(1), REG_IN(0) == 0, REG_IN(1) == 0);
         iss->insn_cache.mode_flush();
         return iss_insn_next(iss, insn, pc);
     }
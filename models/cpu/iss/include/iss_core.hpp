@@ -66,5 +66,8 @@ static inline iss_reg_t iss_insn_next(Iss *iss, iss_insn_t *insn, iss_reg_t pc)
 #include <cpu/iss/include/decode.hpp>
 #include "cpu/iss/include/insn_cache.hpp"
 #include "cpu/iss/include/resource.hpp"
+#if defined(CONFIG_GVSOC_ISS_JIT)
+#include "cpu/iss/include/jit_implem.hpp"
+#endif
 
 #endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <vp/vp.hpp>
+#include <cpu/iss/include/types.hpp>
+
+struct InsnBlock;
+
+// Native code generated for a run of instructions. It only works on the register file.
+typedef void (*iss_jit_code_t)(iss_reg_t *regs);
+
+// Dynamic binary translation tier for translated blocks.
+// Blocks executed more than a threshold get their runs of simple integer instructions compiled
+// into native code, which directly works on the register file. All other instructions (CSR,
+// loads and stores, branches, and so on) are still executed by their handlers.
+class Jit
+{
+public:
+    Jit(Iss &iss);
+
+    void build();
+
+    // Tell if native code can be executed. This is not the case when something needs to be
+    // done for each instruction, like power or PC traces.
+    inline bool is_usable();
+
+    // Account one execution of the block and compile it once it gets hot
+    inline void block_profile(InsnBlock *block);
+
+    // Execute the native code starting at the specified instruction of the block, and return
+    // the index of the first instruction which was not executed
+    inline int block_exec(InsnBlock *block, int index);
+
+    // Drop all native code, must be called when blocks are flushed
+    void flush();
+
+    bool enabled;
+
+private:
+    void block_compile(InsnBlock *block);
+    int block_exec_check(InsnBlock *block, int index);
+    // Change the protection of the pages covering the specified range of the arena
+    void arena_protect(size_t start, size_t end, int prot);
+    bool insn_compile(iss_insn_t *insn);
+
+    inline void emit8(uint8_t value);
+    inline void emit32(uint32_t value);
+    inline void emit_rex();
+    void emit_reg_op(uint8_t opcode, int modrm_reg, int reg);
+    void emit_imm_op(uint8_t opcode, int64_t imm);
+    void emit_set_imm(int64_t imm);
+    void emit_shift_imm(int modrm, int amount);
+    void emit_shift_reg(int modrm, int reg);
+    void emit_compare(int reg, bool is_imm, int64_t value, uint8_t setcc);
+
+    Iss &iss;
+    vp::Trace trace;
+
+    // Native instructions are generated into this arena, which is reset when blocks are flushed.
+    // It is executable except while a block is being compiled into it.
+    uint8_t *arena;
+    size_t arena_size;
+    size_t arena_pos;
+    bool arena_full;
+
+    int64_t threshold;
+    // When set, native code is executed on a copy of the register file and compared with the
+    // interpreter, which is used for the actual execution
+    bool check;
+    int64_t nb_compiled_insns;
+};
+
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cpu/iss/include/types.hpp>
+
+
+inline bool Jit::is_usable()
+{
+#ifdef VP_MEMCHECK_ACTIVE
+    return false;
+#else
+    return this->enabled && this->arena != NULL && !this->iss.top.power.is_enabled();
+#endif
+}
+
+inline void Jit::block_profile(InsnBlock *block)
+{
+    if (unlikely(block->nb_execs++ == this->threshold))
+    {
+        this->block_compile(block);
+    }
+}
+
+inline int Jit::block_exec(InsnBlock *block, int index)
+{
+    if (unlikely(this->check))
+    {
+        return this->block_exec_check(block, index);
+    }
+
+    block->jit_code[index](this->iss.regfile.regs);
+    return block->jit_end[index];
+}
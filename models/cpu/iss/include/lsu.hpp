@@ -32,6 +32,25 @@
 #define ADDR_MASK (~(ISS_REG_WIDTH / 4 - 1))
 #endif
 
+// Number of direct memory interface grants cached by the LSU
+#define LSU_DMI_NB_RANGES 8
+// Number of pages for which it is remembered that no grant could be obtained, so that accesses
+// to peripherals do not ask for it each time
+#define LSU_DMI_NB_DENIED 16
+#define LSU_DMI_DENIED_PAGE_BITS 12
+
+struct LsuDmiRange
+{
+    iss_addr_t base;
+    // Last address of the range, inclusive so that a range can end at the top of the address
+    // space
+    iss_addr_t last;
+    uint8_t *data;
+    int64_t latency;
+    bool read_allowed;
+    bool write_allowed;
+};
+
 class Lsu
 {
 public:
@@ -44,6 +63,7 @@ public:
     int data_req(iss_addr_t addr, uint8_t *data, uint8_t *memcheck_data, int size, bool is_write, int64_t &latency);
     int data_req_aligned(iss_addr_t addr, uint8_t *data_ptr, uint8_t *memcheck_data, int size, bool is_write, int64_t &latency);
     int data_misaligned_req(iss_addr_t addr, uint8_t *data_ptr, uint8_t *memcheck_data, int size, bool is_write, int64_t &latency);
+    bool data_req_dmi(iss_addr_t addr, uint8_t *data_ptr, uint8_t *memcheck_data, int size, bool is_write, int64_t &latency);
 
     static void exec_misaligned(vp::Block *__this, vp::ClockEvent *event);
     static void data_grant(vp::Block *__this, vp::IoReq *req);
@@ -119,5 +139,17 @@ private:
     static void load_signed_resume(Lsu *lsu);
     static void load_float_resume(Lsu *lsu);
 
+    LsuDmiRange *dmi_range_get(iss_addr_t addr, bool is_write);
+    void dmi_flush();
+
     int64_t pending_latency;
+
+    // Direct memory interface, used to directly access memories granting it instead of
+    // sending requests
+    bool dmi_enabled;
+    uint64_t dmi_generation;
+    LsuDmiRange dmi_ranges[LSU_DMI_NB_RANGES];
+    int dmi_nb_ranges;
+    int dmi_next_range;
+    uint64_t dmi_denied_pages[LSU_DMI_NB_DENIED];
 };
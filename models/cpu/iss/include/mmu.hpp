@@ -21,12 +21,17 @@
 
 #pragma once
 
+#include <vector>
 #include <vp/vp.hpp>
 #include <cpu/iss/include/types.hpp>
 
 #define MMU_TLB_NB_ENTRIES 256
 #define MMU_TLB_ENTRIES_MASK 0xff
 
+// Default geometry of the set-associative TLB
+#define MMU_TLB_NB_SETS 256
+#define MMU_TLB_NB_WAYS 4
+
 #define MMU_PGSHIFT 12
 
 #define MMU_MODE_OFF  0
@@ -55,6 +60,27 @@ struct Pte
     };
 };
 
+/**
+ * @brief Entry of the set-associative TLB
+ *
+ * An entry maps a whole page, which is a superpage if level is not 0. The offset is the same for
+ * all the pages of a superpage, which makes it possible to fill the direct-mapped arrays from it.
+ */
+struct MmuTlbEntry
+{
+    // Virtual page number, at the granularity of the page size of the entry
+    iss_addr_t vpn;
+    // Physical address minus virtual address
+    iss_addr_t offset;
+    // Leaf pte, for the permissions
+    Pte pte;
+    iss_reg_t asid;
+    // Page-table level of the leaf, 0 for 4KB pages, 1 for 2MB superpages and 2 for 1GB ones
+    int level;
+    bool global;
+    bool valid;
+};
+
 class Mmu
 {
 public:
@@ -69,9 +95,16 @@ public:
     bool virt_to_phys_miss(iss_addr_t virt_addr, iss_addr_t &phys_addr, bool &use_mem_array);
 
     bool satp_update(bool is_write, iss_reg_t &value);
-    void flush(iss_addr_t address, iss_reg_t address_space);
+    void mode_update(int old_mode, int new_mode);
+    void flush_all();
+    void flush(iss_addr_t address, iss_reg_t asid, bool all_addresses, bool all_asids);
 
 private:
+    void tlb_l0_flush();
+    void tlb_l0_fill(iss_addr_t virt_addr, iss_addr_t offset, Pte pte, int level);
+    MmuTlbEntry *tlb_lookup(iss_addr_t virt_addr);
+    void tlb_insert(iss_addr_t virt_addr, iss_addr_t offset, Pte pte, int level, bool global);
+    bool pte_allows_access(Pte pte);
     void read_pte(iss_addr_t pte_addr);
     void walk_pgtab(iss_addr_t virt_addr);
     bool handle_pte();
@@ -95,8 +128,22 @@ private:
     iss_addr_t tlb_load_use_mem_array[MMU_TLB_NB_ENTRIES];
     iss_addr_t tlb_store_tag[MMU_TLB_NB_ENTRIES];
     iss_addr_t tlb_ls_phys_addr[MMU_TLB_NB_ENTRIES];
+    // True when the direct-mapped arrays contain pages of superpages, which must then be fully
+    // flushed when a single address is flushed
+    bool tlb_l0_superpages;
+
+    // The direct-mapped arrays above are only a cache of the translations of the current
+    // address space. Misses are first looked up in this set-associative TLB, tagged with the
+    // ASID, before walking the page-table.
+    std::vector<MmuTlbEntry> tlb;
+    std::vector<int> tlb_next_way;
+    int tlb_nb_sets = 0;
+    int tlb_nb_ways = 0;
+    vp::reg_64 tlb_hits;
+    vp::reg_64 tlb_misses;
 
     int current_level;
+    bool current_global;
     int current_vpn_bit;
     iss_addr_t current_virt_addr;
     Pte pte_value;
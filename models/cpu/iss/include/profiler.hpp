@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vp/vp.hpp>
+#include <cpu/iss/include/types.hpp>
+#include <array>
+#include <unordered_map>
+
+class IssWrapper;
+
+// Reasons why the core is not executing instructions, as seen by the sampling profiler
+typedef enum
+{
+    ISS_STALL_NONE,
+    ISS_STALL_FETCH,
+    ISS_STALL_BRANCH,
+    ISS_STALL_JUMP,
+    ISS_STALL_LOAD,
+    ISS_STALL_LOAD_DEPENDENCY,
+    ISS_STALL_INSN_DEPENDENCY,
+    ISS_STALL_INSN,
+    ISS_STALL_MISALIGNED,
+    ISS_STALL_WAIT,
+    ISS_STALL_NB
+} iss_stall_reason_e;
+
+typedef enum
+{
+    ISS_PROFILER_CYCLES,
+    ISS_PROFILER_INSNS,
+} iss_profiler_mode_e;
+
+// Statistical profiler, sampling the core state every N cycles or N retired instructions, with
+// a random jitter so that samples do not stay in phase with loops.
+// Each sample records the PC, and the stall reason if the core is stalled. Functions are only
+// resolved from the debug info when the profile is dumped, at the end of the simulation, as a
+// flat profile and as folded stacks for flamegraph tools.
+class Profiler : public vp::Block
+{
+public:
+    Profiler(IssWrapper &top, Iss &iss, iss_profiler_mode_e mode, int64_t period);
+
+    // Called when the core starts or stops executing instructions, to sample only active cycles
+    void core_active(bool active);
+
+    // Called by the core when the instruction countdown expires, in instruction mode
+    void insn_sample(iss_reg_t pc);
+
+    void stop();
+
+private:
+    static void cycle_sample_handler(vp::Block *__this, vp::ClockEvent *event);
+    int64_t next_interval();
+    void account(iss_reg_t pc, int reason);
+    void dump();
+
+    Iss &iss;
+    IssWrapper &top;
+    vp::ClockEvent sample_event;
+    iss_profiler_mode_e mode;
+    int64_t period;
+    uint64_t random_state;
+    int64_t nb_samples = 0;
+    // Number of samples per PC and per stall reason
+    std::unordered_map<iss_reg_t, std::array<int64_t, ISS_STALL_NB>> samples;
+    // In instruction mode, sampled instruction waiting for the next one to know if it stalled
+    bool insn_pending = false;
+    iss_reg_t insn_pending_pc;
+};
@@ -63,7 +63,7 @@ inline void Regfile::scoreboard_reg_check(int reg)
 #ifdef CONFIG_GVSOC_ISS_TIMED
     int64_t diff = this->scoreboard_reg_timestamp[reg] - this->engine->get_cycles() - this->iss.exec.stall_cycles;
 
-    if (unlikely(diff > 0))
+    if (unlikely(diff > 0) && !this->iss.exec.fast_forward)
     {
         int stall_reason = this->scoreboard_reg_stall_reason[reg];
         this->iss.timing.stall_cycles_account(diff);
@@ -83,7 +83,7 @@ inline void Regfile::scoreboard_freg_check(int reg)
 #else
     int64_t diff = this->scoreboard_freg_timestamp[reg] - this->engine->get_cycles() - this->iss.exec.stall_cycles;
 
-    if (unlikely(diff > 0))
+    if (unlikely(diff > 0) && !this->iss.exec.fast_forward)
     {
         int stall_reason = this->scoreboard_freg_stall_reason[reg];
         this->iss.timing.stall_cycles_account(diff);
@@ -23,6 +23,7 @@
 
 #include <vp/vp.hpp>
 #include <cpu/iss/include/types.hpp>
+#include <cpu/iss/include/profiler.hpp>
 
 class Timing
 {
@@ -58,7 +59,7 @@ public:
     inline void event_trace_reset(unsigned int event);
     inline int event_trace_is_active(unsigned int event);
 
-    inline void stall_cycles_account(int incr);
+    inline void stall_cycles_account(int incr, int reason=ISS_STALL_INSN);
 
     inline void event_account(unsigned int event, int incr);
     inline void handle_pending_events();
@@ -88,6 +89,18 @@ public:
     vp::PowerSource background_power;
     uint32_t pcer_trace_active_events;
 
+    // Sampling profiler, or NULL if it is disabled
+    Profiler *profiler = NULL;
+    // True when the profiler samples retired instructions. The core then stays on the slow
+    // instruction handler, which is the only one checking the countdown, so that the fast
+    // handlers do not pay anything for the profiler.
+    bool profiler_insns = false;
+    // Number of instructions to execute before calling the profiler, in instruction mode
+    int64_t profiler_countdown = INT64_MAX;
+    // Last stall and the instruction which caused it, used by the profiler
+    int stall_reason = ISS_STALL_NONE;
+    iss_reg_t stall_pc = 0;
+
 private:
 
     Iss &iss;
@@ -23,12 +23,20 @@
 
 #include "cpu/iss/include/types.hpp"
 
-inline void Timing::stall_cycles_account(int cycles)
+inline void Timing::stall_cycles_account(int cycles, int reason)
 {
 #if defined(CONFIG_GVSOC_ISS_TIMED)
+    // Pipeline timing is not modeled in fast-forward mode
+    if (unlikely(this->iss.exec.fast_forward))
+    {
+        return;
+    }
+
     this->iss.exec.stall_cycles += cycles;
     if (cycles > 0)
     {
+        this->stall_reason = reason;
+        this->stall_pc = this->iss.exec.current_insn;
         this->power_stall_first.account_energy_quantum();
         for (int i=0; i<cycles-1; i++)
         {
@@ -162,6 +170,8 @@ inline void Timing::event_apu_contention_account(int incr)
 
 inline void Timing::insn_stall_start()
 {
+    this->stall_reason = ISS_STALL_WAIT;
+    this->stall_pc = this->iss.exec.current_insn;
     this->event_trace_set(CSR_PCER_CYCLES);
 }
 
@@ -210,25 +220,25 @@ inline void Timing::insn_account()
 
 inline void Timing::stall_fetch_account(int cycles)
 {
-    this->stall_cycles_account(cycles);
+    this->stall_cycles_account(cycles, ISS_STALL_FETCH);
     this->event_account(CSR_PCER_IMISS, cycles);
 }
 
 inline void Timing::stall_misaligned_account()
 {
-    this->stall_cycles_account(1);
+    this->stall_cycles_account(1, ISS_STALL_MISALIGNED);
     this->event_account(CSR_PCER_LD, 1);
 }
 
 inline void Timing::stall_load_account(int cycles)
 {
-    this->stall_cycles_account(cycles);
+    this->stall_cycles_account(cycles, ISS_STALL_LOAD);
 }
 
 inline void Timing::stall_taken_branch_account()
 {
 #ifndef CONFIG_GVSOC_ISS_SNITCH
-    this->stall_cycles_account(2);
+    this->stall_cycles_account(2, ISS_STALL_BRANCH);
 #endif
     this->event_branch_account(1);
     this->event_taken_branch_account(1);
@@ -241,17 +251,17 @@ inline void Timing::stall_insn_account(int cycles)
 
 inline void Timing::stall_insn_dependency_account(int latency)
 {
-    this->stall_cycles_account(latency - 1);
+    this->stall_cycles_account(latency - 1, ISS_STALL_INSN_DEPENDENCY);
 }
 
 inline void Timing::stall_jump_account()
 {
-    this->stall_cycles_account(1);
+    this->stall_cycles_account(1, ISS_STALL_JUMP);
     this->event_jump_account(1);
 }
 
 inline void Timing::stall_load_dependency_account(int latency)
 {
-    this->stall_cycles_account(latency);
+    this->stall_cycles_account(latency, ISS_STALL_LOAD_DEPENDENCY);
     this->event_account(CSR_PCER_LD_STALL, latency);
 }
@@ -27,6 +27,66 @@
 
 
 
+// Kinds of records dumped in the binary instruction trace, see bin/gvsoc_insn_trace
+#define ISS_TRACE_BINARY_INFO   0
+#define ISS_TRACE_BINARY_DECODE 1
+#define ISS_TRACE_BINARY_EXEC   2
+
+// Flags of the execution records
+#define ISS_TRACE_BINARY_FLAG_REG_DUMP (1 << 0)
+#define ISS_TRACE_BINARY_FLAG_STR_DUMP (1 << 1)
+
+// Core information, dumped once before the first instruction is described. It is followed by
+// the paths of the debug binaries, each one prefixed by its 16bits length.
+typedef struct
+{
+    uint8_t kind;
+    uint8_t reg_size;
+    uint8_t has_double;
+    uint8_t single_regfile;
+    uint8_t float_hex;
+    uint8_t memcheck;
+    uint16_t fp_width;
+    uint16_t nb_regs;
+    uint16_t nb_binaries;
+} __attribute__((packed)) iss_trace_binary_info_t;
+
+// Decoded instruction, dumped the first time it is executed. It is followed by the label and
+// by one iss_trace_binary_arg_t per argument.
+typedef struct
+{
+    uint8_t kind;
+    uint8_t nb_args;
+    uint16_t label_len;
+    uint32_t id;
+    uint64_t opcode;
+} __attribute__((packed)) iss_trace_binary_decode_t;
+
+// Decoded argument, followed by its name if it is dumped by name
+typedef struct
+{
+    uint8_t type;
+    uint8_t dump_name;
+    uint16_t name_len;
+    uint32_t flags;
+    uint32_t insn_flags;
+    int32_t reg;
+    int32_t reg2;
+    int64_t imm;
+} __attribute__((packed)) iss_trace_binary_arg_t;
+
+// Executed instruction. It is followed by the values of the registers of the arguments, each
+// one with its memcheck value, and then optionally by the register and string dumps.
+typedef struct
+{
+    uint8_t kind;
+    uint8_t mode;
+    uint8_t flags;
+    uint8_t nb_values;
+    uint32_t id;
+    uint64_t pc;
+} __attribute__((packed)) iss_trace_binary_exec_t;
+
 class Trace
 {
 public:
@@ -35,6 +95,14 @@ public:
     void build();
     void reset(bool active);
 
+    // Tell if executed instructions should be traced, either as text or binary records
+    inline bool get_insn_trace_active()
+    {
+        return this->insn_trace.get_active() || this->insn_bin_trace.get_active();
+    }
+
+    void dump_binary(iss_insn_t *insn, iss_reg_t pc);
+
     void insn_trace_callback();
     void dump_debug_traces();
 
@@ -50,6 +118,8 @@ public:
     bool force_trace_dump;
 
     vp::Trace insn_trace;
+    // Same as insn_trace but dumping binary records, which are rendered offline
+    vp::Trace insn_bin_trace;
     iss_insn_arg_t saved_args[ISS_MAX_DECODE_ARGS];
     iss_insn_arg_t check_args[ISS_MAX_DECODE_ARGS];
     int priv_mode;
@@ -59,6 +129,10 @@ public:
     std::string str_dump;
 
 private:
+    void dump_binary_info();
+    void dump_binary_decode(iss_insn_t *insn);
 
     Iss &iss;
+    bool binary_info_dumped = false;
+    uint32_t binary_nb_decoded = 0;
 };
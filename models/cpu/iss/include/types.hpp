@@ -406,6 +406,9 @@ typedef struct iss_insn_s
 
     iss_insn_t *expand_table;
     bool is_macro_op;
+    // Identifier under which the decoded instruction has been described in the binary
+    // instruction trace, or 0 if it has not been described yet
+    uint32_t trace_binary_id;
 
     void *data[ISS_MAX_DATA];
 
@@ -53,6 +53,21 @@ class Iss(st.Component):
         starts it (default: False).
     boot_addr : int, optional
         Address of the first instruction (default: 0)
+    quantum : int, optional
+        Number of instructions the core can execute ahead of the clock engine in loosely-timed
+        mode, or 0 to execute one instruction per cycle (default: 0).
+    block_cache : bool, optional
+        True if instructions should be executed by translated blocks in loosely-timed mode. This is
+        only used when timing is not modeled (default: False).
+    dmi : bool, optional
+        True if data accesses should directly access memories granting a direct memory interface
+        instead of sending requests. Memories only grant it when nothing else than the latency is
+        modeled (default: False).
+    tlb_sets : int, optional
+        Number of sets of the MMU TLB, must be a power of 2 (default: 256).
+    tlb_ways : int, optional
+        Number of ways of the MMU TLB, or 0 to walk the page-table on each miss of the small
+        direct-mapped translation cache (default: 4).
 
     """
 
@@ -81,7 +96,12 @@ class Iss(st.Component):
             user=False,
             internal_atomics=False,
             timed=True,
-            scoreboard=False):
+            scoreboard=False,
+            quantum: int=0,
+            block_cache: bool=False,
+            dmi: bool=False,
+            tlb_sets: int=256,
+            tlb_ways: int=4):
 
         super(Iss, self).__init__(parent, name)
 
@@ -103,6 +123,11 @@ class Iss(st.Component):
             'core_id': core_id,
             'fetch_enable': fetch_enable,
             'boot_addr': boot_addr,
+            'quantum': quantum,
+            'block_cache': block_cache,
+            'dmi': dmi,
+            'tlb_sets': tlb_sets,
+            'tlb_ways': tlb_ways,
         })
 
         if core == 'ri5ky':
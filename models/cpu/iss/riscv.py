@@ -57,6 +57,39 @@ class RiscvCommon(st.Component):
         starts it (default: False).
     boot_addr : int, optional
         Address of the first instruction (default: 0)
+    quantum : int, optional
+        Number of instructions the core can execute ahead of the clock engine in loosely-timed
+        mode, or 0 to execute one instruction per cycle. Not supported by the snitch FP
+        subsystem (default: 0).
+    block_cache : bool, optional
+        True if instructions should be executed by translated blocks in loosely-timed mode. This is
+        only used when timing is not modeled (default: False).
+    dmi : bool, optional
+        True if data accesses should directly access memories granting a direct memory interface
+        instead of sending requests. Memories only grant it when nothing else than the latency is
+        modeled (default: False).
+    tlb_sets : int, optional
+        Number of sets of the MMU TLB, must be a power of 2 (default: 256).
+    tlb_ways : int, optional
+        Number of ways of the MMU TLB, or 0 to walk the page-table on each miss of the small
+        direct-mapped translation cache (default: 4).
+    jit : bool, optional
+        True if hot translated blocks should be compiled into native code. This builds the JIT
+        support and enables it by default, it can then be disabled at runtime through the jit
+        property (default: False).
+    jit_threshold : int, optional
+        Number of executions after which a translated block gets compiled (default: 100).
+    jit_check : bool, optional
+        True if native code should be checked against the interpreter (default: False).
+    insn_page_bits : int, optional
+        Log2 of the size in bytes of the pages of decoded instructions, or None to keep the
+        default of 9 (default: None).
+    sampling_profiler : str, optional
+        Mode of the sampling profiler, "cycles" to sample the core every sampling_period cycles,
+        "insns" to sample it every sampling_period retired instructions, or "none". The profile is
+        dumped at the end of the simulation (default: "none").
+    sampling_period : int, optional
+        Average number of cycles or instructions between 2 samples (default: 1000).
 
     """
 
@@ -94,7 +127,18 @@ class RiscvCommon(st.Component):
             external_pccr=False,
             htif=False,
             custom_sources=False,
-            float_lib='softfloat'):
+            float_lib='softfloat',
+            quantum: int=0,
+            block_cache: bool=False,
+            dmi: bool=False,
+            tlb_sets: int=256,
+            tlb_ways: int=4,
+            jit: bool=False,
+            jit_threshold: int=100,
+            jit_check: bool=False,
+            insn_page_bits: int=None,
+            sampling_profiler: str='none',
+            sampling_period: int=1000):
 
         super().__init__(parent, name)
 
@@ -120,6 +164,7 @@ class RiscvCommon(st.Component):
                 "cpu/iss/src/decode.cpp",
                 "cpu/iss/src/lsu.cpp",
                 "cpu/iss/src/timing.cpp",
+                "cpu/iss/src/profiler.cpp",
                 "cpu/iss/src/insn_cache.cpp",
                 "cpu/iss/src/iss.cpp",
                 "cpu/iss/src/core.cpp",
@@ -137,6 +182,10 @@ class RiscvCommon(st.Component):
                 "cpu/iss/flexfloat/flexfloat.c",
             ])
 
+        if jit:
+            self.add_sources(["cpu/iss/src/jit.cpp"])
+            self.add_c_flags(['-DCONFIG_GVSOC_ISS_JIT=1'])
+
         if power_models_file is not None:
             power_models = self.load_property_file(power_models_file)
 
@@ -153,6 +202,16 @@ class RiscvCommon(st.Component):
             'core_id': core_id,
             'fetch_enable': fetch_enable,
             'boot_addr': boot_addr,
+            'quantum': quantum,
+            'block_cache': block_cache,
+            'dmi': dmi,
+            'tlb_sets': tlb_sets,
+            'tlb_ways': tlb_ways,
+            'jit': jit,
+            'jit_threshold': jit_threshold,
+            'jit_check': jit_check,
+            'sampling_profiler': sampling_profiler,
+            'sampling_period': sampling_period,
             'has_double': isa.has_isa('rvd'),
         })
 
@@ -167,6 +226,11 @@ class RiscvCommon(st.Component):
                 'memory_size': memory_size,
             })
 
+            # Make sure the instruction page table covers the whole memory
+            self.add_properties({
+                'insn_cache_addr_bits': max(32, (memory_start + memory_size - 1).bit_length())
+            })
+
 
         if cflags is not None:
             self.add_c_flags(cflags)
@@ -206,6 +270,9 @@ class RiscvCommon(st.Component):
         if prefetcher_size is not None:
             self.add_c_flags([f'-DCONFIG_GVSOC_ISS_PREFETCHER_SIZE={prefetcher_size}'])
 
+        if insn_page_bits is not None:
+            self.add_c_flags([f'-DCONFIG_GVSOC_ISS_INSN_PAGE_BITS={insn_page_bits}'])
+
         if timed:
             self.add_c_flags(['-DCONFIG_GVSOC_ISS_TIMED=1'])
 
@@ -189,6 +189,7 @@ bool Core::sstatus_update(bool is_write, iss_reg_t &value)
 
 void Core::mode_set(int mode)
 {
+    this->iss.mmu.mode_update(this->mode, mode);
     this->mode = mode;
     this->iss.insn_cache.mode_flush();
 }
\ No newline at end of file
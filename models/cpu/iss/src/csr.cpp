@@ -20,6 +20,7 @@
  */
 
 #include "cpu/iss/include/iss.hpp"
+#include <vp/checkpoint.hpp>
 
 Csr::Csr(Iss &iss)
     : iss(iss)
@@ -1770,6 +1771,95 @@ bool Csr::access(bool is_write, iss_reg_t address, iss_reg_t &value)
 }
 
 
+uint64_t Csr::checkpoint_nb_regs()
+{
+    uint64_t nb_regs = 0;
+    for (auto &reg: this->regs)
+    {
+        nb_regs += reg.second != NULL;
+    }
+    return nb_regs;
+}
+
+void Csr::checkpoint_save(vp::CheckpointWriter &writer)
+{
+    // CSRs are saved with their address so that restoring on a core with a different set of
+    // CSRs is detected. The map also contains NULL entries for the undeclared CSRs which were
+    // accessed, they are skipped since they depend on the execution.
+    writer.write_u64(this->checkpoint_nb_regs());
+    for (auto &reg: this->regs)
+    {
+        if (reg.second != NULL)
+        {
+            writer.write_u64(reg.first);
+            writer.write_u64(*reg.second->value_p);
+        }
+    }
+
+    writer.write(&this->depc, sizeof(this->depc));
+    writer.write(&this->dcsr, sizeof(this->dcsr));
+#if defined(ISS_HAS_PERF_COUNTERS)
+    writer.write(this->pccr, sizeof(this->pccr));
+    writer.write(&this->pcer, sizeof(this->pcer));
+    writer.write(&this->pcmr, sizeof(this->pcmr));
+#endif
+    writer.write(&this->stack_conf, sizeof(this->stack_conf));
+    writer.write(&this->stack_start, sizeof(this->stack_start));
+    writer.write(&this->stack_end, sizeof(this->stack_end));
+    writer.write(&this->scratch0, sizeof(this->scratch0));
+    writer.write(&this->scratch1, sizeof(this->scratch1));
+    writer.write(&this->fcsr, sizeof(this->fcsr));
+#if defined(CONFIG_GVSOC_ISS_RI5KY)
+    writer.write(this->hwloop_regs, sizeof(this->hwloop_regs));
+#endif
+}
+
+void Csr::checkpoint_restore(vp::CheckpointReader &reader)
+{
+    if (!reader.check_u64(this->checkpoint_nb_regs(), "number of CSRs"))
+    {
+        return;
+    }
+
+    for (auto &reg: this->regs)
+    {
+        if (reg.second == NULL)
+        {
+            continue;
+        }
+
+        iss_reg_t address = reader.read_u64();
+        iss_reg_t value = reader.read_u64();
+        if (reader.is_ok() && address != reg.first)
+        {
+            reader.set_error("mismatch on CSR address (checkpoint: " + std::to_string(address) +
+                ", platform: " + std::to_string(reg.first) + ")");
+            return;
+        }
+
+        // Raw restore, side effects of CSR writes are rebuilt by the core
+        *reg.second->value_p = value;
+    }
+
+    reader.read(&this->depc, sizeof(this->depc));
+    reader.read(&this->dcsr, sizeof(this->dcsr));
+#if defined(ISS_HAS_PERF_COUNTERS)
+    reader.read(this->pccr, sizeof(this->pccr));
+    reader.read(&this->pcer, sizeof(this->pcer));
+    reader.read(&this->pcmr, sizeof(this->pcmr));
+#endif
+    reader.read(&this->stack_conf, sizeof(this->stack_conf));
+    reader.read(&this->stack_start, sizeof(this->stack_start));
+    reader.read(&this->stack_end, sizeof(this->stack_end));
+    reader.read(&this->scratch0, sizeof(this->scratch0));
+    reader.read(&this->scratch1, sizeof(this->scratch1));
+    reader.read(&this->fcsr, sizeof(this->fcsr));
+#if defined(CONFIG_GVSOC_ISS_RI5KY)
+    reader.read(this->hwloop_regs, sizeof(this->hwloop_regs));
+#endif
+}
+
+
 bool Mstatus::check_access(Iss *iss, bool write, bool read)
 {
     if (read && iss->core.mode_get() == PRIV_U)
@@ -274,6 +274,7 @@ int Decode::decode_insn(iss_insn_t *insn, iss_reg_t pc, iss_opcode_t opcode, iss
 #endif
 
     insn->is_macro_op = item->u.insn.is_macro_op;
+    insn->trace_binary_id = 0;
 
     if (item->u.insn.decode != NULL)
     {
@@ -290,7 +291,7 @@ int Decode::decode_insn(iss_insn_t *insn, iss_reg_t pc, iss_opcode_t opcode, iss
     }
 #endif
 
-    if (iss.trace.insn_trace.get_active() || iss.timing.insn_trace_event.get_event_active())
+    if (iss.trace.get_insn_trace_active() || iss.timing.insn_trace_event.get_event_active())
     {
         insn->saved_handler = insn->handler;
         insn->handler = this->iss.exec.insn_trace_callback_get();
@@ -380,12 +381,16 @@ void Decode::decode_pc(iss_insn_t *insn, iss_reg_t pc)
 
 iss_reg_t iss_decode_pc_handler(Iss *iss, iss_insn_t *insn, iss_reg_t pc)
 {
-#if !defined(CONFIG_GVSOC_ISS_TIMED)
+    // In timed mode, the opcode was already fetched before executing the instruction, except in
+    // fast-forward mode where the fetch is only done here, like in untimed mode
+#if defined(CONFIG_GVSOC_ISS_TIMED)
+    if (iss->exec.fast_forward && !iss->prefetcher.fetch(pc))
+#else
     if (!iss->prefetcher.fetch(pc))
+#endif
     {
         return pc;
     }
-#endif
 
     iss->decode.decode_pc(insn, pc);
 
@@ -21,6 +21,7 @@
 
 #include <vp/vp.hpp>
 #include "cpu/iss/include/iss.hpp"
+#include <vp/fast_forward.hpp>
 
 
 
@@ -34,6 +35,7 @@ Exec::Exec(IssWrapper &top, Iss &iss)
 void Exec::build()
 {
     this->iss.top.traces.new_trace("exec", &this->trace, vp::DEBUG);
+    this->iss.top.traces.new_trace("quantum", &this->quantum_trace, vp::DEBUG);
 
     this->iss.top.new_master_port("busy", &busy_itf);
 
@@ -68,12 +70,30 @@ void Exec::build()
     this->iss.top.new_reg("wfi", &this->wfi, false);
     this->iss.top.new_reg("irq_enter", &this->irq_enter, false);
     this->iss.top.new_reg("irq_exit", &this->irq_exit, false);
+    this->iss.top.new_reg("quantum_insns", &this->quantum_insns, 0);
 
     this->stalled.set(false);
     this->halted.set(false);
 
     this->bootaddr_offset = this->iss.top.get_js_config()->get_child_int("bootaddr_offset");
 
+    this->quantum = this->iss.top.get_js_config()->get_child_int("quantum");
+    // In fast-forward mode, the core runs loosely-timed with the fast-forward quantum until the
+    // platform switches to timed mode, and then gets back to its own quantum
+    this->timed_quantum = this->quantum;
+    this->fast_forward = vp::FastForward::is_active();
+    this->fast_forward_pc = -1;
+    this->fast_forward_insns = -1;
+    if (this->fast_forward)
+    {
+        this->quantum = vp::FastForward::get_quantum();
+        this->fast_forward_pc = vp::FastForward::get_until_pc();
+        this->fast_forward_insns = vp::FastForward::get_until_insns();
+    }
+    this->quantum_yield = false;
+    this->quantum_report_insns = 0;
+    this->block_cache = this->iss.top.get_js_config()->get_child_bool("block_cache");
+
 
     this->current_insn = 0;
     this->stall_insn = 0;
@@ -101,6 +121,7 @@ void Exec::reset(bool active)
         this->insn_on_hold = false;
         this->stall_cycles = 0;
         this->cache_sync = false;
+        this->quantum_yield = false;
 
         // Always increase the stall when reset is asserted since stall count is set to 0
         // and we need to prevent the core from fetching instructions
@@ -166,7 +187,7 @@ void Exec::exec_instr(vp::Block *__this, vp::ClockEvent *event)
 
     if (iss->exec.handle_stall_cycles()) return;
 
-    iss->exec.trace.msg(vp::Trace::LEVEL_TRACE, "Handling instruction with fast handler\n");
+    vp_trace_msg(&iss->exec.trace, vp::Trace::LEVEL_TRACE, "Handling instruction with fast handler\n");
 
     iss_reg_t pc = iss->exec.current_insn;
 
@@ -194,6 +215,269 @@ void Exec::exec_instr(vp::Block *__this, vp::ClockEvent *event)
 }
 
 
+void Exec::exec_instr_quantum(vp::Block *__this, vp::ClockEvent *event)
+{
+    Iss *const iss = (Iss *)__this;
+    Exec *_this = &iss->exec;
+
+    if (_this->handle_stall_cycles()) return;
+
+    // The platform may have been switched to timed mode by another core or by the proxy
+    if (unlikely(_this->fast_forward && !vp::FastForward::is_active()))
+    {
+        _this->fast_forward_exit();
+        return;
+    }
+
+    // In loosely-timed mode, instructions are executed back-to-back, with the core local time
+    // running ahead of the clock engine, until either the quantum expires or something needs
+    // the engine to get back control (stall on a pending request, IRQ, exception, switch to the
+    // full handler, and so on), which is flagged through quantum_yield.
+    _this->quantum_yield = false;
+    int64_t nb_insns = 0;
+    int64_t quantum = _this->quantum;
+    if (_this->fast_forward_insns > 0 && _this->fast_forward_insns < quantum)
+    {
+        quantum = _this->fast_forward_insns;
+    }
+
+    // Translated blocks skip the fetch, they can only be used when fetch timing is not modeled.
+    // They are always used in fast-forward mode, except with a PC trigger, which is checked
+    // on each instruction.
+#if defined(CONFIG_GVSOC_ISS_TIMED)
+    bool use_blocks = _this->fast_forward;
+#else
+    bool use_blocks = _this->block_cache || _this->fast_forward;
+#endif
+    if (use_blocks && _this->fast_forward_pc == (iss_reg_t)-1)
+    {
+        nb_insns = _this->quantum_exec_blocks(quantum);
+    }
+    else
+    {
+        do
+        {
+            iss_reg_t pc = _this->current_insn;
+
+            if (unlikely(pc == _this->fast_forward_pc))
+            {
+                _this->fast_forward_trigger("pc reached");
+                break;
+            }
+
+#if defined(CONFIG_GVSOC_ISS_TIMED)
+            if (!_this->fast_forward && !iss->prefetcher.fetch(pc)) break;
+#endif
+
+            iss_reg_t index;
+            iss_insn_t *insn = iss->insn_cache.get_insn(pc, index);
+            if (insn == NULL) break;
+
+            _this->insn_exec_profiling();
+
+            _this->current_insn = insn->fast_handler(iss, insn, pc);
+
+            _this->insn_exec_power(insn);
+
+            iss->regfile.memcheck_fault();
+
+            nb_insns++;
+        }
+        while (nb_insns < quantum && !_this->quantum_yield && _this->stall_cycles == 0);
+    }
+
+    if (_this->fast_forward_insns > 0)
+    {
+        _this->fast_forward_insns -= nb_insns;
+        if (_this->fast_forward_insns <= 0)
+        {
+            _this->fast_forward_trigger("instruction count reached");
+        }
+    }
+
+    // The first instruction is executed in the current cycle, the other ones are paid back by
+    // stalling the event, so that the engine catches up with the core local time.
+    if (nb_insns > 1)
+    {
+        event->stall_cycle_inc(nb_insns - 1);
+    }
+
+    _this->quantum_insns.inc(nb_insns);
+
+    if (_this->quantum_trace.get_active())
+    {
+        _this->quantum_report();
+    }
+}
+
+
+
+int64_t Exec::quantum_exec_blocks(int64_t quantum)
+{
+    Iss *const iss = &this->iss;
+    InsnBlock *block = NULL;
+    int64_t nb_insns = 0;
+    iss_reg_t pc = this->current_insn;
+#if defined(CONFIG_GVSOC_ISS_JIT)
+    bool use_jit = iss->insn_cache.jit.is_usable();
+#endif
+
+    do
+    {
+        block = iss->insn_cache.block_get(pc, block);
+
+        if (likely(block != NULL))
+        {
+#if defined(CONFIG_GVSOC_ISS_JIT)
+            if (use_jit)
+            {
+                iss->insn_cache.jit.block_profile(block);
+            }
+#endif
+
+            // Execute the block until its end or until an instruction does not continue with
+            // the recorded one (side exit, exception) or something needs the engine
+            int i;
+            for (i = 0; i < block->nb_insns; i++)
+            {
+#if defined(CONFIG_GVSOC_ISS_JIT)
+                if (block->jit_code[i] != NULL && use_jit)
+                {
+                    // Compiled instructions always continue with the next one and cannot stall
+                    i = iss->insn_cache.jit.block_exec(block, i) - 1;
+                    pc = block->pcs[i + 1];
+                    this->current_insn = pc;
+                    continue;
+                }
+#endif
+
+                iss_insn_t *insn = block->insns[i];
+
+                this->insn_exec_profiling();
+
+                pc = block->handlers[i](iss, insn, pc);
+                this->current_insn = pc;
+
+                this->insn_exec_power(insn);
+
+                iss->regfile.memcheck_fault();
+
+                if (unlikely(pc != block->pcs[i + 1] || this->quantum_yield))
+                {
+                    i++;
+                    break;
+                }
+            }
+
+            nb_insns += i;
+        }
+        else
+        {
+            // No block yet at this address, execute instructions one by one and record them
+            // until the first one which does not continue with the next one
+            int64_t nb_recorded = nb_insns;
+            block = iss->insn_cache.block_new(pc);
+
+            while (block->nb_insns < INSN_BLOCK_MAX_INSNS)
+            {
+                iss_reg_t index;
+                iss_insn_t *insn = iss->insn_cache.get_insn(pc, index);
+                if (insn == NULL) break;
+
+                this->insn_exec_profiling();
+
+                iss_reg_t next_pc = insn->fast_handler(iss, insn, pc);
+                this->current_insn = next_pc;
+
+                this->insn_exec_power(insn);
+
+                iss->regfile.memcheck_fault();
+
+                nb_insns++;
+
+                // The instruction may not have been decoded if the fetch is pending
+                if (!iss->insn_cache.insn_is_decoded(insn)) break;
+
+                int index_in_block = block->nb_insns++;
+                block->insns[index_in_block] = insn;
+                block->handlers[index_in_block] = insn->fast_handler;
+                block->pcs[index_in_block + 1] = next_pc;
+
+                iss_reg_t fallthrough_pc = pc + insn->size;
+                pc = next_pc;
+
+                if (next_pc != fallthrough_pc || this->quantum_yield) break;
+            }
+
+            block = iss->insn_cache.block_commit(block);
+
+            if (nb_insns == nb_recorded) break;
+        }
+    }
+    while (nb_insns < quantum && !this->quantum_yield);
+
+    return nb_insns;
+}
+
+
+
+void Exec::fast_forward_trigger(std::string reason)
+{
+    if (!this->fast_forward)
+    {
+        return;
+    }
+
+    vp::FastForward::stop(reason + " by " + this->iss.top.get_path());
+    this->fast_forward_exit();
+}
+
+
+
+void Exec::fast_forward_exit()
+{
+    this->trace.msg(vp::Trace::LEVEL_INFO, "Switching to timed mode (pc: 0x%lx)\n",
+        this->current_insn);
+
+    this->fast_forward = false;
+    this->fast_forward_pc = -1;
+    this->fast_forward_insns = -1;
+    this->quantum = this->timed_quantum;
+
+    // The prefetch buffer was only used for decoding and must be refilled with timing
+    this->iss.prefetcher.flush();
+
+    // Reselect the instruction handler for the timed mode
+    this->switch_to_full_mode();
+}
+
+
+
+void Exec::quantum_report()
+{
+    // Report throughput periodically rather than at each quantum to not slow down simulation
+    // too much while the trace is active
+    int64_t nb_insns = this->quantum_insns.get() - this->quantum_report_insns;
+    if (nb_insns < 10000000 && this->quantum_report_insns != 0)
+    {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+
+    if (this->quantum_report_insns != 0)
+    {
+        double elapsed = std::chrono::duration<double, std::micro>(now - this->quantum_report_time).count();
+        this->quantum_trace.msg(vp::Trace::LEVEL_INFO, "Loosely-timed throughput (quantum: %ld, instructions: %ld, mips: %.2f)\n",
+            this->quantum, this->quantum_insns.get(), elapsed > 0 ? nb_insns / elapsed : 0.0);
+    }
+
+    this->quantum_report_insns = this->quantum_insns.get();
+    this->quantum_report_time = now;
+}
+
+
+
 #if defined(CONFIG_GVSOC_ISS_RI5KY)
 
 // TODO HW loop methods could be moved to ri5cy specific code by using inheritance
@@ -208,6 +492,9 @@ void Exec::hwloop_stub_insert(iss_insn_t *insn, iss_reg_t pc)
 {
     if (insn->hwloop_handler == NULL)
     {
+        // Translated blocks have a copy of the handler
+        this->iss.insn_cache.block_flush();
+
         insn->hwloop_handler = insn->handler;
 
 #ifdef CONFIG_GVSOC_ISS_RI5KY
@@ -259,7 +546,7 @@ void Exec::exec_instr_check_all(vp::Block *__this, vp::ClockEvent *event)
 
     if (iss->exec.handle_stall_cycles()) return;
 
-    _this->trace.msg(vp::Trace::LEVEL_TRACE, "Handling instruction with slow handler (pc: 0x%lx)\n", iss->exec.current_insn);
+    vp_trace_msg(&_this->trace, vp::Trace::LEVEL_TRACE, "Handling instruction with slow handler (pc: 0x%lx)\n", iss->exec.current_insn);
 
     if(_this->pending_flush)
     {
@@ -277,11 +564,16 @@ void Exec::exec_instr_check_all(vp::Block *__this, vp::ClockEvent *event)
     // if HW counters are disabled as they are checked with the slow handler
     if (_this->can_switch_to_fast_mode())
     {
-        _this->instr_event.set_callback(&Exec::exec_instr);
+        _this->instr_event.set_callback(_this->quantum > 0 ? &Exec::exec_instr_quantum : &Exec::exec_instr);
     }
 
     _this->insn_exec_profiling();
 
+    if (unlikely(_this->iss.timing.profiler_insns && --_this->iss.timing.profiler_countdown <= 0))
+    {
+        _this->iss.timing.profiler->insn_sample(_this->current_insn);
+    }
+
     if (!_this->skip_irq_check)
     {
         _this->iss.irq.check();
@@ -293,8 +585,21 @@ void Exec::exec_instr_check_all(vp::Block *__this, vp::ClockEvent *event)
 
     iss_reg_t pc = iss->exec.current_insn;
 
+    // Triggers are checked before the instruction, which is then executed in timed mode
+    if (unlikely(_this->fast_forward))
+    {
+        if (!vp::FastForward::is_active())
+        {
+            _this->fast_forward_exit();
+        }
+        else if (pc == _this->fast_forward_pc)
+        {
+            _this->fast_forward_trigger("pc reached");
+        }
+    }
+
 #if defined(CONFIG_GVSOC_ISS_TIMED)
-    if (iss->prefetcher.fetch(pc))
+    if (_this->fast_forward || iss->prefetcher.fetch(pc))
 #endif
     {
         iss_reg_t index;
@@ -303,6 +608,11 @@ void Exec::exec_instr_check_all(vp::Block *__this, vp::ClockEvent *event)
 
         _this->current_insn = _this->insn_exec(insn, pc);
 
+        if (unlikely(_this->fast_forward_insns > 0) && --_this->fast_forward_insns == 0)
+        {
+            _this->fast_forward_trigger("instruction count reached");
+        }
+
         _this->iss.timing.insn_account();
 
         _this->insn_exec_power(insn);
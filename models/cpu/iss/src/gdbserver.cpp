@@ -239,6 +239,9 @@ void Gdbserver::breakpoint_stub_insert(iss_insn_t *insn, iss_reg_t pc)
 {
     if (insn->breakpoints.size() == 0)
     {
+        // Translated blocks have a copy of the handler
+        this->iss.insn_cache.block_flush();
+
         insn->breakpoint_saved_handler = insn->handler;
         insn->breakpoint_saved_fast_handler = insn->fast_handler;
         insn->handler = breakpoint_check_exec;
@@ -256,6 +259,8 @@ void Gdbserver::breakpoint_stub_remove(iss_insn_t *insn, iss_reg_t pc)
 
     if (insn->breakpoints.size() == 0)
     {
+        this->iss.insn_cache.block_flush();
+
         insn->handler = insn->breakpoint_saved_handler;
         insn->fast_handler = insn->breakpoint_saved_fast_handler;
     }
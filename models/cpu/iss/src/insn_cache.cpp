@@ -21,15 +21,45 @@
 
 #include "cpu/iss/include/iss.hpp"
 #include <string.h>
+#include <algorithm>
 
 InsnCache::InsnCache(Iss &iss)
+#if defined(CONFIG_GVSOC_ISS_JIT)
+    : jit(iss), iss(iss)
+#else
     : iss(iss)
+#endif
 {
 }
 
 void InsnCache::build()
 {
     this->current_insn_page_base = -1;
+    this->block_recording_flushed = false;
+
+    // Size the top level of the page table so that it covers the physical address range where
+    // code is expected, usually given by the platform memory map
+    int addr_bits = this->iss.top.get_js_config()->get_child_int("insn_cache_addr_bits");
+    if (addr_bits == 0)
+    {
+        addr_bits = 32;
+    }
+    addr_bits = std::min(addr_bits, ISS_REG_WIDTH);
+    int top_bits = std::max(0, addr_bits - INSN_PAGE_BITS - 2 * INSN_TABLE_LEVEL_BITS);
+    top_bits = std::min(top_bits, INSN_TABLE_TOP_MAX_BITS);
+
+    this->page_table_size = 1 << top_bits;
+    this->page_table_limit = (iss_reg_t)this->page_table_size << (2 * INSN_TABLE_LEVEL_BITS);
+    this->page_table = new InsnPageTableNode *[this->page_table_size]();
+
+    for (int i=0; i<INSN_RECENT_PAGES; i++)
+    {
+        this->recent_pages[i].vpage = -1;
+    }
+
+#if defined(CONFIG_GVSOC_ISS_JIT)
+    this->jit.build();
+#endif
 }
 
 bool InsnCache::insn_is_decoded(iss_insn_t *insn)
@@ -43,6 +73,33 @@ void InsnCache::flush()
 {
     this->iss.prefetcher.flush();
 
+    for (int i=0; i<this->page_table_size; i++)
+    {
+        InsnPageTableNode *node = this->page_table[i];
+        if (node == NULL)
+        {
+            continue;
+        }
+
+        for (int j=0; j<INSN_TABLE_LEVEL_SIZE; j++)
+        {
+            InsnPageTableLeaf *leaf = node->leaves[j];
+            if (leaf == NULL)
+            {
+                continue;
+            }
+
+            for (int k=0; k<INSN_TABLE_LEVEL_SIZE; k++)
+            {
+                delete leaf->pages[k];
+            }
+            delete leaf;
+        }
+
+        delete node;
+        this->page_table[i] = NULL;
+    }
+
     for (auto page: this->pages)
     {
         delete page.second;
@@ -66,9 +123,19 @@ void InsnCache::flush()
 void InsnCache::mode_flush()
 {
     this->current_insn_page_base = -1;
+
+    for (int i=0; i<INSN_RECENT_PAGES; i++)
+    {
+        this->recent_pages[i].vpage = -1;
+    }
+
+    // Blocks are indexed by virtual address, they must be dropped as soon as the translation
+    // may change
+    this->block_flush();
 }
 
 
+
 void Decode::flush_cache_sync(vp::Block *__this, bool active)
 {
     Decode *_this = (Decode *)__this;
@@ -82,7 +149,8 @@ void Decode::flush_cache_sync(vp::Block *__this, bool active)
 InsnPage *InsnCache::page_get(iss_reg_t paddr)
 {
     iss_reg_t index = paddr >> INSN_PAGE_BITS;
-    InsnPage *page = this->pages[index];
+    InsnPage **entry = this->page_entry_get(index);
+    InsnPage *page = *entry;
     if (page != NULL)
     {
         return page;
@@ -90,7 +158,7 @@ InsnPage *InsnCache::page_get(iss_reg_t paddr)
 
     page = new InsnPage;
 
-    this->pages[index] = page;
+    *entry = page;
 
     iss_reg_t addr = index << INSN_PAGE_BITS;
     for (int i=0; i<INSN_PAGE_SIZE; i++)
@@ -104,21 +172,155 @@ InsnPage *InsnCache::page_get(iss_reg_t paddr)
 
 
 
+InsnPage **InsnCache::page_entry_get(iss_reg_t index)
+{
+    if (unlikely(index >= this->page_table_limit))
+    {
+        return &this->pages[index];
+    }
+
+    InsnPageTableNode *&node = this->page_table[index >> (2 * INSN_TABLE_LEVEL_BITS)];
+    if (node == NULL)
+    {
+        node = new InsnPageTableNode();
+    }
+
+    InsnPageTableLeaf *&leaf = node->leaves[(index >> INSN_TABLE_LEVEL_BITS) & INSN_TABLE_LEVEL_MASK];
+    if (leaf == NULL)
+    {
+        leaf = new InsnPageTableLeaf();
+    }
+
+    return &leaf->pages[index & INSN_TABLE_LEVEL_MASK];
+}
+
+
+
 iss_insn_t *InsnCache::get_insn_from_cache(iss_reg_t vaddr, iss_reg_t &index)
 {
-    iss_reg_t paddr;
+    iss_reg_t vpage = vaddr >> INSN_PAGE_BITS;
+    InsnRecentPage *recent = &this->recent_pages[vpage & (INSN_RECENT_PAGES - 1)];
 
-#ifdef CONFIG_GVSOC_ISS_MMU
-    if (this->iss.mmu.insn_virt_to_phys(vaddr, paddr))
+    // Recent pages are dropped on mode flush, so a hit is still valid for the current
+    // translation
+    if (likely(recent->vpage == vpage))
     {
-        return NULL;
+        this->current_insn_page = recent->page;
     }
+    else
+    {
+        iss_reg_t paddr;
+
+#ifdef CONFIG_GVSOC_ISS_MMU
+        if (this->iss.mmu.insn_virt_to_phys(vaddr, paddr))
+        {
+            return NULL;
+        }
 #else
-    paddr = vaddr;
+        paddr = vaddr;
 #endif
 
-    this->current_insn_page = this->page_get(paddr);
-    this->current_insn_page_base = (vaddr >> INSN_PAGE_BITS) << INSN_PAGE_BITS;
+        this->current_insn_page = this->page_get(paddr);
+        recent->vpage = vpage;
+        recent->page = this->current_insn_page;
+    }
+
+    this->current_insn_page_base = vpage << INSN_PAGE_BITS;
 
     return this->get_insn(vaddr, index);
-}
\ No newline at end of file
+}
+
+
+
+void InsnCache::block_flush()
+{
+    this->block_recording_flushed = true;
+
+    if (this->blocks.size() == 0)
+    {
+        return;
+    }
+
+    for (auto block: this->blocks)
+    {
+        this->free_blocks.push_back(block.second);
+    }
+
+    this->blocks.clear();
+
+#if defined(CONFIG_GVSOC_ISS_JIT)
+    // Native code is referenced by the blocks, it can be dropped with them
+    this->jit.flush();
+#endif
+
+    // Make sure the block being executed, if any, is left after the current instruction
+    this->iss.exec.quantum_yield = true;
+}
+
+
+
+InsnBlock *InsnCache::block_lookup(iss_reg_t pc, InsnBlock *prev)
+{
+    auto it = this->blocks.find(pc);
+    if (it == this->blocks.end())
+    {
+        return NULL;
+    }
+
+    InsnBlock *block = it->second;
+
+    // Chain it to the previous block so that the next transition does not need the lookup
+    if (prev != NULL)
+    {
+        prev->next[pc == prev->pcs[prev->nb_insns] ? 0 : 1] = block;
+    }
+
+    return block;
+}
+
+
+
+InsnBlock *InsnCache::block_new(iss_reg_t pc)
+{
+    InsnBlock *block;
+
+    if (this->free_blocks.size() > 0)
+    {
+        block = this->free_blocks.back();
+        this->free_blocks.pop_back();
+    }
+    else
+    {
+        block = new InsnBlock;
+    }
+
+    block->pc = pc;
+    block->nb_insns = 0;
+    block->pcs[0] = pc;
+    block->next[0] = NULL;
+    block->next[1] = NULL;
+#if defined(CONFIG_GVSOC_ISS_JIT)
+    block->nb_execs = 0;
+    memset(block->jit_code, 0, sizeof(block->jit_code));
+#endif
+    this->block_recording_flushed = false;
+
+    return block;
+}
+
+
+
+InsnBlock *InsnCache::block_commit(InsnBlock *block)
+{
+    // Recording may have been interrupted before the first instruction could be recorded,
+    // or by a flush, in which case the block must not be used
+    if (block->nb_insns == 0 || this->block_recording_flushed)
+    {
+        this->free_blocks.push_back(block);
+        return NULL;
+    }
+
+    this->blocks[block->pc] = block;
+
+    return block;
+}
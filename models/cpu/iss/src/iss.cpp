@@ -21,6 +21,7 @@
 
 #include "cpu/iss/include/iss.hpp"
 #include <string.h>
+#include <vp/checkpoint.hpp>
 
 
 void IssWrapper::start()
@@ -62,6 +63,121 @@ void IssWrapper::reset(bool active)
 #endif
 }
 
+void IssWrapper::checkpoint_save(vp::CheckpointWriter &writer)
+{
+    // The state of an instruction being executed in several steps, like a misaligned access or
+    // a page-table walk, is spread over the pending events and requests and cannot be saved
+    if (this->iss.exec.insn_on_hold || this->iss.exec.irq_locked)
+    {
+        writer.set_error("core " + this->get_path() + " is in the middle of an instruction");
+        return;
+    }
+
+    // Registers, signals and wfi, busy, stalled, etc, declared as old-style registers
+    vp::Component::checkpoint_save(writer);
+
+    writer.write(this->iss.regfile.regs, sizeof(this->iss.regfile.regs));
+#if !defined(ISS_SINGLE_REGFILE)
+    writer.write(this->iss.regfile.fregs, sizeof(this->iss.regfile.fregs));
+#endif
+
+    this->iss.csr.checkpoint_save(writer);
+
+    writer.write_i64(this->iss.core.mode_get());
+    writer.write_i64(this->iss.core.float_mode);
+    writer.write_u64(this->iss.core.load_reserve_addr_get());
+
+    Exec &exec = this->iss.exec;
+    writer.write_u64(exec.current_insn);
+    writer.write_u64(exec.stall_insn);
+    writer.write_i64(exec.stall_reg);
+    writer.write_i64(exec.stall_cycles);
+    writer.write_i64(exec.debug_mode);
+    writer.write_u64(exec.elw_insn);
+    writer.write_i64(exec.elw_interrupted);
+#if defined(CONFIG_GVSOC_ISS_RI5KY)
+    writer.write(exec.hwloop_start_insn, sizeof(exec.hwloop_start_insn));
+    writer.write(exec.hwloop_end_insn, sizeof(exec.hwloop_end_insn));
+    writer.write_u64(exec.hwloop_next_insn);
+#endif
+
+#if defined(CONFIG_GVSOC_ISS_INC_SPATZ)
+    // Vector configuration, vl and vtype are CSRs and are saved with them
+    Spatz &spatz = this->iss.spatz;
+    writer.write(spatz.vregfile.vregs, sizeof(spatz.vregfile.vregs));
+    writer.write_i64(spatz.SEW_t);
+    writer.write(&spatz.LMUL_t, sizeof(spatz.LMUL_t));
+    writer.write_i64(spatz.VMA);
+    writer.write_i64(spatz.VTA);
+    writer.write_i64(this->iss.waiting_barrier);
+#endif
+}
+
+
+
+void IssWrapper::checkpoint_restore(vp::CheckpointReader &reader)
+{
+    vp::Component::checkpoint_restore(reader);
+
+    reader.read(this->iss.regfile.regs, sizeof(this->iss.regfile.regs));
+#if !defined(ISS_SINGLE_REGFILE)
+    reader.read(this->iss.regfile.fregs, sizeof(this->iss.regfile.fregs));
+#endif
+
+    this->iss.csr.checkpoint_restore(reader);
+
+    int mode = reader.read_i64();
+    this->iss.core.float_mode = reader.read_i64();
+    this->iss.core.load_reserve_addr_set(reader.read_u64());
+
+    Exec &exec = this->iss.exec;
+    exec.current_insn = reader.read_u64();
+    exec.stall_insn = reader.read_u64();
+    exec.stall_reg = reader.read_i64();
+    exec.stall_cycles = reader.read_i64();
+    exec.debug_mode = reader.read_i64();
+    exec.elw_insn = reader.read_u64();
+    exec.elw_interrupted = reader.read_i64();
+#if defined(CONFIG_GVSOC_ISS_RI5KY)
+    reader.read(exec.hwloop_start_insn, sizeof(exec.hwloop_start_insn));
+    reader.read(exec.hwloop_end_insn, sizeof(exec.hwloop_end_insn));
+    exec.hwloop_next_insn = reader.read_u64();
+#endif
+
+#if defined(CONFIG_GVSOC_ISS_INC_SPATZ)
+    Spatz &spatz = this->iss.spatz;
+    reader.read(spatz.vregfile.vregs, sizeof(spatz.vregfile.vregs));
+    spatz.SEW_t = reader.read_i64();
+    reader.read(&spatz.LMUL_t, sizeof(spatz.LMUL_t));
+    spatz.VMA = reader.read_i64();
+    spatz.VTA = reader.read_i64();
+    this->iss.waiting_barrier = reader.read_i64();
+#endif
+
+    if (!reader.is_ok())
+    {
+        return;
+    }
+
+#if ISS_REG_WIDTH == 64
+    // The MMU keeps a decoded copy of satp, rewrite it from machine mode so that it is rebuilt
+    // without any permission check
+    this->iss.core.mode_set(PRIV_M);
+    iss_reg_t satp = this->iss.csr.satp.value;
+    this->iss.csr.satp.access(true, satp);
+#endif
+    this->iss.core.mode_set(mode);
+
+    // Everything which was decoded or translated from the previous state is dropped, and the
+    // instruction handler, which is not part of the checkpoint, is reselected
+    this->iss.mmu.flush_all();
+    this->iss.insn_cache.flush();
+    this->iss.prefetcher.flush();
+    exec.switch_to_full_mode();
+}
+
+
+
 IssWrapper::IssWrapper(vp::ComponentConf &config)
     : vp::Component(config), iss(*this)
 {
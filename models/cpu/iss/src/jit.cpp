@@ -0,0 +1,541 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "cpu/iss/include/iss.hpp"
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+
+// Size of the arena where native code is generated
+#define JIT_ARENA_SIZE (16 << 20)
+// Maximum number of bytes generated for one instruction
+#define JIT_INSN_MAX_SIZE 32
+
+// x86-64 opcodes working on eax/rax and a register of the register file, which is accessed
+// through rdi
+#define X86_OP_ADD_MEM  0x03
+#define X86_OP_SUB_MEM  0x2B
+#define X86_OP_AND_MEM  0x23
+#define X86_OP_OR_MEM   0x0B
+#define X86_OP_XOR_MEM  0x33
+#define X86_OP_CMP_MEM  0x3B
+#define X86_OP_LOAD     0x8B
+#define X86_OP_STORE    0x89
+#define X86_OP_ADD_IMM  0x05
+#define X86_OP_AND_IMM  0x25
+#define X86_OP_OR_IMM   0x0D
+#define X86_OP_XOR_IMM  0x35
+#define X86_OP_CMP_IMM  0x3D
+#define X86_MODRM_SHL   0xE0
+#define X86_MODRM_SHR   0xE8
+#define X86_MODRM_SAR   0xF8
+#define X86_SETL        0x9C
+#define X86_SETB        0x92
+#define X86_RAX 0
+#define X86_RCX 1
+
+typedef enum
+{
+    JIT_OP_NONE,
+    JIT_OP_LUI,
+    JIT_OP_ADDI,
+    JIT_OP_SLTI,
+    JIT_OP_SLTIU,
+    JIT_OP_XORI,
+    JIT_OP_ORI,
+    JIT_OP_ANDI,
+    JIT_OP_SLLI,
+    JIT_OP_SRLI,
+    JIT_OP_SRAI,
+    JIT_OP_ADD,
+    JIT_OP_SUB,
+    JIT_OP_SLL,
+    JIT_OP_SLT,
+    JIT_OP_SLTU,
+    JIT_OP_XOR,
+    JIT_OP_SRL,
+    JIT_OP_SRA,
+    JIT_OP_OR,
+    JIT_OP_AND,
+    JIT_OP_MUL,
+} jit_op_e;
+
+// Mask of the fields identifying immediate shifts, whose amount has one more bit on 64 bits cores
+#if ISS_REG_WIDTH == 64
+#define JIT_SHIFT_MASK 0xfc00707f
+#else
+#define JIT_SHIFT_MASK 0xfe00707f
+#endif
+
+// Instructions which can be compiled, identified by their encoding. Compressed instructions
+// have the same arguments as the instruction they expand to, and use the same handlers.
+// The first matching entry is used, so that the special encodings which are decoded as other
+// instructions (c.nop, c.jr, c.jalr, c.ebreak, c.addi16sp) are caught before the generic ones.
+static const struct
+{
+    int size;
+    iss_opcode_t mask;
+    iss_opcode_t match;
+    jit_op_e op;
+} jit_ops[] = {
+    {4, 0x0000007f,     0x00000037, JIT_OP_LUI},    // lui
+    {4, 0x0000707f,     0x00000013, JIT_OP_ADDI},   // addi
+    {4, 0x0000707f,     0x00002013, JIT_OP_SLTI},   // slti
+    {4, 0x0000707f,     0x00003013, JIT_OP_SLTIU},  // sltiu
+    {4, 0x0000707f,     0x00004013, JIT_OP_XORI},   // xori
+    {4, 0x0000707f,     0x00006013, JIT_OP_ORI},    // ori
+    {4, 0x0000707f,     0x00007013, JIT_OP_ANDI},   // andi
+    {4, JIT_SHIFT_MASK, 0x00001013, JIT_OP_SLLI},   // slli
+    {4, JIT_SHIFT_MASK, 0x00005013, JIT_OP_SRLI},   // srli
+    {4, JIT_SHIFT_MASK, 0x40005013, JIT_OP_SRAI},   // srai
+    {4, 0xfe00707f,     0x00000033, JIT_OP_ADD},    // add
+    {4, 0xfe00707f,     0x40000033, JIT_OP_SUB},    // sub
+    {4, 0xfe00707f,     0x00001033, JIT_OP_SLL},    // sll
+    {4, 0xfe00707f,     0x00002033, JIT_OP_SLT},    // slt
+    {4, 0xfe00707f,     0x00003033, JIT_OP_SLTU},   // sltu
+    {4, 0xfe00707f,     0x00004033, JIT_OP_XOR},    // xor
+    {4, 0xfe00707f,     0x00005033, JIT_OP_SRL},    // srl
+    {4, 0xfe00707f,     0x40005033, JIT_OP_SRA},    // sra
+    {4, 0xfe00707f,     0x00006033, JIT_OP_OR},     // or
+    {4, 0xfe00707f,     0x00007033, JIT_OP_AND},    // and
+    {4, 0xfe00707f,     0x02000033, JIT_OP_MUL},    // mul
+    {2, 0xffff,         0x0001,     JIT_OP_NONE},   // c.nop
+    {2, 0xe003,         0x0000,     JIT_OP_ADDI},   // c.addi4spn
+    {2, 0xe003,         0x0001,     JIT_OP_ADDI},   // c.addi
+    {2, 0xe003,         0x4001,     JIT_OP_ADDI},   // c.li
+    {2, 0xef83,         0x6101,     JIT_OP_ADDI},   // c.addi16sp
+    {2, 0xe003,         0x6001,     JIT_OP_LUI},    // c.lui
+    {2, 0xec03,         0x8001,     JIT_OP_SRLI},   // c.srli
+    {2, 0xec03,         0x8401,     JIT_OP_SRAI},   // c.srai
+    {2, 0xec03,         0x8801,     JIT_OP_ANDI},   // c.andi
+    {2, 0xfc63,         0x8c01,     JIT_OP_SUB},    // c.sub
+    {2, 0xfc63,         0x8c21,     JIT_OP_XOR},    // c.xor
+    {2, 0xfc63,         0x8c41,     JIT_OP_OR},     // c.or
+    {2, 0xfc63,         0x8c61,     JIT_OP_AND},    // c.and
+    {2, 0xe003,         0x0002,     JIT_OP_SLLI},   // c.slli
+    {2, 0xf07f,         0x8002,     JIT_OP_NONE},   // c.jr
+    {2, 0xf003,         0x8002,     JIT_OP_ADD},    // c.mv
+    {2, 0xf07f,         0x9002,     JIT_OP_NONE},   // c.jalr, c.ebreak
+    {2, 0xf003,         0x9002,     JIT_OP_ADD},    // c.add
+};
+
+static jit_op_e jit_op_get(iss_insn_t *insn)
+{
+    // Only successfully decoded instructions have a decoder item, illegal ones must not be
+    // compiled even if their encoding matches
+    if (insn->decoder_item == NULL)
+    {
+        return JIT_OP_NONE;
+    }
+
+    for (unsigned int i=0; i<sizeof(jit_ops)/sizeof(jit_ops[0]); i++)
+    {
+        if (insn->size == jit_ops[i].size && (insn->opcode & jit_ops[i].mask) == jit_ops[i].match)
+        {
+            return jit_ops[i].op;
+        }
+    }
+
+    return JIT_OP_NONE;
+}
+
+
+
+Jit::Jit(Iss &iss)
+    : iss(iss)
+{
+}
+
+void Jit::build()
+{
+    this->iss.top.traces.new_trace("jit", &this->trace, vp::DEBUG);
+
+    this->enabled = this->iss.top.get_js_config()->get_child_bool("jit");
+    this->check = this->iss.top.get_js_config()->get_child_bool("jit_check");
+    this->threshold = this->iss.top.get_js_config()->get_child_int("jit_threshold");
+    this->arena = NULL;
+    this->arena_size = 0;
+    this->arena_pos = 0;
+    this->arena_full = false;
+    this->nb_compiled_insns = 0;
+
+#if defined(__x86_64__)
+    if (this->enabled)
+    {
+        // The arena is only made executable once code is emitted, see arena_protect
+        void *arena = mmap(NULL, JIT_ARENA_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (arena == MAP_FAILED)
+        {
+            this->trace.force_warning("Failed to allocate JIT arena, disabling JIT\n");
+        }
+        else
+        {
+            this->arena = (uint8_t *)arena;
+            this->arena_size = JIT_ARENA_SIZE;
+        }
+    }
+#else
+    if (this->enabled)
+    {
+        this->trace.force_warning("JIT is only supported on x86-64 hosts, disabling JIT\n");
+    }
+#endif
+}
+
+
+
+void Jit::arena_protect(size_t start, size_t end, int prot)
+{
+    size_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+    size_t first = start & ~page_mask;
+
+    if (mprotect(&this->arena[first], end - first, prot))
+    {
+        this->trace.fatal("Failed to change JIT arena protection (error: %s)\n", strerror(errno));
+    }
+}
+
+
+
+void Jit::flush()
+{
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "Flushing native code (size: %ld)\n", this->arena_pos);
+    this->arena_pos = 0;
+    this->arena_full = false;
+}
+
+
+
+void Jit::block_compile(InsnBlock *block)
+{
+    if (this->arena_full)
+    {
+        return;
+    }
+
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "Compiling block (pc: 0x%lx, nb_insns: %d)\n",
+        block->pc, block->nb_insns);
+
+    // Native code is never writable and executable at the same time. The part of the arena
+    // where this block may be emitted is writable only while it is compiled.
+    size_t start = this->arena_pos;
+    size_t end = std::min(this->arena_size,
+        start + block->nb_insns * (JIT_INSN_MAX_SIZE + 1));
+    this->arena_protect(start, end, PROT_READ | PROT_WRITE);
+
+    int index = 0;
+    while (index < block->nb_insns)
+    {
+        // Look for the next run of instructions which can all be compiled. A single instruction
+        // is not worth it, the native call would cost as much as the handler.
+        int first = index;
+        while (index < block->nb_insns && jit_op_get(block->insns[index]) != JIT_OP_NONE)
+        {
+            index++;
+        }
+        int last = index;
+
+        if (last - first >= 2)
+        {
+            if (this->arena_pos + (last - first) * JIT_INSN_MAX_SIZE + 1 > this->arena_size)
+            {
+                // Stop compiling until blocks are flushed, since native code is only dropped
+                // with them
+                this->trace.msg(vp::Trace::LEVEL_DEBUG, "JIT arena is full\n");
+                this->arena_full = true;
+                break;
+            }
+
+            uint8_t *code = &this->arena[this->arena_pos];
+
+            for (int i=first; i<last; i++)
+            {
+                this->insn_compile(block->insns[i]);
+            }
+
+            // ret
+            this->emit8(0xC3);
+
+            block->jit_code[first] = (iss_jit_code_t)code;
+            block->jit_end[first] = last;
+            this->nb_compiled_insns += last - first;
+        }
+
+        // Skip the instruction which cannot be compiled
+        index++;
+    }
+
+    this->arena_protect(start, end, PROT_READ | PROT_EXEC);
+}
+
+
+
+int Jit::block_exec_check(InsnBlock *block, int index)
+{
+    iss_reg_t regs[ISS_NB_REGS + 1];
+    int end = block->jit_end[index];
+
+    memcpy(regs, this->iss.regfile.regs, sizeof(regs));
+
+    block->jit_code[index](regs);
+
+    // The interpreter is the reference and executes the instructions for real
+    for (int i=index; i<end; i++)
+    {
+        block->handlers[i](&this->iss, block->insns[i], block->pcs[i]);
+    }
+
+    for (int i=0; i<ISS_NB_REGS; i++)
+    {
+        if (regs[i] != this->iss.regfile.regs[i])
+        {
+            this->trace.fatal("JIT mismatch (pc: 0x%lx, reg: %d, native: 0x%lx, interpreter: 0x%lx)\n",
+                block->pcs[index], i, regs[i], this->iss.regfile.regs[i]);
+        }
+    }
+
+    return end;
+}
+
+
+
+inline void Jit::emit8(uint8_t value)
+{
+    this->arena[this->arena_pos++] = value;
+}
+
+inline void Jit::emit32(uint32_t value)
+{
+    memcpy(&this->arena[this->arena_pos], &value, 4);
+    this->arena_pos += 4;
+}
+
+inline void Jit::emit_rex()
+{
+    // Operations are done on the full register width, which needs REX.W on 64 bits cores
+    if (sizeof(iss_reg_t) == 8)
+    {
+        this->emit8(0x48);
+    }
+}
+
+void Jit::emit_reg_op(uint8_t opcode, int modrm_reg, int reg)
+{
+    // <op> eax/ecx, [rdi + reg offset]
+    this->emit_rex();
+    this->emit8(opcode);
+    this->emit8(0x87 | (modrm_reg << 3));
+    this->emit32(reg * sizeof(iss_reg_t));
+}
+
+void Jit::emit_imm_op(uint8_t opcode, int64_t imm)
+{
+    // <op> eax, imm32, immediate is sign-extended on 64 bits
+    this->emit_rex();
+    this->emit8(opcode);
+    this->emit32((uint32_t)(int32_t)imm);
+}
+
+void Jit::emit_set_imm(int64_t imm)
+{
+    if (sizeof(iss_reg_t) == 8)
+    {
+        // movabs rax, imm64
+        this->emit8(0x48);
+        this->emit8(0xB8);
+        this->emit32((uint32_t)imm);
+        this->emit32((uint32_t)((uint64_t)imm >> 32));
+    }
+    else
+    {
+        // mov eax, imm32
+        this->emit8(0xB8);
+        this->emit32((uint32_t)imm);
+    }
+}
+
+void Jit::emit_shift_imm(int modrm, int amount)
+{
+    this->emit_rex();
+    this->emit8(0xC1);
+    this->emit8(modrm);
+    this->emit8(amount & (ISS_REG_WIDTH - 1));
+}
+
+void Jit::emit_shift_reg(int modrm, int reg)
+{
+    // The shift amount is masked by the host the same way as the interpreter does
+    this->emit_reg_op(X86_OP_LOAD, X86_RCX, reg);
+    this->emit_rex();
+    this->emit8(0xD3);
+    this->emit8(modrm);
+}
+
+void Jit::emit_compare(int reg, bool is_imm, int64_t value, uint8_t setcc)
+{
+    // xor ecx, ecx
+    this->emit8(0x31);
+    this->emit8(0xC9);
+    this->emit_reg_op(X86_OP_LOAD, X86_RAX, reg);
+    if (is_imm)
+    {
+        this->emit_imm_op(X86_OP_CMP_IMM, value);
+    }
+    else
+    {
+        this->emit_reg_op(X86_OP_CMP_MEM, X86_RAX, value);
+    }
+    // set<cc> cl
+    this->emit8(0x0F);
+    this->emit8(setcc);
+    this->emit8(0xC1);
+}
+
+
+
+bool Jit::insn_compile(iss_insn_t *insn)
+{
+    int rd = insn->out_regs[0];
+    int rs1 = insn->in_regs[0];
+    int rs2 = insn->in_regs[1];
+    int result = X86_RAX;
+
+    switch (jit_op_get(insn))
+    {
+        case JIT_OP_LUI:
+            this->emit_set_imm(insn->uim[0]);
+            break;
+
+        case JIT_OP_ADDI:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_imm_op(X86_OP_ADD_IMM, insn->sim[0]);
+            break;
+
+        case JIT_OP_XORI:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_imm_op(X86_OP_XOR_IMM, insn->sim[0]);
+            break;
+
+        case JIT_OP_ORI:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_imm_op(X86_OP_OR_IMM, insn->sim[0]);
+            break;
+
+        case JIT_OP_ANDI:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_imm_op(X86_OP_AND_IMM, insn->sim[0]);
+            break;
+
+        case JIT_OP_SLTI:
+            this->emit_compare(rs1, true, insn->sim[0], X86_SETL);
+            result = X86_RCX;
+            break;
+
+        case JIT_OP_SLTIU:
+            this->emit_compare(rs1, true, insn->sim[0], X86_SETB);
+            result = X86_RCX;
+            break;
+
+        case JIT_OP_SLLI:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_shift_imm(X86_MODRM_SHL, insn->uim[0]);
+            break;
+
+        case JIT_OP_SRLI:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_shift_imm(X86_MODRM_SHR, insn->uim[0]);
+            break;
+
+        case JIT_OP_SRAI:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_shift_imm(X86_MODRM_SAR, insn->uim[0]);
+            break;
+
+        case JIT_OP_ADD:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_reg_op(X86_OP_ADD_MEM, X86_RAX, rs2);
+            break;
+
+        case JIT_OP_SUB:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_reg_op(X86_OP_SUB_MEM, X86_RAX, rs2);
+            break;
+
+        case JIT_OP_XOR:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_reg_op(X86_OP_XOR_MEM, X86_RAX, rs2);
+            break;
+
+        case JIT_OP_OR:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_reg_op(X86_OP_OR_MEM, X86_RAX, rs2);
+            break;
+
+        case JIT_OP_AND:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_reg_op(X86_OP_AND_MEM, X86_RAX, rs2);
+            break;
+
+        case JIT_OP_SLL:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_shift_reg(X86_MODRM_SHL, rs2);
+            break;
+
+        case JIT_OP_SRL:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_shift_reg(X86_MODRM_SHR, rs2);
+            break;
+
+        case JIT_OP_SRA:
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_shift_reg(X86_MODRM_SAR, rs2);
+            break;
+
+        case JIT_OP_SLT:
+            this->emit_compare(rs1, false, rs2, X86_SETL);
+            result = X86_RCX;
+            break;
+
+        case JIT_OP_SLTU:
+            this->emit_compare(rs1, false, rs2, X86_SETB);
+            result = X86_RCX;
+            break;
+
+        case JIT_OP_MUL:
+            // imul eax, [rdi + rs2 offset], low part is the same for signed and unsigned
+            this->emit_reg_op(X86_OP_LOAD, X86_RAX, rs1);
+            this->emit_rex();
+            this->emit8(0x0F);
+            this->emit8(0xAF);
+            this->emit8(0x87);
+            this->emit32(rs2 * sizeof(iss_reg_t));
+            break;
+
+        default:
+            return false;
+    }
+
+    // Writes to x0 go to the dummy register, as for the interpreter
+    this->emit_reg_op(X86_OP_STORE, result, rd);
+
+    return true;
+}
@@ -134,9 +134,132 @@ void Lsu::data_response(vp::Block *__this, vp::IoReq *req)
     }
 }
 
+void Lsu::dmi_flush()
+{
+    this->dmi_generation = vp::IoDmi::get_generation();
+    this->dmi_nb_ranges = 0;
+    this->dmi_next_range = 0;
+
+    for (int i=0; i<LSU_DMI_NB_DENIED; i++)
+    {
+        this->dmi_denied_pages[i] = -1;
+    }
+}
+
+LsuDmiRange *Lsu::dmi_range_get(iss_addr_t addr, bool is_write)
+{
+    uint64_t page = addr >> LSU_DMI_DENIED_PAGE_BITS;
+    uint64_t *denied_page = &this->dmi_denied_pages[page & (LSU_DMI_NB_DENIED - 1)];
+    if (*denied_page == page)
+    {
+        return NULL;
+    }
+
+    vp::IoDmi dmi;
+    dmi.init();
+    if (!this->data.get_dmi(addr, is_write, &dmi) || dmi.size == 0)
+    {
+        *denied_page = page;
+        return NULL;
+    }
+
+    // Keep only the part which can be addressed by the core
+    uint64_t last = dmi.base + dmi.size - 1;
+    if (last < dmi.base || last > (iss_addr_t)-1)
+    {
+        last = (iss_addr_t)-1;
+    }
+
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "Got direct access (base: 0x%lx, last: 0x%lx, latency: %ld)\n",
+        dmi.base, last, dmi.latency);
+
+    LsuDmiRange *range = &this->dmi_ranges[this->dmi_next_range];
+    this->dmi_next_range = (this->dmi_next_range + 1) % LSU_DMI_NB_RANGES;
+    if (this->dmi_nb_ranges < LSU_DMI_NB_RANGES)
+    {
+        this->dmi_nb_ranges++;
+    }
+
+    range->base = dmi.base;
+    range->last = last;
+    range->data = dmi.data;
+    range->latency = dmi.latency;
+    range->read_allowed = dmi.read_allowed;
+    range->write_allowed = dmi.write_allowed;
+
+    return range;
+}
+
+bool Lsu::data_req_dmi(iss_addr_t addr, uint8_t *data_ptr, uint8_t *memcheck_data, int size, bool is_write, int64_t &latency)
+{
+    // Grants are all dropped as soon as one of them is revoked
+    if (unlikely(this->dmi_generation != vp::IoDmi::get_generation()))
+    {
+        this->dmi_flush();
+    }
+
+    iss_addr_t last = addr + size - 1;
+    LsuDmiRange *range = NULL;
+    for (int i=0; i<this->dmi_nb_ranges; i++)
+    {
+        LsuDmiRange *current = &this->dmi_ranges[i];
+        if (addr >= current->base && last <= current->last && last >= addr)
+        {
+            range = current;
+            break;
+        }
+    }
+
+    if (range == NULL)
+    {
+        range = this->dmi_range_get(addr, is_write);
+        // The grant may not cover the whole access, for example with interleaved memories
+        if (range == NULL || last > range->last || last < addr)
+        {
+            return false;
+        }
+    }
+
+    if (is_write ? !range->write_allowed : !range->read_allowed)
+    {
+        return false;
+    }
+
+    uint8_t *host_data = range->data + (addr - range->base);
+    if (is_write)
+    {
+        memcpy(host_data, data_ptr, size);
+    }
+    else
+    {
+        memcpy(data_ptr, host_data, size);
+#ifdef VP_MEMCHECK_ACTIVE
+        if (memcheck_data)
+        {
+            memset(memcheck_data, 0xFF, size);
+        }
+#endif
+    }
+
+    // Same timing as for requests
+#ifndef CONFIG_GVSOC_ISS_SNITCH
+    latency = range->latency + 1;
+#else
+    latency = is_write ? range->latency : range->latency + 1;
+#endif
+
+    return true;
+}
+
 int Lsu::data_req_aligned(iss_addr_t addr, uint8_t *data_ptr, uint8_t *memcheck_data, int size, bool is_write, int64_t &latency)
 {
-    this->trace.msg("Data request (addr: 0x%lx, size: 0x%x, is_write: %d)\n", addr, size, is_write);
+    vp_trace_msg(&this->trace, vp::Trace::LEVEL_DEBUG, "Data request (addr: 0x%lx, size: 0x%x, is_write: %d)\n", addr, size, is_write);
+
+    if (this->dmi_enabled && this->data_req_dmi(addr, data_ptr, memcheck_data, size, is_write, latency))
+    {
+        return 0;
+    }
+
     vp::IoReq *req = &this->io_req;
     req->init();
     req->set_addr(addr);
@@ -198,7 +321,7 @@ int Lsu::data_req_aligned(iss_addr_t addr, uint8_t *data_ptr, uint8_t *memcheck_
         return err;
     }
 
-    this->trace.msg(vp::Trace::LEVEL_TRACE, "Waiting for asynchronous response\n");
+    vp_trace_msg(&this->trace, vp::Trace::LEVEL_TRACE, "Waiting for asynchronous response\n");
     this->iss.exec.insn_stall();
     return err;
 }
@@ -249,6 +372,9 @@ void Lsu::build()
     this->memory_start = -1;
     this->memory_end = -1;
 
+    this->dmi_enabled = this->iss.top.get_js_config()->get_child_bool("dmi");
+    this->dmi_flush();
+
     if (this->iss.top.get_js_config()->get("memory_start") != NULL)
     {
         this->memory_start = this->iss.top.get_js_config()->get("memory_start")->get_int();
@@ -30,7 +30,7 @@
 
 static inline iss_reg_t get_field(iss_reg_t field, int bit, int width)
 {
-    return (field >> bit) & ((1 << width) - 1);
+    return (field >> bit) & ((((iss_reg_t)1) << width) - 1);
 }
 
 Mmu::Mmu(Iss &iss)
@@ -43,13 +43,41 @@ void Mmu::build()
     this->iss.top.traces.new_trace("mmu", &this->trace, vp::DEBUG);
 
     this->iss.csr.satp.register_callback(std::bind(&Mmu::satp_update, this, std::placeholders::_1, std::placeholders::_2));
+
+#ifdef CONFIG_GVSOC_ISS_MMU
+    this->iss.top.new_reg("tlb_hits", &this->tlb_hits, 0);
+    this->iss.top.new_reg("tlb_misses", &this->tlb_misses, 0);
+
+    js::Config *config = this->iss.top.get_js_config();
+    js::Config *nb_sets = config->get("tlb_sets");
+    js::Config *nb_ways = config->get("tlb_ways");
+    this->tlb_nb_sets = nb_sets ? nb_sets->get_int() : MMU_TLB_NB_SETS;
+    this->tlb_nb_ways = nb_ways ? nb_ways->get_int() : MMU_TLB_NB_WAYS;
+
+    // The set is selected with the low bits of the virtual page number
+    if (this->tlb_nb_sets <= 0 || (this->tlb_nb_sets & (this->tlb_nb_sets - 1)) != 0)
+    {
+        this->trace.force_warning("Number of TLB sets must be a power of 2, using default (nb_sets: %d)\n",
+            this->tlb_nb_sets);
+        this->tlb_nb_sets = MMU_TLB_NB_SETS;
+    }
+    if (this->tlb_nb_ways < 0)
+    {
+        this->tlb_nb_ways = 0;
+    }
+
+    this->tlb.resize(this->tlb_nb_sets * this->tlb_nb_ways);
+    this->tlb_next_way.resize(this->tlb_nb_sets);
+#endif
 }
 
 void Mmu::reset(bool active)
 {
     this->satp = 0;
+    this->asid = 0;
+    this->mode = MMU_MODE_OFF;
 
-    this->flush(0, 0);
+    this->flush_all();
 
 }
 
@@ -66,6 +94,9 @@ bool Mmu::satp_update(bool is_write, iss_reg_t &value)
 
     if (is_write)
     {
+        iss_reg_t old_asid = this->asid;
+        iss_reg_t old_mode = this->mode;
+        iss_reg_t old_pt_base = this->pt_base;
         iss_reg_t pt_base = get_field(value, 0, 44) << 12;
         iss_reg_t asid = get_field(value, 44, 16);
         iss_reg_t mode = get_field(value, 60, 4);
@@ -90,10 +121,27 @@ bool Mmu::satp_update(bool is_write, iss_reg_t &value)
 
         this->trace.msg(vp::Trace::LEVEL_DEBUG, "Updated SATP (base: 0x%x, asid: %d, mode: %d)\n",
             pt_base, asid, mode);
-    }
 
-    this->flush(0, 0);
-    this->iss.insn_cache.mode_flush();
+        // Entries of the other address spaces are kept in the TLB since they are tagged with
+        // their ASID. The direct-mapped arrays are not tagged and only contain the current
+        // address space.
+        // Software not using ASIDs may also switch the page-table without sfence.vma, so the
+        // entries of the ASID are dropped in this case.
+        if (mode != old_mode)
+        {
+            this->flush_all();
+        }
+        else if (asid == old_asid && pt_base != old_pt_base)
+        {
+            this->flush(0, asid, true, false);
+        }
+        else
+        {
+            this->tlb_l0_flush();
+        }
+
+        this->iss.insn_cache.mode_flush();
+    }
 
     return true;
 
@@ -116,15 +164,188 @@ void Mmu::handle_pte_stub(vp::Block *__this, vp::ClockEvent *event)
     _this->handle_pte();
 }
 
-void Mmu::flush(iss_addr_t address, iss_reg_t address_space)
+void Mmu::mode_update(int old_mode, int new_mode)
+{
+#ifdef CONFIG_GVSOC_ISS_MMU
+    // Machine mode fills the direct-mapped arrays with untranslated pages, which must not be
+    // seen by the other modes, and the other way around
+    if ((old_mode == PRIV_M) != (new_mode == PRIV_M))
+    {
+        this->tlb_l0_flush();
+    }
+#endif
+}
+
+void Mmu::tlb_l0_flush()
 {
-    // For now just flush everything
     for (int i=0; i<MMU_TLB_NB_ENTRIES; i++)
     {
         this->tlb_insn_tag[i] = -1;
         this->tlb_load_tag[i] = -1;
         this->tlb_store_tag[i] = -1;
     }
+    this->tlb_l0_superpages = false;
+}
+
+void Mmu::flush_all()
+{
+    this->tlb_l0_flush();
+
+    for (MmuTlbEntry &entry: this->tlb)
+    {
+        entry.valid = false;
+    }
+}
+
+void Mmu::flush(iss_addr_t address, iss_reg_t asid, bool all_addresses, bool all_asids)
+{
+#ifdef CONFIG_GVSOC_ISS_MMU
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "Flushing TLB (address: 0x%lx, asid: %ld, all_addresses: %d, "
+        "all_asids: %d, hits: %ld, misses: %ld)\n", address, asid, all_addresses, all_asids,
+        this->tlb_hits.get(), this->tlb_misses.get());
+
+    // Global entries are kept when flushing a single address space
+    for (MmuTlbEntry &entry: this->tlb)
+    {
+        if (entry.valid &&
+            (all_addresses || entry.vpn == address >> (MMU_PGSHIFT + entry.level * this->vpn_width)) &&
+            (all_asids || (!entry.global && entry.asid == asid)))
+        {
+            entry.valid = false;
+        }
+    }
+#endif
+
+    // The direct-mapped arrays only contain the current address space
+    if (!all_asids && asid != this->asid)
+    {
+        return;
+    }
+
+    if (all_addresses || this->tlb_l0_superpages)
+    {
+        this->tlb_l0_flush();
+    }
+    else
+    {
+        iss_addr_t tag = address >> MMU_PGSHIFT;
+        int index = tag & MMU_TLB_ENTRIES_MASK;
+        this->tlb_insn_tag[index] = -1;
+        this->tlb_load_tag[index] = -1;
+        this->tlb_store_tag[index] = -1;
+    }
+}
+
+MmuTlbEntry *Mmu::tlb_lookup(iss_addr_t virt_addr)
+{
+    if (this->tlb_nb_ways == 0)
+    {
+        return NULL;
+    }
+
+    // Entries are indexed with their own page size, so each size has to be looked up
+    for (int level=0; level<this->nb_levels; level++)
+    {
+        iss_addr_t vpn = virt_addr >> (MMU_PGSHIFT + level * this->vpn_width);
+        MmuTlbEntry *set = &this->tlb[(vpn & (this->tlb_nb_sets - 1)) * this->tlb_nb_ways];
+
+        for (int way=0; way<this->tlb_nb_ways; way++)
+        {
+            MmuTlbEntry *entry = &set[way];
+            if (entry->valid && entry->vpn == vpn && entry->level == level &&
+                (entry->global || entry->asid == this->asid))
+            {
+                return entry;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+void Mmu::tlb_insert(iss_addr_t virt_addr, iss_addr_t offset, Pte pte, int level, bool global)
+{
+    if (this->tlb_nb_ways == 0)
+    {
+        return;
+    }
+
+    iss_addr_t vpn = virt_addr >> (MMU_PGSHIFT + level * this->vpn_width);
+    int set_index = vpn & (this->tlb_nb_sets - 1);
+    MmuTlbEntry *set = &this->tlb[set_index * this->tlb_nb_ways];
+
+    // Reuse the entry of the same page in case it was walked again after a permission
+    // failure, otherwise use round-robin replacement
+    int way;
+    for (way=0; way<this->tlb_nb_ways; way++)
+    {
+        if (set[way].valid && set[way].vpn == vpn && set[way].level == level &&
+            (set[way].global || set[way].asid == this->asid))
+        {
+            break;
+        }
+    }
+
+    if (way == this->tlb_nb_ways)
+    {
+        way = this->tlb_next_way[set_index];
+        this->tlb_next_way[set_index] = (way + 1) % this->tlb_nb_ways;
+    }
+
+    MmuTlbEntry *entry = &set[way];
+    entry->vpn = vpn;
+    entry->offset = offset;
+    entry->pte = pte;
+    entry->asid = this->asid;
+    entry->level = level;
+    entry->global = global;
+    entry->valid = true;
+}
+
+bool Mmu::pte_allows_access(Pte pte)
+{
+    if (this->access_type & ACCESS_INSN)
+    {
+        return pte.a && pte.x;
+    }
+
+    bool is_store = this->access_type & ACCESS_STORE;
+    bool is_load = this->access_type & ACCESS_LOAD;
+    return pte.a && !(is_load && !pte.r) && !(is_store && (!pte.w || !pte.d));
+}
+
+void Mmu::tlb_l0_fill(iss_addr_t virt_addr, iss_addr_t offset, Pte pte, int level)
+{
+    iss_addr_t tag = virt_addr >> MMU_PGSHIFT;
+    int index = tag & MMU_TLB_ENTRIES_MASK;
+    iss_addr_t phys_base = (tag << MMU_PGSHIFT) + offset;
+
+    if (level > 0)
+    {
+        this->tlb_l0_superpages = true;
+    }
+
+    if (this->access_type & ACCESS_INSN)
+    {
+        this->tlb_insn_tag[index] = tag;
+        this->tlb_insn_phys_addr[index] = offset;
+    }
+    else
+    {
+        this->tlb_load_tag[index] = -1;
+        this->tlb_store_tag[index] = -1;
+
+        if (pte.r)
+        {
+            this->tlb_load_tag[index] = tag;
+        }
+        if (pte.w && pte.d)
+        {
+            this->tlb_store_tag[index] = tag;
+        }
+        this->tlb_load_use_mem_array[index] = phys_base >= this->iss.lsu.memory_start && phys_base < this->iss.lsu.memory_end;
+        this->tlb_ls_phys_addr[index] = offset;
+    }
 }
 
 void Mmu::raise_exception()
@@ -171,6 +392,9 @@ bool Mmu::handle_pte()
         return false;
     }
 
+    // A global pointer pte makes the whole sub-tree global
+    this->current_global |= this->pte_value.g;
+
     if (this->pte_value.r || this->pte_value.x)
     {
         // A leaf has been found
@@ -178,63 +402,28 @@ bool Mmu::handle_pte()
         iss_addr_t phys_base = (this->pte_value.raw & ~MMU_PTE_ATTR) >> MMU_PTE_PPN_SHIFT << MMU_PGSHIFT;
 
         // In case we are not at the last level, check if we have a misaligned superpage
-        if (this->current_level > 0)
+        int page_bits = MMU_PGSHIFT + this->vpn_width * this->current_level;
+        if (get_field(phys_base, MMU_PGSHIFT, page_bits - MMU_PGSHIFT) != 0)
         {
-            int lower_ppn = get_field(phys_base, MMU_PGSHIFT, this->pte_size * this->current_level);
-            if (lower_ppn != 0)
-            {
-                this->trace.msg(vp::Trace::LEVEL_DEBUG, "Found misaligned superpage\n");
-                this->raise_exception();
-                return false;
-            }
+            this->trace.msg(vp::Trace::LEVEL_DEBUG, "Found misaligned superpage\n");
+            this->raise_exception();
+            return false;
         }
 
-        if (this->current_level > 0)
+        if (!this->pte_allows_access(this->pte_value))
         {
-            int vpn_index = get_field(this->current_virt_addr, MMU_PGSHIFT, this->vpn_width);
-            phys_base += vpn_index << MMU_PGSHIFT;
+            this->raise_exception();
+            return false;
         }
 
-        iss_addr_t virt_base = this->current_virt_addr >> MMU_PGSHIFT << MMU_PGSHIFT;
-        iss_addr_t tag = this->current_virt_addr >> MMU_PGSHIFT;
-        int index = tag & MMU_TLB_ENTRIES_MASK;
-        if (this->access_type & ACCESS_INSN)
-        {
-            if (!this->pte_value.a || !this->pte_value.x)
-            {
-                this->raise_exception();
-                return false;
-            }
+        // The offset is the same for all the pages of a superpage
+        iss_addr_t virt_base = this->current_virt_addr >> page_bits << page_bits;
+        this->tlb_insert(this->current_virt_addr, phys_base - virt_base, this->pte_value,
+            this->current_level, this->current_global);
 
-            this->tlb_insn_tag[index] = tag;
-            this->tlb_insn_phys_addr[index] = phys_base - virt_base;
-        }
-        else
-        {
-            bool is_store = this->access_type & ACCESS_STORE;
-            bool is_load = this->access_type & ACCESS_LOAD;
-            if (!this->pte_value.a ||
-                is_load && !this->pte_value.r ||
-                is_store && (!this->pte_value.w || !this->pte_value.d))
-            {
-                this->raise_exception();
-                return false;
-            }
-
-            this->tlb_load_tag[index] = -1;
-            this->tlb_store_tag[index] = -1;
+        this->tlb_l0_fill(this->current_virt_addr, phys_base - virt_base, this->pte_value,
+            this->current_level);
 
-            if (this->pte_value.r)
-            {
-                this->tlb_load_tag[index] = tag;
-            }
-            if (this->pte_value.w && this->pte_value.d)
-            {
-                this->tlb_store_tag[index] = tag;
-            }
-            this->tlb_load_use_mem_array[index] = phys_base >= this->iss.lsu.memory_start && phys_base < this->iss.lsu.memory_end;
-            this->tlb_ls_phys_addr[index] = phys_base - virt_base;
-        }
         this->iss.trace.dump_trace_enabled = true;
         this->iss.exec.irq_locked--;
         this->iss.exec.insn_resume();
@@ -305,6 +494,7 @@ void Mmu::walk_pgtab(iss_addr_t virt_addr)
     this->stall_insn = this->iss.exec.current_insn;
 
     this->current_virt_addr = virt_addr;
+    this->current_global = false;
     this->current_level = this->nb_levels - 1;
     this->current_vpn_bit = MMU_PGSHIFT + this->nb_levels * this->vpn_width;
 
@@ -329,7 +519,7 @@ bool Mmu::virt_to_phys_miss(iss_addr_t virt_addr, iss_addr_t &phys_addr, bool &u
         mode = this->iss.csr.mstatus.mpp;
     }
 
-    int tag = virt_addr >> MMU_PGSHIFT;
+    iss_addr_t tag = virt_addr >> MMU_PGSHIFT;
     int index = tag & MMU_TLB_ENTRIES_MASK;
     iss_addr_t page_virt_addr = tag << MMU_PGSHIFT;
     iss_addr_t page_phys_addr;
@@ -357,6 +547,21 @@ bool Mmu::virt_to_phys_miss(iss_addr_t virt_addr, iss_addr_t &phys_addr, bool &u
     }
     else
     {
+        MmuTlbEntry *entry = this->tlb_lookup(virt_addr);
+
+        // Entries which do not allow the access are walked again, in case the pte was
+        // updated
+        if (entry && this->pte_allows_access(entry->pte))
+        {
+            this->tlb_hits.inc(1);
+            this->tlb_l0_fill(virt_addr, entry->offset, entry->pte, entry->level);
+            phys_addr = virt_addr + entry->offset;
+            iss_addr_t phys_base = page_virt_addr + entry->offset;
+            use_mem_array = phys_base >= this->iss.lsu.memory_start && phys_base < this->iss.lsu.memory_end;
+            return false;
+        }
+
+        this->tlb_misses.inc(1);
         this->walk_pgtab(virt_addr);
         return true;
     }
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpu/iss/include/iss.hpp"
+#include <string.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+// Number of instructions listed in the flat profile
+#define PROFILER_NB_HOT_INSNS 20
+
+static const char *stall_reason_names[ISS_STALL_NB] = {
+    "none",
+    "fetch",
+    "taken_branch",
+    "jump",
+    "load",
+    "load_dependency",
+    "insn_dependency",
+    "insn",
+    "misaligned",
+    "wait",
+};
+
+class ProfilerFunction
+{
+public:
+    std::string name;
+    int64_t samples = 0;
+    std::array<int64_t, ISS_STALL_NB> reasons{};
+};
+
+
+Profiler::Profiler(IssWrapper &top, Iss &iss, iss_profiler_mode_e mode, int64_t period)
+    : vp::Block(&top, "profiler"), iss(iss), top(top),
+    sample_event(this, &Profiler::cycle_sample_handler), mode(mode), period(period)
+{
+    // Seed the jitter from the core path, so that cores do not sample in phase, while keeping
+    // the profile reproducible from one run to another
+    this->random_state = std::hash<std::string>()(top.get_path()) | 1;
+
+    if (this->mode == ISS_PROFILER_INSNS)
+    {
+        this->iss.timing.profiler_insns = true;
+        this->iss.timing.profiler_countdown = this->next_interval();
+    }
+}
+
+int64_t Profiler::next_interval()
+{
+    if (this->period <= 1)
+    {
+        return 1;
+    }
+
+    // Xorshift generator, uniform jitter between half and one and a half period
+    this->random_state ^= this->random_state << 13;
+    this->random_state ^= this->random_state >> 7;
+    this->random_state ^= this->random_state << 17;
+
+    return this->period / 2 + this->random_state % this->period;
+}
+
+void Profiler::account(iss_reg_t pc, int reason)
+{
+    this->samples[pc][reason]++;
+    this->nb_samples++;
+}
+
+void Profiler::core_active(bool active)
+{
+    if (this->mode != ISS_PROFILER_CYCLES)
+    {
+        return;
+    }
+
+    if (active && !this->sample_event.is_enqueued())
+    {
+        this->sample_event.enqueue(this->next_interval());
+    }
+    else if (!active && this->sample_event.is_enqueued())
+    {
+        this->sample_event.cancel();
+    }
+}
+
+void Profiler::cycle_sample_handler(vp::Block *__this, vp::ClockEvent *event)
+{
+    Profiler *_this = (Profiler *)__this;
+    Exec &exec = _this->iss.exec;
+
+    if (exec.is_stalled() || exec.insn_on_hold)
+    {
+        // Waiting for something external like a memory response, the stalled instruction is the
+        // one which is still executing
+        _this->account(exec.stall_insn, ISS_STALL_WAIT);
+    }
+    else if (exec.stall_cycles > 0)
+    {
+        // Paying the stall cycles accounted by a previous instruction
+        _this->account(_this->iss.timing.stall_pc, _this->iss.timing.stall_reason);
+    }
+    else
+    {
+        _this->account(exec.current_insn, ISS_STALL_NONE);
+    }
+
+    _this->sample_event.enqueue(_this->next_interval());
+}
+
+void Profiler::insn_sample(iss_reg_t pc)
+{
+    // The sample is taken in 2 steps, the instruction is first selected, and the sample is
+    // accounted when the next one starts, to know if it has stalled
+    if (this->insn_pending)
+    {
+        Timing &timing = this->iss.timing;
+        int reason = timing.stall_pc == this->insn_pending_pc ? timing.stall_reason : ISS_STALL_NONE;
+        this->account(this->insn_pending_pc, reason);
+        this->insn_pending = false;
+
+        int64_t interval = this->next_interval() - 1;
+        if (interval > 0)
+        {
+            timing.profiler_countdown = interval;
+            return;
+        }
+    }
+
+    this->insn_pending = true;
+    this->insn_pending_pc = pc;
+    this->iss.timing.stall_reason = ISS_STALL_NONE;
+    this->iss.timing.profiler_countdown = 1;
+}
+
+void Profiler::stop()
+{
+    this->dump();
+}
+
+void Profiler::dump()
+{
+    std::string path = this->top.get_path();
+    std::string name = path;
+    std::replace(name.begin(), name.end(), '/', '.');
+    if (name.size() > 0 && name[0] == '.')
+    {
+        name = name.substr(1);
+    }
+    std::string prefix = "profile." + name;
+    // Root frame of the stacks, so that the profiles of several cores can be merged
+    std::string root = path.size() > 0 && path[0] == '/' ? path.substr(1) : path;
+
+    // Resolve functions now, for all sampled PCs
+    std::map<std::string, ProfilerFunction> functions;
+    std::map<std::string, int64_t> stacks;
+    std::array<int64_t, ISS_STALL_NB> reasons{};
+    std::vector<std::pair<int64_t, iss_reg_t>> insns;
+
+    for (auto &x: this->samples)
+    {
+        const char *func = "[unknown]", *inline_func = "-", *file = "-";
+        int line = 0;
+        iss_trace_pc_info(x.first, &func, &inline_func, &file, &line);
+
+        ProfilerFunction &function = functions[func];
+        function.name = func;
+
+        std::string stack = root + ";" + func;
+        if (strcmp(inline_func, "-") != 0 && inline_func[0] != 0 && strcmp(inline_func, func) != 0)
+        {
+            stack += std::string(";") + inline_func;
+        }
+
+        int64_t pc_samples = 0;
+        for (int i = 0; i < ISS_STALL_NB; i++)
+        {
+            int64_t count = x.second[i];
+            if (count == 0)
+            {
+                continue;
+            }
+
+            function.samples += count;
+            function.reasons[i] += count;
+            reasons[i] += count;
+            pc_samples += count;
+
+            if (i == ISS_STALL_NONE)
+            {
+                stacks[stack] += count;
+            }
+            else
+            {
+                stacks[stack + ";[stall:" + stall_reason_names[i] + "]"] += count;
+            }
+        }
+
+        insns.push_back(std::make_pair(pc_samples, x.first));
+    }
+
+    std::string flat_path = prefix + ".txt";
+    FILE *file = fopen(flat_path.c_str(), "w");
+    if (file == NULL)
+    {
+        this->get_trace()->force_warning("Unable to open profile file (path: %s, error: %s)\n",
+            flat_path.c_str(), strerror(errno));
+        return;
+    }
+
+    double total = this->nb_samples > 0 ? this->nb_samples : 1;
+
+    fprintf(file, "# Sampling profile of %s\n", path.c_str());
+    fprintf(file, "# Mode: %s, period: %" PRId64 ", samples: %" PRId64 "\n",
+        this->mode == ISS_PROFILER_CYCLES ? "cycles" : "insns", this->period, this->nb_samples);
+
+    std::vector<ProfilerFunction *> sorted;
+    for (auto &x: functions)
+    {
+        sorted.push_back(&x.second);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [](ProfilerFunction *a, ProfilerFunction *b) { return a->samples > b->samples; });
+
+    fprintf(file, "\n%10s %8s %8s  %-16s %s\n", "samples", "%", "stall%", "main_stall", "function");
+    for (ProfilerFunction *function: sorted)
+    {
+        int64_t stalled = function->samples - function->reasons[ISS_STALL_NONE];
+        int main_stall = ISS_STALL_NONE;
+        for (int i = ISS_STALL_NONE + 1; i < ISS_STALL_NB; i++)
+        {
+            if (function->reasons[i] > 0 &&
+                (main_stall == ISS_STALL_NONE || function->reasons[i] > function->reasons[main_stall]))
+            {
+                main_stall = i;
+            }
+        }
+
+        fprintf(file, "%10" PRId64 " %8.2f %8.2f  %-16s %s\n", function->samples,
+            function->samples * 100.0 / total, stalled * 100.0 / function->samples,
+            main_stall == ISS_STALL_NONE ? "-" : stall_reason_names[main_stall],
+            function->name.c_str());
+    }
+
+    fprintf(file, "\n%10s %8s  %s\n", "samples", "%", "stall_reason");
+    for (int i = 0; i < ISS_STALL_NB; i++)
+    {
+        if (reasons[i] > 0)
+        {
+            fprintf(file, "%10" PRId64 " %8.2f  %s\n", reasons[i], reasons[i] * 100.0 / total,
+                stall_reason_names[i]);
+        }
+    }
+
+    std::stable_sort(insns.begin(), insns.end(),
+        [](std::pair<int64_t, iss_reg_t> a, std::pair<int64_t, iss_reg_t> b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second); });
+
+    fprintf(file, "\n%10s %8s  %-18s %s\n", "samples", "%", "pc", "location");
+    for (size_t i = 0; i < insns.size() && i < PROFILER_NB_HOT_INSNS; i++)
+    {
+        const char *func = "[unknown]", *inline_func = "-", *debug_file = "-";
+        int line = 0;
+        iss_trace_pc_info(insns[i].second, &func, &inline_func, &debug_file, &line);
+
+        fprintf(file, "%10" PRId64 " %8.2f  0x%-16" PRIx64 " %s %s:%d\n", insns[i].first,
+            insns[i].first * 100.0 / total, (uint64_t)insns[i].second, func, debug_file, line);
+    }
+
+    fclose(file);
+
+    // Folded stacks, one line per stack with its number of samples, as expected by flamegraph
+    // tools
+    std::string folded_path = prefix + ".folded";
+    file = fopen(folded_path.c_str(), "w");
+    if (file == NULL)
+    {
+        this->get_trace()->force_warning("Unable to open profile file (path: %s, error: %s)\n",
+            folded_path.c_str(), strerror(errno));
+        return;
+    }
+
+    for (auto &x: stacks)
+    {
+        fprintf(file, "%s %" PRId64 "\n", x.first.c_str(), x.second);
+    }
+
+    fclose(file);
+}
@@ -467,6 +467,7 @@ int Decode::decode_insn(iss_insn_t *insn, iss_reg_t pc, iss_opcode_t opcode, iss
 #endif
 
     insn->is_macro_op = item->u.insn.is_macro_op;
+    insn->trace_binary_id = 0;
 
     if (item->u.insn.decode != NULL)
     {
@@ -555,7 +556,7 @@ void Decode::decode_pc(iss_insn_t *insn, iss_reg_t pc)
 
     insn->opcode = opcode;
 
-    if (iss.trace.insn_trace.get_active() || iss.timing.insn_trace_event.get_event_active())
+    if (iss.trace.get_insn_trace_active() || iss.timing.insn_trace_event.get_event_active())
     {
         insn->saved_handler = insn->handler;
         insn->handler = this->iss.exec.insn_trace_callback_get();
@@ -72,6 +72,13 @@ void Exec::build()
 
     this->bootaddr_offset = this->iss.top.get_js_config()->get_child_int("bootaddr_offset");
 
+    // This core is driven by offload requests and always executes one instruction per cycle,
+    // refuse the quantum mode instead of silently ignoring it
+    if (this->iss.top.get_js_config()->get_child_int("quantum") > 0)
+    {
+        this->trace.fatal("Quantum mode is not supported by the snitch FP subsystem\n");
+    }
+
 
     this->current_insn = 0;
     this->stall_insn = 0;
@@ -163,7 +170,7 @@ void Exec::exec_instr(vp::Block *__this, vp::ClockEvent *event)
 
     if (iss->exec.handle_stall_cycles()) return;
 
-    iss->exec.trace.msg(vp::Trace::LEVEL_TRACE, "Handling instruction with fast handler\n");
+    vp_trace_msg(&iss->exec.trace, vp::Trace::LEVEL_TRACE, "Handling instruction with fast handler\n");
 
     iss_reg_t pc = iss->exec.current_insn;
 
@@ -253,7 +260,7 @@ void Exec::exec_instr_check_all(vp::Block *__this, vp::ClockEvent *event)
 
     if (iss->exec.handle_stall_cycles()) return;
 
-    _this->trace.msg(vp::Trace::LEVEL_TRACE, "Handling instruction with slow handler (pc: 0x%lx)\n", iss->exec.current_insn);
+    vp_trace_msg(&_this->trace, vp::Trace::LEVEL_TRACE, "Handling instruction with slow handler (pc: 0x%lx)\n", iss->exec.current_insn);
 
     if(_this->pending_flush)
     {
@@ -276,6 +283,11 @@ void Exec::exec_instr_check_all(vp::Block *__this, vp::ClockEvent *event)
 
     _this->insn_exec_profiling();
 
+    if (unlikely(_this->iss.timing.profiler_insns && --_this->iss.timing.profiler_countdown <= 0))
+    {
+        _this->iss.timing.profiler->insn_sample(_this->current_insn);
+    }
+
     if (!_this->skip_irq_check)
     {
         _this->iss.irq.check();
@@ -731,6 +731,13 @@ void Syscalls::handle_riscv_ebreak()
       break;
     }
 
+    case 0x117:
+    {
+        // Marks the end of the part of the workload to be fast-forwarded
+        this->iss.exec.fast_forward_trigger("semihosting call");
+        break;
+    }
+
     default:
         this->trace.force_warning("Unknown ebreak call (id: %d)\n", id);
         break;
@@ -70,6 +70,19 @@ void Timing::build()
         this->iss.top.new_master_port("ext_counter[" + std::to_string(i) + "]", &this->ext_counter[i]);
     }
 
+    std::string profiler_mode = this->iss.top.get_js_config()->get_child_str("sampling_profiler");
+    if (profiler_mode == "cycles" || profiler_mode == "insns")
+    {
+        int64_t period = this->iss.top.get_js_config()->get_child_int("sampling_period");
+        this->profiler = new Profiler((IssWrapper &)this->iss.top, this->iss,
+            profiler_mode == "cycles" ? ISS_PROFILER_CYCLES : ISS_PROFILER_INSNS,
+            period > 0 ? period : 1000);
+    }
+    else if (profiler_mode != "" && profiler_mode != "none")
+    {
+        this->iss.top.get_trace()->force_warning("Unknown sampling profiler mode (mode: %s)\n",
+            profiler_mode.c_str());
+    }
 
 }
 
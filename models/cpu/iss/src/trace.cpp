@@ -34,6 +34,8 @@ void Trace::build()
 {
     this->iss.top.traces.new_trace("insn", &this->insn_trace, vp::DEBUG);
     this->insn_trace.register_callback(std::bind(&Trace::insn_trace_callback, this));
+    this->iss.top.traces.new_trace_binary("insn_bin", &this->insn_bin_trace);
+    this->insn_bin_trace.register_callback(std::bind(&Trace::insn_trace_callback, this));
     iss_trace_init(&this->iss);
 
     for (auto x : this->iss.top.get_js_config()->get("**/debug_binaries")->get_elems())
@@ -658,18 +660,229 @@ void iss_trace_save_args(Iss *iss, iss_insn_t *insn, iss_insn_arg_t saved_args[]
     }
 }
 
+void Trace::dump_binary_info()
+{
+    this->binary_info_dumped = true;
+
+    int size = sizeof(iss_trace_binary_info_t);
+    for (std::string &binary : binaries)
+    {
+        size += sizeof(uint16_t) + binary.size();
+    }
+
+    uint8_t *buffer = this->insn_bin_trace.binary_alloc(size);
+    iss_trace_binary_info_t *info = (iss_trace_binary_info_t *)buffer;
+    info->kind = ISS_TRACE_BINARY_INFO;
+    info->reg_size = sizeof(iss_reg_t);
+    info->has_double = this->iss.decode.has_double;
+#ifdef ISS_SINGLE_REGFILE
+    info->single_regfile = 1;
+#else
+    info->single_regfile = 0;
+#endif
+    info->float_hex = this->iss.top.traces.get_trace_engine()->get_trace_float_hex();
+    info->memcheck = this->iss.top.traces.get_trace_engine()->is_memcheck_enabled();
+    info->fp_width = CONFIG_GVSOC_ISS_FP_WIDTH;
+    info->nb_regs = ISS_NB_REGS;
+    info->nb_binaries = binaries.size();
+    buffer += sizeof(iss_trace_binary_info_t);
+
+    for (std::string &binary : binaries)
+    {
+        *(uint16_t *)buffer = binary.size();
+        buffer += sizeof(uint16_t);
+        memcpy(buffer, binary.c_str(), binary.size());
+        buffer += binary.size();
+    }
+}
+
+void Trace::dump_binary_decode(iss_insn_t *insn)
+{
+    if (!this->binary_info_dumped)
+    {
+        this->dump_binary_info();
+    }
+
+    insn->trace_binary_id = ++this->binary_nb_decoded;
+
+    const char *label = insn->decoder_item->u.insn.label;
+    int label_len = strlen(label);
+    int nb_args = insn->decoder_item->u.insn.nb_args;
+    int size = sizeof(iss_trace_binary_decode_t) + label_len;
+    for (int i = 0; i < nb_args; i++)
+    {
+        size += sizeof(iss_trace_binary_arg_t);
+        if (insn->args[i].flags & ISS_DECODER_ARG_FLAG_DUMP_NAME)
+        {
+            size += strlen(insn->args[i].name);
+        }
+    }
+
+    uint8_t *buffer = this->insn_bin_trace.binary_alloc(size);
+    iss_trace_binary_decode_t *decode = (iss_trace_binary_decode_t *)buffer;
+    decode->kind = ISS_TRACE_BINARY_DECODE;
+    decode->nb_args = nb_args;
+    decode->label_len = label_len;
+    decode->id = insn->trace_binary_id;
+    decode->opcode = insn->opcode;
+    buffer += sizeof(iss_trace_binary_decode_t);
+    memcpy(buffer, label, label_len);
+    buffer += label_len;
+
+    for (int i = 0; i < nb_args; i++)
+    {
+        iss_insn_arg_t *insn_arg = &insn->args[i];
+        iss_decoder_arg_t *arg = &insn->decoder_item->u.insn.args[i];
+        iss_trace_binary_arg_t *bin_arg = (iss_trace_binary_arg_t *)buffer;
+        buffer += sizeof(iss_trace_binary_arg_t);
+
+        bin_arg->type = arg->type;
+        bin_arg->flags = arg->flags;
+        bin_arg->insn_flags = insn_arg->flags;
+        bin_arg->dump_name = 0;
+        bin_arg->reg = 0;
+        bin_arg->reg2 = 0;
+        bin_arg->imm = 0;
+        bin_arg->name_len = 0;
+
+        if (arg->type == ISS_DECODER_ARG_TYPE_OUT_REG || arg->type == ISS_DECODER_ARG_TYPE_IN_REG)
+        {
+            bin_arg->dump_name = arg->u.reg.dump_name;
+            bin_arg->reg = insn_arg->u.reg.index;
+        }
+        else if (arg->type == ISS_DECODER_ARG_TYPE_UIMM)
+        {
+            bin_arg->imm = insn_arg->u.uim.value;
+        }
+        else if (arg->type == ISS_DECODER_ARG_TYPE_SIMM)
+        {
+            bin_arg->imm = insn_arg->u.sim.value;
+        }
+        else if (arg->type == ISS_DECODER_ARG_TYPE_INDIRECT_IMM)
+        {
+            bin_arg->reg = insn_arg->u.indirect_imm.reg_index;
+            bin_arg->imm = insn_arg->u.indirect_imm.imm;
+        }
+        else if (arg->type == ISS_DECODER_ARG_TYPE_INDIRECT_REG)
+        {
+            bin_arg->reg = insn_arg->u.indirect_reg.base_reg_index;
+            bin_arg->reg2 = insn_arg->u.indirect_reg.offset_reg_index;
+        }
+
+        if (insn_arg->flags & ISS_DECODER_ARG_FLAG_DUMP_NAME)
+        {
+            bin_arg->name_len = strlen(insn_arg->name);
+            memcpy(buffer, insn_arg->name, bin_arg->name_len);
+            buffer += bin_arg->name_len;
+        }
+    }
+}
+
+void Trace::dump_binary(iss_insn_t *insn, iss_reg_t pc)
+{
+    if (insn->trace_binary_id == 0)
+    {
+        this->dump_binary_decode(insn);
+    }
+
+    // Only the register values are dumped, everything else is rendered offline from the decoded
+    // instruction
+    int nb_args = insn->decoder_item->u.insn.nb_args;
+    int nb_values = 0;
+    for (int i = 0; i < nb_args; i++)
+    {
+        iss_decoder_arg_type_e type = insn->decoder_item->u.insn.args[i].type;
+        if (type == ISS_DECODER_ARG_TYPE_OUT_REG || type == ISS_DECODER_ARG_TYPE_IN_REG ||
+            type == ISS_DECODER_ARG_TYPE_INDIRECT_IMM)
+        {
+            nb_values += 2;
+        }
+        else if (type == ISS_DECODER_ARG_TYPE_INDIRECT_REG)
+        {
+            nb_values += 4;
+        }
+    }
+
+    int size = sizeof(iss_trace_binary_exec_t) + nb_values * sizeof(uint64_t);
+    if (this->has_reg_dump)
+    {
+        size += sizeof(uint64_t);
+    }
+    if (this->has_str_dump)
+    {
+        size += sizeof(uint16_t) + this->str_dump.size();
+    }
+
+    uint8_t *buffer = this->insn_bin_trace.binary_alloc(size);
+    iss_trace_binary_exec_t *exec = (iss_trace_binary_exec_t *)buffer;
+    exec->kind = ISS_TRACE_BINARY_EXEC;
+    exec->mode = this->priv_mode;
+    exec->flags = (this->has_reg_dump ? ISS_TRACE_BINARY_FLAG_REG_DUMP : 0) |
+        (this->has_str_dump ? ISS_TRACE_BINARY_FLAG_STR_DUMP : 0);
+    exec->nb_values = nb_values;
+    exec->id = insn->trace_binary_id;
+    exec->pc = pc;
+
+    uint64_t *values = (uint64_t *)(buffer + sizeof(iss_trace_binary_exec_t));
+    for (int i = 0; i < nb_args; i++)
+    {
+        iss_decoder_arg_t *arg = &insn->decoder_item->u.insn.args[i];
+        iss_insn_arg_t *saved_arg = &this->saved_args[i];
+
+        if (arg->type == ISS_DECODER_ARG_TYPE_OUT_REG || arg->type == ISS_DECODER_ARG_TYPE_IN_REG)
+        {
+            bool is_64 = arg->flags & (ISS_DECODER_ARG_FLAG_REG64 | ISS_DECODER_ARG_FLAG_FREG);
+            *values++ = is_64 ? saved_arg->u.reg.value_64 : saved_arg->u.reg.value;
+            *values++ = arg->flags & ISS_DECODER_ARG_FLAG_REG64 ?
+                saved_arg->u.reg.memcheck_value_64 : saved_arg->u.reg.memcheck_value;
+        }
+        else if (arg->type == ISS_DECODER_ARG_TYPE_INDIRECT_IMM)
+        {
+            *values++ = saved_arg->u.indirect_imm.reg_value;
+            *values++ = saved_arg->u.indirect_imm.memcheck_reg_value;
+        }
+        else if (arg->type == ISS_DECODER_ARG_TYPE_INDIRECT_REG)
+        {
+            *values++ = saved_arg->u.indirect_reg.base_reg_value;
+            *values++ = saved_arg->u.indirect_reg.memcheck_base_reg_value;
+            *values++ = saved_arg->u.indirect_reg.offset_reg_value;
+            *values++ = saved_arg->u.indirect_reg.memcheck_offset_reg_value;
+        }
+    }
+
+    if (this->has_reg_dump)
+    {
+        *values++ = this->reg_dump;
+    }
+
+    if (this->has_str_dump)
+    {
+        uint8_t *str = (uint8_t *)values;
+        *(uint16_t *)str = this->str_dump.size();
+        memcpy(str + sizeof(uint16_t), this->str_dump.c_str(), this->str_dump.size());
+    }
+}
+
 void iss_trace_dump(Iss *iss, iss_insn_t *insn, iss_reg_t pc)
 {
     if (!insn->is_macro_op || iss->top.traces.get_trace_engine()->get_format() == TRACE_FORMAT_LONG)
     {
-        char buffer[1024];
-
         iss_trace_save_args(iss, insn, iss->trace.saved_args, true);
 
-        iss_trace_dump_insn(iss, insn, pc, buffer, 1024, iss->trace.saved_args,
-            iss->top.traces.get_trace_engine()->get_format() == TRACE_FORMAT_LONG, iss->trace.priv_mode, 0);
+        if (iss->trace.insn_trace.get_active())
+        {
+            char buffer[1024];
+
+            iss_trace_dump_insn(iss, insn, pc, buffer, 1024, iss->trace.saved_args,
+                iss->top.traces.get_trace_engine()->get_format() == TRACE_FORMAT_LONG, iss->trace.priv_mode, 0);
+
+            iss->trace.insn_trace.msg(buffer);
+        }
 
-        iss->trace.insn_trace.msg(buffer);
+        if (iss->trace.insn_bin_trace.get_active())
+        {
+            iss->trace.dump_binary(insn, pc);
+        }
     }
 }
 
@@ -700,7 +913,7 @@ iss_reg_t iss_exec_insn_with_trace(Iss *iss, iss_insn_t *insn, iss_reg_t pc)
         iss_event_dump(iss, insn, pc);
     }
 
-    if (iss->trace.insn_trace.get_active())
+    if (iss->trace.get_insn_trace_active())
     {
         iss->trace.priv_mode = iss->core.mode_get();
 
@@ -35,6 +35,7 @@
 
 #include <vp/itf/hyper.hpp>
 #include <vp/itf/wire.hpp>
+#include <vp/preload_cache.hpp>
 
 // Flash sector size
 #define MX25_SECTOR_SIZE (1 << 12)
@@ -1030,10 +1031,20 @@ Mx25::Mx25(vp::ComponentConf &config)
 
     this->trace.msg(vp::Trace::LEVEL_INFO, "Building flash (size: 0x%x)\n", this->size);
 
+    // An input preload file can be mapped from the preload cache, so that simulations using the
+    // same file share the flash array until they program it.
+    bool preloaded = false;
+    if (preload_file_conf && !writeback)
+    {
+        this->data = vp::PreloadCache::map(&this->trace, preload_file_conf->get_str(), this->size,
+            0xff);
+        preloaded = this->data != NULL;
+    }
+
     // If there is no preload file or if the preload file is a classi input file,
     // Allocate an array for the flash and fill it with clean state which is 1 everywhere so that
     //. the whole flash can be programmed without being erased.
-    if (!preload_file_conf || !writeback)
+    if (!preloaded && (!preload_file_conf || !writeback))
     {
         this->data = new uint8_t[this->size];
         memset(this->data, 0xff, this->size);
@@ -1041,7 +1052,7 @@ Mx25::Mx25(vp::ComponentConf &config)
 
     // The preload file can be either input file, or memory-mapped file to keep flash content
     // on workstation
-    if (preload_file_conf)
+    if (preload_file_conf && !preloaded)
     {
         if (this->preload_file((char *)preload_file_conf->get_str().c_str(), writeback))
         {
@@ -31,6 +31,7 @@
 
 #include <vp/itf/hyper.hpp>
 #include <vp/itf/wire.hpp>
+#include <vp/preload_cache.hpp>
 
 #define REGS_AREA_SIZE 1024
 
@@ -403,7 +404,10 @@ int Hyperflash::setup_writeback_file(const char *path)
 
   /* copy the current data content into the mmap area and replace data pointer with the mmap pointer */
   memcpy(mmapped_data, this->data, this->size);
-  free(this->data);
+  if (this->data_is_mmapped)
+    vp::PreloadCache::unmap(this->data, this->size);
+  else
+    free(this->data);
   this->data = mmapped_data;
   this->data_is_mmapped = true;
 
@@ -434,9 +438,28 @@ Hyperflash::Hyperflash(vp::ComponentConf &config)
   this->size = conf->get("size")->get_int();
   this->trace.msg(vp::Trace::LEVEL_INFO, "Building flash (size: 0x%x)\n", this->size);
 
-  this->data = new uint8_t[this->size];
-  memset(this->data, 0xff, this->size);
-  this->data_is_mmapped = false;
+  js::Config *preload_file_conf = conf->get("preload_file");
+  if (preload_file_conf == NULL)
+  {
+    preload_file_conf = conf->get("content/image");
+  }
+
+  /*
+   * Input preload files can be mapped from the preload cache to share them with other
+   * simulations, the mapping is then the flash array
+   */
+  this->data = NULL;
+  if (preload_file_conf && !conf->get_child_bool("writeback"))
+  {
+    this->data = vp::PreloadCache::map(&this->trace, preload_file_conf->get_str(), this->size, 0xff);
+  }
+  this->data_is_mmapped = this->data != NULL;
+
+  if (!this->data_is_mmapped)
+  {
+    this->data = new uint8_t[this->size];
+    memset(this->data, 0xff, this->size);
+  }
 
   this->reg_data = new uint8_t[REGS_AREA_SIZE];
   memset(this->reg_data, 0x57, REGS_AREA_SIZE);
@@ -446,13 +469,7 @@ Hyperflash::Hyperflash(vp::ComponentConf &config)
   this->pending_bytes = 0;
   this->pending_cmd = 0;
 
-  js::Config *preload_file_conf = conf->get("preload_file");
-  if (preload_file_conf == NULL)
-  {
-    preload_file_conf = conf->get("content/image");
-  }
-
-  if (preload_file_conf)
+  if (preload_file_conf && !this->data_is_mmapped)
   {
     if (this->preload_file((char *)preload_file_conf->get_str().c_str()))
     {
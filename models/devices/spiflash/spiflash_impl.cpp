@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <vp/itf/qspim.hpp>
+#include <vp/preload_cache.hpp>
 
 #define CMD_READ_ID       0x9f
 #define CMD_RDCR          0x35
@@ -463,9 +464,31 @@ spiflash::spiflash(vp::ComponentConf &config)
 
   this->size = this->get_js_config()->get_child_int("size");
 
-  this->mem_data = new uint8_t[this->size];
+  js::Config *stim_file_conf = this->get_js_config()->get("stim_file");
+  if (stim_file_conf == NULL)
+  {
+    stim_file_conf = this->get_js_config()->get("content/image");
+  }
+  if (stim_file_conf == NULL)
+  {
+    stim_file_conf = this->get_js_config()->get("preload_file");
+  }
 
-  memset(this->mem_data, 0x57, this->size);
+  // The stimuli file can be mapped from the preload cache to share it with other simulations,
+  // the mapping is then the memory array
+  bool preloaded = false;
+  if (stim_file_conf != NULL)
+  {
+    this->mem_data = vp::PreloadCache::map(&this->trace, stim_file_conf->get_str(), this->size, 0x57);
+    preloaded = this->mem_data != NULL;
+  }
+
+  if (!preloaded)
+  {
+    this->mem_data = new uint8_t[this->size];
+
+    memset(this->mem_data, 0x57, this->size);
+  }
 
   this->cr1.raw = 0;
   this->quad = false;
@@ -477,17 +500,7 @@ spiflash::spiflash(vp::ComponentConf &config)
   this->trace.msg(vp::Trace::LEVEL_INFO, "Building spiFlash (size: 0x%x)\n", this->size);
 
   // Preload the memory
-  js::Config *stim_file_conf = this->get_js_config()->get("stim_file");
-  if (stim_file_conf == NULL)
-  {
-    stim_file_conf = this->get_js_config()->get("content/image");
-  }
-  if (stim_file_conf == NULL)
-  {
-    stim_file_conf = this->get_js_config()->get("preload_file");
-  }
-
-  if (stim_file_conf != NULL)
+  if (stim_file_conf != NULL && !preloaded)
   {
     string path = stim_file_conf->get_str();
     this->trace.msg(vp::Trace::LEVEL_INFO, "Preloading memory with stimuli file (path: %s)\n", path.c_str());
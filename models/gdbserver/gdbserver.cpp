@@ -69,6 +69,8 @@ int Gdb_server::register_core(vp::Gdbserver_core *core)
 
 void Gdb_server::signal(vp::Gdbserver_core *core, int signal, std::string reason, int info)
 {
+    // Cores are stopped, this gives the context which led to the stop
+    this->traces.get_trace_engine()->flight_recorder_dump("gdb stop");
     this->rsp->signal_from_core(core, signal, reason, info);
 }
 
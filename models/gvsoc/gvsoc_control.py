@@ -18,6 +18,7 @@ import socket
 import threading
 import socket
 import os
+import json
 
 
 
@@ -294,6 +295,80 @@ class Proxy(object):
 
         self._send_cmd('trace level %s' % level)
 
+    def trace_flight_recorder_dump(self):
+        """Dump the content of the flight recorder.
+
+        The last messages and events recorded since the previous dump are formatted to the
+        flight recorder file.
+        """
+
+        self._send_cmd('trace flight_recorder dump')
+
+    def get_engine_stats(self) -> dict:
+        """Get the engine statistics.
+
+        The statistics give, for each time engine and each clock engine, the number of events
+        executed, enqueued and canceled, and the maximum depths of their queues. They also give
+        the counters of the IO request pools.
+
+        :return: A dictionary with the lists "time_engines" and "clock_engines", and the IO
+            request pool counters.
+        """
+
+        return json.loads(self._send_cmd('engine_stats'))
+
+    def reset_engine_stats(self):
+        """Reset the engine statistics.
+
+        The counters of the time and clock engines are cleared, so that the next statistics only
+        cover what is simulated from now.
+        """
+
+        self._send_cmd('engine_stats reset')
+
+    def checkpoint_save(self, path: str) -> bool:
+        """Save a checkpoint.
+
+        The state of the whole platform is saved into the specified file, so that other
+        simulations of the same platform can start from it with checkpoint_restore.
+        The simulation should be stopped.
+
+        :param path: Path of the checkpoint file, which must not contain spaces.
+        :return: True if the checkpoint was saved.
+        """
+
+        return self._send_cmd('checkpoint save %s' % path) == 'ok'
+
+    def checkpoint_restore(self, path: str) -> bool:
+        """Restore a checkpoint.
+
+        The state of the whole platform, including the time, is restored from a file saved by a
+        simulation of the same platform. This is usually done before running the simulation.
+
+        :param path: Path of the checkpoint file, which must not contain spaces.
+        :return: True if the checkpoint was restored.
+        """
+
+        return self._send_cmd('checkpoint restore %s' % path) == 'ok'
+
+    def fast_forward_stop(self):
+        """Stop the fast-forward mode.
+
+        The platform switches to timed mode. This has no effect if the platform is not in
+        fast-forward mode.
+        """
+
+        self._send_cmd('fast_forward stop')
+
+    def host_profiler_dump(self):
+        """Dump the host profile.
+
+        The host time spent in each component since the beginning of the simulation is written
+        to the host profile files. This requires the host profiler to be enabled.
+        """
+
+        self._send_cmd('host_profiler dump')
+
     def event_add(self, event: str):
         """Enable an event.
 
@@ -524,7 +524,7 @@ class ConfigString(config):
 
     def set_from_list(self, name_list, value):
         if len(name_list) == 0:
-            self.value = self.get_tree(value)
+            self.value = value
 
 
 class ConfigNumber(config):
@@ -551,7 +551,7 @@ class ConfigNumber(config):
 
     def set_from_list(self, name_list, value):
         if len(name_list) == 0:
-            self.value = self.get_tree(value)
+            self.value = value
 
 
 class config_bool(config):
@@ -578,4 +578,4 @@ class config_bool(config):
 
     def set_from_list(self, name_list, value):
         if len(name_list) == 0:
-            self.value = self.get_tree(value)
+            self.value = value
@@ -67,6 +67,9 @@ def gen_config(args, config, working_dir, runner, cosim_mode):
     for trace in args.traces:
         gvsoc_config.set('traces/include_regex', trace)
 
+    for trace in args.binary_traces:
+        gvsoc_config.set('traces/binary_include_regex', trace)
+
     if args.trace_level is not None:
         gvsoc_config.set('traces/level', args.trace_level)
 
@@ -75,6 +78,13 @@ def gen_config(args, config, working_dir, runner, cosim_mode):
 
     gvsoc_config.set('traces/float_hex', args.trace_float_hex)
 
+    if args.flight_recorder is not None:
+        gvsoc_config.set('traces/flight_recorder/enabled', True)
+        gvsoc_config.set('traces/flight_recorder/size', args.flight_recorder)
+
+    if args.flight_recorder_file is not None:
+        gvsoc_config.set('traces/flight_recorder/file', args.flight_recorder_file)
+
     if args.vcd:
         gvsoc_config.set('events/enabled', True)
 
@@ -90,17 +100,79 @@ def gen_config(args, config, working_dir, runner, cosim_mode):
     if args.format is not None:
         gvsoc_config.set('events/format', args.format)
 
+    for partition in args.parallel_partitions:
+        gvsoc_config.set('parallel/partitions', [partition.split(',')])
+
+    if len(gvsoc_config.get('parallel/partitions')) != 0:
+        gvsoc_config.set('parallel/enabled', True)
+
+    if args.parallel_quantum is not None:
+        gvsoc_config.set('parallel/quantum', args.parallel_quantum)
+
+    if args.io_req_pool_report:
+        gvsoc_config.set('io_req_pool/report', True)
+
+    if args.event_ring_depth is not None:
+        gvsoc_config.set('events/ring_depth', args.event_ring_depth)
+
+    if args.event_ring_drop:
+        gvsoc_config.set('events/ring_drop', True)
+
+    if args.event_ring_report:
+        gvsoc_config.set('events/ring_report', True)
+
+    if args.event_no_parallel:
+        gvsoc_config.set('events/parallel', False)
+
+    if args.host_profiler:
+        gvsoc_config.set('host_profiler/enabled', True)
+
+    if args.host_profiler_file is not None:
+        gvsoc_config.set('host_profiler/file', args.host_profiler_file)
+
+    if args.preload_cache:
+        gvsoc_config.set('preload_cache/enabled', True)
+
+    if args.preload_cache_dir is not None:
+        gvsoc_config.set('preload_cache/dir', args.preload_cache_dir)
+
+    if args.checkpoint_restore is not None:
+        gvsoc_config.set('checkpoint/restore', args.checkpoint_restore)
+
+    if args.fast_forward or args.fast_forward_until_pc is not None or \
+            args.fast_forward_until_insns is not None:
+        gvsoc_config.set('fast_forward/enabled', True)
+
+    if args.fast_forward_until_pc is not None:
+        gvsoc_config.set('fast_forward/until_pc', int(args.fast_forward_until_pc, 0))
+
+    if args.fast_forward_until_insns is not None:
+        gvsoc_config.set('fast_forward/until_insns', args.fast_forward_until_insns)
+
+    if args.fast_forward_quantum is not None:
+        gvsoc_config.set('fast_forward/quantum', args.fast_forward_quantum)
+
+    if args.iss_profiler is not None:
+        full_config.set('**/sampling_profiler', args.iss_profiler)
+
+    if args.iss_profiler_period is not None:
+        full_config.set('**/sampling_period', args.iss_profiler_period)
+
     debug_mode = args.debug_mode or gvsoc_config.get_bool('debug-mode') or \
         gvsoc_config.get_bool('traces/enabled') or \
         gvsoc_config.get_bool('events/enabled') or \
         len(gvsoc_config.get('traces/include_regex')) != 0 or \
+        len(gvsoc_config.get('traces/binary_include_regex')) != 0 or \
+        gvsoc_config.get_bool('traces/flight_recorder/enabled') or \
         len(gvsoc_config.get('events/include_regex')) != 0 or \
         args.gui and not cosim_mode or \
         args.memcheck or args.power
 
     gvsoc_config.set("debug-mode", debug_mode)
 
-    if debug_mode:
+    # The profiler needs the debug info to resolve functions, but not the debug mode, which would
+    # slow down the simulation
+    if debug_mode or args.iss_profiler is not None:
         debug_binaries = []
 
         if args.binary is not None:
@@ -182,6 +254,12 @@ class Runner():
                         "traces": {},
                         "tags": [ "overview" ],
                         "gtkw": False,
+                        "ring_depth": 256,
+                        "ring_drop": False,
+                        "ring_report": False,
+                        "parallel": True,
+                        "tdb_chunk_events": 4096,
+                        "tdb_compression": "lz4",
                     },
 
                     "include_dirs": args.install_dirs,
@@ -205,7 +283,46 @@ class Runner():
                         "float_hex": False,
                         "enabled": False,
                         "include_regex": [],
-                        "exclude_regex": []
+                        "exclude_regex": [],
+                        "binary_include_regex": [],
+                        "flight_recorder": {
+                            "enabled": False,
+                            "size": 64,
+                            "file": "flight_recorder.txt"
+                        }
+                    },
+
+                    "parallel": {
+                        "enabled": False,
+                        "quantum": 0,
+                        "mailbox_size": 1024,
+                        "partitions": []
+                    },
+
+                    "io_req_pool": {
+                        "slab_size": 64,
+                        "report": False
+                    },
+
+                    "host_profiler": {
+                        "enabled": False,
+                        "file": "host_profile"
+                    },
+
+                    "preload_cache": {
+                        "enabled": False,
+                        "dir": ""
+                    },
+
+                    "checkpoint": {
+                        "restore": ""
+                    },
+
+                    "fast_forward": {
+                        "enabled": False,
+                        "quantum": 1000,
+                        "until_pc": -1,
+                        "until_insns": -1
                     }
                 }
             })
@@ -622,12 +739,21 @@ class Target(gapy.Target):
             parser.add_argument("--trace", dest="traces", default=[], action="append",
                 help="Specify gvsoc trace")
 
+            parser.add_argument("--trace-binary", dest="binary_traces", default=[], action="append",
+                help="Specify gvsoc binary trace, dumped to a binary file which can be rendered with gvsoc_insn_trace")
+
             parser.add_argument("--trace-level", dest="trace_level", default=None,
                 help="Specify trace level")
 
             parser.add_argument("--trace-format", dest="trace_format", default="long",
                 help="Specify trace format")
 
+            parser.add_argument("--flight-recorder", dest="flight_recorder", type=int, default=None,
+                help="Keep the selected traces and events in a memory buffer of the specified size in MB, only dumped on fatal errors, gdb stops, ctrl-C or proxy requests")
+
+            parser.add_argument("--flight-recorder-file", dest="flight_recorder_file", default=None,
+                help="Specify the file where the flight recorder is dumped, or an empty string for the terminal")
+
             parser.add_argument("--trace-float-hex", dest="trace_float_hex", action="store_true", help="Dump float values in hexadecimal")
 
             parser.add_argument("--vcd", dest="vcd", action="store_true", help="Activate VCD traces")
@@ -639,7 +765,19 @@ class Target(gapy.Target):
                 help="Specify gvsoc event through tags(for VCD traces)")
 
             parser.add_argument("--event-format", dest="format", default=None,
-                help="Specify events format (vcd or fst)")
+                help="Specify events format (vcd, fst, raw or tdb)")
+
+            parser.add_argument("--event-ring-depth", dest="event_ring_depth", type=int, default=None,
+                help="Number of event buffers exchanged between the simulation and the event thread")
+
+            parser.add_argument("--event-ring-drop", dest="event_ring_drop", action="store_true",
+                help="Drop events instead of stalling the simulation when the event thread is late")
+
+            parser.add_argument("--event-ring-report", dest="event_ring_report", action="store_true",
+                help="Report event buffer counters at the end of the simulation")
+
+            parser.add_argument("--event-no-parallel", dest="event_no_parallel", action="store_true",
+                help="Write all event files from the event thread instead of one thread per file")
 
             parser.add_argument("--emulation", dest="emulation", action="store_true",
                 help="Launch in emulation mode")
@@ -699,6 +837,64 @@ class Target(gapy.Target):
             parser.add_argument("--gtkw", dest="gtkw", action="store_true",
                                 help="Generate GTKwave script")
 
+            parser.add_argument("--parallel-partition", dest="parallel_partitions", default=[],
+                action="append", help="Simulate the specified components in their own thread. "
+                "Several component paths can be given, separated by commas, for example to include "
+                "the clock domain of a cluster")
+
+            parser.add_argument("--parallel-quantum", dest="parallel_quantum", default=None, type=int,
+                help="Synchronization period in picoseconds of the partitions simulated in parallel. "
+                "By default, the smallest clock period of the bindings crossing partitions is used")
+
+            parser.add_argument("--io-req-pool-report", dest="io_req_pool_report", action="store_true",
+                help="Report IO request allocation counters at the end of the simulation")
+
+            parser.add_argument("--host-profiler", dest="host_profiler", action="store_true",
+                help="Measure the host time spent in each component and dump it at the end of the "
+                "simulation, sorted by component")
+
+            parser.add_argument("--host-profiler-file", dest="host_profiler_file", default=None,
+                help="Specify the path prefix of the host profile files (default: host_profile)")
+
+            parser.add_argument("--preload-cache", dest="preload_cache", action="store_true",
+                help="Map memory preload files copy-on-write from a shared cache, so that "
+                "simulations preloading the same files share their host memory")
+
+            parser.add_argument("--preload-cache-dir", dest="preload_cache_dir", default=None,
+                help="Specify the directory of the preload cache (default: "
+                "/tmp/gvsoc_preload_cache_<uid>)")
+
+            parser.add_argument("--checkpoint-restore", dest="checkpoint_restore", default=None,
+                help="Restore the platform state from the specified checkpoint file before "
+                "starting the simulation")
+
+            parser.add_argument("--fast-forward", dest="fast_forward", action="store_true",
+                help="Start the simulation in fast-forward mode, where timing is not modeled, until "
+                "the software or the proxy switches it to timed mode")
+
+            parser.add_argument("--fast-forward-until-pc", dest="fast_forward_until_pc",
+                default=None, help="Start in fast-forward mode and switch to timed mode when a core "
+                "reaches the specified PC")
+
+            parser.add_argument("--fast-forward-until-insns", dest="fast_forward_until_insns",
+                default=None, type=int, help="Start in fast-forward mode and switch to timed mode "
+                "when a core has executed the specified number of instructions")
+
+            parser.add_argument("--fast-forward-quantum", dest="fast_forward_quantum", default=None,
+                type=int, help="Number of instructions that a core can execute in advance of the "
+                "clock in fast-forward mode (default: 1000)")
+
+            parser.add_argument("--iss-profiler", dest="iss_profiler", default=None,
+                choices=['cycles', 'insns'],
+                help="Sample the cores every N cycles or N retired instructions, and dump for each "
+                "core a flat profile and folded stacks at the end of the simulation. The insns mode "
+                "keeps the cores on the slow instruction handler and disables the quantum mode and "
+                "the JIT, so its overhead is much higher than the one of the cycles mode")
+
+            parser.add_argument("--iss-profiler-period", dest="iss_profiler_period", default=None,
+                type=int, help="Average number of cycles or instructions between 2 samples of the "
+                "ISS profiler (default: 1000)")
+
             [args, otherArgs] = parser.parse_known_args()
 
         self.model = model(parent=self, name=None, parser=parser, options=options)
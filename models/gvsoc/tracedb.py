@@ -0,0 +1,261 @@
+#
+# Copyright (C) 2021 GreenWaves Technologies, SAS, ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+#
+# Reader of trace databases dumped with --event-format=tdb.
+# See engine/include/gv/tracedb.hpp for the description of the format.
+#
+
+import bisect
+import mmap
+import struct
+
+try:
+    import lz4.block as _lz4_block
+except ImportError:
+    _lz4_block = None
+
+
+TRACEDB_MAGIC = b'GVTDB\0\0\0'
+TRACEDB_VERSION = 1
+
+TRACEDB_COMPRESSION_NONE = 0
+TRACEDB_COMPRESSION_LZ4 = 1
+
+TRACEDB_TYPE_LOGICAL = 0
+TRACEDB_TYPE_REAL = 1
+TRACEDB_TYPE_STRING = 2
+
+_HEADER = struct.Struct('<8sIi')
+_CHUNK = struct.Struct('<IIIIIIqq')
+_INDEX_ENTRY = struct.Struct('<qqQQ')
+_TRACE = struct.Struct('<IIIIQQQ')
+_TRAILER = struct.Struct('<QQ8s')
+
+
+def _lz4_decompress(src, raw_size):
+    """Decompress an LZ4 block, using the lz4 module if available."""
+    if _lz4_block is not None:
+        return _lz4_block.decompress(src, uncompressed_size=raw_size)
+
+    src = bytes(src)
+    dst = bytearray()
+    pos = 0
+    while pos < len(src):
+        token = src[pos]
+        pos += 1
+
+        length = token >> 4
+        if length == 15:
+            while True:
+                byte = src[pos]
+                pos += 1
+                length += byte
+                if byte != 255:
+                    break
+        dst += src[pos:pos + length]
+        pos += length
+
+        # The last sequence only contains literals
+        if pos >= len(src):
+            break
+
+        offset = src[pos] | (src[pos + 1] << 8)
+        pos += 2
+
+        length = token & 0xf
+        if length == 15:
+            while True:
+                byte = src[pos]
+                pos += 1
+                length += byte
+                if byte != 255:
+                    break
+        length += 4
+
+        start = len(dst) - offset
+        if length <= offset:
+            dst += dst[start:start + length]
+        else:
+            # Overlapping copy
+            for i in range(length):
+                dst.append(dst[start + i])
+
+    return bytes(dst)
+
+
+class Trace(object):
+    """
+    A trace of the database.
+
+    :param path: str, the path of the trace
+    :param type: int, one of TRACEDB_TYPE_LOGICAL, TRACEDB_TYPE_REAL or TRACEDB_TYPE_STRING
+    :param width: int, the width in bits of logical traces
+    :param nb_events: int, the number of value changes
+    """
+
+    def __init__(self, db, path, trace_id, type, width, nb_events, nb_chunks, index_offset):
+        self.db = db
+        self.path = path
+        self.id = trace_id
+        self.type = type
+        self.width = width
+        self.nb_events = nb_events
+        self.nb_chunks = nb_chunks
+        self.index_offset = index_offset
+
+    def _get_index_entry(self, index):
+        return _INDEX_ENTRY.unpack_from(self.db.map, self.index_offset + index * _INDEX_ENTRY.size)
+
+    def _find_chunk(self, timestamp):
+        # Binary search directly in the chunk index of the file, so that only a few entries are
+        # read whatever the size of the trace
+        low, high = 0, self.nb_chunks
+        while low < high:
+            mid = (low + high) // 2
+            if self._get_index_entry(mid)[0] <= timestamp:
+                low = mid + 1
+            else:
+                high = mid
+        return max(low - 1, 0)
+
+    def _decode_value(self, value, flags):
+        if flags == 1:
+            return None
+        if self.type == TRACEDB_TYPE_REAL:
+            return struct.unpack('<d', value)[0]
+        if self.type == TRACEDB_TYPE_STRING:
+            return bytes(value).rstrip(b'\0').decode('utf-8', errors='replace')
+        return int.from_bytes(value, 'little') & ((1 << self.width) - 1)
+
+    def get_events(self, start: int = 0, end: int = None):
+        """
+        Get the value changes in a time window.
+
+        The first value change returned is the one valid at the start of the window, if any,
+        followed by all value changes until the end of the window, included.
+        A value of None means high impedance.
+
+        :param start: int, the start of the window
+        :param end: int, the end of the window, or None for the end of the trace
+        :return: a generator of (timestamp, value) tuples
+        """
+        chunk = self._find_chunk(start)
+        first = True
+
+        while chunk < self.nb_chunks:
+            first_timestamp, _, offset, _ = self._get_index_entry(chunk)
+            if end is not None and first_timestamp > end:
+                return
+
+            data, nb_events = self.db._get_chunk(offset)
+            timestamps = memoryview(data)[0:nb_events * 8].cast('q')
+            flags_offset = nb_events * 8
+            values_offset = flags_offset + ((nb_events + 7) & ~7)
+
+            if self.type == TRACEDB_TYPE_STRING:
+                offsets = memoryview(data)[values_offset:values_offset + (nb_events + 1) * 4].cast('I')
+                values_offset += (nb_events + 1) * 4
+            else:
+                value_size = 8 if self.type == TRACEDB_TYPE_REAL else (self.width + 7) // 8
+
+            event = 0
+            if first:
+                event = max(bisect.bisect_right(timestamps, start) - 1, 0)
+                first = False
+
+            while event < nb_events:
+                timestamp = timestamps[event]
+                if end is not None and timestamp > end:
+                    return
+
+                if self.type == TRACEDB_TYPE_STRING:
+                    value = data[values_offset + offsets[event]:values_offset + offsets[event + 1]]
+                else:
+                    value_start = values_offset + event * value_size
+                    value = data[value_start:value_start + value_size]
+
+                yield (timestamp, self._decode_value(value, data[flags_offset + event]))
+                event += 1
+
+            chunk += 1
+
+
+class TraceDb(object):
+    """
+    A trace database dumped by GVSOC.
+
+    The file is memory-mapped and only the chunks covering the requested time windows are
+    decompressed, so that huge traces can be opened instantly.
+
+    :param path: str, the path of the trace database
+    """
+
+    def __init__(self, path: str):
+        self.file = open(path, 'rb')
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, version, self.timescale = _HEADER.unpack_from(self.map, 0)
+        traces_offset, nb_traces, trailer_magic = _TRAILER.unpack_from(self.map,
+            len(self.map) - _TRAILER.size)
+
+        if magic != TRACEDB_MAGIC or trailer_magic != TRACEDB_MAGIC or version != TRACEDB_VERSION:
+            raise RuntimeError('Invalid or incomplete trace database (path: %s)' % path)
+
+        self.traces = {}
+        offset = traces_offset
+        for i in range(0, nb_traces):
+            trace_id, type, width, path_len, nb_events, nb_chunks, index_offset = \
+                _TRACE.unpack_from(self.map, offset)
+            offset += _TRACE.size
+            trace_path = self.map[offset:offset + path_len].decode('utf-8')
+            offset += (path_len + 7) & ~7
+
+            self.traces[trace_path] = Trace(self, trace_path, trace_id, type, width, nb_events,
+                nb_chunks, index_offset)
+
+        self._chunk_offset = None
+        self._chunk = None
+
+    def get_paths(self):
+        """Get the paths of all traces."""
+        return list(self.traces.keys())
+
+    def get_trace(self, path: str):
+        """Get a trace from its path, or None if it is not in the database."""
+        return self.traces.get(path)
+
+    def _get_chunk(self, offset):
+        # Keep the last decompressed chunk, since consecutive windows often fall in the same one
+        if self._chunk_offset != offset:
+            _, nb_events, compression, raw_size, stored_size, _, _, _ = \
+                _CHUNK.unpack_from(self.map, offset)
+            start = offset + _CHUNK.size
+            stored = self.map[start:start + stored_size]
+
+            if compression == TRACEDB_COMPRESSION_LZ4:
+                data = _lz4_decompress(stored, raw_size)
+            else:
+                data = stored
+
+            self._chunk_offset = offset
+            self._chunk = (data, nb_events)
+
+        return self._chunk
+
+    def close(self):
+        self.map.close()
+        self.file.close()
@@ -23,6 +23,7 @@
 #include <vp/itf/io.hpp>
 #include <stdio.h>
 #include <math.h>
+#include <algorithm>
 
 class interleaver : public vp::Component
 {
@@ -33,6 +34,8 @@ public:
 
   static vp::IoReqStatus req(vp::Block *__this, vp::IoReq *req);
 
+  static bool dmi_req(vp::Block *__this, uint64_t offset, bool is_write, vp::IoDmi *dmi);
+
 
   static void grant(vp::Block *__this, vp::IoReq *req);
 
@@ -57,8 +60,10 @@ interleaver::interleaver(vp::ComponentConf &config)
 : vp::Component(config)
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
+  this->trace.register_callback([]() { vp::IoDmi::invalidate_all(); });
 
   in.set_req_meth(&interleaver::req);
+  in.set_dmi_meth(&interleaver::dmi_req);
   new_slave_port("input", &in);
 
   nb_slaves = get_js_config()->get_child_int("nb_slaves");
@@ -89,6 +94,7 @@ interleaver::interleaver(vp::ComponentConf &config)
   {
     masters_in[i] = new vp::IoSlave();
     masters_in[i]->set_req_meth(&interleaver::req);
+    masters_in[i]->set_dmi_meth(&interleaver::dmi_req);
     new_slave_port("in_" + std::to_string(i), masters_in[i]);
   }
 
@@ -172,6 +178,46 @@ vp::IoReqStatus interleaver::req(vp::Block *__this, vp::IoReq *req)
   return vp::IO_REQ_OK;
 }
 
+bool interleaver::dmi_req(vp::Block *__this, uint64_t offset, bool is_write, vp::IoDmi *dmi)
+{
+  interleaver *_this = (interleaver *)__this;
+
+  if (_this->trace.get_active())
+  {
+    return false;
+  }
+
+  // Only one chunk of interleaving size is contiguous in the output port, so this is what can be
+  // granted at most
+  uint64_t port_size = 1 << _this->interleaving_bits;
+  uint64_t chunk_base = (offset - _this->remove_offset) & ~(port_size - 1);
+
+  int output_id = (chunk_base >> _this->interleaving_bits) & ((1 << _this->stage_bits) - 1);
+  uint64_t new_chunk_base = (chunk_base & _this->offset_mask) >> _this->stage_bits;
+
+  if (!_this->out[output_id]) return false;
+
+  // Same latency model as for requests, the highest one is kept
+  int64_t latency = dmi->latency;
+  dmi->latency = 0;
+
+  if (!_this->out[output_id]->get_dmi(new_chunk_base + ((offset - _this->remove_offset) & (port_size - 1)),
+    is_write, dmi))
+  {
+    return false;
+  }
+
+  uint64_t base = std::max(dmi->base, new_chunk_base);
+  uint64_t end = std::min(dmi->base + dmi->size, new_chunk_base + port_size);
+
+  dmi->data += base - dmi->base;
+  dmi->base = chunk_base + _this->remove_offset + (base - new_chunk_base);
+  dmi->size = end - base;
+  dmi->latency = std::max(latency, dmi->latency);
+
+  return true;
+}
+
 void interleaver::grant(vp::Block *__this, vp::IoReq *req)
 {
 
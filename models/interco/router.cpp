@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <vp/mapping_tree.hpp>
+#include <vp/fast_forward.hpp>
 #include "router_common.hpp"
 
 class Router;
@@ -45,6 +46,10 @@ public:
     // the latency and duration with the current utilization of the limiter with respect to the
     // bandwidth
     void apply_bandwidth(int64_t cycles, vp::IoReq *req);
+    // Can be called on any direct memory interface grant going through the limiter to add the
+    // fixed latency. Returns false if the grant can not be given, which is the case when the
+    // latency depends on the bandwidth utilization.
+    bool apply_dmi(vp::IoDmi *dmi);
 
 private:
     Router *top;
@@ -90,6 +95,9 @@ public:
     InputPort(Router *top, int64_t bandwidth, int64_t latency);
     vp::IoSlave itf;
     BandwidthLimiter bw_limiter;
+    // Mapping which was last hit by this input port, checked first since masters tend to stream
+    // to the same target
+    vp::MappingTreeEntry *last_mapping = NULL;
 };
 
 
@@ -111,6 +119,8 @@ private:
     vp::IoReqStatus handle_req(vp::IoReq *req, int port) override;
     // Interface callback where incoming requests are received. Just a wrapper for handle_req
     static vp::IoReqStatus req(vp::Block *__this, vp::IoReq *req, int port);
+    // Interface callback where direct memory interface grants are asked
+    static bool dmi_req(vp::Block *__this, uint64_t offset, bool is_write, vp::IoDmi *dmi, int port);
     // Asynchronous response are received here in case a request is spread over multiple mappings.
     static void response(vp::Block *__this, vp::IoReq *req);
     // Called to handle the end of a request, either because it was handled synchronously or through
@@ -144,6 +154,7 @@ Router::Router(vp::ComponentConf &config)
     : RouterCommon(config), mapping_tree(&this->trace)
 {
     this->traces.new_trace("trace", &trace, vp::DEBUG);
+    this->trace.register_callback([]() { vp::IoDmi::invalidate_all(); });
 
     int bandwidth = this->get_js_config()->get_int("bandwidth");
     int latency = this->get_js_config()->get_int("latency");
@@ -159,6 +170,7 @@ Router::Router(vp::ComponentConf &config)
         vp::IoSlave *input = &input_port->itf;
         std::string name = i == 0 ? "input" : "input_" + std::to_string(i);
         input->set_req_meth_muxed(&Router::req, i);
+        input->set_dmi_meth_muxed(&Router::dmi_req);
         this->new_slave_port(name, input, this);
     }
 
@@ -209,14 +221,15 @@ vp::IoReqStatus Router::handle_req(vp::IoReq *req, int port)
     uint8_t *data = req->get_data();
     bool is_write = req->get_is_write();
 
-    this->trace.msg(vp::Trace::LEVEL_TRACE, "Received IO req (offset: 0x%llx, size: 0x%llx, is_write: %d)\n",
+    vp_trace_msg(&this->trace, vp::Trace::LEVEL_TRACE, "Received IO req (offset: 0x%llx, size: 0x%llx, is_write: %d)\n",
         offset, size, is_write);
 
     // First apply the bandwidth limitation coming from the input port
     this->inputs[port]->bw_limiter.apply_bandwidth(this->clock.get_cycles(), req);
 
     // Get the mapping from the tree
-    vp::MappingTreeEntry *mapping = this->mapping_tree.get(offset, size, req->get_is_write());
+    vp::MappingTreeEntry *mapping = this->mapping_tree.get(offset, size, req->get_is_write(),
+        this->inputs[port]->last_mapping);
 
     // In case no mapping was found, or we hit the error mapping, return an error
     if (!mapping || mapping->id == this->error_id)
@@ -229,7 +242,7 @@ vp::IoReqStatus Router::handle_req(vp::IoReq *req, int port)
     // the mapping
     if (mapping->size == 0 || offset + size <= mapping->base + mapping->size)
     {
-        this->trace.msg(vp::Trace::LEVEL_TRACE, "Routing to entry (OutputPort: %s)\n", mapping->name.c_str());
+        vp_trace_msg(&this->trace, vp::Trace::LEVEL_TRACE, "Routing to entry (OutputPort: %s)\n", mapping->name.c_str());
 
         OutputPort *entry = this->entries[mapping->id];
 
@@ -277,7 +290,7 @@ vp::IoReqStatus Router::handle_req(vp::IoReq *req, int port)
                 return vp::IO_REQ_INVALID;
             }
 
-            this->trace.msg(vp::Trace::LEVEL_TRACE, "Routing to entry (OutputPort: %s)\n", mapping->name.c_str());
+            vp_trace_msg(&this->trace, vp::Trace::LEVEL_TRACE, "Routing to entry (OutputPort: %s)\n", mapping->name.c_str());
 
             OutputPort *entry = this->entries[mapping->id];
 
@@ -347,6 +360,50 @@ vp::IoReqStatus Router::handle_req(vp::IoReq *req, int port)
     }
 }
 
+bool Router::dmi_req(vp::Block *__this, uint64_t offset, bool is_write, vp::IoDmi *dmi, int port)
+{
+    Router *_this = (Router *)__this;
+
+    // Direct accesses are not traced, requests must go through the router when it is
+    if (_this->trace.get_active() || !_this->inputs[port]->bw_limiter.apply_dmi(dmi))
+    {
+        return false;
+    }
+
+    vp::MappingTreeEntry *mapping = _this->mapping_tree.get(offset, 1, is_write);
+    if (!mapping || mapping->id == _this->error_id)
+    {
+        return false;
+    }
+
+    OutputPort *entry = _this->entries[mapping->id];
+    if (!entry->itf.is_bound() || !entry->bw_limiter.apply_dmi(dmi))
+    {
+        return false;
+    }
+
+    if (!entry->itf.get_dmi(offset - entry->remove_offset + entry->add_offset, is_write, dmi))
+    {
+        return false;
+    }
+
+    // Translate the granted range back into our address space, and restrict it to the
+    // addresses which are routed to this mapping
+    uint64_t base = dmi->base + entry->remove_offset - entry->add_offset;
+    uint64_t end = base + dmi->size;
+    uint64_t mapping_base, mapping_end;
+    _this->mapping_tree.get_range(offset, mapping, mapping_base, mapping_end);
+
+    uint64_t granted_base = std::max(base, mapping_base);
+    uint64_t granted_end = std::min(end, mapping_end);
+
+    dmi->data += granted_base - base;
+    dmi->base = granted_base;
+    dmi->size = granted_end - granted_base;
+
+    return true;
+}
+
 void Router::response(vp::Block *__this, vp::IoReq *req)
 {
     Router *_this = (Router *)__this;
@@ -427,6 +484,12 @@ void BandwidthLimiter::apply_bandwidth(int64_t cycles, vp::IoReq *req)
 {
     uint64_t size = req->get_size();
 
+    // Neither the bandwidth nor the latency are modeled in fast-forward mode
+    if (vp::FastForward::is_active())
+    {
+        return;
+    }
+
     if (this->bandwidth != 0)
     {
         // Bandwidth was specified
@@ -465,6 +528,24 @@ void BandwidthLimiter::apply_bandwidth(int64_t cycles, vp::IoReq *req)
     }
 }
 
+bool BandwidthLimiter::apply_dmi(vp::IoDmi *dmi)
+{
+    // The grant is invalidated when fast-forward mode stops, so that the bandwidth is modeled
+    // again after that
+    if (vp::FastForward::is_active())
+    {
+        return true;
+    }
+
+    if (this->bandwidth != 0)
+    {
+        return false;
+    }
+
+    dmi->latency += this->latency;
+    return true;
+}
+
 extern "C" vp::Component *gv_new(vp::ComponentConf &config)
 {
     return new Router(config);
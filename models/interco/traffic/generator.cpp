@@ -105,8 +105,17 @@ void Generator::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
 
     if (!_this->stalled && _this->size > 0)
     {
-        uint8_t *data = new uint8_t[_this->packet_size];
-        vp::IoReq *req = new vp::IoReq(_this->address, data, _this->packet_size, false);
+        vp::IoReq *req = _this->output_itf.req_new(_this->address, NULL, _this->packet_size, false);
+
+        // Use the request payload for small packets so that no allocation is needed
+        if (_this->packet_size <= (uint64_t)req->get_payload_size())
+        {
+            req->set_data(req->get_payload());
+        }
+        else
+        {
+            req->set_data(new uint8_t[_this->packet_size]);
+        }
 
         _this->trace.msg(vp::Trace::LEVEL_DEBUG, "Sending request (req: %p, address: 0x%llx, size: 0x%llx, packet_size: 0x%llx)\n",
             req, _this->address, _this->packet_size, _this->packet_size);
@@ -142,8 +151,11 @@ void Generator::handle_req_end(vp::IoReq *req)
         this->end_trigger->enqueue();
     }
 
-    delete[] req->get_data();
-    delete req;
+    if (req->get_data() != req->get_payload())
+    {
+        delete[] req->get_data();
+    }
+    this->output_itf.req_del(req);
 }
 
 extern "C" vp::Component *gv_new(vp::ComponentConf &config)
@@ -21,12 +21,32 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <optional>
 #include <algorithm>
+#include <vector>
 #include <vp/vp.hpp>
 #include <vp/memcheck.hpp>
 #include <vp/itf/io.hpp>
 #include <vp/itf/wire.hpp>
+#include <vp/preload_cache.hpp>
+#include <vp/checkpoint.hpp>
+#include <vp/fast_forward.hpp>
+
+// Value of memory bytes which were never written, to detect uninitialized variables
+#define MEMORY_FILL_PATTERN 0x57
+// Granularity at which uniform areas are skipped in checkpoints
+#define MEMORY_CHECKPOINT_CHUNK 0x1000
+
+typedef enum
+{
+    // Whole memory allocated up front
+    MEMORY_STORAGE_FLAT,
+    // Whole memory reserved with an anonymous mapping, host pages are only committed when touched
+    MEMORY_STORAGE_MMAP,
+    // Memory split into pages allocated on first write
+    MEMORY_STORAGE_SPARSE,
+} memory_storage_e;
 
 class Memory : public vp::Component
 {
@@ -35,8 +55,11 @@ public:
     Memory(vp::ComponentConf &config);
 
     void reset(bool active);
+    void checkpoint_save(vp::CheckpointWriter &writer) override;
+    void checkpoint_restore(vp::CheckpointReader &reader) override;
 
     static vp::IoReqStatus req(vp::Block *__this, vp::IoReq *req);
+    static bool dmi_req(vp::Block *__this, uint64_t offset, bool is_write, vp::IoDmi *dmi);
 
     uint64_t memcheck_alloc(uint64_t ptr, uint64_t size);
     uint64_t memcheck_free(uint64_t ptr, uint64_t size);
@@ -56,6 +79,14 @@ private:
     void memcheck_find_closest_buffer(uint64_t offset, uint64_t &distance, uint64_t &buffer_offset, uint64_t &buffer_size);
     void memcheck_buffer_setup(uint64_t base, uint64_t size, bool enable);
     bool check_buffer_access(uint64_t offset, uint64_t size, bool is_write);
+    // Copy data from or to the storage, whatever its kind
+    inline void storage_read(uint64_t offset, uint64_t size, uint8_t *data);
+    inline void storage_write(uint64_t offset, uint64_t size, uint8_t *data);
+    void sparse_read(uint64_t offset, uint64_t size, uint8_t *data);
+    void sparse_write(uint64_t offset, uint64_t size, uint8_t *data);
+    // Return the page containing the offset, allocate it if it does not exist yet
+    uint8_t *sparse_page_get(uint64_t offset);
+    void preload(FILE *file);
 
     vp::Trace trace;
     vp::IoSlave in;
@@ -65,7 +96,18 @@ private:
     int width_bits = -1;
     int latency;
 
-    uint8_t *mem_data;
+    memory_storage_e storage = MEMORY_STORAGE_FLAT;
+    uint8_t *mem_data = NULL;
+    // Page table of the sparse storage, unallocated pages are NULL
+    uint8_t **pages = NULL;
+    int page_bits;
+    uint64_t nb_pages;
+    uint64_t nb_allocated_pages = 0;
+    // Page full of the fill pattern, given read-only as direct access to unallocated pages
+    uint8_t *fill_page = NULL;
+    // True if the fill page was granted, direct accesses must then be revoked when a page is
+    // allocated, so that masters stop reading the fill page in place of it
+    bool fill_page_granted = false;
     uint8_t *memcheck_data = NULL;
     uint8_t *check_mem;
     uint8_t *memcheck_valid_flags = NULL;
@@ -100,11 +142,26 @@ private:
 
 
 
+// Reserve a zero-initialized area without committing host memory nor swap space, pages are only
+// allocated by the host when they are first touched
+static uint8_t *memory_mmap_alloc(uint64_t size)
+{
+    void *area = mmap(NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (area == MAP_FAILED) throw std::bad_alloc();
+    return (uint8_t *)area;
+}
+
+
+
 Memory::Memory(vp::ComponentConf &config)
     : vp::Component(config)
 {
     traces.new_trace("trace", &trace, vp::DEBUG);
+    // Direct accesses are not traced, they must stop as soon as the trace is enabled
+    this->trace.register_callback([]() { vp::IoDmi::invalidate_all(); });
     in.set_req_meth(&Memory::req);
+    in.set_dmi_meth(&Memory::dmi_req);
     new_slave_port("input", &in);
 
     this->power_ctrl_itf.set_sync_meth(&Memory::power_ctrl_sync);
@@ -134,16 +191,76 @@ Memory::Memory(vp::ComponentConf &config)
     this->latency = get_js_config()->get_child_int("latency");
     int align = get_js_config()->get_child_int("align");
 
-    trace.msg("Building Memory (size: 0x%x, check: %d)\n", size, check);
+    std::string storage = get_js_config()->get_child_str("storage");
+    if (storage == "mmap")
+    {
+        this->storage = MEMORY_STORAGE_MMAP;
+    }
+    else if (storage == "sparse")
+    {
+        this->storage = MEMORY_STORAGE_SPARSE;
+    }
+    else if (storage != "" && storage != "flat")
+    {
+        this->trace.fatal("Unknown storage (storage: %s)\n", storage.c_str());
+        return;
+    }
+
+    trace.msg("Building Memory (size: 0x%x, check: %d, storage: %s)\n", size, check,
+        storage == "" ? "flat" : storage.c_str());
 
-    if (align)
+    // The preload file can be mapped from the preload cache, which then gives the whole memory
+    // content, already filled like it would be without the cache
+    std::string stim_file = get_js_config()->get_child_str("stim_file");
+    bool preloaded = false;
+    if (stim_file != "" && this->storage != MEMORY_STORAGE_SPARSE)
     {
-        mem_data = (uint8_t *)aligned_alloc(align, size);
+        uint8_t fill = this->storage == MEMORY_STORAGE_FLAT && size < (2<<24) ?
+            MEMORY_FILL_PATTERN : 0;
+        mem_data = vp::PreloadCache::map(&this->trace, stim_file, size, fill);
+        preloaded = mem_data != NULL;
     }
-    else
+
+    // When preloaded, the storage is the private mapping of the cache file, which behaves like
+    // the mmap storage
+    if (!preloaded)
     {
-        mem_data = (uint8_t *)calloc(size, 1);
-        if (mem_data == NULL) throw std::bad_alloc();
+        if (this->storage == MEMORY_STORAGE_SPARSE)
+        {
+            int64_t page_size = get_js_config()->get_child_int("page_size");
+            if (page_size == 0)
+            {
+                page_size = 0x10000;
+            }
+            if (page_size < 0x1000 || (page_size & (page_size - 1)) != 0)
+            {
+                this->trace.fatal("Invalid page size, must be a power of 2 of at least 4KB "
+                    "(page_size: 0x%lx)\n", page_size);
+                return;
+            }
+
+            this->page_bits = __builtin_ctzll(page_size);
+            this->nb_pages = (size + page_size - 1) >> this->page_bits;
+            this->pages = (uint8_t **)calloc(this->nb_pages, sizeof(uint8_t *));
+            if (this->pages == NULL) throw std::bad_alloc();
+            this->fill_page = (uint8_t *)malloc(page_size);
+            if (this->fill_page == NULL) throw std::bad_alloc();
+            memset(this->fill_page, MEMORY_FILL_PATTERN, page_size);
+        }
+        else if (this->storage == MEMORY_STORAGE_MMAP)
+        {
+            // Mappings are aligned on host pages, which is enough for any reasonable alignment
+            mem_data = memory_mmap_alloc(size);
+        }
+        else if (align)
+        {
+            mem_data = (uint8_t *)aligned_alloc(align, size);
+        }
+        else
+        {
+            mem_data = (uint8_t *)calloc(size, 1);
+            if (mem_data == NULL) throw std::bad_alloc();
+        }
     }
 
     // Special option to check for uninitialized accesses
@@ -158,16 +275,30 @@ Memory::Memory(vp::ComponentConf &config)
 
     if (this->traces.get_trace_engine()->is_memcheck_enabled())
     {
-        this->memcheck_data = (uint8_t *)calloc(size, 1);
-        if (this->memcheck_data == NULL) throw std::bad_alloc();
+        if (this->storage == MEMORY_STORAGE_FLAT)
+        {
+            this->memcheck_data = (uint8_t *)calloc(size, 1);
+            if (this->memcheck_data == NULL) throw std::bad_alloc();
+        }
+        else
+        {
+            this->memcheck_data = memory_mmap_alloc(size);
+        }
 
         int memcheck_id = this->get_js_config()->get_child_int("memcheck_id");
         if (memcheck_id != -1)
         {
             this->memcheck_expansion_factor = this->get_js_config()->get_child_int("memcheck_expansion_factor");
-            int memcheck_size = size * this->memcheck_expansion_factor;
-            this->memcheck_valid_flags = (uint8_t *)calloc((memcheck_size + 7) / 8, 1);
-            if (this->memcheck_valid_flags == NULL) throw std::bad_alloc();
+            uint64_t memcheck_size = size * this->memcheck_expansion_factor;
+            if (this->storage == MEMORY_STORAGE_FLAT)
+            {
+                this->memcheck_valid_flags = (uint8_t *)calloc((memcheck_size + 7) / 8, 1);
+                if (this->memcheck_valid_flags == NULL) throw std::bad_alloc();
+            }
+            else
+            {
+                this->memcheck_valid_flags = memory_mmap_alloc((memcheck_size + 7) / 8);
+            }
 
             this->memcheck_base = this->get_js_config()->get_child_int("memcheck_base");
             this->memcheck_virtual_base = this->get_js_config()->get_child_int("memcheck_virtual_base");
@@ -179,32 +310,26 @@ Memory::Memory(vp::ComponentConf &config)
     // Initialize the Memory with a special value to detect uninitialized
     // variables.
     // Only do it for small memories to not slow down too much simulation init.
-    if (size < (2<<24))
+    // The sparse storage gets it for free since unallocated pages read as the fill pattern,
+    // while the mmap one is not filled to not commit all its pages.
+    if (!preloaded && this->storage == MEMORY_STORAGE_FLAT && size < (2<<24))
     {
-        memset(mem_data, 0x57, size);
+        memset(mem_data, MEMORY_FILL_PATTERN, size);
     }
 
     // Preload the Memory
-    js::Config *stim_file_conf = this->get_js_config()->get("stim_file");
-    if (stim_file_conf != NULL)
+    if (!preloaded && stim_file != "")
     {
-        string path = stim_file_conf->get_str();
-        if (path != "")
-        {
-            trace.msg("Preloading Memory with stimuli file (path: %s)\n", path.c_str());
+        trace.msg("Preloading Memory with stimuli file (path: %s)\n", stim_file.c_str());
 
-            FILE *file = fopen(path.c_str(), "rb");
-            if (file == NULL)
-            {
-                this->trace.fatal("Unable to open stim file: %s, %s\n", path.c_str(), strerror(errno));
-                return;
-            }
-            if (fread(this->mem_data, 1, size, file) == 0)
-            {
-                this->trace.fatal("Failed to read stim file: %s, %s\n", path.c_str(), strerror(errno));
-                return;
-            }
+        FILE *file = fopen(stim_file.c_str(), "rb");
+        if (file == NULL)
+        {
+            this->trace.fatal("Unable to open stim file: %s, %s\n", stim_file.c_str(), strerror(errno));
+            return;
         }
+        this->preload(file);
+        fclose(file);
     }
 
     this->background_power.leakage_power_start();
@@ -224,12 +349,18 @@ vp::IoReqStatus Memory::req(vp::Block *__this, vp::IoReq *req)
 
     _this->trace.msg("Memory access (offset: 0x%x, size: 0x%x, is_write: %d, op: %d)\n", offset, size, req->get_is_write(), req->get_opcode());
 
-    req->inc_latency(_this->latency);
+    // Requests take no time in fast-forward mode
+    bool timed = !vp::FastForward::is_active();
+
+    if (timed)
+    {
+        req->inc_latency(_this->latency);
+    }
 
     if (!req->is_debug())
     {
         // Impact the Memory bandwith on the packet
-        if (_this->width_bits != -1)
+        if (_this->width_bits != -1 && timed)
         {
     #define MAX(a, b) (((a) > (b)) ? (a) : (b))
             int duration = MAX(size >> _this->width_bits, 1);
@@ -330,6 +461,201 @@ vp::IoReqStatus Memory::req(vp::Block *__this, vp::IoReq *req)
 
 
 
+bool Memory::dmi_req(vp::Block *__this, uint64_t offset, bool is_write, vp::IoDmi *dmi)
+{
+    Memory *_this = (Memory *)__this;
+
+    // Direct accesses are only possible when requests would just copy data with a fixed
+    // latency, and would not be traced or accounted. The bandwidth is not modeled in
+    // fast-forward mode, and direct accesses are invalidated when it stops.
+    bool timed = !vp::FastForward::is_active();
+    if (!_this->powered_up || _this->check || _this->memcheck_data != NULL ||
+        (_this->width_bits != -1 && timed) || _this->power_trigger || _this->power.is_enabled() ||
+        _this->trace.get_active() || offset >= _this->size)
+    {
+        return false;
+    }
+
+    int64_t latency = timed ? _this->latency : 0;
+
+    if (_this->storage == MEMORY_STORAGE_SPARSE)
+    {
+        // Only pages are contiguous. Reading an unallocated page gives the fill page, so that
+        // reads do not allocate memory, while writing allocates it.
+        uint64_t page = offset >> _this->page_bits;
+        uint8_t *page_data = _this->pages[page];
+        if (page_data == NULL && is_write)
+        {
+            page_data = _this->sparse_page_get(offset);
+        }
+
+        dmi->base = page << _this->page_bits;
+        dmi->size = std::min(_this->size - dmi->base, (uint64_t)1 << _this->page_bits);
+        dmi->latency += latency;
+        dmi->read_allowed = true;
+        if (page_data == NULL)
+        {
+            _this->fill_page_granted = true;
+            dmi->data = _this->fill_page;
+            dmi->write_allowed = false;
+        }
+        else
+        {
+            dmi->data = page_data;
+            dmi->write_allowed = true;
+        }
+
+        return true;
+    }
+
+    dmi->base = 0;
+    dmi->size = _this->size;
+    dmi->data = _this->mem_data;
+    dmi->latency += latency;
+    dmi->read_allowed = true;
+    dmi->write_allowed = true;
+
+    return true;
+}
+
+
+
+inline void Memory::storage_read(uint64_t offset, uint64_t size, uint8_t *data)
+{
+    if (this->pages == NULL)
+    {
+        memcpy((void *)data, (void *)&this->mem_data[offset], size);
+    }
+    else
+    {
+        this->sparse_read(offset, size, data);
+    }
+}
+
+
+
+inline void Memory::storage_write(uint64_t offset, uint64_t size, uint8_t *data)
+{
+    if (this->pages == NULL)
+    {
+        memcpy((void *)&this->mem_data[offset], (void *)data, size);
+    }
+    else
+    {
+        this->sparse_write(offset, size, data);
+    }
+}
+
+
+
+uint8_t *Memory::sparse_page_get(uint64_t offset)
+{
+    uint64_t page = offset >> this->page_bits;
+    uint8_t *page_data = this->pages[page];
+    if (page_data == NULL)
+    {
+        uint64_t page_size = (uint64_t)1 << this->page_bits;
+        page_data = (uint8_t *)malloc(page_size);
+        if (page_data == NULL) throw std::bad_alloc();
+        memset(page_data, MEMORY_FILL_PATTERN, page_size);
+        this->pages[page] = page_data;
+        this->nb_allocated_pages++;
+
+        this->trace.msg(vp::Trace::LEVEL_DEBUG, "Allocated page (offset: 0x%lx, allocated: %ld/%ld)\n",
+            page << this->page_bits, this->nb_allocated_pages, this->nb_pages);
+
+        // Masters may still be reading the fill page in place of the new one
+        if (this->fill_page_granted)
+        {
+            this->fill_page_granted = false;
+            vp::IoDmi::invalidate_all();
+        }
+    }
+    return page_data;
+}
+
+
+
+void Memory::sparse_read(uint64_t offset, uint64_t size, uint8_t *data)
+{
+    uint64_t page_mask = ((uint64_t)1 << this->page_bits) - 1;
+    while (size > 0)
+    {
+        uint64_t page_offset = offset & page_mask;
+        uint64_t chunk = std::min(size, page_mask + 1 - page_offset);
+        uint8_t *page_data = this->pages[offset >> this->page_bits];
+
+        if (page_data == NULL)
+        {
+            memset((void *)data, MEMORY_FILL_PATTERN, chunk);
+        }
+        else
+        {
+            memcpy((void *)data, (void *)&page_data[page_offset], chunk);
+        }
+
+        offset += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+
+
+void Memory::sparse_write(uint64_t offset, uint64_t size, uint8_t *data)
+{
+    uint64_t page_mask = ((uint64_t)1 << this->page_bits) - 1;
+    while (size > 0)
+    {
+        uint64_t page_offset = offset & page_mask;
+        uint64_t chunk = std::min(size, page_mask + 1 - page_offset);
+        uint8_t *page_data = this->sparse_page_get(offset);
+
+        memcpy((void *)&page_data[page_offset], (void *)data, chunk);
+
+        offset += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+
+
+void Memory::preload(FILE *file)
+{
+    if (this->pages == NULL)
+    {
+        if (fread(this->mem_data, 1, this->size, file) == 0)
+        {
+            this->trace.fatal("Failed to read stim file: %s\n", strerror(errno));
+        }
+        return;
+    }
+
+    // Sparse storage is preloaded page per page so that only the pages covered by the file are
+    // allocated
+    uint64_t page_size = (uint64_t)1 << this->page_bits;
+    std::vector<uint8_t> buffer(page_size);
+    uint64_t offset = 0;
+    while (offset < this->size)
+    {
+        size_t len = fread(buffer.data(), 1, std::min(page_size, this->size - offset), file);
+        if (len == 0)
+        {
+            break;
+        }
+        this->sparse_write(offset, len, buffer.data());
+        offset += len;
+    }
+
+    if (offset == 0)
+    {
+        this->trace.fatal("Failed to read stim file: %s\n", strerror(errno));
+    }
+}
+
+
+
 vp::IoReqStatus Memory::handle_write(uint64_t offset, uint64_t size, uint8_t *data, uint8_t *req_memcheck_data)
 {
     // Writes on powered-down memory are silently ignored
@@ -361,7 +687,7 @@ vp::IoReqStatus Memory::handle_write(uint64_t offset, uint64_t size, uint8_t *da
 
     if (data)
     {
-        memcpy((void *)&this->mem_data[offset], (void *)data, size);
+        this->storage_write(offset, size, data);
     }
 
     return vp::IO_REQ_OK;
@@ -544,7 +870,7 @@ vp::IoReqStatus Memory::handle_read(uint64_t offset, uint64_t size, uint8_t *dat
 
     if (data)
     {
-        memcpy((void *)data, (void *)&this->mem_data[offset], size);
+        this->storage_read(offset, size, data);
     }
 
     return vp::IO_REQ_OK;
@@ -652,14 +978,112 @@ void Memory::reset(bool active)
     {
         this->next_packet_start = 0;
         this->powered_up = true;
+        vp::IoDmi::invalidate_all();
+    }
+}
+
+
+
+// The content is saved by chunks. Chunks filled with a single value, like the never-written
+// parts of the memory, are saved as this value, the other ones are saved as is and compressed by
+// the checkpoint stream.
+void Memory::checkpoint_save(vp::CheckpointWriter &writer)
+{
+    vp::Component::checkpoint_save(writer);
+
+    writer.write_u64(this->size);
+    writer.write_u64(this->powered_up);
+    writer.write_i64(this->next_packet_start);
+
+    writer.write_u64(this->res_table.size());
+    for (auto &reservation: this->res_table)
+    {
+        writer.write_u64(reservation.first);
+        writer.write_u64(reservation.second);
+    }
+
+    uint8_t chunk[MEMORY_CHECKPOINT_CHUNK];
+    for (uint64_t offset = 0; offset < this->size && writer.is_ok(); offset += MEMORY_CHECKPOINT_CHUNK)
+    {
+        uint64_t len = std::min(this->size - offset, (uint64_t)MEMORY_CHECKPOINT_CHUNK);
+        this->storage_read(offset, len, chunk);
+
+        uint8_t uniform = len == 1 || memcmp(chunk, chunk + 1, len - 1) == 0;
+        writer.write(&uniform, 1);
+        if (uniform)
+        {
+            writer.write(chunk, 1);
+        }
+        else
+        {
+            writer.write(chunk, len);
+        }
     }
 }
 
 
 
+// Chunks are only written if they differ from the current content, so that restoring does not
+// make private the pages of the sparse storage or of memories shared through the preload cache
+void Memory::checkpoint_restore(vp::CheckpointReader &reader)
+{
+    vp::Component::checkpoint_restore(reader);
+
+    if (!reader.check_u64(this->size, "size of " + this->get_path()))
+    {
+        return;
+    }
+
+    this->powered_up = reader.read_u64();
+    this->next_packet_start = reader.read_i64();
+
+    this->res_table.clear();
+    uint64_t nb_reservations = reader.read_u64();
+    for (uint64_t i = 0; i < nb_reservations && reader.is_ok(); i++)
+    {
+        uint64_t addr = reader.read_u64();
+        this->res_table[addr] = reader.read_u64();
+    }
+
+    uint8_t chunk[MEMORY_CHECKPOINT_CHUNK];
+    uint8_t current[MEMORY_CHECKPOINT_CHUNK];
+    for (uint64_t offset = 0; offset < this->size && reader.is_ok(); offset += MEMORY_CHECKPOINT_CHUNK)
+    {
+        uint64_t len = std::min(this->size - offset, (uint64_t)MEMORY_CHECKPOINT_CHUNK);
+        uint8_t uniform;
+        reader.read(&uniform, 1);
+        if (uniform)
+        {
+            reader.read(chunk, 1);
+            memset(chunk + 1, chunk[0], len - 1);
+        }
+        else
+        {
+            reader.read(chunk, len);
+        }
+
+        this->storage_read(offset, len, current);
+        if (memcmp(chunk, current, len) != 0)
+        {
+            this->storage_write(offset, len, chunk);
+        }
+    }
+
+    vp::IoDmi::invalidate_all();
+}
+
+
+
 void Memory::power_ctrl_sync(vp::Block *__this, bool value)
 {
     Memory *_this = (Memory *)__this;
+
+    // Accesses to a powered-down memory have a different behavior, direct accesses must stop
+    if (value != _this->powered_up)
+    {
+        vp::IoDmi::invalidate_all();
+    }
+
     _this->powered_up = value;
 }
 
@@ -668,6 +1092,15 @@ void Memory::power_ctrl_sync(vp::Block *__this, bool value)
 void Memory::meminfo_sync_back(vp::Block *__this, void **value)
 {
     Memory *_this = (Memory *)__this;
+
+    // The sparse storage has no contiguous host area to give
+    if (_this->storage == MEMORY_STORAGE_SPARSE)
+    {
+        _this->trace.fatal("Host pointer to memory is not available with sparse storage\n");
+        *value = NULL;
+        return;
+    }
+
     *value = _this->mem_data;
 }
 
@@ -676,7 +1109,17 @@ void Memory::meminfo_sync_back(vp::Block *__this, void **value)
 void Memory::meminfo_sync(vp::Block *__this, void *value)
 {
     Memory *_this = (Memory *)__this;
+
+    if (_this->storage == MEMORY_STORAGE_SPARSE)
+    {
+        _this->trace.force_warning("Memory storage can not be replaced with sparse storage\n");
+        return;
+    }
+
     _this->mem_data = (uint8_t *)value;
+
+    // Direct accesses may still point to the previous storage
+    vp::IoDmi::invalidate_all();
 }
 
 
@@ -56,11 +56,22 @@ class Memory(gvsoc.systree.Component):
         Absolute virtual base of allocated buffers.
     memcheck_expansion_factor: int
         Extra size used to track buffer overflow.
+    storage: str
+        How the memory content is stored on the host. "flat" allocates the whole memory at
+        startup. "mmap" reserves it with an anonymous mapping, host memory is then only used for
+        the parts which are accessed, and they are initialized to zero. "sparse" splits the memory
+        into pages allocated on first write, reads of unallocated pages return the 0x57 fill
+        pattern. Direct accesses are then granted per page and the memory can not be given as a
+        single host pointer, so it should be used for big memories like DDRs.
+    page_size: int
+        Size in bytes of the pages of the sparse storage, must be a power of 2 of at least 4KB.
+        Default is 64KB if 0.
     """
     def __init__(self, parent: gvsoc.systree.Component, name: str, size: int, width_log2: int=2,
             stim_file: str=None, power_trigger: bool=False,
             align: int=0, atomics: bool=False, latency=0, memcheck_id: int=-1, memcheck_base: int=0,
-            memcheck_virtual_base: int=0, memcheck_expansion_factor: int=5):
+            memcheck_virtual_base: int=0, memcheck_expansion_factor: int=5, storage: str='flat',
+            page_size: int=0):
 
         super().__init__(parent, name)
 
@@ -83,6 +94,8 @@ class Memory(gvsoc.systree.Component):
             'memcheck_base': memcheck_base,
             'memcheck_virtual_base': memcheck_virtual_base,
             'memcheck_expansion_factor': memcheck_expansion_factor,
+            'storage': storage,
+            'page_size': page_size,
         })
 
     def i_INPUT(self) -> gvsoc.systree.SlaveItf: